@@ -0,0 +1,99 @@
+/*
+ * Compares loading a document from YAML text with loading the same document
+ * from its CBOR encoding, which is written by a dumper in CBOR mode.
+ *
+ * usage: bench_cbor [record count [iterations]]
+ *
+ * Throughput is given in documents per second and in MB of input per second.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cbor.h"
+#include <cbor_loading.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <yaml_dumper.h>
+#include <yaml_loader.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char *render_records(size_t const count, size_t *const size) {
+  char *const input = malloc(count * 160 + 16);
+  char *pos = input;
+  pos += sprintf(pos, "records:\n");
+  for (size_t i = 0; i < count; ++i) {
+    pos += sprintf(pos, "- id: %zu\n  name: record %zu\n  score: %zu.%03zu\n"
+                   "  active: %s\n  values: [%zu, -%zu, %zu]\n  limit: %s\n",
+                   i, i, i % 100, i % 1000, i % 2 == 0 ? "true" : "false",
+                   i % 7, i * 3, i * i, i % 3 == 0 ? "!none" : "!max 100");
+  }
+  *size = (size_t)(pos - input);
+  return input;
+}
+
+static bool load(const unsigned char *const input, size_t const size,
+                 bool const cbor) {
+  yaml_loader_t loader;
+  if (!(cbor ? yaml_loader_init_cbor(&loader, input, size) :
+               yaml_loader_init_string(&loader, input, size))) {
+    return false;
+  }
+  struct root value;
+  bool const ret = yaml_load_struct_root(&value, &loader);
+  if (ret) yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+  return ret;
+}
+
+int main(int argc, char* argv[]) {
+  size_t const count = argc > 1 ? (size_t)atol(argv[1]) : 50000;
+  int const iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+  size_t size;
+  char *const text = render_records(count, &size);
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)text, size);
+  struct root value;
+  if (!yaml_load_struct_root(&value, &loader)) {
+    fprintf(stderr, "error while loading.\n");
+    return 1;
+  }
+  yaml_loader_delete(&loader);
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  yaml_dumper_use_cbor(&dumper);
+  if (!yaml_dump_struct_root(&value, &dumper) ||
+      !load(dumper.buffer, dumper.size, true)) {
+    fprintf(stderr, "error while encoding.\n");
+    return 1;
+  }
+  yaml_free_struct_root(&value);
+  printf("%s\n%zu records, %.1f MB of YAML, %.1f MB of CBOR\n", argv[0],
+         count, (double)size / 1e6, (double)dumper.size / 1e6);
+
+  double seconds[2];
+  for (int cbor = 0; cbor < 2; ++cbor) {
+    double const start = now();
+    for (int i = 0; i < iterations; ++i) {
+      if (cbor) load(dumper.buffer, dumper.size, true);
+      else load((const unsigned char*)text, size, false);
+    }
+    seconds[cbor] = (now() - start) / iterations;
+  }
+  printf("YAML: %6.1f loads/s %7.1f MB/s\n"
+         "CBOR: %6.1f loads/s %7.1f MB/s (%.1fx)\n",
+         1 / seconds[0], (double)size / seconds[0] / 1e6, 1 / seconds[1],
+         (double)dumper.size / seconds[1] / 1e6, seconds[0] / seconds[1]);
+  yaml_dumper_delete(&dumper);
+  free(text);
+  return 0;
+}
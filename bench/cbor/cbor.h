@@ -0,0 +1,50 @@
+#ifndef _CBOR_H
+#define _CBOR_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+//!list
+struct values {
+  long *data;
+  size_t count;
+  size_t capacity;
+};
+
+enum limit_kind {
+  //!repr max
+  LIMIT_MAX,
+  //!repr none
+  LIMIT_NONE
+};
+
+//!tagged
+struct limit {
+  enum limit_kind kind;
+  union {
+    long max;
+  };
+};
+
+struct record {
+  long id;
+  //!string
+  char *name;
+  double score;
+  bool active;
+  struct values values;
+  struct limit limit;
+};
+
+//!list
+struct record_list {
+  struct record *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  struct record_list records;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Compares constructing nested documents on the calling thread's stack with
+ * constructing them on a separate stack (generator switch -s). This is built
+ * as bench_depth and bench_depth_stack, which differ only in the switch.
+ *
+ * usage: bench_depth[_stack] [chain count [chain depth [iterations]]]
+ *
+ * Throughput is measured by loading a list of chains of nested mappings.
+ * Depth is measured as the number of bytes of the calling thread's stack used
+ * while loading a single chain, by running the load on a thread whose stack
+ * has been filled with a pattern.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "depth.h"
+#include <depth_loading.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <yaml_loader.h>
+
+#define PATTERN 0xa5
+#define MEASURED_STACK_SIZE (4 * 1024 * 1024)
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char *render_chains(size_t const count, size_t const depth,
+                           size_t *const size) {
+  char *const input = malloc(count * (depth * 24 + 8) + 16);
+  char *pos = input;
+  pos += sprintf(pos, "chains:\n");
+  for (size_t i = 0; i < count; ++i) {
+    pos += sprintf(pos, "- ");
+    for (size_t j = 0; j < depth; ++j) {
+      pos += sprintf(pos, j == depth - 1 ? "{value: %zu" : "{value: %zu, child: ",
+                     j);
+    }
+    for (size_t j = 0; j < depth; ++j) *pos++ = '}';
+    *pos++ = '\n';
+  }
+  *pos = '\0';
+  *size = (size_t)(pos - input);
+  return input;
+}
+
+static bool load(const char *const input, size_t const size) {
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, size);
+  struct root value;
+  bool const ret = yaml_load_struct_root(&value, &loader);
+  if (ret) yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+  return ret;
+}
+
+typedef struct {
+  const char *input;
+  size_t size;
+  bool ret;
+} measured_load_t;
+
+static void *measured_load(void *arg) {
+  measured_load_t *const load_arg = (measured_load_t*)arg;
+  load_arg->ret = load(load_arg->input, load_arg->size);
+  yaml_loader_pool_clear();
+  return NULL;
+}
+
+/*
+ * Return the number of bytes of its stack a thread loading a single chain of
+ * the given depth has used, or 0 on failure.
+ */
+static size_t stack_usage(size_t const depth) {
+  measured_load_t arg;
+  arg.input = render_chains(1, depth, &arg.size);
+  unsigned char *const stack = malloc(MEASURED_STACK_SIZE);
+  memset(stack, PATTERN, MEASURED_STACK_SIZE);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, stack, MEASURED_STACK_SIZE);
+  pthread_t thread;
+  size_t used = 0;
+  if (pthread_create(&thread, &attr, &measured_load, &arg) == 0) {
+    pthread_join(thread, NULL);
+    // the stack grows downwards, so the untouched part is at its start.
+    size_t untouched = 0;
+    while (untouched < MEASURED_STACK_SIZE && stack[untouched] == PATTERN) {
+      ++untouched;
+    }
+    if (arg.ret) used = MEASURED_STACK_SIZE - untouched;
+  }
+  pthread_attr_destroy(&attr);
+  free(stack);
+  free((char*)arg.input);
+  return used;
+}
+
+int main(int argc, char* argv[]) {
+  size_t const count = argc > 1 ? (size_t)atol(argv[1]) : 2000;
+  size_t const depth = argc > 2 ? (size_t)atol(argv[2]) : 16;
+  int const iterations = argc > 3 ? atoi(argv[3]) : 20;
+
+  size_t size;
+  char *const input = render_chains(count, depth, &size);
+  if (!load(input, size)) {
+    fprintf(stderr, "error while loading.\n");
+    return 1;
+  }
+  double const start = now();
+  for (int i = 0; i < iterations; ++i) load(input, size);
+  double const seconds = (now() - start) / iterations;
+  printf("%s\n%zu chains of depth %zu: %.2f ms per load, %.1f MB/s\n",
+         argv[0], count, depth, seconds * 1000, (double)size / seconds / 1e6);
+  free(input);
+
+  size_t const shallow = stack_usage(250), deep = stack_usage(1000);
+  if (shallow == 0 || deep == 0) {
+    fprintf(stderr, "error while measuring stack usage.\n");
+    return 1;
+  }
+  double const per_level = (double)((long)deep - (long)shallow) / 750;
+  printf("thread stack used: %zu bytes at depth 250, %zu bytes at depth 1000"
+         "\n%.1f bytes per level", shallow, deep, per_level);
+  if (per_level >= 1) {
+    printf(", i.e. a 64 KiB thread stack fits about %.0f levels\n",
+           (64 * 1024 - (double)shallow + 250 * per_level) / per_level);
+  } else puts(", i.e. depth is not limited by the thread's stack");
+  return 0;
+}
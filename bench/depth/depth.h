@@ -0,0 +1,23 @@
+#ifndef _DEPTH_H
+#define _DEPTH_H
+
+#include <stdlib.h>
+
+struct node {
+  int value;
+  //!optional
+  struct node *child;
+};
+
+//!list
+struct node_list {
+  struct node *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  struct node_list chains;
+};
+
+#endif
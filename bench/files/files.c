@@ -0,0 +1,138 @@
+/*
+ * Loads a directory of small files, one per tenant, sequentially with one
+ * loader per file and with yaml_load_batch_* on a varying number of threads,
+ * on a warm and a cold page cache.
+ *
+ * usage: bench_files [directory [file count [max threads]]]
+ *
+ * The files are created if they do not exist. For the cold runs, the files'
+ * pages are dropped from the page cache with posix_fadvise before each run.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "files.h"
+#include <files_loading.h>
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <yaml_loader.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool write_files(char **const paths, size_t const count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (access(paths[i], R_OK) == 0) continue;
+    FILE *const file = fopen(paths[i], "w");
+    if (file == NULL) return false;
+    fprintf(file, "tenant: tenant-%zu\nid: %zu\nlimits:\n"
+                  "  requests: %zu\n  connections: 64\n  burst: 1.5\nhosts:\n",
+            i, i, 100 + i % 900);
+    for (size_t j = 0; j < 8 + i % 24; ++j) {
+      fprintf(file, "  - {name: host-%zu-%zu.example.com, port: %zu}\n", i, j,
+              8000 + j);
+    }
+    fclose(file);
+  }
+  return true;
+}
+
+static void drop_cache(char **const paths, size_t const count) {
+  for (size_t i = 0; i < count; ++i) {
+    int const fd = open(paths[i], O_RDONLY);
+    if (fd < 0) continue;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+static bool load_sequentially(char **const paths, size_t const count,
+                              struct root *const values) {
+  bool ret = true;
+  for (size_t i = 0; i < count; ++i) {
+    FILE *const file = fopen(paths[i], "rb");
+    if (file == NULL) return false;
+    yaml_loader_t loader;
+    yaml_loader_init_file(&loader, file);
+    if (!yaml_load_struct_root(&values[i], &loader)) ret = false;
+    yaml_loader_delete(&loader);
+    fclose(file);
+  }
+  return ret;
+}
+
+static void free_values(struct root *const values, size_t const count) {
+  for (size_t i = 0; i < count; ++i) yaml_free_struct_root(&values[i]);
+}
+
+int main(int argc, char* argv[]) {
+  const char *const directory = argc > 1 ? argv[1] : "bench_files";
+  size_t const count = argc > 2 ? (size_t)atol(argv[2]) : 3000;
+  unsigned const max_threads = argc > 3 ? (unsigned)atoi(argv[3]) : 8;
+
+  mkdir(directory, 0755);
+  char **const paths = malloc(count * sizeof(char*));
+  for (size_t i = 0; i < count; ++i) {
+    paths[i] = malloc(strlen(directory) + 32);
+    sprintf(paths[i], "%s/tenant-%zu.yaml", directory, i);
+  }
+  if (!write_files(paths, count)) {
+    fprintf(stderr, "unable to write files into %s.\n", directory);
+    return 1;
+  }
+  struct root *const values = malloc(count * sizeof(struct root));
+  yaml_loader_batch_result_t *const results =
+      malloc(count * sizeof(yaml_loader_batch_result_t));
+
+  printf("%zu files\n%-20s %12s %12s\n", count, "", "warm [ms]", "cold [ms]");
+  for (int cold = 0; cold < 2; ++cold) {
+    // a warm-up run fills the page cache.
+    if (!load_sequentially(paths, count, values)) {
+      fprintf(stderr, "error while loading.\n");
+      return 1;
+    }
+    free_values(values, count);
+  }
+  double timings[2];
+  for (int cold = 0; cold < 2; ++cold) {
+    if (cold) drop_cache(paths, count);
+    double const start = now();
+    load_sequentially(paths, count, values);
+    timings[cold] = (now() - start) * 1000;
+    free_values(values, count);
+  }
+  printf("%-20s %12.1f %12.1f\n", "sequential", timings[0], timings[1]);
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    for (int cold = 0; cold < 2; ++cold) {
+      if (cold) drop_cache(paths, count);
+      double const start = now();
+      if (!yaml_load_batch_struct_root((const char *const *)paths, count,
+                                       values, results, threads)) {
+        fprintf(stderr, "error while loading batch.\n");
+        return 1;
+      }
+      timings[cold] = (now() - start) * 1000;
+      free_values(values, count);
+    }
+    char label[32];
+    sprintf(label, "batch, %u thread%s", threads, threads == 1 ? "" : "s");
+    printf("%-20s %12.1f %12.1f\n", label, timings[0], timings[1]);
+  }
+
+  for (size_t i = 0; i < count; ++i) free(paths[i]);
+  free(paths);
+  free(values);
+  free(results);
+  return 0;
+}
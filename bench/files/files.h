@@ -0,0 +1,33 @@
+#ifndef _FILES_H
+#define _FILES_H
+
+#include <stdlib.h>
+
+struct host {
+  //!string
+  char *name;
+  int port;
+};
+
+//!list
+struct host_list {
+  struct host *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct limits {
+  int requests;
+  int connections;
+  double burst;
+};
+
+struct root {
+  //!string
+  char *tenant;
+  int id;
+  struct limits limits;
+  struct host_list hosts;
+};
+
+#endif
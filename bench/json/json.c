@@ -0,0 +1,114 @@
+/*
+ * Compares loading a JSON document through libyaml's parser with loading it
+ * through the JSON scanner, both for recording the events alone and for
+ * constructing the document from them.
+ *
+ * usage: bench_json [record count [iterations]]
+ *
+ * Throughput is given in MB of input per second.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "json.h"
+#include <json_loading.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <yaml_loader.h>
+#include <yaml_tape.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char *render_records(size_t const count, size_t *const size) {
+  char *const input = malloc(count * 160 + 32);
+  char *pos = input;
+  pos += sprintf(pos, "{\"records\": [\n");
+  for (size_t i = 0; i < count; ++i) {
+    pos += sprintf(pos, "  {\"id\": %zu, \"name\": \"record \\\"%zu\\\"\", "
+                   "\"score\": %zu.%03zu, \"active\": %s,\n"
+                   "   \"values\": [%zu, -%zu, %zu]}%s\n",
+                   i, i, i % 100, i % 1000, i % 2 == 0 ? "true" : "false",
+                   i % 7, i * 3, i * i, i == count - 1 ? "" : ",");
+  }
+  pos += sprintf(pos, "]}\n");
+  *size = (size_t)(pos - input);
+  return input;
+}
+
+static bool record(yaml_tape_t *const tape, const char *const input,
+                   size_t const size, bool const json) {
+  if (json) {
+    return yaml_tape_record_json(tape, (const unsigned char*)input, size);
+  }
+  yaml_parser_t parser;
+  yaml_parser_initialize(&parser);
+  yaml_parser_set_input_string(&parser, (const unsigned char*)input, size);
+  bool const ret = yaml_tape_record(tape, &parser);
+  yaml_parser_delete(&parser);
+  return ret;
+}
+
+static bool load(const char *const input, size_t const size,
+                 bool const json) {
+  yaml_loader_t loader;
+  yaml_parser_t parser;
+  if (json) {
+    if (!yaml_loader_init_json(&loader, (const unsigned char*)input, size)) {
+      return false;
+    }
+  } else {
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_string(&parser, (const unsigned char*)input, size);
+    yaml_loader_init_parser(&loader, &parser);
+  }
+  struct root value;
+  bool const ret = yaml_load_struct_root(&value, &loader);
+  if (ret) yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+  if (!json) yaml_parser_delete(&parser);
+  return ret;
+}
+
+int main(int argc, char* argv[]) {
+  size_t const count = argc > 1 ? (size_t)atol(argv[1]) : 50000;
+  int const iterations = argc > 2 ? atoi(argv[2]) : 10;
+
+  size_t size;
+  char *const input = render_records(count, &size);
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  if (!record(&tape, input, size, false) || !record(&tape, input, size, true) ||
+      !load(input, size, false) || !load(input, size, true)) {
+    fprintf(stderr, "error while loading.\n");
+    return 1;
+  }
+  printf("%s\n%zu records, %.1f MB\n", argv[0], count, (double)size / 1e6);
+
+  double seconds[2][2];
+  for (int json = 0; json < 2; ++json) {
+    double start = now();
+    for (int i = 0; i < iterations; ++i) record(&tape, input, size, json);
+    seconds[json][0] = (now() - start) / iterations;
+    start = now();
+    for (int i = 0; i < iterations; ++i) load(input, size, json);
+    seconds[json][1] = (now() - start) / iterations;
+  }
+  static const char *const stages[] = {"recording events", "loading"};
+  for (int stage = 0; stage < 2; ++stage) {
+    printf("%-16s  libyaml: %7.1f MB/s  JSON scanner: %7.1f MB/s  (%.1fx)\n",
+           stages[stage], (double)size / seconds[0][stage] / 1e6,
+           (double)size / seconds[1][stage] / 1e6,
+           seconds[0][stage] / seconds[1][stage]);
+  }
+  yaml_tape_delete(&tape);
+  free(input);
+  return 0;
+}
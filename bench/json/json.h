@@ -0,0 +1,34 @@
+#ifndef _JSON_H
+#define _JSON_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+//!list
+struct values {
+  long *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct record {
+  long id;
+  //!string
+  char *name;
+  double score;
+  bool active;
+  struct values values;
+};
+
+//!list
+struct record_list {
+  struct record *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  struct record_list records;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "cmdline_config.h"
 
 void usage(const char *executable) {
@@ -10,7 +11,13 @@ void usage(const char *executable) {
         "    -r name            expects the root type to be named $name.\n"
         "                       default: \"root\"\n"
         "    -n name            names output files $name.h and $name.c .\n"
-        "                       default: $file without extension.\n", stdout);
+        "                       default: $file without extension.\n"
+        "    -s bytes           loads on a heap-allocated stack of $bytes bytes\n"
+        "                       instead of the caller's stack, and deallocates\n"
+        "                       without recursion.\n"
+        "                       default: the caller's stack, with recursion.\n"
+        "    -e file            embeds the document in $file as constant\n"
+        "                       yaml_embedded_<root> of the root type.\n", stdout);
 }
 
 const char *last_index(const char *string, char c) {
@@ -30,6 +37,8 @@ cmdline_result_t process_cmdline_args(int argc, const char* argv[],
   const char* output_name = NULL;
   config->input_file_path = NULL;
   config->first_clang_param = argc;
+  config->stack_size = 0;
+  config->embed_path = NULL;
 
   for (int i = 1; i < argc; ++i) {
     if (argv[i][0] == '-') {
@@ -70,6 +79,31 @@ cmdline_result_t process_cmdline_args(int argc, const char* argv[],
             output_name = argv[++i];
           }
           break;
+        case 's': {
+          if (config->stack_size != 0) {
+            fputs("duplicate -s switch!\n", stderr);
+            usage(argv[0]);
+            return ARGS_ERROR;
+          }
+          char *end;
+          unsigned long long const size = strtoull(argv[++i], &end, 10);
+          if (*end != '\0' || size == 0 || size > SIZE_MAX) {
+            fprintf(stderr, "invalid stack size: '%s'\n", argv[i]);
+            usage(argv[0]);
+            return ARGS_ERROR;
+          }
+          config->stack_size = (size_t)size;
+          break;
+        }
+        case 'e':
+          if (config->embed_path != NULL) {
+            fputs("duplicate -e switch!\n", stderr);
+            usage(argv[0]);
+            return ARGS_ERROR;
+          } else {
+            config->embed_path = argv[++i];
+          }
+          break;
         case 'h':
           usage(argv[0]);
           return ARGS_HELP;
@@ -106,7 +140,8 @@ cmdline_result_t process_cmdline_args(int argc, const char* argv[],
 
   size_t target_dir_len = strlen(target_dir);
   const size_t output_name_len = strlen(output_name);
-  const size_t path_length = target_dir_len + output_name_len + 3;
+  const size_t path_length =
+      target_dir_len + output_name_len + sizeof("/.h");
   config->output_header_path = malloc(path_length);
   config->output_impl_path = malloc(path_length);
   memcpy(config->output_header_path, target_dir, target_dir_len);
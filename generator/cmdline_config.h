@@ -2,6 +2,7 @@
 #define LIBHEROES_CMDLINE_CONFIG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct {
   char *output_impl_path;
@@ -11,6 +12,10 @@ typedef struct {
   const char *input_file_path;
   const char *input_file_name;
   int first_clang_param;
+  /* size of the stack loading runs on, 0 for the calling thread's stack. */
+  size_t stack_size;
+  /* YAML file to embed as constant of the root type, NULL for none. */
+  const char *embed_path;
 } cmdline_config_t;
 
 typedef enum {
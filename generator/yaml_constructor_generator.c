@@ -8,6 +8,9 @@
 #include <clang-c/Index.h>
 #include <assert.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <yaml.h>
 
 #include "cmdline_config.h"
 
@@ -100,6 +103,83 @@ typedef struct {
    * constructor and destructor must be declared in the input.
    */
   bool custom;
+  /*
+   * Type is custom and the user has declared a dumper for it.
+   */
+  bool custom_dumper;
+  /*
+   * Type is custom and the user has declared hash and equality functions for
+   * it.
+   */
+  bool custom_hash;
+  /*
+   * Type is a string view, i.e. a struct that has a ptr and a len field and
+   * refers to the scalar's bytes inside the input instead of owning a copy.
+   */
+  bool view;
+  /*
+   * Type is a stream, i.e. a list whose items are not stored but handed to a
+   * user-defined handler one at a time. Implies list.
+   */
+  bool stream;
+  /*
+   * Entity is a pointer whose target is not constructed during loading.
+   * Instead, the position of its subtree is recorded, and the target is
+   * constructed on demand by the type's yaml_force_ function.
+   */
+  bool lazy;
+  /*
+   * Type is the target of at least one !lazy field, so a yaml_force_ function
+   * must be generated for it.
+   */
+  bool lazy_target;
+  /*
+   * Entity is a pointer whose target is reference counted, so that aliases
+   * resolve to the value constructed for their anchor instead of a copy.
+   */
+  bool shared;
+  /*
+   * Type is deduplicated, i.e. values of pointer fields to it are shared, and
+   * a newly constructed value is replaced by an equal one that has been
+   * constructed before in the same document.
+   */
+  bool dedup;
+  /*
+   * Type is the target of at least one shared field, so a descriptor of type
+   * yaml_loader_shared_type_t must be generated for it.
+   */
+  bool shared_target;
+  /*
+   * Type has been checked to be hashable, since a !dedup type contains it.
+   */
+  bool dedup_checked;
+  /*
+   * Type refers to the input or the loader, since it is a view or contains
+   * views or !lazy fields. Values of such types are not handed over as a
+   * whole by yaml_reload_ functions, since the old input may be gone.
+   */
+  bool input_bound;
+  /*
+   * Type is reached by the root's yaml_reload_ function, so a reconcile_
+   * function must be generated for it.
+   */
+  bool reconciled;
+  /*
+   * Type is reached by the root's yaml_load_into_ function, so a recycle_
+   * function must be generated for it.
+   */
+  bool recycled;
+  /*
+   * Type is the target of at least one pointer field that is neither !shared
+   * nor a string, nor targets a !dedup type.
+   */
+  bool pointer_target;
+  /*
+   * Code is generated with -s, so lists of the type and pointers to it defer
+   * deallocating their values with yaml_constructor_free_deferred. A
+   * destroy_ function is generated for the type if it is a pointer target.
+   */
+  bool deferred;
   /*
    * Type has a default value, i.e. it is allowed to leave out a value for a
    * field of this type, and that field will then take the default value.
@@ -116,10 +196,28 @@ typedef struct {
 #define CONVERTER_PREAMBLE "static bool"
 #define DESTRUCTOR_PREAMBLE "void"
 #define LOADER_PREFIX "yaml_load_"
+#define NEXT_LOADER_PREFIX "yaml_load_next_"
+#define ALL_LOADER_PREFIX "yaml_load_all_"
+#define BATCH_LOADER_PREFIX "yaml_load_batch_"
+#define PUSH_LOADER_PREFIX "yaml_push_"
+#define STEP_LOADER_PREFIX "yaml_start_"
 #define DEALLOCATOR_PREFIX "yaml_free_"
 #define CONSTRUCTOR_PREFIX "yaml_construct_"
 #define CONVERTER_PREFIX "convert_to_"
 #define DESTRUCTOR_PREFIX "yaml_delete_"
+#define HANDLER_PREFIX "yaml_handle_"
+#define FORCE_PREFIX "yaml_force_"
+#define EMBEDDED_PREFIX "yaml_embedded_"
+#define DUMPER_PREAMBLE "bool"
+#define DUMPER_PREFIX "yaml_dump_"
+#define HASH_PREFIX "yaml_hash_"
+#define EQUAL_PREFIX "yaml_equal_"
+#define SHARED_TYPE_PREFIX "shared_"
+#define RELEASE_PREFIX "release_"
+#define RECONCILE_PREFIX "reconcile_"
+#define RELOADER_PREFIX "yaml_reload_"
+#define RECYCLE_PREFIX "recycle_"
+#define INTO_LOADER_PREFIX "yaml_load_into_"
 
 /*
  * Describes a type of an entity, like a struct field. In addition to the
@@ -273,7 +371,12 @@ typedef enum {
   ANN_IGNORED = 7,
   ANN_CUSTOM = 8,
   ANN_DEFAULT = 9,
-  ANN_ENUM_END = 10
+  ANN_VIEW = 10,
+  ANN_STREAM = 11,
+  ANN_LAZY = 12,
+  ANN_SHARED = 13,
+  ANN_DEDUP = 14,
+  ANN_ENUM_END = 15
 } annotation_kind_t;
 
 /*
@@ -293,6 +396,38 @@ typedef struct {
   size_t count, capacity;
 } names_list_t;
 
+// ------- Embedding documents ---------
+
+/*
+ * Growing string holding an initializer while it is rendered.
+ */
+typedef struct {
+  char *data;
+  size_t count, capacity;
+} embed_buffer_t;
+
+/*
+ * State for rendering a YAML document as C initializers.
+ */
+typedef struct {
+  /*
+   * The document being embedded, and the path it has been read from.
+   */
+  yaml_document_t document;
+  char const *path;
+  types_list_t const *types_list;
+  /*
+   * File the static objects referenced by the initializer are written to.
+   * Objects are numbered by the order they are written in.
+   */
+  FILE *out;
+  size_t objects;
+  /*
+   * Current nesting depth. Limited since aliases may form cycles.
+   */
+  size_t depth;
+} embed_info_t;
+
 // ---- States for discovering types ----
 
 /*
@@ -304,9 +439,26 @@ typedef struct {
    */
   types_list_t *list;
   /*
-   * List of discovered names of custom constructors and destructors
+   * List of discovered names of custom constructors, destructors, dumpers,
+   * hash and equality functions, and of handlers for stream items
    */
-  names_list_t constructor_names, destructor_names;
+  names_list_t constructor_names, destructor_names, dumper_names,
+      hash_names, equal_names, handler_names;
+  /*
+   * Spellings of the canonical types of the items the handlers take, in the
+   * order of handler_names.
+   */
+  names_list_t handler_items;
+  /*
+   * List of the names of types targeted by !lazy fields.
+   */
+  names_list_t lazy_targets;
+  /*
+   * List of the names of types targeted by !shared fields, and by other
+   * pointer fields that are neither !lazy nor strings. The latter are shared
+   * if their target is !dedup.
+   */
+  names_list_t shared_targets, pointer_targets;
   /*
    * The last discovered type. Used to discover that a following typedef
    * contains the recent type's definition. In that case, a possible annotation
@@ -327,6 +479,13 @@ typedef struct {
   CXType data_type;
 } list_info_t;
 
+/*
+ * State for discovering information on a view struct.
+ */
+typedef struct {
+  bool seen_ptr, seen_len, seen_error;
+} view_info_t;
+
 /*
  * Current state of tagged union discovery
  */
@@ -352,11 +511,13 @@ typedef struct {
 
 static char const *const annotation_names[] = {
     "", "string", "list", "tagged", "repr", "optional", "optional_string",
-    "ignored", "custom", "default"
+    "ignored", "custom", "default", "view", "stream", "lazy", "shared",
+    "dedup"
 };
 
 static bool const annotation_has_param[] = {
-    false, false, false, false, true, false, false, false, false
+    false, false, false, false, true, false, false, false, false, false, false,
+    false, false, false, false
 };
 
 /*
@@ -377,6 +538,36 @@ static void print_error(CXCursor const cursor, char const *const message, ...) {
   va_end(args);
 }
 
+/*
+ * Returns the declaration of the given type, looking through typedefs, so
+ * that the fields of a typedef'd anonymous struct can be visited.
+ */
+static CXCursor type_declaration(CXType const type) {
+  return clang_getTypeDeclaration(clang_getCanonicalType(type));
+}
+
+/*
+ * Returns the spelling under which the given field type is found in the
+ * types list. size_t is looked up by its own name, so that its values are
+ * passed to the runtime's size_t functions whatever its canonical type is.
+ */
+static char const *field_type_name(CXType type) {
+  CXType const canonical = clang_getCanonicalType(type);
+  while (type.kind == CXType_Elaborated || type.kind == CXType_Typedef) {
+    if (type.kind == CXType_Elaborated) {
+      type = clang_Type_getNamedType(type);
+      continue;
+    }
+    CXCursor const decl = clang_getTypeDeclaration(type);
+    if (strcmp(clang_getCString(clang_getCursorSpelling(decl)),
+               "size_t") == 0) {
+      return "size_t";
+    }
+    type = clang_getTypedefDeclUnderlyingType(decl);
+  }
+  return clang_getCString(clang_getTypeSpelling(canonical));
+}
+
 #define ANNOTATION_IS(value) !strncmp(start, annotation_names[value], \
                                       annotation_len[value]) && \
     (start[annotation_len[value]] == '\0' || \
@@ -518,11 +709,33 @@ static bool gen_type_descriptor(CXCursor const cursor, CXType const type,
     free(annotation->param);
     return false;
   }
+  if (annotation->kind == ANN_DEDUP &&
+      clang_getCanonicalType(type).kind != CXType_Record) {
+    print_error(cursor, "!dedup must be applied on a struct (found '%s').\n",
+                clang_getCString(clang_getTypeKindSpelling(type.kind)));
+    return false;
+  }
 
   result->type = type;
-  result->flags.list = (annotation->kind == ANN_LIST);
+  result->flags.list = (annotation->kind == ANN_LIST ||
+                       annotation->kind == ANN_STREAM);
+  result->flags.stream = (annotation->kind == ANN_STREAM);
   result->flags.tagged = (annotation->kind == ANN_TAGGED);
   result->flags.custom = (annotation->kind == ANN_CUSTOM);
+  result->flags.custom_dumper = false;
+  result->flags.custom_hash = false;
+  result->flags.view = (annotation->kind == ANN_VIEW);
+  result->flags.lazy = false;
+  result->flags.lazy_target = false;
+  result->flags.shared = false;
+  result->flags.dedup = (annotation->kind == ANN_DEDUP);
+  result->flags.shared_target = false;
+  result->flags.dedup_checked = false;
+  result->flags.input_bound = (annotation->kind == ANN_VIEW);
+  result->flags.reconciled = false;
+  result->flags.recycled = false;
+  result->flags.pointer_target = false;
+  result->flags.deferred = false;
   result->flags.pointer = (annotation->kind == ANN_OPTIONAL) ?
       PTR_OPTIONAL_VALUE : (annotation->kind == ANN_STRING) ? PTR_STRING_VALUE :
                            (annotation->kind == ANN_OPTIONAL_STRING) ?
@@ -541,6 +754,11 @@ static bool equal_type_descriptors(type_descriptor_t const left,
          left.flags.list == right.flags.list &&
          left.flags.tagged == right.flags.tagged &&
          left.flags.custom == right.flags.custom &&
+         left.flags.view == right.flags.view &&
+         left.flags.stream == right.flags.stream &&
+         left.flags.lazy == right.flags.lazy &&
+         left.flags.shared == right.flags.shared &&
+         left.flags.dedup == right.flags.dedup &&
          left.flags.pointer == right.flags.pointer;
 }
 
@@ -612,6 +830,41 @@ static size_t add_predefined(types_list_t *const types_list,
   }\
 } while (false)
 
+/*
+ * Check that the given handler is declared as
+ * bool yaml_handle_<list type>(<item type> *item, yaml_loader_t *loader).
+ * Return the spelling of the canonical item type, or NULL after rendering an
+ * error.
+ */
+static char const *handler_item(CXCursor const cursor) {
+  CXType const function = clang_getCursorType(cursor);
+  if (clang_getCanonicalType(clang_getResultType(function)).kind !=
+          CXType_Bool ||
+      clang_getNumArgTypes(function) != 2) {
+    print_error(cursor, "handler must take an item and a loader and return "
+                        "bool!\n");
+    return NULL;
+  }
+  CXType const item = clang_getCanonicalType(clang_getArgType(function, 0));
+  CXType const loader = clang_getArgType(function, 1);
+  CXType const loader_type = clang_getPointeeType(loader);
+  if (item.kind != CXType_Pointer ||
+      clang_isConstQualifiedType(clang_getPointeeType(item))) {
+    print_error(cursor, "first parameter of handler must be a pointer to a "
+                        "mutable item!\n");
+    return NULL;
+  }
+  if (clang_getCanonicalType(loader).kind != CXType_Pointer ||
+      clang_isConstQualifiedType(loader_type) ||
+      strcmp(clang_getCString(clang_getTypeSpelling(loader_type)),
+             "yaml_loader_t") != 0) {
+    print_error(cursor, "second parameter of handler must be of type "
+                        "yaml_loader_t*!\n");
+    return NULL;
+  }
+  return clang_getCString(clang_getTypeSpelling(clang_getPointeeType(item)));
+}
+
 /*
  * Recursively walks through the defined types and adds them to the type_info
  * given by client_data.
@@ -683,6 +936,33 @@ static enum CXChildVisitResult discover_types
               clang_getCursorKindSpelling(type_decl.kind));
           TYPE_DISCOVERY_ERROR;
         }
+        annotation_t annotation;
+        if (!get_annotation(cursor, &annotation)) TYPE_DISCOVERY_ERROR;
+        if (annotation.kind == ANN_LAZY) {
+          // the field is checked when generating its struct's constructor
+          CXType const canonical_type = clang_getCanonicalType(type);
+          if (canonical_type.kind == CXType_Pointer) {
+            char const **ptr;
+            APPEND(&type_info->lazy_targets, ptr);
+            if (ptr != NULL) (*ptr) = clang_getCString(clang_getTypeSpelling(
+                clang_getPointeeType(canonical_type)));
+          }
+        } else {
+          if (annotation.param != NULL) free(annotation.param);
+          // the field is checked when generating its struct's constructor
+          CXType const canonical_type = clang_getCanonicalType(type);
+          names_list_t *const targets =
+              annotation.kind == ANN_SHARED ? &type_info->shared_targets :
+              (annotation.kind == ANN_NONE ||
+               annotation.kind == ANN_OPTIONAL) ?
+              &type_info->pointer_targets : NULL;
+          if (targets != NULL && canonical_type.kind == CXType_Pointer) {
+            char const **ptr;
+            APPEND(targets, ptr);
+            if (ptr != NULL) (*ptr) = clang_getCString(clang_getTypeSpelling(
+                clang_getPointeeType(canonical_type)));
+          }
+        }
         break;
       }
       case CXCursor_TypedefDecl: {
@@ -751,9 +1031,34 @@ static enum CXChildVisitResult discover_types
           APPEND(&type_info->destructor_names, ptr);
           if (ptr != NULL) (*ptr) = name;
           // TODO: ensure that the function is properly typed
+        } else if (strncmp(DUMPER_PREFIX, name,
+                           sizeof(DUMPER_PREFIX) - 1) == 0) {
+          char const **ptr;
+          APPEND(&type_info->dumper_names, ptr);
+          if (ptr != NULL) (*ptr) = name;
+        } else if (strncmp(HASH_PREFIX, name,
+                           sizeof(HASH_PREFIX) - 1) == 0) {
+          char const **ptr;
+          APPEND(&type_info->hash_names, ptr);
+          if (ptr != NULL) (*ptr) = name;
+        } else if (strncmp(EQUAL_PREFIX, name,
+                           sizeof(EQUAL_PREFIX) - 1) == 0) {
+          char const **ptr;
+          APPEND(&type_info->equal_names, ptr);
+          if (ptr != NULL) (*ptr) = name;
+        } else if (strncmp(HANDLER_PREFIX, name,
+                           sizeof(HANDLER_PREFIX) - 1) == 0) {
+          char const *const item = handler_item(cursor);
+          if (item == NULL) TYPE_DISCOVERY_ERROR;
+          char const **ptr;
+          APPEND(&type_info->handler_names, ptr);
+          if (ptr != NULL) (*ptr) = name;
+          APPEND(&type_info->handler_items, ptr);
+          if (ptr != NULL) (*ptr) = item;
         } else {
-          print_error(cursor, "unsupported function (expected constructor or "
-                              "destructor): %s\n", name);
+          print_error(cursor, "unsupported function (expected constructor, "
+                              "destructor, dumper, hash, equality or "
+                              "handler): %s\n", name);
           TYPE_DISCOVERY_ERROR;
         }
         break;
@@ -770,8 +1075,127 @@ static enum CXChildVisitResult discover_types
 }
 
 /*
- * Write declarations of constructors, destructors and converters of the types
- * in the given list to the given file.
+ * Write the name of the function of the given type with the given prefix,
+ * e.g. its dumper, to the given file. The name is derived from the name of
+ * the type's constructor.
+ */
+static void put_function_name(type_descriptor_t const *const type_descriptor,
+                              char const *const prefix, FILE *const out) {
+  size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+  fprintf(out, "%s%.*s", prefix,
+          (int)(type_descriptor->constructor_name_len - prefix_len),
+          type_descriptor->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE) +
+          prefix_len);
+}
+
+/*
+ * Write the name of the dumper of the given type to the given file.
+ */
+static void put_dumper_name(type_descriptor_t const *const type_descriptor,
+                            FILE *const out) {
+  put_function_name(type_descriptor, DUMPER_PREFIX, out);
+}
+
+/*
+ * Write the declaration of the hash function of the given type to the given
+ * file, without trailing semicolon or body.
+ */
+static void put_hash_decl(type_descriptor_t const *const type_descriptor,
+                          FILE *const out) {
+  fputs("uint64_t ", out);
+  put_function_name(type_descriptor, HASH_PREFIX, out);
+  fprintf(out, "(const %s *const value, uint64_t hash)",
+          clang_getCString(clang_getTypeSpelling(type_descriptor->type)));
+}
+
+/*
+ * Write the declaration of the equality function of the given type to the
+ * given file, without trailing semicolon or body.
+ */
+static void put_equal_decl(type_descriptor_t const *const type_descriptor,
+                           FILE *const out) {
+  char const *const type_name =
+      clang_getCString(clang_getTypeSpelling(type_descriptor->type));
+  fputs("bool ", out);
+  put_function_name(type_descriptor, EQUAL_PREFIX, out);
+  fprintf(out, "(const %s *const left,\n    const %s *const right)",
+          type_name, type_name);
+}
+
+/*
+ * Returns true iff the given type is a generated struct, list or tagged union,
+ * whose values are reconciled and recycled field by field when reloading.
+ */
+static bool is_compound(type_descriptor_t const *const type_descriptor) {
+  return type_descriptor->type.kind != CXType_Unexposed &&
+         !type_descriptor->flags.custom && !type_descriptor->flags.view &&
+         !type_descriptor->flags.stream &&
+         clang_getCanonicalType(type_descriptor->type).kind == CXType_Record;
+}
+
+/*
+ * Write the declaration of the function reconciling a reloaded value of the
+ * given type with the old one to the given file, without trailing semicolon
+ * or body.
+ */
+static void put_reconcile_decl(type_descriptor_t const *const type_descriptor,
+                               FILE *const out) {
+  char const *const type_name =
+      clang_getCString(clang_getTypeSpelling(type_descriptor->type));
+  fputs("static void ", out);
+  put_function_name(type_descriptor, RECONCILE_PREFIX, out);
+  fprintf(out, "(%s *const value,\n    %s *const old, "
+          "yaml_reload_changes_t *const changes)", type_name, type_name);
+}
+
+/*
+ * Write the declaration of the function handing the allocations of a value
+ * of the given type to a loader for reuse to the given file, without
+ * trailing semicolon or body.
+ */
+static void put_recycle_decl(type_descriptor_t const *const type_descriptor,
+                             FILE *const out) {
+  fputs("static void ", out);
+  put_function_name(type_descriptor, RECYCLE_PREFIX, out);
+  fprintf(out, "(%s *const value,\n    yaml_loader_t *const loader)",
+          clang_getCString(clang_getTypeSpelling(type_descriptor->type)));
+}
+
+/*
+ * Write the declaration of the dumper of the given type to the given file,
+ * without trailing semicolon or body.
+ */
+static void put_dumper_decl(type_descriptor_t const *const type_descriptor,
+                            FILE *const out) {
+  fputs(DUMPER_PREAMBLE " ", out);
+  put_dumper_name(type_descriptor, out);
+  fprintf(out, "(const %s *const value, yaml_dumper_t *const dumper)",
+          clang_getCString(clang_getTypeSpelling(type_descriptor->type)));
+}
+
+/*
+ * Returns true iff names contains prefix followed by the given suffix.
+ */
+static bool has_suffix(names_list_t const *const names,
+                       char const *const prefix, char const *const suffix,
+                       size_t const suffix_len) {
+  size_t const prefix_len = strlen(prefix);
+  for (size_t i = 0; i < names->count; ++i) {
+    char const *const name = names->data[i] + prefix_len;
+    if (strlen(name) == suffix_len && strncmp(suffix, name, suffix_len) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// used to find the item type of streams, defined with the list generators.
+static enum CXChildVisitResult list_visitor
+    (CXCursor cursor, CXCursor parent, CXClientData client_data);
+
+/*
+ * Write declarations of constructors, destructors and dumpers of the types in
+ * the given list to the given file.
  */
 static bool write_decls(type_info_t const *const info, FILE *const out) {
   const types_list_t *list = info->list;
@@ -868,19 +1292,124 @@ static bool write_decls(type_info_t const *const info, FILE *const out) {
         }
       }
 
+      // a dumper is optional; without one, dumping the type fails.
+      size_t const suffix_len = list->data[i].constructor_name_len -
+                                (sizeof(CONSTRUCTOR_PREFIX) - 1);
+      name = list->data[i].constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE) +
+             sizeof(CONSTRUCTOR_PREFIX) - 1;
+      list->data[i].flags.custom_dumper =
+          has_suffix(&info->dumper_names, DUMPER_PREFIX, name, suffix_len);
+
+      // hash and equality functions are optional, but must come in pairs.
+      bool const has_hash = has_suffix(&info->hash_names, HASH_PREFIX,
+                                       name, suffix_len);
+      if (has_hash != has_suffix(&info->equal_names, EQUAL_PREFIX, name,
+                                 suffix_len)) {
+        print_error(clang_getTypeDeclaration(list->data[i].type),
+                    "missing %s function for custom type!\n",
+                    has_hash ? "equality" : "hash");
+        return false;
+      }
+      list->data[i].flags.custom_hash = has_hash;
+
       // don't write anything; user has declared constructor and destructor
       continue;
     }
+    if (list->data[i].flags.stream) {
+      const char *name = list->data[i].constructor_decl +
+                         sizeof(CONSTRUCTOR_PREAMBLE) +
+                         sizeof(CONSTRUCTOR_PREFIX) - 1;
+      const size_t len = list->data[i].constructor_name_len -
+                         (sizeof(CONSTRUCTOR_PREFIX) - 1);
+      int found = -1;
+      for (size_t j = 0; j < info->handler_names.count; ++j) {
+        const char *const handler =
+            info->handler_names.data[j] + sizeof(HANDLER_PREFIX) - 1;
+        if (strlen(handler) == len && strncmp(name, handler, len) == 0) {
+          found = (int)j;
+          break;
+        }
+      }
+      if (found == -1) {
+        print_error(clang_getTypeDeclaration(list->data[i].type),
+                    "missing handler for stream (expected "
+                    HANDLER_PREFIX "%.*s)!\n", (int)len, name);
+        return false;
+      }
+      list_info_t items = {.seen_error = false, .seen_capacity = false,
+                           .seen_count = false};
+      clang_visitChildren(clang_getTypeDeclaration(list->data[i].type),
+                          &list_visitor, &items);
+      if (items.seen_error) return false;
+      char const *const item = clang_getCString(clang_getTypeSpelling(
+          clang_getCanonicalType(items.data_type)));
+      if (strcmp(item, info->handler_items.data[found]) != 0) {
+        print_error(clang_getTypeDeclaration(list->data[i].type),
+                    "handler " HANDLER_PREFIX "%.*s takes %s instead of "
+                    "the stream's items (%s)!\n", (int)len, name,
+                    info->handler_items.data[found], item);
+        return false;
+      }
+    }
     fputs(list->data[i].constructor_decl, out);
     fputs(";\n", out);
     if (list->data[i].destructor_decl != NULL) {
       fputs(list->data[i].destructor_decl, out);
       fputs(";\n", out);
     }
+    put_dumper_decl(&list->data[i], out);
+    fputs(";\n", out);
   }
   return true;
 }
 
+/*
+ * Write declarations of the hash and equality functions of the types in the
+ * given list to the given file. Must be called after write_decls.
+ */
+static void write_hash_decls(types_list_t const *const list, FILE *const out) {
+  fputs("\n/* structural hash and equality of values */\n\n", out);
+  for (size_t i = 0; i < list->count; ++i) {
+    if (list->data[i].type.kind == CXType_Unexposed ||
+        list->data[i].flags.custom) {
+      // predefined types are covered by yaml_hash.h, custom types by the user.
+      continue;
+    }
+    put_hash_decl(&list->data[i], out);
+    fputs(";\n", out);
+    put_equal_decl(&list->data[i], out);
+    fputs(";\n", out);
+  }
+}
+
+/*
+ * Write declarations of the functions that construct the targets of !lazy
+ * fields to the given file.
+ */
+static void write_force_decls(types_list_t const *const list,
+                              FILE *const out) {
+  bool first = true;
+  for (size_t i = 0; i < list->count; ++i) {
+    if (!list->data[i].flags.lazy_target) continue;
+    if (first) {
+      fputs("\n/* functions constructing targets of !lazy fields on demand */"
+            "\n\n", out);
+      first = false;
+    }
+    char const *const type_name =
+        clang_getCString(clang_getTypeSpelling(list->data[i].type));
+    const char *const space = strchr(type_name, ' ');
+    if (space == NULL) {
+      fprintf(out, CONSTRUCTOR_PREAMBLE " " FORCE_PREFIX "%s(%s **const value, "
+              "yaml_loader_t *const loader);\n", type_name, type_name);
+    } else {
+      fprintf(out, CONSTRUCTOR_PREAMBLE " " FORCE_PREFIX
+              "%.*s_%s(%s **const value, yaml_loader_t *const loader);\n",
+              (int)(space - type_name), type_name, space + 1, type_name);
+    }
+  }
+}
+
 static void write_static_decls(types_list_t const *const list,
                                FILE *const out) {
   for (size_t i = 0; i < list->count; ++i) {
@@ -888,7 +1417,20 @@ static void write_static_decls(types_list_t const *const list,
       // predefined type; do not generate anything
       continue;
     } else if (list->data[i].flags.custom) {
-      // custom type; user has declared constructor and destructor.
+      // custom type; user has declared constructor and destructor. The
+      // dumper is generated if the user has not declared one.
+      if (!list->data[i].flags.custom_dumper) {
+        fputs("static ", out);
+        put_dumper_decl(&list->data[i], out);
+        fputs(";\n", out);
+      }
+      if (!list->data[i].flags.custom_hash) {
+        fputs("static ", out);
+        put_hash_decl(&list->data[i], out);
+        fputs(";\nstatic ", out);
+        put_equal_decl(&list->data[i], out);
+        fputs(";\n", out);
+      }
       continue;
     }
     char const *const type_name =
@@ -923,6 +1465,32 @@ static void write_static_decls(types_list_t const *const list,
       list->data[i].converter_decl = NULL;
       list->data[i].converter_name_len = 0;
     }
+    if (list->data[i].flags.reconciled) {
+      put_reconcile_decl(&list->data[i], out);
+      fputs(";\n", out);
+    }
+    if (list->data[i].flags.recycled) {
+      put_recycle_decl(&list->data[i], out);
+      fputs(";\n", out);
+    }
+  }
+  // destroy_ functions are defined right away, since the destructors they
+  // call have been declared in the header.
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t const *const descriptor = &list->data[i];
+    if (!descriptor->flags.deferred || !descriptor->flags.pointer_target ||
+        descriptor->destructor_decl == NULL) continue;
+    fprintf(out,
+            "\nstatic void destroy_%.*s(void *value) {\n"
+            "  %.*s((%s*)value);\n"
+            "}\n",
+            (int)(descriptor->destructor_name_len -
+                  (sizeof(DESTRUCTOR_PREFIX) - 1)),
+            descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE) +
+            sizeof(DESTRUCTOR_PREFIX) - 1,
+            (int)descriptor->destructor_name_len,
+            descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE),
+            clang_getCString(clang_getTypeSpelling(descriptor->type)));
   }
 }
 
@@ -997,6 +1565,58 @@ static enum CXChildVisitResult list_visitor
   return CXChildVisit_Continue;
 }
 
+#define VIEW_VISITOR_ERROR \
+    do {view_info->seen_error = true; return CXChildVisit_Break; } while (false)
+
+/*
+ * Collects info about a view struct into the view_info_t given by client_data.
+ */
+static enum CXChildVisitResult view_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  view_info_t *const view_info = (view_info_t*) client_data;
+  const enum CXCursorKind kind = clang_getCursorKind(cursor);
+  if (kind != CXCursor_FieldDecl) {
+    print_error(cursor, "Unexpected item in struct (expected field): %s",
+                clang_getCString(clang_getCursorKindSpelling(kind)));
+    VIEW_VISITOR_ERROR;
+  }
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  CXType const t = clang_getCanonicalType(clang_getCursorType(cursor));
+
+  annotation_t annotation;
+  if (!get_annotation(cursor, &annotation)) VIEW_VISITOR_ERROR;
+  if (annotation.kind != ANN_NONE) {
+    print_error(cursor, "view fields may not carry annotations!\n");
+    if (annotation_has_param[annotation.kind]) free(annotation.param);
+    VIEW_VISITOR_ERROR;
+  }
+
+  if (!strcmp(name, "ptr")) {
+    // plain char is unsigned on some targets.
+    enum CXTypeKind const pointee = clang_getPointeeType(t).kind;
+    if (t.kind != CXType_Pointer ||
+        (pointee != CXType_Char_S && pointee != CXType_Char_U)) {
+      print_error(cursor, "ptr field of view must be a char pointer!\n");
+      VIEW_VISITOR_ERROR;
+    }
+    view_info->seen_ptr = true;
+  } else if (!strcmp(name, "len")) {
+    if (t.kind != CXType_UChar && t.kind != CXType_UShort &&
+        t.kind != CXType_UInt && t.kind != CXType_ULong &&
+        t.kind != CXType_ULongLong) {
+      print_error(cursor, "\"len\" field must be an unsigned type!\n");
+      VIEW_VISITOR_ERROR;
+    }
+    view_info->seen_len = true;
+  } else {
+    print_error(cursor, "illegal field \"%s\" for view!\n", name);
+    VIEW_VISITOR_ERROR;
+  }
+  return CXChildVisit_Continue;
+}
+
 /*
  * render the call to the destructor of the given type and return it as string.
  * The subject shall contain the expression referencing the value to destruct.
@@ -1010,7 +1630,38 @@ static char *render_destructor_call
      char const *const subject, bool const is_ref) {
   size_t chars_needed = 1; // terminator
   size_t const subject_len = strlen(subject);
-  if (type_descriptor->destructor_decl != NULL) {
+  if (type_descriptor->flags.shared) {
+    // the last reference destroys the value.
+    char *const ret = malloc(sizeof("if ( != NULL && "
+                                    "yaml_constructor_shared_release()) {"
+                                    "(); yaml_constructor_shared_free();}") +
+                             subject_len * 4 +
+                             type_descriptor->destructor_name_len);
+    char *cur = ret;
+    if (type_descriptor->flags.pointer == PTR_OPTIONAL_VALUE) {
+      cur += sprintf(cur, "if (%s != NULL && ", subject);
+    } else cur += sprintf(cur, "if (");
+    cur += sprintf(cur, "yaml_constructor_shared_release(%s)) {", subject);
+    if (type_descriptor->destructor_decl != NULL) {
+      cur += sprintf(cur, "%.*s(%s);",
+          (int)type_descriptor->destructor_name_len,
+          type_descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE),
+          subject);
+    }
+    sprintf(cur, "yaml_constructor_shared_free(%s);}", subject);
+    return ret;
+  }
+  // the target of a deferred pointer is destroyed by its destroy_ function.
+  bool const deferred = type_descriptor->flags.deferred &&
+      type_descriptor->flags.pointer_target &&
+      type_descriptor->flags.pointer != PTR_NONE &&
+      type_descriptor->destructor_decl != NULL;
+  if (deferred) {
+    chars_needed += sizeof("yaml_constructor_free_deferred(, 1, 0, "
+                           "&destroy_);") - 1 + subject_len +
+                    type_descriptor->destructor_name_len -
+                    (sizeof(DESTRUCTOR_PREFIX) - 1);
+  } else if (type_descriptor->destructor_decl != NULL) {
     chars_needed += type_descriptor->destructor_name_len + subject_len + 4;
   }
   if (type_descriptor->flags.pointer != PTR_NONE) {
@@ -1021,29 +1672,109 @@ static char *render_destructor_call
     }
   }
   if (chars_needed == 1) return NULL;
+  if (type_descriptor->flags.lazy) {
+    chars_needed += sizeof("if (yaml_constructor_is_lazy()) "
+                           "yaml_constructor_lazy_free(); else {}") - 1 +
+                    subject_len * 2;
+  }
   char *const ret = malloc(chars_needed);
   char *cur = ret;
+  if (type_descriptor->flags.lazy) {
+    cur += sprintf(cur, "if (yaml_constructor_is_lazy(%s)) "
+                        "yaml_constructor_lazy_free(%s); else {",
+                   subject, subject);
+  }
   if (type_descriptor->flags.pointer == PTR_OPTIONAL_VALUE ||
       type_descriptor->flags.pointer == PTR_OPTIONAL_STRING_VALUE) {
     cur += sprintf(cur, "if (%s != NULL) {", subject);
   }
-  if (type_descriptor->destructor_decl != NULL) {
-    cur += sprintf(cur, "%.*s(%s%s);",
-        (int)type_descriptor->destructor_name_len,
-        type_descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE),
-        (type_descriptor->flags.pointer != PTR_NONE || is_ref) ? "" : "&",
-                   subject);
-  }
-  if (type_descriptor->flags.pointer != PTR_NONE) {
-    cur += sprintf(cur, "free(%s);", subject);
+  if (deferred) {
+    cur += sprintf(cur, "yaml_constructor_free_deferred(%s, 1, 0, "
+                        "&destroy_%.*s);", subject,
+        (int)(type_descriptor->destructor_name_len -
+              (sizeof(DESTRUCTOR_PREFIX) - 1)),
+        type_descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE) +
+        sizeof(DESTRUCTOR_PREFIX) - 1);
+  } else {
+    if (type_descriptor->destructor_decl != NULL) {
+      cur += sprintf(cur, "%.*s(%s%s);",
+          (int)type_descriptor->destructor_name_len,
+          type_descriptor->destructor_decl + sizeof(DESTRUCTOR_PREAMBLE),
+          (type_descriptor->flags.pointer != PTR_NONE || is_ref) ? "" : "&",
+                     subject);
+    }
+    if (type_descriptor->flags.pointer != PTR_NONE) {
+      cur += sprintf(cur, "free(%s);", subject);
+    }
   }
   if (type_descriptor->flags.pointer == PTR_OPTIONAL_VALUE ||
       type_descriptor->flags.pointer == PTR_OPTIONAL_STRING_VALUE) {
+    cur += sprintf(cur, "}");
+  }
+  if (type_descriptor->flags.lazy) {
     /*cur +=*/ sprintf(cur, "}");
   }
   return ret;
 }
 
+/*
+ * Generate the constructor body and the destructor for the given stream. The
+ * constructor's declaration has already been written.
+ */
+static void gen_stream_impls(type_descriptor_t const *const type_descriptor,
+                             type_descriptor_t const *const inner_type,
+                             char const *const complete_name,
+                             FILE *const out) {
+  fprintf(out,
+          "  if (!yaml_constructor_check_event_type(loader, cur, "
+          "YAML_SEQUENCE_START_EVENT))\n"
+          "    return false;\n"
+          "  value->data = NULL;\n"
+          "  value->count = 0;\n"
+          "  value->capacity = 0;\n"
+          "  yaml_event_t event;\n"
+          "  if (!yaml_loader_next_event(loader, &event)) {\n"
+          "    yaml_loader_event_delete(loader, cur);\n"
+          "    return false;\n"
+          "  }\n"
+          "  while (event.type != YAML_SEQUENCE_END_EVENT) {\n"
+          "    %s item;\n"
+          "    if (!%.*s(&item, loader, &event)) {\n"
+          "      yaml_loader_event_delete(loader, cur);\n"
+          "      return false;\n"
+          "    }\n"
+          "    bool const handled = " HANDLER_PREFIX "%.*s(&item, loader);\n",
+          complete_name, (int)inner_type->constructor_name_len,
+          inner_type->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE),
+          (int)(type_descriptor->constructor_name_len -
+                (sizeof(CONSTRUCTOR_PREFIX) - 1)),
+          type_descriptor->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE) +
+          sizeof(CONSTRUCTOR_PREFIX) - 1);
+  char *const item_destructor_call =
+      render_destructor_call(inner_type, "item", false);
+  if (item_destructor_call != NULL) {
+    fprintf(out, "    %s\n", item_destructor_call);
+    free(item_destructor_call);
+  }
+  fputs("    if (!handled) {\n"
+        "      loader->error_info.type = YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR;\n"
+        "      loader->error_info.event = event;\n"
+        "      yaml_loader_event_delete(loader, cur);\n"
+        "      return false;\n"
+        "    }\n"
+        "    value->count++;\n"
+        "    yaml_loader_event_delete(loader, &event);\n"
+        "    if (!yaml_loader_next_event(loader, &event)) {\n"
+        "      yaml_loader_event_delete(loader, cur);\n"
+        "      return false;\n"
+        "    }\n"
+        "  }\n"
+        "  yaml_loader_event_delete(loader, &event);\n"
+        "  return true;\n}\n", out);
+  fprintf(out, "%s {\n"
+               "  (void)value;\n}\n", type_descriptor->destructor_decl);
+}
+
 /*
  * Generate constructor and destructior implementations for the given list.
  */
@@ -1051,7 +1782,6 @@ bool gen_list_impls(type_descriptor_t const *const type_descriptor,
                     types_list_t const *const types_list,
                     FILE *const out) {
   CXCursor const decl = clang_getTypeDeclaration(type_descriptor->type);
-  fprintf(out, "\n%s {\n", type_descriptor->constructor_decl);
   list_info_t info = {.seen_error = false, .seen_capacity = false,
                       .seen_count = false};
   info.data_type.kind = CXType_Unexposed;
@@ -1080,49 +1810,105 @@ bool gen_list_impls(type_descriptor_t const *const type_descriptor,
   }
   type_descriptor_t const *const inner_type =
       &types_list->data[type_index];
+  if (type_descriptor->flags.stream) {
+    fprintf(out, "\n%s {\n", type_descriptor->constructor_decl);
+    gen_stream_impls(type_descriptor, inner_type, complete_name, out);
+    return true;
+  }
+
+  // functions for constructing items on worker threads.
+  int const suffix_len = (int)(type_descriptor->constructor_name_len -
+                               (sizeof(CONSTRUCTOR_PREFIX) - 1));
+  char const *const suffix = type_descriptor->constructor_decl +
+      sizeof(CONSTRUCTOR_PREAMBLE) + sizeof(CONSTRUCTOR_PREFIX) - 1;
+  fprintf(out,
+          "\nstatic bool construct_item_%.*s(void *item, "
+          "yaml_loader_t *loader,\n"
+          "    yaml_event_t *cur) {\n"
+          "  return %.*s((%s*)item, loader, cur);\n"
+          "}\n", suffix_len, suffix, (int)inner_type->constructor_name_len,
+          inner_type->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE),
+          complete_name);
+  fprintf(out,
+          "\nstatic void delete_item_%.*s(void *item) {\n"
+          "  %s *const typed = (%s*)item;\n", suffix_len, suffix,
+          complete_name, complete_name);
+  char *const item_destructor_call =
+      render_destructor_call(inner_type, "(*typed)", false);
+  if (item_destructor_call != NULL) {
+    fprintf(out, "  %s\n", item_destructor_call);
+    free(item_destructor_call);
+  } else fputs("  (void)typed;\n", out);
+  fputs("}\n", out);
+
+  fprintf(out, "\n%s {\n", type_descriptor->constructor_decl);
 
   fprintf(out,
           "  if (!yaml_constructor_check_event_type(loader, cur, "
           "YAML_SEQUENCE_START_EVENT))\n"
           "    return false;\n"
-          "  value->data = malloc(16 * sizeof(%s));\n"
+          "  size_t const length = yaml_loader_sequence_length(loader, cur);\n"
+          "  value->capacity = length > 0 ? length : 16;\n"
+          "  if (!yaml_constructor_check_items(loader, cur, length) ||\n"
+          "      !yaml_constructor_reserve(loader, cur,\n"
+          "                                value->capacity * sizeof(%s)))\n"
+          "    return false;\n"
+          "  value->data = yaml_loader_alloc(loader, value->capacity * "
+          "sizeof(%s));\n"
           "  if (value->data == NULL) {\n"
           "    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-          "    yaml_event_delete(cur);\n"
+          "    yaml_loader_event_delete(loader, cur);\n"
           "    return false;\n"
           "  }\n"
           "  value->count = 0;\n"
-          "  value->capacity = 16;\n"
+          "  if (yaml_loader_parallel(loader, cur)) {\n"
+          "    if (!yaml_loader_construct_items(loader, value->data, "
+          "sizeof(%s),\n"
+          "        &construct_item_%.*s, &delete_item_%.*s)) {\n"
+          "      free(value->data);\n"
+          "      yaml_loader_event_delete(loader, cur);\n"
+          "      return false;\n"
+          "    }\n"
+          "    value->count = length;\n"
+          "    return true;\n"
+          "  }\n"
           "  yaml_event_t event;\n"
-          "  if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "    loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "    yaml_event_delete(cur);\n"
+          "  if (!yaml_loader_next_event(loader, &event)) {\n"
+          "    yaml_loader_event_delete(loader, cur);\n"
           "    return false;\n"
           "  }\n"
           "  while (event.type != YAML_SEQUENCE_END_EVENT) {\n"
-          "    %s *item;\n"
-          "    YAML_CONSTRUCTOR_APPEND(value, item);\n"
+          "    %s *item = NULL;\n"
           "    bool ret = false;\n"
-          "    if (item == NULL) {\n"
-          "      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-          "      yaml_event_delete(cur);\n"
+          "    if (!yaml_constructor_check_items(loader, cur, value->count + 1) ||\n"
+          "        (value->count == value->capacity &&\n"
+          "         !yaml_constructor_reserve(loader, cur,\n"
+          "             value->capacity * 2 * sizeof(%s)))) {\n"
+          "      yaml_loader_event_delete(loader, &event);\n"
           "    } else {\n"
-          "      ret = %.*s(item, loader, &event);\n"
-          "      if (!ret) {\n"
-          "        value->count--;\n"
-          "        yaml_event_delete(cur);\n"
+          "      YAML_CONSTRUCTOR_LOADER_APPEND(loader, value, item);\n"
+          "      if (item == NULL) {\n"
+          "        loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
+          "        yaml_loader_event_delete(loader, cur);\n"
+          "      } else {\n"
+          "        ret = %.*s(item, loader, &event);\n"
+          "        if (!ret) {\n"
+          "          value->count--;\n"
+          "          yaml_loader_event_delete(loader, cur);\n"
+          "        }\n"
           "      }\n"
           "    }\n"
-          "    if (ret) {\n"
-          "      yaml_event_delete(&event);\n"
-          "      if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "        loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "        yaml_event_delete(cur);\n"
+          "    if (YAML_CONSTRUCTOR_LIKELY(ret)) {\n"
+          "      yaml_loader_event_delete(loader, &event);\n"
+          "      if (YAML_CONSTRUCTOR_UNLIKELY(\n"
+          "          !yaml_loader_next_event(loader, &event))) {\n"
+          "        yaml_loader_event_delete(loader, cur);\n"
           "        ret = false;\n"
           "      }\n"
           "    }\n"
-          "    if (!ret) {\n",
-          complete_name, complete_name,
+          "    if (YAML_CONSTRUCTOR_UNLIKELY(!ret)) {\n",
+          complete_name, complete_name, complete_name, suffix_len, suffix,
+          suffix_len, suffix, complete_name, complete_name,
           (int)inner_type->constructor_name_len,
           inner_type->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE));
   char *const destructor_call =
@@ -1134,11 +1920,20 @@ bool gen_list_impls(type_descriptor_t const *const type_descriptor,
   fputs("      return false;\n"
         "    }\n"
         "  }\n"
-        "  yaml_event_delete(&event);\n"
+        "  yaml_loader_event_delete(loader, &event);\n"
         "  return true;\n}\n", out);
 
   if (type_descriptor->type.kind != CXType_Unexposed) {
     fprintf(out, "%s {\n", type_descriptor->destructor_decl);
+    if (type_descriptor->flags.deferred &&
+        inner_type->type.kind != CXType_Unexposed) {
+      fprintf(out,
+              "  if (value->data != NULL) {\n"
+              "    yaml_constructor_free_deferred(value->data, value->count,\n"
+              "        sizeof(%s), &delete_item_%.*s);\n"
+              "  }\n}\n", complete_name, suffix_len, suffix);
+      return true;
+    }
     if (inner_type->type.kind != CXType_Unexposed) {
       fputs("  for(size_t i = 0; i < value->count; ++i) {\n", out);
       char *const inner_destructor_call =
@@ -1155,10 +1950,41 @@ bool gen_list_impls(type_descriptor_t const *const type_descriptor,
 }
 
 /*
- * Render a call to the given constructor, deserializing a value into the given
- * field, using the given event as starting point.
- *
- * The return value shall be deallocated by the caller.
+ * Generate constructor and destructor implementations for the given view.
+ */
+bool gen_view_impls(type_descriptor_t const *const type_descriptor,
+                    FILE *const out) {
+  CXCursor const decl = clang_getTypeDeclaration(type_descriptor->type);
+  view_info_t info = {.seen_ptr = false, .seen_len = false,
+                      .seen_error = false};
+  clang_visitChildren(decl, &view_visitor, &info);
+  if (info.seen_error) return false;
+  if (!info.seen_ptr) {
+    print_error(decl, "ptr field for view missing!\n");
+    return false;
+  }
+  if (!info.seen_len) {
+    print_error(decl, "len field for view missing!\n");
+    return false;
+  }
+
+  fprintf(out, "\n%s {\n", type_descriptor->constructor_decl);
+  fputs("  char const *ptr;\n"
+        "  size_t len;\n"
+        "  if (!yaml_construct_view(&ptr, &len, loader, cur)) return false;\n"
+        "  value->ptr = ptr;\n"
+        "  value->len = len;\n"
+        "  return true;\n}\n", out);
+  fprintf(out, "%s {\n"
+               "  (void)value;\n}\n", type_descriptor->destructor_decl);
+  return true;
+}
+
+/*
+ * Render a call to the given constructor, deserializing a value into the given
+ * field, using the given event as starting point.
+ *
+ * The return value shall be deallocated by the caller.
  */
 static char *new_deserialization
     (const char *const field, char const *const constructor,
@@ -1211,6 +2037,8 @@ static enum describe_field_result_t describe_field
   ptr_kind pointer_kind = PTR_OBJECT_POINTER;
   ptr_kind str_pointer_kind = PTR_STRING_VALUE;
   bool should_have_default = false;
+  bool lazy = false;
+  bool shared = false;
   switch (annotation.kind) {
     case ANN_IGNORED: return IGNORED;
     case ANN_OPTIONAL_STRING:
@@ -1239,6 +2067,18 @@ static enum describe_field_result_t describe_field
       } else {
         ret->flags.list = false;
         ret->flags.tagged = false;
+        ret->flags.view = false;
+        ret->flags.stream = false;
+        ret->flags.lazy = false;
+        ret->flags.shared = false;
+        ret->flags.dedup = false;
+        ret->flags.shared_target = false;
+        ret->flags.dedup_checked = true;
+        ret->flags.input_bound = false;
+        ret->flags.reconciled = false;
+        ret->flags.recycled = false;
+        ret->flags.pointer_target = false;
+        ret->flags.deferred = false;
         ret->flags.default_value = NO_DEFAULT;
         ret->flags.pointer = str_pointer_kind;
         ret->constructor_decl = NULL;
@@ -1265,6 +2105,20 @@ static enum describe_field_result_t describe_field
       }
       pointer_kind = PTR_OPTIONAL_VALUE;
       break;
+    case ANN_LAZY:
+      if (t.kind != CXType_Pointer) {
+        print_error(cursor, "!lazy must be applied on a pointer type.");
+        return ERROR;
+      }
+      lazy = true;
+      break;
+    case ANN_SHARED:
+      if (t.kind != CXType_Pointer) {
+        print_error(cursor, "!shared must be applied on a pointer type.");
+        return ERROR;
+      }
+      shared = true;
+      break;
     case ANN_NONE:
       break;
     default:
@@ -1279,27 +2133,39 @@ static enum describe_field_result_t describe_field
       print_error(cursor, "pointer to pointer not supported.");
       return ERROR;
     }
-    char const *const type_name = clang_getCString(
-        clang_getTypeSpelling(pointee));
+    CXType const declared = clang_getCursorType(cursor);
+    char const *const type_name = field_type_name(
+        declared.kind == CXType_Pointer ? clang_getPointeeType(declared) :
+                                          pointee);
     int const type_index = find(&types_list->names, type_name);
     if (type_index == -1) {
       print_error(cursor, "Unknown type: %s\n", type_name);
       return ERROR;
     }
     *ret = types_list->data[type_index];
+    if (lazy && (ret->type.kind == CXType_Unexposed ||
+                 clang_getCanonicalType(ret->type).kind != CXType_Record)) {
+      print_error(cursor, "!lazy must be applied on a pointer to a struct "
+                          "(found pointer to '%s').\n", type_name);
+      return ERROR;
+    }
     ret->flags.pointer = pointer_kind;
+    ret->flags.lazy = lazy;
+    // values of !dedup types are shared unless constructed lazily.
+    ret->flags.shared = shared || (ret->flags.dedup && !lazy);
     ret->flags.default_value = NO_DEFAULT;
     ret->spelling = type_name;
     return ADDED;
   } else {
-    char const *const type_name =
-        clang_getCString(clang_getTypeSpelling(t));
+    char const *const type_name = field_type_name(clang_getCursorType(cursor));
     int const type_index = find(&types_list->names, type_name);
     if (type_index == -1) {
       print_error(cursor, "Unknown type: %s\n", type_name);
       return ERROR;
     }
     *ret = types_list->data[type_index];
+    ret->flags.lazy = false;
+    ret->flags.shared = false;
     if (should_have_default) {
       switch (t.kind) {
         case CXType_UChar:
@@ -1363,8 +2229,83 @@ static char *gen_field_deserialization
           gen_deserialization(name, descriptor, event_ref);
       if (value_deserialization == NULL) return NULL;
       size_t const value_deser_len = strlen(value_deserialization);
+      if (descriptor->flags.lazy) {
+        static char const lazy_templ[] =
+            "if (yaml_constructor_can_defer(loader)) {\n"
+            "            void *lazy;\n"
+            "            ret = yaml_construct_lazy(&lazy, loader, %s);\n"
+            "            if (ret) value->%s = lazy;\n"
+            "          } else {\n"
+            "            value->%s = malloc(sizeof(%s));\n            %s"
+            "            if (!ret) free(value->%s);\n"
+            "          }\n";
+        size_t const full_len = sizeof(lazy_templ) - 12 + value_deser_len +
+                                strlen(event_ref) + strlen(name) * 3 +
+                                strlen(descriptor->spelling);
+        char *const buffer = malloc(full_len);
+        sprintf(buffer, lazy_templ, event_ref, name, name,
+                descriptor->spelling, value_deserialization, name);
+        free(value_deserialization);
+        return buffer;
+      }
+      if (descriptor->flags.shared) {
+        // the anchor is recorded once the value is complete, so aliases
+        // cannot form cycles. a deduplicated value is anchored as the value
+        // it has been replaced with.
+        static char const shared_templ[] =
+            "if ((%s)->type == YAML_ALIAS_EVENT) {\n"
+            "            void *shared;\n"
+            "            ret = yaml_construct_alias(&shared, &" SHARED_TYPE_PREFIX
+            "%.*s,\n"
+            "                                       loader, %s);\n"
+            "            if (ret) value->%s = shared;\n"
+            "          } else {\n"
+            "            void *shared;\n"
+            "            ret = yaml_constructor_shared_alloc(&shared, sizeof(%s),\n"
+            "                                                loader, %s);\n"
+            "            if (ret) {\n"
+            "              value->%s = shared;\n              %s"
+            "              if (!ret) yaml_constructor_shared_free(shared);\n"
+            "              else {\n%s"
+            "                if (!yaml_constructor_anchor(loader, %s, shared,\n"
+            "                                             &" SHARED_TYPE_PREFIX
+            "%.*s)) {\n"
+            "                  " RELEASE_PREFIX "%.*s(shared);\n"
+            "                  ret = false;\n"
+            "                }\n"
+            "              }\n"
+            "            }\n"
+            "          }\n";
+        static char const dedup_templ[] =
+            "                shared = yaml_constructor_dedup(loader, shared,\n"
+            "                    &" SHARED_TYPE_PREFIX "%.*s);\n"
+            "                value->%s = shared;\n";
+        size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+        int const suffix_len =
+            (int)(descriptor->constructor_name_len - prefix_len);
+        char const *const suffix = descriptor->constructor_decl +
+            sizeof(CONSTRUCTOR_PREAMBLE) + prefix_len;
+        char *dedup = NULL;
+        if (descriptor->flags.dedup) {
+          dedup = malloc(sizeof(dedup_templ) + (size_t)suffix_len +
+                         strlen(name));
+          sprintf(dedup, dedup_templ, suffix_len, suffix, name);
+        }
+        char const *const spelling = descriptor->spelling;
+        size_t const full_len = sizeof(shared_templ) + value_deser_len +
+            strlen(event_ref) * 4 + strlen(name) * 2 + strlen(spelling) +
+            (size_t)suffix_len * 3 + (dedup == NULL ? 0 : strlen(dedup));
+        char *const buffer = malloc(full_len);
+        sprintf(buffer, shared_templ, event_ref, suffix_len, suffix, event_ref,
+                name, spelling, event_ref, name, value_deserialization,
+                dedup == NULL ? "" : dedup, event_ref, suffix_len, suffix,
+                suffix_len, suffix);
+        free(dedup);
+        free(value_deserialization);
+        return buffer;
+      }
       static char const malloc_templ[] =
-          "value->%s = malloc(sizeof(%s));\n          %s"
+          "value->%s = yaml_loader_alloc(loader, sizeof(%s));\n          %s"
           "          if (!ret) free(value->%s);\n";
       size_t const full_len = sizeof(malloc_templ) - 8 + value_deser_len +
                               strlen(name) * 2 + strlen(descriptor->spelling);
@@ -1528,36 +2469,21 @@ static enum CXChildVisitResult tagged_visitor
             "      loader->error_info.expected_event_type = YAML_SCALAR_EVENT;\n"
             "      return false;\n"
             "  }\n"
-            "  if (tag == NULL || tag[0] != '!' || tag[1] == '\\0') {\n"
-            "    loader->error_info.expected = malloc(sizeof(typename));\n"
-            "    if (loader->error_info.expected == NULL) {\n"
-            "      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-            "      yaml_event_delete(cur);\n"
-            "    } else {\n"
-            "      loader->error_info.type = YAML_LOADER_ERROR_TAG;\n"
-            "      memcpy(loader->error_info.expected, typename,"
-            "             sizeof(typename));\n"
-            "      loader->error_info.event = *cur;\n"
-            "    }\n"
-            "    return false;\n"
+            "  if (YAML_CONSTRUCTOR_UNLIKELY(\n"
+            "      tag == NULL || tag[0] != '!' || tag[1] == '\\0')) {\n"
+            "    return yaml_constructor_error(loader, cur, "
+            "YAML_LOADER_ERROR_TAG,\n"
+            "                                  typename);\n"
             "  }\n", info->out);
       fprintf(info->out,
               "  bool res = %.*s((const char*)(tag + 1), &value->%s);\n",
               (int)enum_descriptor->converter_name_len,
               enum_descriptor->converter_decl + sizeof(CONVERTER_PREAMBLE),
               info->field_name);
-      fputs("  if (!res) {\n"
-            "    loader->error_info.expected = malloc(sizeof(typename));\n"
-            "    if (loader->error_info.expected == NULL) {\n"
-            "      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-            "      yaml_event_delete(cur);\n"
-            "    } else {\n"
-            "      loader->error_info.type = YAML_LOADER_ERROR_TAG;\n"
-            "      memcpy(loader->error_info.expected, typename,"
-            "             sizeof(typename));\n"
-            "      loader->error_info.event = *cur;\n"
-            "    }\n"
-            "    return false;\n"
+      fputs("  if (YAML_CONSTRUCTOR_UNLIKELY(!res)) {\n"
+            "    return yaml_constructor_error(loader, cur, "
+            "YAML_LOADER_ERROR_TAG,\n"
+            "                                  typename);\n"
             "  }\n"
             "  bool ret = false;\n", info->out);
       fprintf(info->out, "  switch(value->%s) {\n", info->field_name);
@@ -1597,16 +2523,8 @@ static bool gen_tagged_impls
   if (seen_empty_variants) {
     fputs("      if (cur->type != YAML_SCALAR_EVENT ||\n"
           "          (cur->data.scalar.value[0] != '\\0')) {\n"
-          "        loader->error_info.expected = malloc(sizeof(typename));\n"
-          "        if (loader->error_info.expected == NULL) {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-          "          yaml_event_delete(cur);\n"
-          "        } else {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_TAG;\n"
-          "          memcpy(loader->error_info.expected, typename,"
-          "                 sizeof(typename));\n"
-          "          loader->error_info.event = *cur;\n"
-          "        }\n"
+          "        yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_TAG,\n"
+          "                               typename);\n"
           "      } else ret = true;\n", out);
   }
   fputs("  }\n"
@@ -1816,30 +2734,22 @@ static void process_struct_loaders(struct_dfa_t const *const dea,
     if (dea->nodes[i]->loader_implementation != NULL) {
       fprintf(out,
               "      case %zu:\n"
-              "        if (found[%zu]) {\n"
-              "          loader->error_info.expected = malloc(name_len);\n"
-              "          if (loader->error_info.expected == NULL) {\n"
-              "            loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-              "            yaml_event_delete(&key);\n"
-              "          } else {\n"
-              "            loader->error_info.type = YAML_LOADER_ERROR_DUPLICATE_KEY;\n"
-              "            memcpy(loader->error_info.expected, name, name_len);\n"
-              "            loader->error_info.event = key;\n"
-              "          }\n"
-              "          ret = false;\n"
+              "        if (YAML_CONSTRUCTOR_UNLIKELY(found[%zu])) {\n"
+              "          ret = yaml_constructor_error(loader, &key,\n"
+              "              YAML_LOADER_ERROR_DUPLICATE_KEY, name);\n"
               "        } else {\n"
-              "          if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-              "            loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-              "            yaml_event_delete(&key);\n"
+              "          if (YAML_CONSTRUCTOR_UNLIKELY(\n"
+              "              !yaml_loader_next_event(loader, &event))) {\n"
+              "            yaml_loader_event_delete(loader, &key);\n"
               "            ret = false;\n"
               "          } else {\n"
               "            ", i, index);
       fputs(dea->nodes[i]->loader_implementation, out);
       fprintf(out,
-              "            if (ret) {\n"
-              "              yaml_event_delete(&event);\n"
+              "            if (YAML_CONSTRUCTOR_LIKELY(ret)) {\n"
+              "              yaml_loader_event_delete(loader, &event);\n"
               "              found[%zu] = true;\n"
-              "            }\n"
+              "            } else yaml_loader_event_delete(loader, &key);\n"
               "          }\n"
               "        }\n"
               "        break;\n", index);
@@ -1913,9 +2823,8 @@ bool gen_struct_impls(type_descriptor_t const *const type_descriptor,
         "YAML_MAPPING_START_EVENT))\n"
         "    return false;"
         "  yaml_event_t key;\n"
-        "  if (yaml_parser_parse(loader->parser, &key) == 0) {\n"
-        "    loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-        "    yaml_event_delete(cur);\n"
+        "  if (!yaml_loader_next_event(loader, &key)) {\n"
+        "    yaml_loader_event_delete(loader, cur);\n"
         "    return false;\n"
         "  }\n"
         "  bool ret = true;\n", out);
@@ -1960,8 +2869,8 @@ bool gen_struct_impls(type_descriptor_t const *const type_descriptor,
     }
     fputs("};\n"
           "  while(key.type != YAML_MAPPING_END_EVENT) {\n"
-          "    if (!yaml_constructor_check_event_type(loader, &key, "
-          "YAML_SCALAR_EVENT)) {\n"
+          "    if (YAML_CONSTRUCTOR_UNLIKELY(!yaml_constructor_check_event_type(\n"
+          "        loader, &key, YAML_SCALAR_EVENT))) {\n"
           "      ret = false;\n"
           "      break;\n"
           "    }\n"
@@ -1970,27 +2879,16 @@ bool gen_struct_impls(type_descriptor_t const *const type_descriptor,
     fprintf(out, "%zu, %zu, result);\n", dea.min - 1, dea.max + 1);
     fputs("    yaml_event_t event;\n"
           "    const char *const name = (const char*)key.data.scalar.value;\n"
-          "    const size_t name_len = strlen(name) + 1;\n"
           "    switch(result) {\n", out);
     process_struct_loaders(&dea, out);
-    fputs("      default: {\n"
-          "        loader->error_info.expected = malloc(name_len);\n"
-          "        if (loader->error_info.expected == NULL) {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-          "          yaml_event_delete(&key);\n"
-          "        } else {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_UNKNOWN_KEY;\n"
-          "          memcpy(loader->error_info.expected, name, name_len);\n"
-          "          loader->error_info.event = key;\n"
-          "        }\n"
-          "        ret = false;\n"
+    fputs("      default:\n"
+          "        ret = yaml_constructor_error(loader, &key,\n"
+          "            YAML_LOADER_ERROR_UNKNOWN_KEY, name);\n"
           "        break;\n"
-          "      }\n"
           "    }\n"
-          "    if (!ret) break;\n"
-          "    yaml_event_delete(&key);\n"
-          "    if (yaml_parser_parse(loader->parser, &key) == 0) {\n"
-          "      loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
+          "    if (YAML_CONSTRUCTOR_UNLIKELY(!ret)) break;\n"
+          "    yaml_loader_event_delete(loader, &key);\n"
+          "    if (YAML_CONSTRUCTOR_UNLIKELY(!yaml_loader_next_event(loader, &key))) {\n"
           "      ret = false;\n"
           "      break;\n"
           "    }\n"
@@ -1998,31 +2896,22 @@ bool gen_struct_impls(type_descriptor_t const *const type_descriptor,
   } else {
     fputs("  if (!yaml_constructor_check_event_type(loader, &key, "
           "YAML_MAPPING_END_EVENT)) {\n"
-          "    yaml_event_delete(cur);\n"
+          "    yaml_loader_event_delete(loader, cur);\n"
           "    return false;\n"
           "  }\n", out);
   }
   if (dea.count > 0) {
     fputs("  if (ret) {\n"
-          "    yaml_event_delete(&key);\n"
+          "    yaml_loader_event_delete(loader, &key);\n"
           "    for (size_t i = 0; i < sizeof(found); i++) {\n"
-          "      if (!found[i] && !optional[i]) {\n"
-          "        const size_t missing_len = strlen(names[i]) + 1;\n"
-          "        loader->error_info.expected = malloc(missing_len);\n"
-          "        if (loader->error_info.expected == NULL) {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-          "          yaml_event_delete(cur);\n"
-          "        } else {\n"
-          "          loader->error_info.type = YAML_LOADER_ERROR_MISSING_KEY;\n"
-          "          memcpy(loader->error_info.expected, names[i], missing_len);\n"
-          "          loader->error_info.event = *cur;\n"
-          "        }\n"
-          "        ret = false;\n"
+          "      if (YAML_CONSTRUCTOR_UNLIKELY(!found[i] && !optional[i])) {\n"
+          "        ret = yaml_constructor_error(loader, cur,\n"
+          "            YAML_LOADER_ERROR_MISSING_KEY, names[i]);\n"
           "        break;\n"
           "      }\n"
           "    }\n"
-          "  } else yaml_event_delete(cur);\n"
-          "  if (!ret) {\n", out);
+          "  } else yaml_loader_event_delete(loader, cur);\n"
+          "  if (YAML_CONSTRUCTOR_UNLIKELY(!ret)) {\n", out);
     process_struct_cleanup(&dea, out);
     fputs("  }\n", out);
   }
@@ -2170,7 +3059,7 @@ bool gen_enum_impls
   fputs("    loader->error_info.expected = malloc(sizeof(typename));\n"
         "    if (loader->error_info.expected == NULL) {\n"
         "      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
-        "      yaml_event_delete(cur);\n"
+        "      yaml_loader_event_delete(loader, cur);\n"
         "    } else {\n"
         "      loader->error_info.type = YAML_LOADER_ERROR_VALUE;\n"
         "      memcpy(loader->error_info.expected, typename, sizeof(typename));\n"
@@ -2182,6 +3071,48 @@ bool gen_enum_impls
   return true;
 }
 
+/*
+ * Write the implementation of the function that constructs a target of a !lazy
+ * field of the given type to the given file. The target's subtree is parsed
+ * with a separate loader, which is initialized by the function.
+ */
+static void gen_force_impl(type_descriptor_t const *const type_descriptor,
+                           FILE *const out) {
+  size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+  char const *const constructor_name =
+      type_descriptor->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE);
+  char const *const type_name =
+      clang_getCString(clang_getTypeSpelling(type_descriptor->type));
+  fprintf(out,
+          "\n" CONSTRUCTOR_PREAMBLE " " FORCE_PREFIX "%.*s(%s **const value, "
+          "yaml_loader_t *const loader) {\n"
+          "  yaml_event_t event;\n"
+          "  if (!yaml_loader_init_lazy(loader, *value, &event)) return false;\n"
+          "  if (event.type == YAML_NO_EVENT) return true;\n"
+          "  %s *const result = malloc(sizeof(%s));\n"
+          "  if (result == NULL) {\n"
+          "    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
+          "    yaml_loader_event_delete(loader, &event);\n"
+          "    return false;\n"
+          "  }\n"
+          "  yaml_constructor_locale_t locale;\n"
+          "  yaml_constructor_enter_c_locale(&locale);\n"
+          "  bool const ret = %.*s(result, loader, &event);\n"
+          "  yaml_constructor_leave_c_locale(&locale);\n"
+          "  if (!ret) {\n"
+          "    free(result);\n"
+          "    return false;\n"
+          "  }\n"
+          "  yaml_loader_event_delete(loader, &event);\n"
+          "  yaml_constructor_lazy_free(*value);\n"
+          "  *value = result;\n"
+          "  return true;\n"
+          "}\n",
+          (int)(type_descriptor->constructor_name_len - prefix_len),
+          constructor_name + prefix_len, type_name, type_name, type_name,
+          (int)type_descriptor->constructor_name_len, constructor_name);
+}
+
 /*
  * Write implemenations of constructors, destructors and converters for all
  * known types into the given file.
@@ -2198,6 +3129,8 @@ static bool write_impls(types_list_t const *const list,
           if (!gen_list_impls(type_descriptor, list, out)) return false;
         } else if (type_descriptor->flags.tagged) {
           if (!gen_tagged_impls(type_descriptor, list, out)) return false;
+        } else if (type_descriptor->flags.view) {
+          if (!gen_view_impls(type_descriptor, out)) return false;
         } else {
           if (!gen_struct_impls(type_descriptor, list, out)) return false;
         }
@@ -2213,224 +3146,2744 @@ static bool write_impls(types_list_t const *const list,
       }
     }
   }
+  for (size_t i = 0; i < list->count; ++i) {
+    if (list->data[i].flags.lazy_target) gen_force_impl(&list->data[i], out);
+  }
   return true;
 }
 
+#define EMBED_MAX_DEPTH 1000
+
 /*
- * Set flags of the given descriptor to the values predefined types have.
+ * Append the formatted string to the given buffer.
  */
-static void mark_as_predefined(type_descriptor_t *const descriptor) {
-  descriptor->type.kind = CXType_Unexposed;
-  descriptor->flags.tagged = false;
-  descriptor->flags.list = false;
-  descriptor->flags.pointer = PTR_NONE;
-  descriptor->converter_name_len = 0;
-  descriptor->converter_decl = NULL;
+static void embed_append(embed_buffer_t *const buffer,
+                         char const *const format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t const len = (size_t)vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  if (buffer->count + len >= buffer->capacity) {
+    size_t capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+    while (buffer->count + len >= capacity) capacity *= 2;
+    buffer->data = realloc(buffer->data, capacity);
+    buffer->capacity = capacity;
+  }
+  va_start(args, format);
+  vsnprintf(buffer->data + buffer->count, len + 1, format, args);
+  va_end(args);
+  buffer->count += len;
 }
 
-#define KNOWN_TYPE(name, constructor) {\
-  /* disabled because it requires a reference to the runtime in the generator */ \
-  /*(void)&(constructor); // ensure constructor exists */\
-  type_descriptor_t desc = {\
-    .constructor_decl = "bool " #constructor,\
-    .constructor_name_len = sizeof(#constructor),\
-    .destructor_decl = NULL, .destructor_name_len = 0,\
-    .spelling = #name};\
-  mark_as_predefined(&desc);\
-  add_predefined(&types_list, #name, desc);\
+/*
+ * Renders an error at the position of the given node to stderr.
+ */
+static void embed_error(embed_info_t const *const info,
+                        yaml_node_t const *const node,
+                        char const *const message, ...) {
+  va_list args;
+  fprintf(stderr, "%s:%zu:%zu : ", info->path, node->start_mark.line + 1,
+          node->start_mark.column + 1);
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  va_end(args);
+  fputc('\n', stderr);
 }
 
-int main(int const argc, char const *argv[]) {
-  cmdline_config_t config;
-  switch (process_cmdline_args(argc, argv, &config)) {
-    case ARGS_ERROR: return 1;
-    case ARGS_HELP: return 0;
-    case ARGS_SUCCESS: break;
-  }
-
-  char const **clang_args =
-      malloc((argc - config.first_clang_param + 1) * sizeof(char*));
-  clang_args[0] = "-std=c11";
-  for (size_t i = 1; i <= argc - config.first_clang_param; ++i) {
-    clang_args[i] = argv[i + config.first_clang_param - 1];
-  }
+/*
+ * Return true iff the given node has the given type. Renders an error to
+ * stderr iff it returns false.
+ */
+static bool embed_expect(embed_info_t const *const info,
+                         yaml_node_t const *const node,
+                         yaml_node_type_t const type) {
+  static char const *const names[] = {"", "scalar", "sequence", "mapping"};
+  if (node->type == type) return true;
+  embed_error(info, node, "expected %s, got %s", names[type],
+              names[node->type]);
+  return false;
+}
 
-  CXIndex index = clang_createIndex(0, 1);
-  CXTranslationUnit unit =
-      clang_parseTranslationUnit(index, config.input_file_path, clang_args,
-                                 argc - config.first_clang_param + 1,
-                                 NULL, 0, CXTranslationUnit_None);
-  if (unit == NULL) {
-    fprintf(stderr, "Unable to parse '%s'.\n", config.input_file_path);
-    return 1;
+/*
+ * Append the given bytes as C string literal to the given buffer.
+ */
+static void embed_literal(embed_buffer_t *const buffer,
+                          unsigned char const *const value,
+                          size_t const length) {
+  embed_append(buffer, "\"");
+  for (size_t i = 0; i < length; ++i) {
+    switch (value[i]) {
+      case '"': embed_append(buffer, "\\\""); break;
+      case '\\': embed_append(buffer, "\\\\"); break;
+      case '\n': embed_append(buffer, "\\n"); break;
+      // avoids trigraphs
+      case '?': embed_append(buffer, "\\?"); break;
+      default:
+        if (value[i] < 0x20 || value[i] >= 0x7f) {
+          embed_append(buffer, "\\%03o", (unsigned)value[i]);
+        } else {
+          embed_append(buffer, "%c", value[i]);
+        }
+    }
   }
+  embed_append(buffer, "\"");
+}
 
-  CXCursor const cursor = clang_getTranslationUnitCursor(unit);
+/*
+ * Write a static object of the given type with the given initializer and
+ * return its number. If array is set, the object is an array and the
+ * initializer holds its items.
+ */
+static size_t embed_object(embed_info_t *const info, char const *const type,
+                           embed_buffer_t const *const initializer,
+                           bool const array) {
+  size_t const id = info->objects++;
+  fprintf(info->out, "\nstatic const %s embedded_%zu%s = %s;\n", type, id,
+          array ? "[]" : "", initializer->data);
+  return id;
+}
 
-  types_list_t types_list = {.data = malloc(sizeof(type_descriptor_t) * 64),
-      .count = 0, .capacity = 64, .got_error = false};
-  types_list.names.count = 1;
-  types_list.names.nodes[0] = malloc(sizeof(typename_node_t));
-  memset(types_list.names.nodes[0]->followers, -1, 256 * sizeof(uint16_t));
-  types_list.names.nodes[0]->type_index = -1;
+static bool embed_value(embed_info_t *info,
+                        type_descriptor_t const *type_descriptor,
+                        yaml_node_t *node, embed_buffer_t *expr);
 
-  // known types
-  KNOWN_TYPE(short, yaml_construct_short);
-  KNOWN_TYPE(int, yaml_construct_int);
-  KNOWN_TYPE(long, yaml_construct_long);
-  KNOWN_TYPE(long long, yaml_construct_long_long);
+/*
+ * Embed a value of one of the predefined types. Accepts the same values as
+ * the type's constructor in the runtime.
+ */
+static bool embed_atomic(embed_info_t *const info,
+                         type_descriptor_t const *const type_descriptor,
+                         yaml_node_t const *const node,
+                         embed_buffer_t *const expr) {
+  static struct {
+    char const *spelling;
+    long long min, max;
+  } const signed_types[] = {
+      {"short", SHRT_MIN, SHRT_MAX}, {"int", INT_MIN, INT_MAX},
+      {"long", LONG_MIN, LONG_MAX}, {"long long", LLONG_MIN, LLONG_MAX}
+  };
+  static struct {
+    char const *spelling;
+    unsigned long long max;
+  } const unsigned_types[] = {
+      {"unsigned char", UCHAR_MAX}, {"unsigned short", USHRT_MAX},
+      {"unsigned int", UINT_MAX}, {"unsigned long", ULONG_MAX},
+      {"unsigned long long", ULLONG_MAX}, {"size_t", SIZE_MAX}
+  };
+  if (!embed_expect(info, node, YAML_SCALAR_NODE)) return false;
+  char const *const type = type_descriptor->spelling;
+  char const *const value = (char const*)node->data.scalar.value;
+  char *end;
+  for (size_t i = 0; i < sizeof(signed_types) / sizeof(*signed_types); ++i) {
+    if (strcmp(type, signed_types[i].spelling) != 0) continue;
+    long long const res = strtoll(value, &end, 10);
+    if (*end != '\0' || res < signed_types[i].min ||
+        res > signed_types[i].max) break;
+    // the negation of LLONG_MIN is not a valid literal.
+    if (res == LLONG_MIN) embed_append(expr, "(%lldLL - 1)", res + 1);
+    else embed_append(expr, "%lldLL", res);
+    return true;
+  }
+  for (size_t i = 0; i < sizeof(unsigned_types) / sizeof(*unsigned_types);
+       ++i) {
+    if (strcmp(type, unsigned_types[i].spelling) != 0) continue;
+    unsigned long long const res = strtoull(value, &end, 10);
+    if (*end != '\0' || res > unsigned_types[i].max) break;
+    embed_append(expr, "%lluULL", res);
+    return true;
+  }
+  // floating point values are rendered as hexadecimal literals, which are
+  // exact.
+  if (!strcmp(type, "float")) {
+    float const res = strtof(value, &end);
+    if (*end == '\0' && isfinite(res)) {
+      embed_append(expr, "%af", (double)res);
+      return true;
+    }
+  } else if (!strcmp(type, "double")) {
+    double const res = strtod(value, &end);
+    if (*end == '\0' && isfinite(res)) {
+      embed_append(expr, "%a", res);
+      return true;
+    }
+  } else if (!strcmp(type, "long double")) {
+    long double const res = strtold(value, &end);
+    if (*end == '\0' && isfinite(res)) {
+      embed_append(expr, "%LaL", res);
+      return true;
+    }
+  } else if (!strcmp(type, "char")) {
+    if (value[0] != '\0' && value[1] == '\0') {
+      embed_append(expr, "(char)%d", value[0]);
+      return true;
+    }
+  } else if (!strcmp(type, "_Bool")) {
+    if (!strcmp(value, "true") || !strcmp(value, "false")) {
+      embed_append(expr, "%s", value);
+      return true;
+    }
+  }
+  embed_error(info, node, "cannot embed '%s' as %s", value, type);
+  return false;
+}
 
-  KNOWN_TYPE(unsigned char, yaml_construct_unsigned_char);
-  KNOWN_TYPE(unsigned short, yaml_construct_unsigned_short);
-  KNOWN_TYPE(unsigned int, yaml_construct_unsigned);
-  KNOWN_TYPE(unsigned long, yaml_construct_unsigned_long);
-  KNOWN_TYPE(unsigned long long, yaml_construct_unsigned_long_long);
+/*
+ * State for finding the enum constant with a given representation.
+ */
+typedef struct {
+  char const *representation;
+  char const *constant;
+  size_t position, index;
+} embed_enum_info_t;
 
-  KNOWN_TYPE(float, yaml_construct_float);
-  KNOWN_TYPE(double, yaml_construct_double);
-  KNOWN_TYPE(long double, yaml_construct_long_double);
+/*
+ * Find the enum constant whose representation matches the one in the
+ * embed_enum_info_t given by client_data. Annotations have been checked when
+ * the enum's constructor was generated.
+ */
+static enum CXChildVisitResult embed_enum_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  embed_enum_info_t *const info = (embed_enum_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_EnumConstantDecl) {
+    return CXChildVisit_Continue;
+  }
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  annotation_t annotation;
+  if (!get_annotation(cursor, &annotation)) return CXChildVisit_Break;
+  char const *const representation =
+      annotation.kind == ANN_REPR ? annotation.param : name;
+  bool const found = annotation.kind != ANN_IGNORED &&
+      !strcmp(representation, info->representation);
+  if (annotation.kind == ANN_REPR) free(annotation.param);
+  if (found) {
+    info->constant = name;
+    info->index = info->position;
+    return CXChildVisit_Break;
+  }
+  ++info->position;
+  return CXChildVisit_Continue;
+}
 
-  KNOWN_TYPE(char, yaml_construct_char);
-  KNOWN_TYPE(_Bool, yaml_construct_bool);
+/*
+ * Return the name of the constant of the given enum type with the given
+ * representation, or NULL if there is none. Stores its position among the
+ * enum's constants in index.
+ */
+static char const *embed_enum_constant(CXType const type,
+                                       char const *const representation,
+                                       size_t *const index) {
+  embed_enum_info_t info = {.representation = representation,
+                            .constant = NULL, .position = 0, .index = 0};
+  clang_visitChildren(clang_getTypeDeclaration(clang_getCanonicalType(type)),
+                      &embed_enum_visitor, &info);
+  *index = info.index;
+  return info.constant;
+}
 
-  type_info_t type_info = {.list = &types_list,
-      .constructor_names = {.data = malloc(16 * sizeof(char*)),
-          .count = 0, .capacity = 16},
-      .destructor_names = {.data = malloc(16 * sizeof(char*)),
-          .count = 0, .capacity = 16}};
-  type_info.recent_annotation.kind = ANN_NONE;
-  type_info.recent_annotation.param = NULL;
-  type_info.recent_def.kind = CXType_Unexposed;
-  clang_visitChildren(cursor, &discover_types, &type_info);
-  if (type_info.recent_annotation.param != NULL)
-    free(type_info.recent_annotation.param);
+/*
+ * State for embedding the fields of a struct.
+ */
+typedef struct {
+  embed_info_t *info;
+  yaml_node_t *node;
+  bool *used, seen_error, first;
+  embed_buffer_t *expr;
+} embed_struct_info_t;
 
-  if (types_list.got_error) {
-    return 1;
+/*
+ * Embed the value of the struct field given by cursor, taken from the mapping
+ * in the embed_struct_info_t given by client_data.
+ */
+static enum CXChildVisitResult embed_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  embed_struct_info_t *const fields = (embed_struct_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
   }
-  int root_index = find(&types_list.names, config.root_name);
-  if (root_index == -1) {
-    fprintf(stderr, "Did not find root type '%s'.\n", config.root_name);
-    return 1;
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, fields->info->types_list, &descriptor)) {
+    case ERROR:
+      fields->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
   }
-  type_descriptor_t const *const root_type = &types_list.data[root_index];
-  char const *const type_spelling =
-      clang_getCString(clang_getTypeSpelling(root_type->type));
-  const char *const space = strchr(type_spelling, ' ');
-
-
-  FILE *const header_out = fopen(config.output_header_path, "w");
-  if (header_out == NULL) {
-    fprintf(stderr, "unable to open '%s' for writing.\n",
-            config.output_header_path);
-    return 1;
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  yaml_node_t *value = NULL;
+  yaml_node_pair_t *const pairs = fields->node->data.mapping.pairs.start;
+  size_t const count =
+      (size_t)(fields->node->data.mapping.pairs.top - pairs);
+  for (size_t i = 0; i < count; ++i) {
+    yaml_node_t const *const key =
+        yaml_document_get_node(&fields->info->document, pairs[i].key);
+    if (!strcmp((char const*)key->data.scalar.value, name)) {
+      fields->used[i] = true;
+      value = yaml_document_get_node(&fields->info->document, pairs[i].value);
+      break;
+    }
   }
-  fprintf(header_out,
-          "#include <yaml.h>\n"
-          "#include <yaml_loader.h>\n"
-          "#include <%s>\n", config.input_file_name);
-  fputs("\n/* main functions for loading / deallocating the root type */\n\n",
-        header_out);
-  if (space == NULL) {
-    fprintf(header_out,
-            "bool " LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader);\n"
-            "void " DEALLOCATOR_PREFIX "%s(%s *value);\n",
-            type_spelling, type_spelling, type_spelling, type_spelling);
-  } else {
-    fprintf(header_out,
-            "bool " LOADER_PREFIX
-                "%.*s_%s(%s *value, yaml_loader_t *loader);\n"
-            "void " DEALLOCATOR_PREFIX "%.*s_%s(%s *value);\n",
-            (int)(space - type_spelling), type_spelling, space + 1,
-            type_spelling, (int)(space - type_spelling), type_spelling,
-            space + 1, type_spelling);
+  if (value == NULL) {
+    // left out fields are zero, i.e. NULL or the default value.
+    if (descriptor.flags.pointer == PTR_OPTIONAL_VALUE ||
+        descriptor.flags.pointer == PTR_OPTIONAL_STRING_VALUE ||
+        descriptor.flags.default_value != NO_DEFAULT) {
+      return CXChildVisit_Continue;
+    }
+    embed_error(fields->info, fields->node, "missing value for field '%s'",
+                name);
+    fields->seen_error = true;
+    return CXChildVisit_Break;
   }
-  fputs("\n/* low-level functions; "
-        "only necessary when writing custom constructors */\n\n", header_out);
-  if (!write_decls(&type_info, header_out)) return 1;
-  fclose(header_out);
-
-  FILE *const out_impl = fopen(config.output_impl_path, "w");
-  if (out_impl == NULL) {
-    fprintf(stderr, "Unable to open '%s' for writing.\n",
-            config.output_impl_path);
-    return 1;
+  embed_append(fields->expr, fields->first ? ".%s = " : ", .%s = ", name);
+  fields->first = false;
+  if (!embed_value(fields->info, &descriptor, value, fields->expr)) {
+    fields->seen_error = true;
+    return CXChildVisit_Break;
   }
-  fprintf(out_impl,
-          "#include <yaml_constructor.h>\n"
-          "#include <stdbool.h>\n"
-          "#include <locale.h>\n"
-          "#include <stdint.h>\n"
-          "#include \"%s\"\n", config.output_header_name);
-
-  write_static_decls(&types_list, out_impl);
-  if (!write_impls(&types_list, out_impl)) return 1;
+  return CXChildVisit_Continue;
+}
 
-  if (space == NULL) {
-    fprintf(out_impl, "bool " LOADER_PREFIX
-                          "%s(%s *value, yaml_loader_t *loader) {\n",
-            type_spelling, type_spelling);
-  } else {
-    fprintf(out_impl,
-            "bool " LOADER_PREFIX
-                "%.*s_%s(%s *value, yaml_loader_t *loader) {\n",
-            (int)(space - type_spelling), type_spelling, space + 1,
-            type_spelling);
+/*
+ * Embed a struct from a mapping. Like the constructor, rejects unknown and
+ * duplicate keys.
+ */
+static bool embed_struct(embed_info_t *const info,
+                         type_descriptor_t const *const type_descriptor,
+                         yaml_node_t *const node, embed_buffer_t *const expr) {
+  if (!embed_expect(info, node, YAML_MAPPING_NODE)) return false;
+  yaml_node_pair_t *const pairs = node->data.mapping.pairs.start;
+  size_t const count = (size_t)(node->data.mapping.pairs.top - pairs);
+  for (size_t i = 0; i < count; ++i) {
+    yaml_node_t *const key = yaml_document_get_node(&info->document,
+                                                    pairs[i].key);
+    if (!embed_expect(info, key, YAML_SCALAR_NODE)) return false;
+    for (size_t j = 0; j < i; ++j) {
+      yaml_node_t const *const other =
+          yaml_document_get_node(&info->document, pairs[j].key);
+      if (!strcmp((char const*)key->data.scalar.value,
+                  (char const*)other->data.scalar.value)) {
+        embed_error(info, key, "duplicate key '%s'", key->data.scalar.value);
+        return false;
+      }
+    }
+  }
+  embed_struct_info_t fields = {.info = info, .node = node,
+      .used = calloc(count + 1, sizeof(bool)), .seen_error = false,
+      .first = true, .expr = expr};
+  embed_append(expr, "{");
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_field_visitor, &fields);
+  bool ret = !fields.seen_error;
+  for (size_t i = 0; ret && i < count; ++i) {
+    if (!fields.used[i]) {
+      yaml_node_t *const key = yaml_document_get_node(&info->document,
+                                                      pairs[i].key);
+      embed_error(info, key, "unknown field '%s' for %s",
+                  key->data.scalar.value, type_descriptor->spelling);
+      ret = false;
+    }
+  }
+  free(fields.used);
+  embed_append(expr, fields.first ? "0}" : "}");
+  return ret;
+}
+
+/*
+ * Embed a list from a sequence. The items are written to a static array.
+ */
+static bool embed_list(embed_info_t *const info,
+                       type_descriptor_t const *const type_descriptor,
+                       yaml_node_t *const node, embed_buffer_t *const expr) {
+  if (!embed_expect(info, node, YAML_SEQUENCE_NODE)) return false;
+  list_info_t list = {.seen_error = false, .seen_capacity = false,
+                      .seen_count = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &list_visitor, &list);
+  char const *const item_name =
+      clang_getCString(clang_getTypeSpelling(list.data_type));
+  type_descriptor_t const *const item_type =
+      &info->types_list->data[find(&info->types_list->names, item_name)];
+  yaml_node_item_t *const items = node->data.sequence.items.start;
+  size_t const count = (size_t)(node->data.sequence.items.top - items);
+  if (count == 0) {
+    embed_append(expr, "{.data = NULL, .count = 0, .capacity = 0}");
+    return true;
+  }
+  embed_buffer_t array = {.data = NULL, .count = 0, .capacity = 0};
+  embed_append(&array, "{\n    ");
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0) embed_append(&array, ",\n    ");
+    if (!embed_value(info, item_type,
+                     yaml_document_get_node(&info->document, items[i]),
+                     &array)) {
+      free(array.data);
+      return false;
+    }
+  }
+  embed_append(&array, "\n}");
+  size_t const id = embed_object(info, item_name, &array, true);
+  free(array.data);
+  embed_append(expr, "{.data = (%s*)embedded_%zu, .count = %zu, "
+               ".capacity = %zu}", item_name, id, count, count);
+  return true;
+}
+
+/*
+ * State for discovering the discriminant and the union of a tagged union,
+ * and the union's field for a given variant.
+ */
+typedef struct {
+  CXCursor children[2];
+  size_t count;
+  embed_info_t *info;
+  size_t variant;
+  type_descriptor_t descriptor;
+  char const *name;
+  bool seen_error;
+} embed_tagged_info_t;
+
+static enum CXChildVisitResult embed_tagged_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  embed_tagged_info_t *const tagged = (embed_tagged_info_t*)client_data;
+  tagged->children[tagged->count++] = cursor;
+  return tagged->count == 2 ? CXChildVisit_Break : CXChildVisit_Continue;
+}
+
+/*
+ * Find the union field for the variant in the embed_tagged_info_t given by
+ * client_data. Fields are counted like the constructor does.
+ */
+static enum CXChildVisitResult embed_variant_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  embed_tagged_info_t *const tagged = (embed_tagged_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, tagged->info->types_list, &descriptor)) {
+    case ERROR:
+      tagged->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  if (tagged->count++ == tagged->variant) {
+    tagged->descriptor = descriptor;
+    tagged->name = clang_getCString(clang_getCursorSpelling(cursor));
+    return CXChildVisit_Break;
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Embed a tagged union. The node's tag selects the variant.
+ */
+static bool embed_tagged(embed_info_t *const info,
+                         type_descriptor_t const *const type_descriptor,
+                         yaml_node_t *const node, embed_buffer_t *const expr) {
+  embed_tagged_info_t tagged = {.count = 0, .info = info, .name = NULL,
+                                .seen_error = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_tagged_visitor, &tagged);
+  CXType const enum_type = clang_getCursorType(tagged.children[0]);
+  char const *const tag = (char const*)node->tag;
+  char const *const constant = tag == NULL || tag[0] != '!' ||
+      tag[1] == '\0' ? NULL :
+      embed_enum_constant(enum_type, tag + 1, &tagged.variant);
+  if (constant == NULL) {
+    embed_error(info, node, "missing or unknown tag for %s",
+                clang_getCString(clang_getTypeSpelling(enum_type)));
+    return false;
+  }
+  embed_append(expr, "{.%s = %s",
+               clang_getCString(clang_getCursorSpelling(tagged.children[0])),
+               constant);
+  tagged.count = 0;
+  clang_visitChildren(clang_getTypeDeclaration(
+      clang_getCursorType(tagged.children[1])), &embed_variant_visitor,
+      &tagged);
+  if (tagged.seen_error) return false;
+  if (tagged.name == NULL) {
+    // variants without a union field take an empty scalar.
+    if (node->type != YAML_SCALAR_NODE || node->data.scalar.value[0] != '\0') {
+      embed_error(info, node, "variant '%s' does not take a value", tag + 1);
+      return false;
+    }
+  } else {
+    embed_append(expr, ", .%s = ", tagged.name);
+    if (!embed_value(info, &tagged.descriptor, node, expr)) return false;
+  }
+  embed_append(expr, "}");
+  return true;
+}
+
+/*
+ * Embed a string view, which refers to a string literal.
+ */
+static bool embed_view(embed_info_t *const info, yaml_node_t *const node,
+                       embed_buffer_t *const expr) {
+  if (!embed_expect(info, node, YAML_SCALAR_NODE)) return false;
+  embed_append(expr, "{.ptr = ");
+  embed_literal(expr, node->data.scalar.value, node->data.scalar.length);
+  embed_append(expr, ", .len = %zu}", node->data.scalar.length);
+  return true;
+}
+
+/*
+ * Append an initializer for a value of the given type, built from the given
+ * node, to expr. Everything it references is written to info->out as static
+ * object. Return true iff the node is a valid value of the type. Renders the
+ * error to stderr iff it returns false.
+ */
+static bool embed_value(embed_info_t *const info,
+                        type_descriptor_t const *const type_descriptor,
+                        yaml_node_t *const node, embed_buffer_t *const expr) {
+  if (info->depth == EMBED_MAX_DEPTH) {
+    embed_error(info, node, "document nested too deeply");
+    return false;
+  }
+  ++info->depth;
+  bool ret;
+  switch (type_descriptor->flags.pointer) {
+    case PTR_STRING_VALUE:
+    case PTR_OPTIONAL_STRING_VALUE:
+      ret = embed_expect(info, node, YAML_SCALAR_NODE);
+      if (ret) {
+        // the constructor copies up to the first null character.
+        embed_literal(expr, node->data.scalar.value,
+                      strlen((char const*)node->data.scalar.value));
+      }
+      break;
+    case PTR_OBJECT_POINTER:
+    case PTR_OPTIONAL_VALUE: {
+      // lazy fields are embedded eagerly; forcing them does nothing.
+      type_descriptor_t target = *type_descriptor;
+      target.flags.pointer = PTR_NONE;
+      target.flags.lazy = false;
+      target.flags.shared = false;
+      embed_buffer_t initializer = {.data = NULL, .count = 0, .capacity = 0};
+      ret = embed_value(info, &target, node, &initializer);
+      if (ret && type_descriptor->flags.shared) {
+        // the dumper reads the reference count in front of the value.
+        size_t const id = info->objects++;
+        fprintf(info->out, "\nstatic const struct {\n"
+                           "  yaml_constructor_shared_t header;\n"
+                           "  %s value;\n"
+                           "} embedded_%zu = {{1}, %s};\n",
+                type_descriptor->spelling, id, initializer.data);
+        embed_append(expr, "(%s*)&embedded_%zu.value",
+                     type_descriptor->spelling, id);
+      } else if (ret) {
+        size_t const id = embed_object(info, type_descriptor->spelling,
+                                       &initializer, false);
+        embed_append(expr, "(%s*)&embedded_%zu", type_descriptor->spelling,
+                     id);
+      }
+      free(initializer.data);
+      break;
+    }
+    default:
+      if (type_descriptor->flags.custom || type_descriptor->flags.stream) {
+        embed_error(info, node, "cannot embed %s: values of %s types are "
+                    "only available at runtime", type_descriptor->spelling,
+                    type_descriptor->flags.custom ? "!custom" : "!stream");
+        ret = false;
+      } else if (type_descriptor->type.kind == CXType_Unexposed) {
+        ret = embed_atomic(info, type_descriptor, node, expr);
+      } else if (clang_getCanonicalType(type_descriptor->type).kind ==
+                 CXType_Enum) {
+        size_t index;
+        char const *const constant = node->type != YAML_SCALAR_NODE ? NULL :
+            embed_enum_constant(type_descriptor->type,
+                                (char const*)node->data.scalar.value, &index);
+        ret = constant != NULL;
+        if (ret) embed_append(expr, "%s", constant);
+        else embed_error(info, node, "not a value of %s",
+                         type_descriptor->spelling);
+      } else if (type_descriptor->flags.list) {
+        ret = embed_list(info, type_descriptor, node, expr);
+      } else if (type_descriptor->flags.tagged) {
+        ret = embed_tagged(info, type_descriptor, node, expr);
+      } else if (type_descriptor->flags.view) {
+        ret = embed_view(info, node, expr);
+      } else {
+        ret = embed_struct(info, type_descriptor, node, expr);
+      }
+  }
+  --info->depth;
+  return ret;
+}
+
+/*
+ * Load the first document from the file at the given path and write it to out
+ * as constant named name of the given root type. Return true iff the document
+ * is a valid value of the root type.
+ */
+static bool write_embedded(types_list_t const *const list,
+                           type_descriptor_t const *const root_type,
+                           char const *const path, char const *const name,
+                           FILE *const out) {
+  FILE *const input = fopen(path, "rb");
+  if (input == NULL) {
+    fprintf(stderr, "Unable to open '%s'.\n", path);
+    return false;
+  }
+  yaml_parser_t parser;
+  yaml_parser_initialize(&parser);
+  yaml_parser_set_input_file(&parser, input);
+  embed_info_t info = {.path = path, .types_list = list, .out = out,
+                       .objects = 0, .depth = 0};
+  bool const loaded = yaml_parser_load(&parser, &info.document) != 0;
+  if (!loaded) {
+    fprintf(stderr, "%s:%zu:%zu : %s\n", path, parser.problem_mark.line + 1,
+            parser.problem_mark.column + 1,
+            parser.problem == NULL ? "invalid YAML" : parser.problem);
+  }
+  yaml_parser_delete(&parser);
+  fclose(input);
+  if (!loaded) return false;
+  yaml_node_t *const root = yaml_document_get_root_node(&info.document);
+  bool ret = root != NULL;
+  if (!ret) {
+    fprintf(stderr, "%s : no document to embed.\n", path);
+  } else {
+    embed_buffer_t initializer = {.data = NULL, .count = 0, .capacity = 0};
+    ret = embed_value(&info, root_type, root, &initializer);
+    if (ret) {
+      fprintf(out, "\nconst %s " EMBEDDED_PREFIX "%s = %s;\n",
+              root_type->spelling, name, initializer.data);
+    }
+    free(initializer.data);
+  }
+  yaml_document_delete(&info.document);
+  return ret;
+}
+
+/*
+ * Write an expression that dumps the value referenced by subject, which is
+ * a value of the given type, to the given file.
+ */
+static void put_dump_call(type_descriptor_t const *const type_descriptor,
+                          char const *const subject, FILE *const out) {
+  switch (type_descriptor->flags.pointer) {
+    case PTR_STRING_VALUE:
+    case PTR_OPTIONAL_STRING_VALUE:
+      fprintf(out, "yaml_dump_string(%s, dumper)", subject);
+      return;
+    case PTR_NONE:
+      put_dumper_name(type_descriptor, out);
+      fprintf(out, "(&%s, dumper)", subject);
+      return;
+    default:
+      if (type_descriptor->flags.shared) {
+        // values with several references are written once per document.
+        fprintf(out, "(yaml_dumper_alias(dumper, %s,\n"
+                     "                         "
+                     "yaml_constructor_shared_refs(%s)) ?\n"
+                     "          dumper->error == YAML_DUMPER_ERROR_NONE :\n"
+                     "          ", subject, subject);
+        put_dumper_name(type_descriptor, out);
+        fprintf(out, "(%s, dumper))", subject);
+      } else if (type_descriptor->flags.lazy) {
+        // the subtree of a lazy field that has not been forced is unknown.
+        fprintf(out, "(yaml_constructor_is_lazy(%s) ?\n"
+                     "          yaml_dumper_fail(dumper, \"%s\") :\n"
+                     "          ",
+                subject, type_descriptor->spelling);
+        put_dumper_name(type_descriptor, out);
+        fprintf(out, "(%s, dumper))", subject);
+      } else {
+        put_dumper_name(type_descriptor, out);
+        fprintf(out, "(%s, dumper)", subject);
+      }
+  }
+}
+
+/*
+ * Write the check a dumper does on its value parameter to the given file.
+ */
+static void put_dumper_preamble(type_descriptor_t const *const type_descriptor,
+                                FILE *const out) {
+  fprintf(out,
+          "  if (YAML_CONSTRUCTOR_UNLIKELY(value == NULL)) {\n"
+          "    return yaml_dumper_fail(dumper, \"%s\");\n"
+          "  }\n", type_descriptor->spelling);
+}
+
+/*
+ * State for writing the dumper of a struct.
+ */
+typedef struct {
+  types_list_t const *types_list;
+  FILE *out;
+  bool seen_error;
+} dump_struct_info_t;
+
+/*
+ * Write the code dumping the struct field given by cursor. Optional fields
+ * are left out when they are NULL.
+ */
+static enum CXChildVisitResult dump_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  dump_struct_info_t *const info = (dump_struct_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, info->types_list, &descriptor)) {
+    case ERROR:
+      info->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  char *const accessor = malloc(sizeof("value->") + strlen(name));
+  sprintf(accessor, "value->%s", name);
+  bool const optional = descriptor.flags.pointer == PTR_OPTIONAL_VALUE ||
+      descriptor.flags.pointer == PTR_OPTIONAL_STRING_VALUE;
+  if (optional) {
+    fprintf(info->out, "  if (%s != NULL &&\n      (", accessor);
+  } else {
+    fputs("  if (", info->out);
+  }
+  fprintf(info->out, "!yaml_dumper_key(dumper, \"%s\", %zu) ||\n      %s!",
+          name, strlen(name), optional ? " " : "");
+  put_dump_call(&descriptor, accessor, info->out);
+  fputs(optional ? ")) {\n" : ") {\n", info->out);
+  fputs("    return false;\n"
+        "  }\n", info->out);
+  free(accessor);
+  return CXChildVisit_Continue;
+}
+
+static bool gen_struct_dumper(type_descriptor_t const *const type_descriptor,
+                              types_list_t const *const types_list,
+                              FILE *const out) {
+  fputc('\n', out);
+  put_dumper_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  put_dumper_preamble(type_descriptor, out);
+  fputs("  if (!yaml_dumper_mapping_start(dumper)) return false;\n", out);
+  dump_struct_info_t info = {.types_list = types_list, .out = out,
+                             .seen_error = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &dump_field_visitor, &info);
+  fputs("  return yaml_dumper_mapping_end(dumper);\n"
+        "}\n", out);
+  return !info.seen_error;
+}
+
+static bool gen_list_dumper(type_descriptor_t const *const type_descriptor,
+                            types_list_t const *const types_list,
+                            FILE *const out) {
+  list_info_t info = {.seen_error = false, .seen_capacity = false,
+                      .seen_count = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &list_visitor, &info);
+  if (info.seen_error) return false;
+  type_descriptor_t const *const inner_type = &types_list->data[
+      find(&types_list->names,
+           clang_getCString(clang_getTypeSpelling(info.data_type)))];
+  fputc('\n', out);
+  put_dumper_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  put_dumper_preamble(type_descriptor, out);
+  fputs("  if (!yaml_dumper_sequence_start(dumper)) return false;\n"
+        "  for (size_t i = 0; i < value->count; ++i) {\n"
+        "    if (YAML_CONSTRUCTOR_UNLIKELY(!", out);
+  put_dump_call(inner_type, "value->data[i]", out);
+  fputs(")) {\n"
+        "      return false;\n"
+        "    }\n"
+        "  }\n"
+        "  return yaml_dumper_sequence_end(dumper);\n"
+        "}\n", out);
+  return true;
+}
+
+/*
+ * A constant of an enum, as needed for dumping.
+ */
+typedef struct {
+  char const *name;
+  /*
+   * representation given with !repr, NULL if the name is the representation.
+   */
+  char *repr;
+  long long value;
+  /*
+   * true iff the constant is !ignored or has the same value as a constant
+   * before it. Values cannot be dumped as such a constant.
+   */
+  bool skipped;
+} dump_constant_t;
+
+typedef struct {
+  dump_constant_t *data;
+  size_t count, capacity;
+  bool seen_error;
+} dump_constants_t;
+
+/*
+ * Collect the constants of an enum into the dump_constants_t given by
+ * client_data.
+ */
+static enum CXChildVisitResult dump_constant_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  dump_constants_t *const constants = (dump_constants_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_EnumConstantDecl) {
+    return CXChildVisit_Continue;
+  }
+  annotation_t annotation;
+  if (!get_annotation(cursor, &annotation)) {
+    constants->seen_error = true;
+    return CXChildVisit_Break;
+  }
+  dump_constant_t *constant;
+  APPEND(constants, constant);
+  if (constant == NULL) {
+    constants->seen_error = true;
+    return CXChildVisit_Break;
+  }
+  constant->name = clang_getCString(clang_getCursorSpelling(cursor));
+  constant->repr = annotation.kind == ANN_REPR ? annotation.param : NULL;
+  constant->value = clang_getEnumConstantDeclValue(cursor);
+  constant->skipped = annotation.kind == ANN_IGNORED;
+  for (size_t i = 0; !constant->skipped && i + 1 < constants->count; ++i) {
+    constant->skipped = !constants->data[i].skipped &&
+                        constants->data[i].value == constant->value;
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Collect the constants of the given enum type. Return false iff that failed;
+ * in that case, no constants need to be freed.
+ */
+static bool collect_constants(CXType const type,
+                              dump_constants_t *const constants) {
+  constants->data = malloc(16 * sizeof(dump_constant_t));
+  constants->count = 0;
+  constants->capacity = 16;
+  constants->seen_error = false;
+  clang_visitChildren(clang_getTypeDeclaration(clang_getCanonicalType(type)),
+                      &dump_constant_visitor, constants);
+  if (constants->seen_error) {
+    for (size_t i = 0; i < constants->count; ++i) free(constants->data[i].repr);
+    free(constants->data);
+    return false;
+  }
+  return true;
+}
+
+static void free_constants(dump_constants_t *const constants) {
+  for (size_t i = 0; i < constants->count; ++i) free(constants->data[i].repr);
+  free(constants->data);
+}
+
+static bool gen_enum_dumper(type_descriptor_t const *const type_descriptor,
+                            FILE *const out) {
+  dump_constants_t constants;
+  if (!collect_constants(type_descriptor->type, &constants)) return false;
+  fputc('\n', out);
+  put_dumper_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  put_dumper_preamble(type_descriptor, out);
+  fputs("  switch (*value) {\n", out);
+  for (size_t i = 0; i < constants.count; ++i) {
+    dump_constant_t const *const constant = &constants.data[i];
+    if (constant->skipped) continue;
+    char const *const repr =
+        constant->repr == NULL ? constant->name : constant->repr;
+    fprintf(out, "    case %s: return yaml_dumper_scalar(dumper, \"%s\", %zu);\n",
+            constant->name, repr, strlen(repr));
+  }
+  fprintf(out, "    default: break;\n"
+               "  }\n"
+               "  return yaml_dumper_fail(dumper, \"%s\");\n"
+               "}\n", type_descriptor->spelling);
+  free_constants(&constants);
+  return true;
+}
+
+/*
+ * The fields of the union of a tagged union, as needed for dumping.
+ */
+typedef struct {
+  struct {
+    char const *name;
+    type_descriptor_t descriptor;
+  } *data;
+  size_t count, capacity;
+  types_list_t const *types_list;
+  bool seen_error;
+} dump_variants_t;
+
+/*
+ * Collect the fields of a tagged union's union into the dump_variants_t given
+ * by client_data. Fields are counted like the constructor does.
+ */
+static enum CXChildVisitResult dump_variant_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  dump_variants_t *const variants = (dump_variants_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, variants->types_list, &descriptor)) {
+    case ERROR:
+      variants->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  if (variants->count == variants->capacity) {
+    variants->capacity *= 2;
+    variants->data = realloc(variants->data,
+                             variants->capacity * sizeof(*variants->data));
+  }
+  variants->data[variants->count].name =
+      clang_getCString(clang_getCursorSpelling(cursor));
+  variants->data[variants->count++].descriptor = descriptor;
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Write the dumper of a tagged union. The variant is written as local tag,
+ * and variants without union field as empty scalar.
+ */
+static bool gen_tagged_dumper(type_descriptor_t const *const type_descriptor,
+                              types_list_t const *const types_list,
+                              FILE *const out) {
+  embed_tagged_info_t tagged = {.count = 0};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_tagged_visitor, &tagged);
+  dump_constants_t constants;
+  if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                         &constants)) {
+    return false;
+  }
+  dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+      .count = 0, .capacity = 16, .types_list = types_list,
+      .seen_error = false};
+  clang_visitChildren(clang_getTypeDeclaration(
+      clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+      &variants);
+  bool const ret = !variants.seen_error;
+  if (ret) {
+    fputc('\n', out);
+    put_dumper_decl(type_descriptor, out);
+    fputs(" {\n", out);
+    put_dumper_preamble(type_descriptor, out);
+    fprintf(out, "  switch (value->%s) {\n",
+            clang_getCString(clang_getCursorSpelling(tagged.children[0])));
+    for (size_t i = 0; i < constants.count; ++i) {
+      dump_constant_t const *const constant = &constants.data[i];
+      if (constant->skipped) continue;
+      fprintf(out, "    case %s:\n"
+                   "      return yaml_dumper_tag(dumper, \"%s\") &&\n"
+                   "             ", constant->name,
+              constant->repr == NULL ? constant->name : constant->repr);
+      if (i < variants.count) {
+        char *const accessor =
+            malloc(sizeof("value->") + strlen(variants.data[i].name));
+        sprintf(accessor, "value->%s", variants.data[i].name);
+        put_dump_call(&variants.data[i].descriptor, accessor, out);
+        free(accessor);
+        fputs(";\n", out);
+      } else {
+        fputs("yaml_dumper_scalar(dumper, \"\", 0);\n", out);
+      }
+    }
+    fprintf(out, "    default: break;\n"
+                 "  }\n"
+                 "  return yaml_dumper_fail(dumper, \"%s\");\n"
+                 "}\n", type_descriptor->spelling);
+  }
+  free(variants.data);
+  free_constants(&constants);
+  return ret;
+}
+
+static void gen_view_dumper(type_descriptor_t const *const type_descriptor,
+                            FILE *const out) {
+  fputc('\n', out);
+  put_dumper_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  put_dumper_preamble(type_descriptor, out);
+  fputs("  return yaml_dumper_scalar(dumper, value->ptr, value->len);\n"
+        "}\n", out);
+}
+
+/*
+ * Write dumpers for all known types into the given file. Custom types
+ * without a user-declared dumper get one that always fails.
+ */
+static bool write_dumpers(types_list_t const *const list, FILE *const out) {
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t const *const type_descriptor = &list->data[i];
+    if (type_descriptor->type.kind == CXType_Unexposed) continue;
+    if (type_descriptor->flags.custom) {
+      if (!type_descriptor->flags.custom_dumper) {
+        fputs("\nstatic ", out);
+        put_dumper_decl(type_descriptor, out);
+        fprintf(out, " {\n"
+                     "  (void)value;\n"
+                     "  return yaml_dumper_fail(dumper, \"%s\");\n"
+                     "}\n", type_descriptor->spelling);
+      }
+      continue;
+    }
+    bool ret = true;
+    if (clang_getCanonicalType(type_descriptor->type).kind == CXType_Enum) {
+      ret = gen_enum_dumper(type_descriptor, out);
+    } else if (type_descriptor->flags.list) {
+      ret = gen_list_dumper(type_descriptor, list, out);
+    } else if (type_descriptor->flags.tagged) {
+      ret = gen_tagged_dumper(type_descriptor, list, out);
+    } else if (type_descriptor->flags.view) {
+      gen_view_dumper(type_descriptor, out);
+    } else {
+      ret = gen_struct_dumper(type_descriptor, list, out);
+    }
+    if (!ret) return false;
+  }
+  return true;
+}
+
+// ---------- Hash and equality ---------
+
+/*
+ * State for checking the types contained in a !dedup type.
+ */
+typedef struct {
+  types_list_t *types_list;
+  char const *container;
+  bool seen_error;
+} dedup_check_info_t;
+
+static bool check_dedup(types_list_t *const types_list,
+                        type_descriptor_t *const descriptor,
+                        char const *const container);
+
+/*
+ * Check the type of the struct or union field given by cursor.
+ */
+static enum CXChildVisitResult dedup_check_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  dedup_check_info_t *const info = (dedup_check_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, info->types_list, &descriptor)) {
+    case ERROR:
+      info->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  if (descriptor.flags.pointer == PTR_STRING_VALUE ||
+      descriptor.flags.pointer == PTR_OPTIONAL_STRING_VALUE) {
+    return CXChildVisit_Continue;
+  }
+  int const index = find(&info->types_list->names, descriptor.spelling);
+  if (!check_dedup(info->types_list, &info->types_list->data[index],
+                   info->container)) {
+    info->seen_error = true;
+    return CXChildVisit_Break;
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Check that the given type and all types it contains have meaningful hash
+ * and equality functions, since the given !dedup type contains them. Return
+ * false iff one of them has not; renders the error to stderr in that case.
+ */
+static bool check_dedup(types_list_t *const types_list,
+                        type_descriptor_t *const descriptor,
+                        char const *const container) {
+  if (descriptor->flags.dedup_checked) return true;
+  CXCursor const decl = type_declaration(descriptor->type);
+  if (descriptor->flags.custom && !descriptor->flags.custom_hash) {
+    print_error(decl, "!dedup type %s cannot contain !custom type %s without "
+                "hash and equality functions.\n", container,
+                descriptor->spelling);
+    return false;
+  }
+  descriptor->flags.dedup_checked = true;
+  if (descriptor->flags.custom ||
+      clang_getCanonicalType(descriptor->type).kind != CXType_Record ||
+      descriptor->flags.view || descriptor->flags.stream) {
+    // hashed without looking at other types.
+    return true;
+  }
+  dedup_check_info_t info = {.types_list = types_list, .container = container,
+                           .seen_error = false};
+  if (descriptor->flags.list) {
+    list_info_t list = {.seen_error = false, .seen_capacity = false,
+                        .seen_count = false};
+    list.data_type.kind = CXType_Unexposed;
+    clang_visitChildren(decl, &list_visitor, &list);
+    if (list.seen_error) return false;
+    // errors in the list are reported when generating its constructor.
+    int const index = find(&types_list->names,
+        clang_getCString(clang_getTypeSpelling(list.data_type)));
+    return index == -1 ||
+           check_dedup(types_list, &types_list->data[index], container);
+  } else if (descriptor->flags.tagged) {
+    embed_tagged_info_t tagged = {.count = 0};
+    clang_visitChildren(decl, &embed_tagged_visitor, &tagged);
+    if (tagged.count != 2) return true;
+    int const index = find(&types_list->names, clang_getCString(
+        clang_getTypeSpelling(clang_getCursorType(tagged.children[0]))));
+    if (index != -1 &&
+        !check_dedup(types_list, &types_list->data[index], container)) {
+      return false;
+    }
+    clang_visitChildren(clang_getTypeDeclaration(
+        clang_getCursorType(tagged.children[1])), &dedup_check_visitor, &info);
+  } else {
+    clang_visitChildren(decl, &dedup_check_visitor, &info);
+  }
+  return !info.seen_error;
+}
+
+/*
+ * Write an expression that combines hash with the hash of the value
+ * referenced by subject, which is a value of the given type, to the given
+ * file.
+ */
+static void put_hash_call(type_descriptor_t const *const type_descriptor,
+                          char const *const subject, FILE *const out) {
+  switch (type_descriptor->flags.pointer) {
+    case PTR_STRING_VALUE:
+    case PTR_OPTIONAL_STRING_VALUE:
+      fprintf(out, "yaml_hash_string(%s, hash)", subject);
+      return;
+    case PTR_NONE:
+      put_function_name(type_descriptor, HASH_PREFIX, out);
+      fprintf(out, "(&%s, hash)", subject);
+      return;
+    case PTR_OPTIONAL_VALUE:
+      fprintf(out, "%s == NULL ? yaml_hash_null(hash) :\n         ", subject);
+      // intentional fall-through
+    default:
+      if (type_descriptor->flags.lazy) {
+        // a subtree that has not been constructed is hashed by its text.
+        fprintf(out, "yaml_constructor_is_lazy(%s) ?\n"
+                     "         yaml_constructor_lazy_hash(%s, hash) :\n"
+                     "         ", subject, subject);
+      }
+      put_function_name(type_descriptor, HASH_PREFIX, out);
+      fprintf(out, "(%s, hash)", subject);
+  }
+}
+
+/*
+ * Write an expression that is true iff the values referenced by left and
+ * right, which are values of the given type, are equal to the given file.
+ * Pointers are compared first, since shared values are often the same.
+ */
+static void put_equal_call(type_descriptor_t const *const type_descriptor,
+                           char const *const left, char const *const right,
+                           FILE *const out) {
+  switch (type_descriptor->flags.pointer) {
+    case PTR_STRING_VALUE:
+    case PTR_OPTIONAL_STRING_VALUE:
+      fprintf(out, "yaml_equal_string(%s, %s)", left, right);
+      return;
+    case PTR_NONE:
+      put_function_name(type_descriptor, EQUAL_PREFIX, out);
+      fprintf(out, "(&%s, &%s)", left, right);
+      return;
+    case PTR_OPTIONAL_VALUE:
+      fprintf(out, "(%s == %s ||\n        (%s != NULL && %s != NULL &&\n"
+                   "         ", left, right, left, right);
+      put_function_name(type_descriptor, EQUAL_PREFIX, out);
+      fprintf(out, "(%s, %s)))", left, right);
+      return;
+    default:
+      fprintf(out, "(%s == %s ||\n        ", left, right);
+      if (type_descriptor->flags.lazy) {
+        fprintf(out, "(yaml_constructor_is_lazy(%s) || "
+                     "yaml_constructor_is_lazy(%s) ?\n"
+                     "         yaml_constructor_lazy_equal(%s, %s) :\n"
+                     "         ", left, right, left, right);
+        put_function_name(type_descriptor, EQUAL_PREFIX, out);
+        fprintf(out, "(%s, %s)))", left, right);
+      } else {
+        put_function_name(type_descriptor, EQUAL_PREFIX, out);
+        fprintf(out, "(%s, %s))", left, right);
+      }
+  }
+}
+
+/*
+ * State for writing the hash or the equality function of a struct.
+ */
+typedef struct {
+  types_list_t const *types_list;
+  FILE *out;
+  bool equal, seen_error;
+} hash_struct_info_t;
+
+/*
+ * Write the code hashing or comparing the struct field given by cursor.
+ */
+static enum CXChildVisitResult hash_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  hash_struct_info_t *const info = (hash_struct_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, info->types_list, &descriptor)) {
+    case ERROR:
+      info->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  if (info->equal) {
+    char *const left = malloc(sizeof("left->") + strlen(name));
+    char *const right = malloc(sizeof("right->") + strlen(name));
+    sprintf(left, "left->%s", name);
+    sprintf(right, "right->%s", name);
+    fputs("  if (!", info->out);
+    put_equal_call(&descriptor, left, right, info->out);
+    fputs(") return false;\n", info->out);
+    free(left);
+    free(right);
+  } else {
+    char *const accessor = malloc(sizeof("value->") + strlen(name));
+    sprintf(accessor, "value->%s", name);
+    fputs("  hash = ", info->out);
+    put_hash_call(&descriptor, accessor, info->out);
+    fputs(";\n", info->out);
+    free(accessor);
+  }
+  return CXChildVisit_Continue;
+}
+
+static bool gen_struct_hash(type_descriptor_t const *const type_descriptor,
+                            types_list_t const *const types_list,
+                            FILE *const out) {
+  CXCursor const decl = type_declaration(type_descriptor->type);
+  hash_struct_info_t info = {.types_list = types_list, .out = out,
+                             .equal = false, .seen_error = false};
+  fputc('\n', out);
+  put_hash_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  clang_visitChildren(decl, &hash_field_visitor, &info);
+  fputs("  return hash;\n"
+        "}\n\n", out);
+  info.equal = true;
+  put_equal_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  if (left == right) return true;\n", out);
+  clang_visitChildren(decl, &hash_field_visitor, &info);
+  fputs("  return true;\n"
+        "}\n", out);
+  return !info.seen_error;
+}
+
+static bool gen_list_hash(type_descriptor_t const *const type_descriptor,
+                          types_list_t const *const types_list,
+                          FILE *const out) {
+  fputc('\n', out);
+  put_hash_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  hash = yaml_hash_integer(value->count, hash);\n", out);
+  if (type_descriptor->flags.stream) {
+    // items of streams are not stored.
+    fputs("  return hash;\n"
+          "}\n\n", out);
+    put_equal_decl(type_descriptor, out);
+    fputs(" {\n"
+          "  return left->count == right->count;\n"
+          "}\n", out);
+    return true;
+  }
+  list_info_t info = {.seen_error = false, .seen_capacity = false,
+                      .seen_count = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &list_visitor, &info);
+  if (info.seen_error) return false;
+  type_descriptor_t const *const inner_type = &types_list->data[
+      find(&types_list->names,
+           clang_getCString(clang_getTypeSpelling(info.data_type)))];
+  fputs("  for (size_t i = 0; i < value->count; ++i) {\n"
+        "    hash = ", out);
+  put_hash_call(inner_type, "value->data[i]", out);
+  fputs(";\n"
+        "  }\n"
+        "  return hash;\n"
+        "}\n\n", out);
+  put_equal_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  if (left->count != right->count) return false;\n"
+        "  for (size_t i = 0; i < left->count; ++i) {\n"
+        "    if (!", out);
+  put_equal_call(inner_type, "left->data[i]", "right->data[i]", out);
+  fputs(") return false;\n"
+        "  }\n"
+        "  return true;\n"
+        "}\n", out);
+  return true;
+}
+
+static void gen_enum_hash(type_descriptor_t const *const type_descriptor,
+                          FILE *const out) {
+  fputc('\n', out);
+  put_hash_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  return yaml_hash_integer((uint64_t)*value, hash);\n"
+        "}\n\n", out);
+  put_equal_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  return *left == *right;\n"
+        "}\n", out);
+}
+
+static void gen_view_hash(type_descriptor_t const *const type_descriptor,
+                          FILE *const out) {
+  fputc('\n', out);
+  put_hash_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  return yaml_hash_bytes(value->ptr, value->len, hash);\n"
+        "}\n\n", out);
+  put_equal_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  return left->len == right->len &&\n"
+        "         (left->len == 0 ||\n"
+        "          memcmp(left->ptr, right->ptr, left->len) == 0);\n"
+        "}\n", out);
+}
+
+/*
+ * Write the hash and equality functions of a tagged union. The hash includes
+ * the variant; values of different variants are never equal.
+ */
+static bool gen_tagged_hash(type_descriptor_t const *const type_descriptor,
+                            types_list_t const *const types_list,
+                            FILE *const out) {
+  embed_tagged_info_t tagged = {.count = 0};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_tagged_visitor, &tagged);
+  dump_constants_t constants;
+  if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                         &constants)) {
+    return false;
+  }
+  dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+      .count = 0, .capacity = 16, .types_list = types_list,
+      .seen_error = false};
+  clang_visitChildren(clang_getTypeDeclaration(
+      clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+      &variants);
+  bool const ret = !variants.seen_error;
+  if (ret) {
+    char const *const tag_name =
+        clang_getCString(clang_getCursorSpelling(tagged.children[0]));
+    fputc('\n', out);
+    put_hash_decl(type_descriptor, out);
+    fprintf(out, " {\n"
+                 "  hash = yaml_hash_integer((uint64_t)value->%s, hash);\n"
+                 "  switch (value->%s) {\n", tag_name, tag_name);
+    for (size_t i = 0; i < constants.count && i < variants.count; ++i) {
+      if (constants.data[i].skipped) continue;
+      char *const accessor =
+          malloc(sizeof("value->") + strlen(variants.data[i].name));
+      sprintf(accessor, "value->%s", variants.data[i].name);
+      fprintf(out, "    case %s:\n"
+                   "      return ", constants.data[i].name);
+      put_hash_call(&variants.data[i].descriptor, accessor, out);
+      fputs(";\n", out);
+      free(accessor);
+    }
+    fputs("    default: return hash;\n"
+          "  }\n"
+          "}\n\n", out);
+    put_equal_decl(type_descriptor, out);
+    fprintf(out, " {\n"
+                 "  if (left->%s != right->%s) return false;\n"
+                 "  switch (left->%s) {\n", tag_name, tag_name, tag_name);
+    for (size_t i = 0; i < constants.count && i < variants.count; ++i) {
+      if (constants.data[i].skipped) continue;
+      char const *const name = variants.data[i].name;
+      char *const left = malloc(sizeof("left->") + strlen(name));
+      char *const right = malloc(sizeof("right->") + strlen(name));
+      sprintf(left, "left->%s", name);
+      sprintf(right, "right->%s", name);
+      fprintf(out, "    case %s:\n"
+                   "      return ", constants.data[i].name);
+      put_equal_call(&variants.data[i].descriptor, left, right, out);
+      fputs(";\n", out);
+      free(left);
+      free(right);
+    }
+    fputs("    default: return true;\n"
+          "  }\n"
+          "}\n", out);
+  }
+  free(variants.data);
+  free_constants(&constants);
+  return ret;
+}
+
+/*
+ * Write hash and equality functions for all known types into the given file.
+ * Custom types without user-declared ones get functions that consider a
+ * value equal only to itself.
+ */
+static bool write_hashers(types_list_t const *const list, FILE *const out) {
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t const *const type_descriptor = &list->data[i];
+    if (type_descriptor->type.kind == CXType_Unexposed) continue;
+    if (type_descriptor->flags.custom) {
+      if (!type_descriptor->flags.custom_hash) {
+        fputs("\nstatic ", out);
+        put_hash_decl(type_descriptor, out);
+        fputs(" {\n"
+              "  (void)value;\n"
+              "  return hash;\n"
+              "}\n\nstatic ", out);
+        put_equal_decl(type_descriptor, out);
+        fputs(" {\n"
+              "  return left == right;\n"
+              "}\n", out);
+      }
+      continue;
+    }
+    bool ret = true;
+    if (clang_getCanonicalType(type_descriptor->type).kind == CXType_Enum) {
+      gen_enum_hash(type_descriptor, out);
+    } else if (type_descriptor->flags.list) {
+      ret = gen_list_hash(type_descriptor, list, out);
+    } else if (type_descriptor->flags.tagged) {
+      ret = gen_tagged_hash(type_descriptor, list, out);
+    } else if (type_descriptor->flags.view) {
+      gen_view_hash(type_descriptor, out);
+    } else {
+      ret = gen_struct_hash(type_descriptor, list, out);
+    }
+    if (!ret) return false;
+  }
+  return true;
+}
+
+/*
+ * Write the descriptors of the targets of shared fields, which the loader
+ * uses to release and deduplicate their values, into the given file.
+ */
+static void write_shared_types(types_list_t const *const list,
+                               FILE *const out) {
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t target = list->data[i];
+    if (!target.flags.shared_target) continue;
+    size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+    int const suffix_len = (int)(target.constructor_name_len - prefix_len);
+    char const *const suffix = target.constructor_decl +
+        sizeof(CONSTRUCTOR_PREAMBLE) + prefix_len;
+    char const *const type_name = target.type.kind == CXType_Unexposed ?
+        target.spelling : clang_getCString(clang_getTypeSpelling(target.type));
+    target.flags.pointer = PTR_OBJECT_POINTER;
+    target.flags.shared = true;
+    char *const release_call = render_destructor_call(&target, "value", false);
+    fprintf(out, "\nstatic void " RELEASE_PREFIX "%.*s(void *value) {\n"
+                 "  %s\n"
+                 "}\n", suffix_len, suffix, release_call);
+    free(release_call);
+    if (target.flags.dedup) {
+      fprintf(out, "\nstatic uint64_t hash_%.*s(const void *value) {\n"
+                   "  return " HASH_PREFIX "%.*s((const %s*)value, 0);\n"
+                   "}\n"
+                   "\nstatic bool equal_%.*s(const void *left, "
+                   "const void *right) {\n"
+                   "  return " EQUAL_PREFIX "%.*s((const %s*)left, "
+                   "(const %s*)right);\n"
+                   "}\n", suffix_len, suffix, suffix_len, suffix, type_name,
+              suffix_len, suffix, suffix_len, suffix, type_name, type_name);
+    }
+    fprintf(out, "\nstatic const yaml_loader_shared_type_t "
+                 SHARED_TYPE_PREFIX "%.*s = {\n"
+                 "  \"%s\", &" RELEASE_PREFIX "%.*s, ",
+            suffix_len, suffix, target.spelling, suffix_len, suffix);
+    if (target.flags.dedup) {
+      fprintf(out, "&hash_%.*s, &equal_%.*s\n};\n", suffix_len, suffix,
+              suffix_len, suffix);
+    } else {
+      fputs("NULL, NULL\n};\n", out);
+    }
+  }
+}
+
+// ---------- Reloading ---------
+
+/*
+ * State for finding out whether a struct refers to the input.
+ */
+typedef struct {
+  types_list_t const *types_list;
+  bool input_bound;
+} input_bound_info_t;
+
+/*
+ * Check whether the struct or union field given by cursor refers to the
+ * input.
+ */
+static enum CXChildVisitResult input_bound_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  input_bound_info_t *const info = (input_bound_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  // errors are reported when generating the constructor.
+  if (describe_field(cursor, info->types_list, &descriptor) != ADDED) {
+    return CXChildVisit_Continue;
+  }
+  if (descriptor.flags.lazy || descriptor.flags.input_bound) {
+    info->input_bound = true;
+    return CXChildVisit_Break;
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Returns true iff a value of the given struct, list or tagged union refers
+ * to the input, according to the current flags of the types it contains.
+ */
+static bool refers_to_input(types_list_t const *const types_list,
+                            type_descriptor_t const *const descriptor) {
+  CXCursor const decl = type_declaration(descriptor->type);
+  input_bound_info_t info = {.types_list = types_list, .input_bound = false};
+  if (descriptor->flags.list) {
+    list_info_t list = {.seen_error = false, .seen_capacity = false,
+                        .seen_count = false};
+    list.data_type.kind = CXType_Unexposed;
+    clang_visitChildren(decl, &list_visitor, &list);
+    if (list.seen_error) return false;
+    int const index = find(&types_list->names,
+        clang_getCString(clang_getTypeSpelling(list.data_type)));
+    return index != -1 && types_list->data[index].flags.input_bound;
+  } else if (descriptor->flags.tagged) {
+    embed_tagged_info_t tagged = {.count = 0};
+    clang_visitChildren(decl, &embed_tagged_visitor, &tagged);
+    if (tagged.count != 2) return false;
+    clang_visitChildren(clang_getTypeDeclaration(
+        clang_getCursorType(tagged.children[1])), &input_bound_visitor, &info);
+  } else {
+    clang_visitChildren(decl, &input_bound_visitor, &info);
+  }
+  return info.input_bound;
+}
+
+/*
+ * Mark all types that contain views or !lazy fields, directly or through
+ * other types, as input_bound.
+ */
+static void mark_input_bound(types_list_t *const types_list) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < types_list->count; ++i) {
+      type_descriptor_t *const descriptor = &types_list->data[i];
+      if (descriptor->flags.input_bound || !is_compound(descriptor)) {
+        continue;
+      }
+      if (refers_to_input(types_list, descriptor)) {
+        descriptor->flags.input_bound = true;
+        changed = true;
+      }
+    }
+  }
+}
+
+/*
+ * State for marking the types whose values are reconciled or recycled
+ * through the fields of a struct.
+ */
+typedef struct {
+  types_list_t *types_list;
+  bool recycle;
+} walk_info_t;
+
+static void mark_walked(types_list_t *types_list,
+                        type_descriptor_t const *descriptor, bool recycle);
+
+static enum CXChildVisitResult walk_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  walk_info_t *const info = (walk_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  // errors are reported when generating the constructor.
+  if (describe_field(cursor, info->types_list, &descriptor) == ADDED) {
+    mark_walked(info->types_list, &descriptor, info->recycle);
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Mark the type of the given descriptor as reconciled (or recycled, if
+ * recycle is set) if put_reconcile (or put_recycle) recurses into values
+ * described by it, and so all types reached from it, so that only the
+ * reconcile_ and recycle_ functions which are called get generated.
+ */
+static void mark_walked(types_list_t *const types_list,
+                        type_descriptor_t const *const descriptor,
+                        bool const recycle) {
+  if (descriptor->flags.pointer == PTR_STRING_VALUE ||
+      descriptor->flags.pointer == PTR_OPTIONAL_STRING_VALUE ||
+      descriptor->flags.shared || !is_compound(descriptor)) {
+    return;
+  }
+  // lazy values are destructed instead of recycled.
+  if (recycle && descriptor->flags.lazy) return;
+  type_descriptor_t *target = NULL;
+  for (size_t i = 0; i < types_list->count; ++i) {
+    if (clang_equalTypes(types_list->data[i].type, descriptor->type)) {
+      target = &types_list->data[i];
+      break;
+    }
+  }
+  if (target == NULL) return;
+  bool *const flag =
+      recycle ? &target->flags.recycled : &target->flags.reconciled;
+  if (*flag) return;
+  *flag = true;
+  CXCursor const decl = type_declaration(target->type);
+  if (target->flags.list) {
+    list_info_t list = {.seen_error = false, .seen_capacity = false,
+                        .seen_count = false};
+    clang_visitChildren(decl, &list_visitor, &list);
+    if (list.seen_error) return;
+    int const index = find(&types_list->names,
+        clang_getCString(clang_getTypeSpelling(list.data_type)));
+    if (index != -1) {
+      mark_walked(types_list, &types_list->data[index], recycle);
+    }
+  } else if (target->flags.tagged) {
+    embed_tagged_info_t tagged = {.count = 0};
+    clang_visitChildren(decl, &embed_tagged_visitor, &tagged);
+    if (tagged.count != 2) return;
+    dump_constants_t constants;
+    if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                           &constants)) {
+      return;
+    }
+    dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+        .count = 0, .capacity = 16, .types_list = types_list,
+        .seen_error = false};
+    clang_visitChildren(clang_getTypeDeclaration(
+        clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+        &variants);
+    for (size_t i = 0; !variants.seen_error && i < constants.count &&
+                       i < variants.count; ++i) {
+      if (!constants.data[i].skipped) {
+        mark_walked(types_list, &variants.data[i].descriptor, recycle);
+      }
+    }
+    free(variants.data);
+    free_constants(&constants);
+  } else {
+    walk_info_t info = {.types_list = types_list, .recycle = recycle};
+    clang_visitChildren(decl, &walk_field_visitor, &info);
+  }
+}
+
+/*
+ * Mark the type targeted by the given field as pointer_target if the
+ * destructor of the field's struct destructs and deallocates the target.
+ */
+static void mark_pointer_target(types_list_t *const types_list,
+                                type_descriptor_t const *const descriptor) {
+  if (descriptor->flags.pointer == PTR_NONE ||
+      descriptor->flags.pointer == PTR_STRING_VALUE ||
+      descriptor->flags.pointer == PTR_OPTIONAL_STRING_VALUE ||
+      descriptor->flags.shared || descriptor->destructor_decl == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < types_list->count; ++i) {
+    if (clang_equalTypes(types_list->data[i].type, descriptor->type)) {
+      types_list->data[i].flags.pointer_target = true;
+      return;
+    }
+  }
+}
+
+static enum CXChildVisitResult pointer_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  types_list_t *const types_list = (types_list_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  // errors are reported when generating the constructor.
+  if (describe_field(cursor, types_list, &descriptor) == ADDED) {
+    mark_pointer_target(types_list, &descriptor);
+  }
+  return CXChildVisit_Continue;
+}
+
+/*
+ * Mark all types targeted by pointer fields of structs and variants of
+ * tagged unions as pointer_target, so that destroy_ functions are generated
+ * exactly for them. Must be called after the destructors have been declared.
+ */
+static void mark_pointer_targets(types_list_t *const types_list) {
+  for (size_t i = 0; i < types_list->count; ++i) {
+    type_descriptor_t const *const descriptor = &types_list->data[i];
+    if (!is_compound(descriptor) || descriptor->flags.list) continue;
+    CXCursor const decl = type_declaration(descriptor->type);
+    if (!descriptor->flags.tagged) {
+      clang_visitChildren(decl, &pointer_field_visitor, types_list);
+      continue;
+    }
+    embed_tagged_info_t tagged = {.count = 0};
+    clang_visitChildren(decl, &embed_tagged_visitor, &tagged);
+    if (tagged.count != 2) continue;
+    dump_constants_t constants;
+    if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                           &constants)) {
+      continue;
+    }
+    dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+        .count = 0, .capacity = 16, .types_list = types_list,
+        .seen_error = false};
+    clang_visitChildren(clang_getTypeDeclaration(
+        clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+        &variants);
+    for (size_t j = 0; !variants.seen_error && j < constants.count &&
+                       j < variants.count; ++j) {
+      if (!constants.data[j].skipped) {
+        mark_pointer_target(types_list, &variants.data[j].descriptor);
+      }
+    }
+    free(variants.data);
+    free_constants(&constants);
+  }
+}
+
+/*
+ * Returns the given indentation, deepened by one level. Must be freed.
+ */
+static char *deeper(char const *const indent) {
+  char *const ret = malloc(strlen(indent) + 3);
+  sprintf(ret, "%s  ", indent);
+  return ret;
+}
+
+/*
+ * Write body to the given file, wrapped in code that enters the path given
+ * by the expression enter before and leaves it afterwards. enter may be NULL
+ * to stay at the current path.
+ */
+static void put_in_path(char const *const body, char const *const enter,
+                        char const *const indent, FILE *const out) {
+  if (enter == NULL) {
+    fprintf(out, "%s%s\n", indent, body);
+  } else {
+    fprintf(out, "%ssize_t const path = %s;\n"
+                 "%s%s\n"
+                 "%syaml_reload_leave(changes, path);\n",
+            indent, enter, indent, body, indent);
+  }
+}
+
+/*
+ * Write code that reconciles the reloaded value referenced by value with the
+ * old one referenced by old, both values of the given type, to the given file.
+ * Equal values are swapped, so that the reloaded value takes over the old
+ * one's allocations, unless they refer to the input. Other values are
+ * reconciled recursively if they are structs, lists or tagged unions that
+ * are not shared, and recorded as changed otherwise.
+ */
+static void put_reconcile(type_descriptor_t const *const type_descriptor,
+                          char const *const value, char const *const old,
+                          char const *const enter, char const *const indent,
+                          FILE *const out) {
+  type_descriptor_t inner = *type_descriptor;
+  char *const inner_indent = deeper(indent);
+  if (inner.flags.pointer == PTR_OPTIONAL_VALUE) {
+    char *const body_indent = deeper(inner_indent);
+    fprintf(out, "%sif (%s == NULL || %s == NULL) {\n"
+                 "%sif (%s != %s) {\n", indent, value, old, inner_indent,
+            value, old);
+    put_in_path("yaml_reload_changed(changes);", enter, body_indent, out);
+    fprintf(out, "%s}\n"
+                 "%s} else {\n", inner_indent, indent);
+    free(body_indent);
+    inner.flags.pointer = PTR_OBJECT_POINTER;
+    put_reconcile(&inner, value, old, enter, inner_indent, out);
+    fprintf(out, "%s}\n", indent);
+    free(inner_indent);
+    return;
+  }
+  if (inner.flags.lazy) {
+    // subtrees that have not been constructed are not reused.
+    fprintf(out, "%sif (yaml_constructor_is_lazy(%s) || "
+                 "yaml_constructor_is_lazy(%s)) {\n"
+                 "%sif (!", indent, value, old, inner_indent);
+    put_equal_call(&inner, value, old, out);
+    fputs(") {\n", out);
+    char *const body_indent = deeper(inner_indent);
+    put_in_path("yaml_reload_changed(changes);", enter, body_indent, out);
+    free(body_indent);
+    fprintf(out, "%s}\n"
+                 "%s} else {\n", inner_indent, indent);
+    inner.flags.lazy = false;
+    put_reconcile(&inner, value, old, enter, inner_indent, out);
+    fprintf(out, "%s}\n", indent);
+    free(inner_indent);
+    return;
+  }
+  bool const string = inner.flags.pointer == PTR_STRING_VALUE ||
+                      inner.flags.pointer == PTR_OPTIONAL_STRING_VALUE;
+  bool const recurse = !string && !inner.flags.shared &&
+                       is_compound(&inner);
+  // values without allocations of their own need not be swapped.
+  bool const swap = string || (!inner.flags.input_bound &&
+      (inner.flags.pointer != PTR_NONE || inner.flags.custom || recurse));
+  char *body;
+  if (recurse) {
+    size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+    int const suffix_len = (int)(inner.constructor_name_len - prefix_len);
+    char const *const suffix =
+        inner.constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE) + prefix_len;
+    char const *const ref = inner.flags.pointer == PTR_NONE ? "&" : "";
+    body = malloc(sizeof(RECONCILE_PREFIX "(, , changes);") + suffix_len +
+                  strlen(value) + strlen(old) + 2 * strlen(ref));
+    sprintf(body, RECONCILE_PREFIX "%.*s(%s%s, %s%s, changes);", suffix_len,
+            suffix, ref, value, ref, old);
+  } else {
+    body = malloc(sizeof("yaml_reload_changed(changes);"));
+    strcpy(body, "yaml_reload_changed(changes);");
+  }
+  if (swap) {
+    fprintf(out, "%sif (", indent);
+    put_equal_call(&inner, value, old, out);
+    fprintf(out, ") {\n"
+                 "%syaml_reload_swap(&%s, &%s, sizeof(%s));\n"
+                 "%s} else {\n", inner_indent, value, old, value, indent);
+    put_in_path(body, enter, inner_indent, out);
+    fprintf(out, "%s}\n", indent);
+  } else if (recurse) {
+    if (enter == NULL) {
+      put_in_path(body, enter, indent, out);
+    } else {
+      fprintf(out, "%s{\n", indent);
+      put_in_path(body, enter, inner_indent, out);
+      fprintf(out, "%s}\n", indent);
+    }
+  } else {
+    fprintf(out, "%sif (!", indent);
+    put_equal_call(&inner, value, old, out);
+    fputs(") {\n", out);
+    put_in_path(body, enter, inner_indent, out);
+    fprintf(out, "%s}\n", indent);
+  }
+  free(body);
+  free(inner_indent);
+}
+
+/*
+ * State for writing the function reconciling a struct.
+ */
+typedef struct {
+  types_list_t const *types_list;
+  FILE *out;
+  bool seen_error, seen_field;
+} reconcile_struct_info_t;
+
+/*
+ * Write the code reconciling the struct field given by cursor.
+ */
+static enum CXChildVisitResult reconcile_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  reconcile_struct_info_t *const info = (reconcile_struct_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, info->types_list, &descriptor)) {
+    case ERROR:
+      info->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  info->seen_field = true;
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  char *const value = malloc(sizeof("value->") + strlen(name));
+  char *const old = malloc(sizeof("old->") + strlen(name));
+  char *const enter =
+      malloc(sizeof("yaml_reload_enter_field(changes, \"\")") + strlen(name));
+  sprintf(value, "value->%s", name);
+  sprintf(old, "old->%s", name);
+  sprintf(enter, "yaml_reload_enter_field(changes, \"%s\")", name);
+  put_reconcile(&descriptor, value, old, enter, "  ", info->out);
+  free(value);
+  free(old);
+  free(enter);
+  return CXChildVisit_Continue;
+}
+
+static bool gen_struct_reconcile(type_descriptor_t const *const type_descriptor,
+                                 types_list_t const *const types_list,
+                                 FILE *const out) {
+  reconcile_struct_info_t info = {.types_list = types_list, .out = out,
+                                  .seen_error = false, .seen_field = false};
+  fputc('\n', out);
+  put_reconcile_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &reconcile_field_visitor, &info);
+  if (!info.seen_field) {
+    fputs("  (void)value;\n"
+          "  (void)old;\n"
+          "  (void)changes;\n", out);
+  }
+  fputs("}\n", out);
+  return !info.seen_error;
+}
+
+/*
+ * Write the function reconciling a list. Items are reconciled pairwise; a
+ * list whose length changed is recorded as changed itself.
+ */
+static bool gen_list_reconcile(type_descriptor_t const *const type_descriptor,
+                               types_list_t const *const types_list,
+                               FILE *const out) {
+  list_info_t info = {.seen_error = false, .seen_capacity = false,
+                      .seen_count = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &list_visitor, &info);
+  if (info.seen_error) return false;
+  type_descriptor_t const *const inner_type = &types_list->data[
+      find(&types_list->names,
+           clang_getCString(clang_getTypeSpelling(info.data_type)))];
+  fputc('\n', out);
+  put_reconcile_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  size_t const count =\n"
+        "      value->count < old->count ? value->count : old->count;\n"
+        "  for (size_t i = 0; i < count; ++i) {\n", out);
+  put_reconcile(inner_type, "value->data[i]", "old->data[i]",
+                "yaml_reload_enter_item(changes, i)", "    ", out);
+  fputs("  }\n"
+        "  if (value->count != old->count) yaml_reload_changed(changes);\n"
+        "}\n", out);
+  return true;
+}
+
+/*
+ * Write the function reconciling a tagged union. A value whose variant
+ * changed is recorded as changed.
+ */
+static bool gen_tagged_reconcile(type_descriptor_t const *const type_descriptor,
+                                 types_list_t const *const types_list,
+                                 FILE *const out) {
+  embed_tagged_info_t tagged = {.count = 0};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_tagged_visitor, &tagged);
+  dump_constants_t constants;
+  if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                         &constants)) {
+    return false;
+  }
+  dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+      .count = 0, .capacity = 16, .types_list = types_list,
+      .seen_error = false};
+  clang_visitChildren(clang_getTypeDeclaration(
+      clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+      &variants);
+  bool const ret = !variants.seen_error;
+  if (ret) {
+    char const *const tag_name =
+        clang_getCString(clang_getCursorSpelling(tagged.children[0]));
+    fputc('\n', out);
+    put_reconcile_decl(type_descriptor, out);
+    fprintf(out, " {\n"
+                 "  if (value->%s != old->%s) {\n"
+                 "    yaml_reload_changed(changes);\n"
+                 "    return;\n"
+                 "  }\n"
+                 "  switch (value->%s) {\n", tag_name, tag_name, tag_name);
+    for (size_t i = 0; i < constants.count && i < variants.count; ++i) {
+      if (constants.data[i].skipped) continue;
+      char const *const name = variants.data[i].name;
+      char *const value = malloc(sizeof("value->") + strlen(name));
+      char *const old = malloc(sizeof("old->") + strlen(name));
+      sprintf(value, "value->%s", name);
+      sprintf(old, "old->%s", name);
+      fprintf(out, "    case %s:\n", constants.data[i].name);
+      put_reconcile(&variants.data[i].descriptor, value, old, NULL, "      ",
+                    out);
+      fputs("      break;\n", out);
+      free(value);
+      free(old);
+    }
+    fputs("    default: break;\n"
+          "  }\n"
+          "}\n", out);
+  }
+  free(variants.data);
+  free_constants(&constants);
+  return ret;
+}
+
+/*
+ * Write the functions reconciling reloaded values with old ones for all
+ * structs, lists and tagged unions that reloading reaches into the given
+ * file.
+ */
+static bool write_reconcilers(types_list_t const *const list,
+                              FILE *const out) {
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t const *const type_descriptor = &list->data[i];
+    if (!type_descriptor->flags.reconciled) continue;
+    bool ret;
+    if (type_descriptor->flags.list) {
+      ret = gen_list_reconcile(type_descriptor, list, out);
+    } else if (type_descriptor->flags.tagged) {
+      ret = gen_tagged_reconcile(type_descriptor, list, out);
+    } else {
+      ret = gen_struct_reconcile(type_descriptor, list, out);
+    }
+    if (!ret) return false;
+  }
+  return true;
+}
+
+/*
+ * Write the call to the function recycling a value of the given compound
+ * type, referenced by the given pointer expression, to the given file.
+ */
+static void put_recycle_call(type_descriptor_t const *const type_descriptor,
+                             char const *const ref, char const *const value,
+                             FILE *const out) {
+  size_t const prefix_len = sizeof(CONSTRUCTOR_PREFIX) - 1;
+  fprintf(out, RECYCLE_PREFIX "%.*s(%s%s, loader);",
+          (int)(type_descriptor->constructor_name_len - prefix_len),
+          type_descriptor->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE) +
+          prefix_len, ref, value);
+}
+
+/*
+ * What the code written by put_recycle refers to. Code using the loader
+ * always uses the value as well.
+ */
+enum recycle_uses_t {
+  USES_NOTHING, USES_VALUE, USES_LOADER
+};
+
+/*
+ * Write the call destructing the value of the given type, if it has a
+ * destructor, to the given file.
+ */
+static enum recycle_uses_t put_recycle_destructor
+    (type_descriptor_t const *const type_descriptor, char const *const value,
+     char const *const indent, FILE *const out) {
+  char *const destructor_call =
+      render_destructor_call(type_descriptor, value, false);
+  if (destructor_call == NULL) return USES_NOTHING;
+  fprintf(out, "%s%s\n", indent, destructor_call);
+  free(destructor_call);
+  return USES_VALUE;
+}
+
+/*
+ * Write code that hands the allocations of the value of the given type to
+ * the loader for reuse, to the given file. Shared and !lazy values are
+ * destructed instead, since they may be referenced elsewhere or refer to
+ * the input. Returns what the written code refers to.
+ */
+static enum recycle_uses_t put_recycle
+    (type_descriptor_t const *const type_descriptor, char const *const value,
+     char const *const indent, FILE *const out) {
+  if (type_descriptor->flags.shared || type_descriptor->flags.lazy) {
+    return put_recycle_destructor(type_descriptor, value, indent, out);
   }
+  switch (type_descriptor->flags.pointer) {
+    case PTR_STRING_VALUE:
+    case PTR_OPTIONAL_STRING_VALUE:
+      fprintf(out, "%sif (%s != NULL) {\n"
+                   "%s  yaml_loader_recycle(loader, %s, strlen(%s) + 1);\n"
+                   "%s}\n", indent, value, indent, value, value, indent);
+      return USES_LOADER;
+    case PTR_NONE:
+      if (is_compound(type_descriptor)) {
+        fputs(indent, out);
+        put_recycle_call(type_descriptor, "&", value, out);
+        fputc('\n', out);
+        return USES_LOADER;
+      }
+      return put_recycle_destructor(type_descriptor, value, indent, out);
+    default: break;
+  }
+  fprintf(out, "%sif (%s != NULL) {\n%s  ", indent, value, indent);
+  type_descriptor_t inner = *type_descriptor;
+  inner.flags.pointer = PTR_NONE;
+  if (is_compound(&inner)) {
+    put_recycle_call(&inner, "", value, out);
+    fprintf(out, "\n%s  ", indent);
+  } else if (inner.destructor_decl != NULL) {
+    fprintf(out, "%.*s(%s);\n%s  ", (int)inner.destructor_name_len,
+            inner.destructor_decl + sizeof(DESTRUCTOR_PREAMBLE), value,
+            indent);
+  }
+  fprintf(out, "yaml_loader_recycle(loader, %s, sizeof(*%s));\n"
+               "%s}\n", value, value, indent);
+  return USES_LOADER;
+}
+
+/*
+ * Write casts that silence warnings about the parameters of a recycle_
+ * function which the code written before did not use, to the given file.
+ */
+static void put_unused_recycle_params(enum recycle_uses_t const uses,
+                                      char const *const indent,
+                                      FILE *const out) {
+  if (uses < USES_VALUE) fprintf(out, "%s(void)value;\n", indent);
+  if (uses < USES_LOADER) fprintf(out, "%s(void)loader;\n", indent);
+}
+
+/*
+ * State for writing the function recycling a struct.
+ */
+typedef struct {
+  types_list_t const *types_list;
+  FILE *out;
+  bool seen_error;
+  enum recycle_uses_t uses;
+} recycle_struct_info_t;
+
+/*
+ * Write the code recycling the struct field given by cursor.
+ */
+static enum CXChildVisitResult recycle_field_visitor
+    (CXCursor const cursor, CXCursor const parent,
+     CXClientData const client_data) {
+  (void)parent;
+  recycle_struct_info_t *const info = (recycle_struct_info_t*)client_data;
+  if (clang_getCursorKind(cursor) != CXCursor_FieldDecl) {
+    return CXChildVisit_Continue;
+  }
+  type_descriptor_t descriptor;
+  switch (describe_field(cursor, info->types_list, &descriptor)) {
+    case ERROR:
+      info->seen_error = true;
+      return CXChildVisit_Break;
+    case IGNORED:
+      return CXChildVisit_Continue;
+    case ADDED: break;
+  }
+  char const *const name = clang_getCString(clang_getCursorSpelling(cursor));
+  char *const value = malloc(sizeof("value->") + strlen(name));
+  sprintf(value, "value->%s", name);
+  enum recycle_uses_t const uses =
+      put_recycle(&descriptor, value, "  ", info->out);
+  if (uses > info->uses) info->uses = uses;
+  free(value);
+  return CXChildVisit_Continue;
+}
+
+static bool gen_struct_recycle(type_descriptor_t const *const type_descriptor,
+                               types_list_t const *const types_list,
+                               FILE *const out) {
+  recycle_struct_info_t info = {.types_list = types_list, .out = out,
+                                .seen_error = false, .uses = USES_NOTHING};
+  fputc('\n', out);
+  put_recycle_decl(type_descriptor, out);
+  fputs(" {\n", out);
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &recycle_field_visitor, &info);
+  put_unused_recycle_params(info.uses, "  ", out);
+  fputs("}\n", out);
+  return !info.seen_error;
+}
+
+static bool gen_list_recycle(type_descriptor_t const *const type_descriptor,
+                             types_list_t const *const types_list,
+                             FILE *const out) {
+  list_info_t info = {.seen_error = false, .seen_capacity = false,
+                      .seen_count = false};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &list_visitor, &info);
+  if (info.seen_error) return false;
+  type_descriptor_t const *const inner_type = &types_list->data[
+      find(&types_list->names,
+           clang_getCString(clang_getTypeSpelling(info.data_type)))];
+  fputc('\n', out);
+  put_recycle_decl(type_descriptor, out);
+  fputs(" {\n"
+        "  for (size_t i = 0; i < value->count; ++i) {\n", out);
+  put_recycle(inner_type, "value->data[i]", "    ", out);
+  fputs("  }\n"
+        "  if (value->data != NULL) {\n"
+        "    yaml_loader_recycle(loader, value->data,\n"
+        "                        value->capacity * sizeof(*value->data));\n"
+        "  }\n"
+        "}\n", out);
+  return true;
+}
+
+static bool gen_tagged_recycle(type_descriptor_t const *const type_descriptor,
+                               types_list_t const *const types_list,
+                               FILE *const out) {
+  embed_tagged_info_t tagged = {.count = 0};
+  clang_visitChildren(type_declaration(type_descriptor->type),
+                      &embed_tagged_visitor, &tagged);
+  dump_constants_t constants;
+  if (!collect_constants(clang_getCursorType(tagged.children[0]),
+                         &constants)) {
+    return false;
+  }
+  dump_variants_t variants = {.data = malloc(16 * sizeof(*variants.data)),
+      .count = 0, .capacity = 16, .types_list = types_list,
+      .seen_error = false};
+  clang_visitChildren(clang_getTypeDeclaration(
+      clang_getCursorType(tagged.children[1])), &dump_variant_visitor,
+      &variants);
+  bool const ret = !variants.seen_error;
+  if (ret) {
+    fputc('\n', out);
+    put_recycle_decl(type_descriptor, out);
+    fprintf(out, " {\n"
+                 "  switch (value->%s) {\n",
+            clang_getCString(clang_getCursorSpelling(tagged.children[0])));
+    // the switch itself uses the value.
+    enum recycle_uses_t uses = USES_VALUE;
+    for (size_t i = 0; i < constants.count && i < variants.count; ++i) {
+      if (constants.data[i].skipped) continue;
+      char const *const name = variants.data[i].name;
+      char *const value = malloc(sizeof("value->") + strlen(name));
+      sprintf(value, "value->%s", name);
+      fprintf(out, "    case %s:\n", constants.data[i].name);
+      if (put_recycle(&variants.data[i].descriptor, value, "      ", out) ==
+          USES_LOADER) {
+        uses = USES_LOADER;
+      }
+      fputs("      break;\n", out);
+      free(value);
+    }
+    fputs("    default: break;\n"
+          "  }\n", out);
+    put_unused_recycle_params(uses, "  ", out);
+    fputs("}\n", out);
+  }
+  free(variants.data);
+  free_constants(&constants);
+  return ret;
+}
+
+/*
+ * Write the functions handing the allocations of values to a loader for
+ * reuse, for all structs, lists and tagged unions that loading into a value
+ * reaches, into the given file.
+ */
+static bool write_recyclers(types_list_t const *const list, FILE *const out) {
+  for (size_t i = 0; i < list->count; ++i) {
+    type_descriptor_t const *const type_descriptor = &list->data[i];
+    if (!type_descriptor->flags.recycled) continue;
+    bool ret;
+    if (type_descriptor->flags.list) {
+      ret = gen_list_recycle(type_descriptor, list, out);
+    } else if (type_descriptor->flags.tagged) {
+      ret = gen_tagged_recycle(type_descriptor, list, out);
+    } else {
+      ret = gen_struct_recycle(type_descriptor, list, out);
+    }
+    if (!ret) return false;
+  }
+  return true;
+}
+
+/*
+ * Set flags of the given descriptor to the values predefined types have.
+ */
+static void mark_as_predefined(type_descriptor_t *const descriptor) {
+  descriptor->type.kind = CXType_Unexposed;
+  descriptor->flags.tagged = false;
+  descriptor->flags.list = false;
+  descriptor->flags.view = false;
+  descriptor->flags.stream = false;
+  descriptor->flags.lazy = false;
+  descriptor->flags.lazy_target = false;
+  descriptor->flags.shared = false;
+  descriptor->flags.dedup = false;
+  descriptor->flags.shared_target = false;
+  // the runtime defines hash and equality functions for predefined types.
+  descriptor->flags.dedup_checked = true;
+  descriptor->flags.input_bound = false;
+  descriptor->flags.reconciled = false;
+  descriptor->flags.recycled = false;
+  descriptor->flags.pointer_target = false;
+  descriptor->flags.deferred = false;
+  descriptor->flags.custom_dumper = false;
+  descriptor->flags.custom_hash = false;
+  descriptor->flags.pointer = PTR_NONE;
+  descriptor->converter_name_len = 0;
+  descriptor->converter_decl = NULL;
+}
+
+#define KNOWN_TYPE(name, constructor) {\
+  /* disabled because it requires a reference to the runtime in the generator */ \
+  /*(void)&(constructor); // ensure constructor exists */\
+  type_descriptor_t desc = {\
+    .constructor_decl = "bool " #constructor,\
+    .constructor_name_len = sizeof(#constructor),\
+    .destructor_decl = NULL, .destructor_name_len = 0,\
+    .spelling = #name};\
+  mark_as_predefined(&desc);\
+  add_predefined(&types_list, #name, desc);\
+}
+
+int main(int const argc, char const *argv[]) {
+  cmdline_config_t config;
+  switch (process_cmdline_args(argc, argv, &config)) {
+    case ARGS_ERROR: return 1;
+    case ARGS_HELP: return 0;
+    case ARGS_SUCCESS: break;
+  }
+
+  char const **clang_args =
+      malloc((argc - config.first_clang_param + 1) * sizeof(char*));
+  clang_args[0] = "-std=c11";
+  for (size_t i = 1; i <= argc - config.first_clang_param; ++i) {
+    clang_args[i] = argv[i + config.first_clang_param - 1];
+  }
+
+  CXIndex index = clang_createIndex(0, 1);
+  CXTranslationUnit unit =
+      clang_parseTranslationUnit(index, config.input_file_path, clang_args,
+                                 argc - config.first_clang_param + 1,
+                                 NULL, 0, CXTranslationUnit_None);
+  if (unit == NULL) {
+    fprintf(stderr, "Unable to parse '%s'.\n", config.input_file_path);
+    return 1;
+  }
+
+  CXCursor const cursor = clang_getTranslationUnitCursor(unit);
+
+  types_list_t types_list = {.data = malloc(sizeof(type_descriptor_t) * 64),
+      .count = 0, .capacity = 64, .got_error = false};
+  types_list.names.count = 1;
+  types_list.names.nodes[0] = malloc(sizeof(typename_node_t));
+  memset(types_list.names.nodes[0]->followers, -1, 256 * sizeof(uint16_t));
+  types_list.names.nodes[0]->type_index = -1;
+
+  // known types
+  KNOWN_TYPE(short, yaml_construct_short);
+  KNOWN_TYPE(int, yaml_construct_int);
+  KNOWN_TYPE(long, yaml_construct_long);
+  KNOWN_TYPE(long long, yaml_construct_long_long);
+
+  KNOWN_TYPE(unsigned char, yaml_construct_unsigned_char);
+  KNOWN_TYPE(unsigned short, yaml_construct_unsigned_short);
+  KNOWN_TYPE(unsigned int, yaml_construct_unsigned);
+  KNOWN_TYPE(unsigned long, yaml_construct_unsigned_long);
+  KNOWN_TYPE(unsigned long long, yaml_construct_unsigned_long_long);
+  KNOWN_TYPE(size_t, yaml_construct_size_t);
+
+  KNOWN_TYPE(float, yaml_construct_float);
+  KNOWN_TYPE(double, yaml_construct_double);
+  KNOWN_TYPE(long double, yaml_construct_long_double);
+
+  KNOWN_TYPE(char, yaml_construct_char);
+  KNOWN_TYPE(_Bool, yaml_construct_bool);
+
+  type_info_t type_info = {.list = &types_list,
+      .constructor_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .destructor_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .dumper_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .hash_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .equal_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .handler_names = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .handler_items = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .lazy_targets = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .shared_targets = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16},
+      .pointer_targets = {.data = malloc(16 * sizeof(char*)),
+          .count = 0, .capacity = 16}};
+  type_info.recent_annotation.kind = ANN_NONE;
+  type_info.recent_annotation.param = NULL;
+  type_info.recent_def.kind = CXType_Unexposed;
+  clang_visitChildren(cursor, &discover_types, &type_info);
+  if (type_info.recent_annotation.param != NULL)
+    free(type_info.recent_annotation.param);
+
+  if (types_list.got_error) {
+    return 1;
+  }
+  for (size_t i = 0; i < type_info.lazy_targets.count; ++i) {
+    int const target_index =
+        find(&types_list.names, type_info.lazy_targets.data[i]);
+    if (target_index >= 0 &&
+        types_list.data[target_index].type.kind != CXType_Unexposed &&
+        clang_getCanonicalType(types_list.data[target_index].type).kind ==
+            CXType_Record) {
+      types_list.data[target_index].flags.lazy_target = true;
+    }
+  }
+  for (size_t i = 0; i < type_info.shared_targets.count; ++i) {
+    int const target_index =
+        find(&types_list.names, type_info.shared_targets.data[i]);
+    if (target_index >= 0) {
+      types_list.data[target_index].flags.shared_target = true;
+    }
+  }
+  for (size_t i = 0; i < type_info.pointer_targets.count; ++i) {
+    int const target_index =
+        find(&types_list.names, type_info.pointer_targets.data[i]);
+    if (target_index >= 0 && types_list.data[target_index].flags.dedup) {
+      types_list.data[target_index].flags.shared_target = true;
+    }
+  }
+  for (size_t i = 0; i < types_list.count; ++i) {
+    if (types_list.data[i].flags.dedup &&
+        !check_dedup(&types_list, &types_list.data[i],
+                     types_list.data[i].spelling)) {
+      return 1;
+    }
+  }
+  mark_input_bound(&types_list);
+  int root_index = find(&types_list.names, config.root_name);
+  if (root_index == -1) {
+    fprintf(stderr, "Did not find root type '%s'.\n", config.root_name);
+    return 1;
+  }
+  type_descriptor_t const *const root_type = &types_list.data[root_index];
+  mark_walked(&types_list, root_type, false);
+  mark_walked(&types_list, root_type, true);
+  char const *const type_spelling =
+      clang_getCString(clang_getTypeSpelling(root_type->type));
+  const char *const space = strchr(type_spelling, ' ');
+  char *const root_suffix = malloc(strlen(type_spelling) + 1);
+  strcpy(root_suffix, type_spelling);
+  if (space != NULL) root_suffix[space - type_spelling] = '_';
+
+  FILE *const header_out = fopen(config.output_header_path, "w");
+  if (header_out == NULL) {
+    fprintf(stderr, "unable to open '%s' for writing.\n",
+            config.output_header_path);
+    return 1;
+  }
+  fprintf(header_out,
+          "#include <yaml.h>\n"
+          "#include <yaml_loader.h>\n"
+          "#include <yaml_dumper.h>\n"
+          "#include <yaml_hash.h>\n"
+          "#include <yaml_reload.h>\n"
+          "#include <%s>\n", config.input_file_name);
+  fputs("\n/* main functions for loading / deallocating the root type */\n\n",
+        header_out);
+  fprintf(header_out,
+          "bool " LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader);\n"
+          "yaml_loader_status_t " NEXT_LOADER_PREFIX
+              "%s(%s *value, yaml_loader_t *loader);\n"
+          "bool " ALL_LOADER_PREFIX "%s(yaml_loader_t *loader,\n"
+          "    bool (*callback)(%s *value, void *context), void *context);\n"
+          "bool " BATCH_LOADER_PREFIX "%s(const char *const *paths, "
+          "size_t count,\n"
+          "    %s *values, yaml_loader_batch_result_t *results, "
+          "unsigned threads);\n"
+          "bool " PUSH_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader);\n"
+          "bool " STEP_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader);\n"
+          "bool " RELOADER_PREFIX "%s(%s *value, yaml_loader_t *loader,\n"
+          "    yaml_reload_changes_t *changes);\n"
+          "bool " INTO_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader);\n"
+          "void " DEALLOCATOR_PREFIX "%s(%s *value);\n",
+          root_suffix, type_spelling, root_suffix, type_spelling, root_suffix,
+          type_spelling, root_suffix, type_spelling, root_suffix,
+          type_spelling, root_suffix, type_spelling, root_suffix,
+          type_spelling, root_suffix, type_spelling, root_suffix,
+          type_spelling);
+  if (config.embed_path != NULL) {
+    fprintf(header_out,
+            "\n/* value of the document embedded at generation time */\n\n"
+            "extern const %s " EMBEDDED_PREFIX "%s;\n",
+            type_spelling, root_suffix);
+  }
+  write_force_decls(&types_list, header_out);
+  fputs("\n/* low-level functions; "
+        "only necessary when writing custom constructors */\n\n", header_out);
+  if (!write_decls(&type_info, header_out)) return 1;
+  write_hash_decls(&types_list, header_out);
+  fclose(header_out);
+
+  FILE *const out_impl = fopen(config.output_impl_path, "w");
+  if (out_impl == NULL) {
+    fprintf(stderr, "Unable to open '%s' for writing.\n",
+            config.output_impl_path);
+    return 1;
+  }
+  fprintf(out_impl,
+          "#include <yaml_constructor.h>\n"
+          "#include <yaml_hash.h>\n"
+          "#include <stdbool.h>\n"
+          "#include <stdint.h>\n"
+          "#include \"%s\"\n", config.output_header_name);
+
+  if (config.stack_size != 0) {
+    // deallocating does not recurse for each level of nesting.
+    for (size_t i = 0; i < types_list.count; ++i) {
+      types_list.data[i].flags.deferred = true;
+    }
+    mark_pointer_targets(&types_list);
+  }
+  write_static_decls(&types_list, out_impl);
+  write_shared_types(&types_list, out_impl);
+  if (!write_impls(&types_list, out_impl)) return 1;
+  if (!write_dumpers(&types_list, out_impl)) return 1;
+  if (!write_hashers(&types_list, out_impl)) return 1;
+  if (!write_reconcilers(&types_list, out_impl)) return 1;
+  if (!write_recyclers(&types_list, out_impl)) return 1;
+
+  char *const destructor_call =
+      render_destructor_call(root_type, "value", true);
+  // with a stack size, the document is constructed by construct_document on
+  // a separate stack, called by load_document.
+  char const *const document_function =
+      config.stack_size == 0 ? "load_document" : "construct_document";
   fprintf(out_impl,
-          "  char *old_locale = setlocale(LC_NUMERIC, NULL);\n"
-          "  setlocale(LC_NUMERIC, \"C\");\n"
+          "\nstatic yaml_loader_status_t %s(%s *value,\n"
+          "    yaml_loader_t *loader, bool accept_end) {\n"
           "  yaml_event_t event;\n"
-          "  if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "    loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "    return false;\n"
+          "  if (!yaml_loader_next_event(loader, &event)) {\n"
+          "    return YAML_LOADER_FAILED;\n"
           "  }\n"
           "  if (event.type == YAML_STREAM_START_EVENT) {\n"
-          "    yaml_event_delete(&event);\n"
-          "    if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "      loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "      return false;\n"
+          "    yaml_loader_event_delete(loader, &event);\n"
+          "    if (!yaml_loader_next_event(loader, &event)) {\n"
+          "      return YAML_LOADER_FAILED;\n"
           "    }\n"
           "  }\n"
+          "  if (accept_end && (event.type == YAML_STREAM_END_EVENT ||\n"
+          "                     event.type == YAML_NO_EVENT)) {\n"
+          "    yaml_loader_event_delete(loader, &event);\n"
+          "    return YAML_LOADER_END_OF_STREAM;\n"
+          "  }\n"
           "  if (!yaml_constructor_check_event_type(loader, &event, "
           "YAML_DOCUMENT_START_EVENT))\n"
-          "    return false;\n"
-          "  yaml_event_delete(&event);\n"
-          "  if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "    loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "    return false;\n"
+          "    return YAML_LOADER_FAILED;\n"
+          "  yaml_loader_event_delete(loader, &event);\n"
+          "  if (!yaml_loader_next_event(loader, &event)) {\n"
+          "    return YAML_LOADER_FAILED;\n"
           "  }\n"
-          "  bool ret = %.*s(value, loader, &event);\n"
-          "  if (ret) {\n"
-          "    yaml_event_delete(&event);\n"
-          "    if (yaml_parser_parse(loader->parser, &event) == 0) {\n"
-          "      loader->error_info.type = YAML_LOADER_ERROR_PARSER;\n"
-          "      return false;\n"
-          "    } else if (!yaml_constructor_check_event_type(loader, &event, "
-          "YAML_DOCUMENT_END_EVENT))\n"
-          "      return false;\n"
-          "    yaml_event_delete(&event);\n"
+          "  if (!%.*s(value, loader, &event)) return YAML_LOADER_FAILED;\n"
+          "  yaml_loader_event_delete(loader, &event);\n"
+          "  if (yaml_loader_next_event(loader, &event) &&\n"
+          "      yaml_constructor_check_event_type(loader, &event, "
+          "YAML_DOCUMENT_END_EVENT)) {\n"
+          "    yaml_loader_event_delete(loader, &event);\n"
+          "    return YAML_LOADER_DOCUMENT;\n"
           "  }\n"
-          "  setlocale(LC_NUMERIC, old_locale);\n"
-          "  return ret;\n"
-          "}\n", (int)root_type->constructor_name_len,
-          root_type->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE));
-  char *const destructor_call =
-      render_destructor_call(root_type, "value", true);
-  if (space == NULL) {
+          "  %s\n"
+          "  return YAML_LOADER_FAILED;\n"
+          "}\n", document_function, type_spelling,
+          (int)root_type->constructor_name_len,
+          root_type->constructor_decl + sizeof(CONSTRUCTOR_PREAMBLE),
+          destructor_call == NULL ? "" : destructor_call);
+  if (config.stack_size != 0) {
+    fprintf(out_impl,
+            "\n#define STACK_SIZE ((size_t)%zuu)\n"
+            "\ntypedef struct {\n"
+            "  %s *value;\n"
+            "  yaml_loader_t *loader;\n"
+            "  bool accept_end;\n"
+            "  yaml_loader_status_t status;\n"
+            "} document_call_t;\n"
+            "\nstatic void call_construct_document(void *arg) {\n"
+            "  document_call_t *const call = (document_call_t*)arg;\n"
+            "  call->status =\n"
+            "      construct_document(call->value, call->loader, "
+            "call->accept_end);\n"
+            "}\n"
+            "\nstatic yaml_loader_status_t load_document(%s *value,\n"
+            "    yaml_loader_t *loader, bool accept_end) {\n"
+            "  document_call_t call = {value, loader, accept_end, "
+            "YAML_LOADER_FAILED};\n"
+            "  if (!yaml_loader_call_on_stack(STACK_SIZE, "
+            "&call_construct_document,\n"
+            "                                 &call)) {\n"
+            "    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\n"
+            "  }\n"
+            "  return call.status;\n"
+            "}\n", config.stack_size, type_spelling, type_spelling);
+  }
+  fprintf(out_impl,
+          "\nbool " LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader) {\n"
+          "  yaml_constructor_locale_t locale;\n"
+          "  yaml_constructor_enter_c_locale(&locale);\n"
+          "  yaml_loader_status_t const status =\n"
+          "      load_document(value, loader, false);\n"
+          "  yaml_constructor_leave_c_locale(&locale);\n"
+          "  return status == YAML_LOADER_DOCUMENT;\n"
+          "}\n", root_suffix, type_spelling);
+  fprintf(out_impl,
+          "\nyaml_loader_status_t " NEXT_LOADER_PREFIX
+              "%s(%s *value, yaml_loader_t *loader) {\n"
+          "  yaml_constructor_locale_t locale;\n"
+          "  yaml_constructor_enter_c_locale(&locale);\n"
+          "  yaml_loader_status_t const status =\n"
+          "      load_document(value, loader, true);\n"
+          "  yaml_constructor_leave_c_locale(&locale);\n"
+          "  return status;\n"
+          "}\n", root_suffix, type_spelling);
+  fprintf(out_impl,
+          "\nbool " ALL_LOADER_PREFIX "%s(yaml_loader_t *loader,\n"
+          "    bool (*callback)(%s *value, void *context), void *context) {\n"
+          "  yaml_constructor_locale_t locale;\n"
+          "  yaml_constructor_enter_c_locale(&locale);\n"
+          "  %s value;\n"
+          "  yaml_loader_status_t status;\n"
+          "  while ((status = load_document(&value, loader, true)) ==\n"
+          "         YAML_LOADER_DOCUMENT) {\n"
+          "    if (!callback(&value, context)) break;\n"
+          "    // the callback is done with the document's view copies.\n"
+          "    yaml_loader_release_view_copies(loader);\n"
+          "  }\n"
+          "  yaml_constructor_leave_c_locale(&locale);\n"
+          "  return status != YAML_LOADER_FAILED;\n"
+          "}\n", root_suffix, type_spelling, type_spelling);
+  fprintf(out_impl,
+          "\nstatic bool load_untyped(void *value, yaml_loader_t *loader) {\n"
+          "  return " LOADER_PREFIX "%s((%s*)value, loader);\n"
+          "}\n"
+          "\nbool " BATCH_LOADER_PREFIX "%s(const char *const *paths, "
+          "size_t count,\n"
+          "    %s *values, yaml_loader_batch_result_t *results, "
+          "unsigned threads) {\n"
+          "  return yaml_loader_load_batch(paths, count, values, sizeof(%s),\n"
+          "      &load_untyped, results, threads);\n"
+          "}\n"
+          "\nbool " PUSH_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader) {\n"
+          "  return yaml_loader_init_push(loader, &load_untyped, value);\n"
+          "}\n"
+          "\nbool " STEP_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader) {\n"
+          "  return yaml_loader_start(loader, &load_untyped, value);\n"
+          "}\n", root_suffix, type_spelling, root_suffix, type_spelling,
+          type_spelling, root_suffix, type_spelling, root_suffix,
+          type_spelling);
+  // with -s, deallocating is deferred instead of recursing, so it runs on
+  // the caller's stack either way.
+  fprintf(out_impl,
+          "\nvoid " DEALLOCATOR_PREFIX "%s(%s *value) {\n"
+          "  %s\n"
+          "}\n", root_suffix, type_spelling,
+          destructor_call == NULL ? "" : destructor_call);
+  if (destructor_call != NULL) free(destructor_call);
+  fprintf(out_impl,
+          "\nbool " RELOADER_PREFIX "%s(%s *value, yaml_loader_t *loader,\n"
+          "    yaml_reload_changes_t *changes) {\n"
+          "  %s fresh;\n"
+          "  if (!" LOADER_PREFIX "%s(&fresh, loader)) return false;\n"
+          "  yaml_reload_changes_t ignored;\n"
+          "  if (changes == NULL) {\n"
+          "    yaml_reload_changes_init(&ignored);\n"
+          "    changes = &ignored;\n"
+          "  }\n", root_suffix, type_spelling, type_spelling, root_suffix);
+  put_reconcile(root_type, "fresh", "(*value)", NULL, "  ", out_impl);
+  fprintf(out_impl,
+          "  // value now holds what has not been taken over.\n"
+          "  " DEALLOCATOR_PREFIX "%s(value);\n"
+          "  *value = fresh;\n"
+          "  if (changes == &ignored) yaml_reload_changes_delete(&ignored);\n"
+          "  return true;\n"
+          "}\n", root_suffix);
+  if (config.stack_size == 0) {
     fprintf(out_impl,
-            "void " DEALLOCATOR_PREFIX "%s(%s *value) {\n"
-            "  %s\n"
-            "}\n", type_spelling, type_spelling,
-            destructor_call == NULL ? "" : destructor_call);
+            "\nstatic void recycle_document(%s *value, yaml_loader_t *loader) {\n",
+            type_spelling);
+    put_unused_recycle_params(
+        put_recycle(root_type, "(*value)", "  ", out_impl), "  ", out_impl);
+    fputs("}\n", out_impl);
   } else {
     fprintf(out_impl,
-            "void " DEALLOCATOR_PREFIX "%.*s_%s(%s *value) {\n"
-            "  %s\n"
-            "}\n", (int)(space - type_spelling), type_spelling, space + 1,
-            type_spelling, destructor_call == NULL ? "" : destructor_call);
+            "\ntypedef struct {\n"
+            "  %s *value;\n"
+            "  yaml_loader_t *loader;\n"
+            "} recycle_call_t;\n"
+            "\nstatic void call_recycle(void *arg) {\n"
+            "  %s *const value = ((recycle_call_t*)arg)->value;\n"
+            "  yaml_loader_t *const loader = ((recycle_call_t*)arg)->loader;\n",
+            type_spelling, type_spelling);
+    put_unused_recycle_params(
+        put_recycle(root_type, "(*value)", "  ", out_impl), "  ", out_impl);
+    fprintf(out_impl,
+            "}\n"
+            "\nstatic void recycle_document(%s *value, yaml_loader_t *loader) {\n"
+            "  recycle_call_t call = {value, loader};\n"
+            "  // without memory for the stack, try on the caller's stack.\n"
+            "  if (!yaml_loader_call_on_stack(STACK_SIZE, &call_recycle, "
+            "&call)) {\n"
+            "    call_recycle(&call);\n"
+            "  }\n"
+            "}\n", type_spelling);
   }
-  if (destructor_call != NULL) free(destructor_call);
+  fprintf(out_impl,
+          "\nbool " INTO_LOADER_PREFIX "%s(%s *value, yaml_loader_t *loader) {\n"
+          "  yaml_loader_begin_recycling(loader);\n"
+          "  recycle_document(value, loader);\n"
+          "  bool const ret = " LOADER_PREFIX "%s(value, loader);\n"
+          "  yaml_loader_end_recycling(loader);\n"
+          "  return ret;\n"
+          "}\n", root_suffix, type_spelling, root_suffix);
+  if (config.embed_path != NULL &&
+      !write_embedded(&types_list, root_type, config.embed_path, root_suffix,
+                      out_impl)) {
+    return 1;
+  }
+  free(root_suffix);
   fclose(out_impl);
 
   clang_disposeTranslationUnit(unit);
@@ -4,6 +4,7 @@
 #include <yaml_loader.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "yaml_loader.h"
@@ -19,6 +20,27 @@
 
 char* yaml_constructor_escape(const char* const string, size_t* const size);
 
+// branch hints for generated code. errors are rare, so error paths are
+// declared unlikely and error reporting is kept out of line.
+#if defined(__GNUC__) || defined(__clang__)
+#define YAML_CONSTRUCTOR_LIKELY(x) __builtin_expect(!!(x), 1)
+#define YAML_CONSTRUCTOR_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define YAML_CONSTRUCTOR_COLD __attribute__((cold, noinline))
+#else
+#define YAML_CONSTRUCTOR_LIKELY(x) (x)
+#define YAML_CONSTRUCTOR_UNLIKELY(x) (x)
+#define YAML_CONSTRUCTOR_COLD
+#endif
+
+/*
+ * fails with the given error type (one that defines expected) at the given
+ * event, which is moved into error_info, and a copy of the given expected
+ * string. on allocation failure, the event is deleted instead. always returns
+ * false.
+ */
+YAML_CONSTRUCTOR_COLD bool yaml_constructor_error(yaml_loader_t *loader,
+    yaml_event_t *event, yaml_loader_error_type_t type, const char *expected);
+
 #define YAML_CONSTRUCTOR_APPEND(list, ptr) do { \
   if ((list)->capacity == 0) {\
     if ((list)->data != NULL) free ((list)->data);\
@@ -45,6 +67,33 @@ char* yaml_constructor_escape(const char* const string, size_t* const size);
   }\
 } while (false)
 
+/*
+ * like YAML_CONSTRUCTOR_APPEND, but allocates through the given loader, so
+ * that recycled buffers are reused.
+ */
+#define YAML_CONSTRUCTOR_LOADER_APPEND(loader, list, ptr) do { \
+  if ((list)->count == (list)->capacity) { \
+    size_t const new_capacity = \
+        (list)->capacity == 0 ? 16 : (list)->capacity * 2; \
+    void *const newlist = \
+        yaml_loader_alloc(loader, sizeof(*(list)->data) * new_capacity); \
+    if (newlist == NULL) { \
+      (ptr) = NULL; \
+    } else { \
+      if ((list)->count != 0) { \
+        memcpy(newlist, (list)->data, sizeof(*(list)->data) * (list)->count); \
+      } \
+      yaml_loader_recycle(loader, (list)->data, \
+                          sizeof(*(list)->data) * (list)->capacity); \
+      (list)->data = newlist; \
+      (list)->capacity = new_capacity; \
+      (ptr) = &((list)->data[(list)->count++]); \
+    } \
+  } else { \
+    (ptr) = &((list)->data[(list)->count++]); \
+  } \
+} while (false)
+
 static inline bool yaml_constructor_check_event_type(
     yaml_loader_t *const loader, yaml_event_t *const event,
     yaml_event_type_t const expected) {
@@ -56,6 +105,36 @@ static inline bool yaml_constructor_check_event_type(
   } else return true;
 }
 
+/*
+ * accounts for allocating the given number of bytes while constructing the
+ * node starting with cur. fails if that exceeds the loader's max_bytes limit,
+ * in which case cur has been moved into error_info.
+ */
+static inline bool yaml_constructor_reserve(yaml_loader_t *const loader,
+    yaml_event_t *const cur, size_t const bytes) {
+  if (!loader->internal.limited) return true;
+  size_t const max = loader->internal.limits.max_bytes;
+  if (max != 0 && bytes > max - loader->internal.bytes) {
+    return yaml_loader_limit_error(loader, cur, "max_bytes");
+  }
+  loader->internal.bytes += bytes;
+  return true;
+}
+
+/*
+ * fails if the given number of items of the list starting with cur exceeds
+ * the loader's max_items limit, in which case cur has been moved into
+ * error_info.
+ */
+static inline bool yaml_constructor_check_items(yaml_loader_t *const loader,
+    yaml_event_t *const cur, size_t const count) {
+  size_t const max = loader->internal.limits.max_items;
+  if (max != 0 && count > max) {
+    return yaml_loader_limit_error(loader, cur, "max_items");
+  }
+  return true;
+}
+
 // the maximum string length (excluding null terminator) returned by
 // yaml_constructor_event_spelling
 #define YAML_CONSTRUCTOR_EVENT_SPELLING_MAX_LENGTH 14
@@ -89,6 +168,9 @@ bool yaml_construct_unsigned_long(unsigned long *const value,
 bool yaml_construct_unsigned_long_long(unsigned long long *const value,
 	yaml_loader_t *const loader, yaml_event_t *cur);
 
+bool yaml_construct_size_t(size_t *const value,
+	yaml_loader_t *const loader, yaml_event_t *cur);
+
 bool yaml_construct_float(float *const value,
 	yaml_loader_t *const loader, yaml_event_t *cur);
 
@@ -104,7 +186,156 @@ bool yaml_construct_string(char** const value,
 bool yaml_construct_char(char *const value, yaml_loader_t *const loader,
 	yaml_event_t* cur);
 
+/*
+ * constructs a view of the current scalar. If the loader reads from a string
+ * and the scalar's content is found verbatim in it, *ptr will point into the
+ * input. Else, the content is copied into storage owned by the loader.
+ * The view is not null-terminated.
+ */
+bool yaml_construct_view(char const **const ptr, size_t *const len,
+	yaml_loader_t *const loader, yaml_event_t* cur);
+
+/*
+ * skips the subtree starting at the current event and records its position in
+ * the input, so that it can be constructed later by a yaml_force_* function.
+ * *value is set to a tagged pointer referring to the record. Must only be
+ * called if yaml_constructor_can_defer returns true.
+ */
+bool yaml_construct_lazy(void **const value, yaml_loader_t *const loader,
+	yaml_event_t* cur);
+
+/*
+ * returns true iff the loader reads from a buffer, so that subtrees may be
+ * deferred with yaml_construct_lazy.
+ */
+static inline bool yaml_constructor_can_defer(
+    yaml_loader_t const *const loader) {
+  return loader->internal.input != NULL;
+}
+
+/*
+ * returns true iff the given value of a !lazy field refers to a subtree that
+ * has not been constructed yet.
+ */
+static inline bool yaml_constructor_is_lazy(void const *const value) {
+  return ((uintptr_t)value & 1) != 0;
+}
+
+/*
+ * deallocates the record of a subtree that has not been constructed.
+ */
+void yaml_constructor_lazy_free(void *const value);
+
+/*
+ * hash of a !lazy field's value that has not been constructed, computed from
+ * the source text of its subtree.
+ */
+uint64_t yaml_constructor_lazy_hash(void const *const value, uint64_t hash);
+
+/*
+ * returns true iff both given values of !lazy fields have not been
+ * constructed and have identical source text. Since the text is compared,
+ * values that are equal but written differently are not considered equal.
+ */
+bool yaml_constructor_lazy_equal(void const *const left,
+                                 void const *const right);
+
+/*
+ * header in front of the value of a !shared field. the union aligns the
+ * value for any type.
+ */
+typedef union {
+  size_t refs;
+  long double align_long_double;
+  long long align_long_long;
+  void *align_pointer;
+} yaml_constructor_shared_t;
+
+/*
+ * allocates the value of a !shared field, whose node starts with cur, with a
+ * reference count of 1. on failure, cur is deleted.
+ */
+bool yaml_constructor_shared_alloc(void **const value, size_t const size,
+	yaml_loader_t *const loader, yaml_event_t* cur);
+
+/*
+ * returns the number of references to the given value of a !shared field.
+ */
+static inline size_t yaml_constructor_shared_refs(void const *const value) {
+  return ((yaml_constructor_shared_t const*)value - 1)->refs;
+}
+
+/*
+ * drops a reference to the given value of a !shared field. returns true iff
+ * it has been the last one, in which case the caller destroys the value and
+ * deallocates it with yaml_constructor_shared_free.
+ */
+static inline bool yaml_constructor_shared_release(void *const value) {
+  return --((yaml_constructor_shared_t*)value - 1)->refs == 0;
+}
+
+void yaml_constructor_shared_free(void *const value);
+
+/*
+ * destroys the count values of the given size at data with destroy, then
+ * deallocates data. a call made by destroy only records its arguments, and
+ * the outermost call destroys the recorded values one after the other, so
+ * that deallocating deeply nested values does not need stack for each level.
+ * destructors generated with -s deallocate pointer targets and list items
+ * this way.
+ */
+void yaml_constructor_free_deferred(void *const data, size_t const count,
+    size_t const size, void (*const destroy)(void*));
+
+/*
+ * resolves the alias cur to the value of a !shared field that has been
+ * constructed from the aliased node, which must be of the given type, and
+ * adds a reference to it.
+ */
+bool yaml_construct_alias(void **const value,
+	yaml_loader_shared_type_t const *const type, yaml_loader_t *const loader,
+	yaml_event_t* cur);
+
+/*
+ * records the given value of a !shared field under the anchor of cur, the
+ * event it has been constructed from, if cur has one. fails only if memory
+ * runs out, in which case cur is deleted.
+ */
+bool yaml_constructor_anchor(yaml_loader_t *const loader, yaml_event_t* cur,
+	void *const value, yaml_loader_shared_type_t const *const type);
+
+/*
+ * returns the value of the given !dedup type constructed earlier in the
+ * document that is equal to the given one, whose reference is then released
+ * in favor of a new reference to the earlier value. returns the given value
+ * if there is none.
+ */
+void *yaml_constructor_dedup(yaml_loader_t *const loader, void *const value,
+	yaml_loader_shared_type_t const *const type);
+
 bool yaml_construct_bool(bool *const value, yaml_loader_t *const loader,
 	yaml_event_t* cur);
 
+/*
+ * numeric locale of the calling thread, saved by
+ * yaml_constructor_enter_c_locale.
+ */
+typedef struct {
+#ifdef _WIN32
+  int per_thread;
+  char *name;
+#else
+  void *previous;
+#endif
+} yaml_constructor_locale_t;
+
+/*
+ * switches the calling thread (and only that thread) to the C locale, so that
+ * numbers are parsed independently of the user's locale. The previous locale
+ * is saved in the given value and restored by yaml_constructor_leave_c_locale.
+ */
+void yaml_constructor_enter_c_locale(yaml_constructor_locale_t *const saved);
+
+void yaml_constructor_leave_c_locale(yaml_constructor_locale_t *const saved);
+
 #endif
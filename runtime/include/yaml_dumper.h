@@ -0,0 +1,196 @@
+#ifndef YAML_DUMPER_H
+#define YAML_DUMPER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef enum {
+  YAML_DUMPER_ERROR_NONE = 0,
+  YAML_DUMPER_ERROR_OUT_OF_MEMORY,
+  /**
+   * writing to the dumper's file failed.
+   */
+  YAML_DUMPER_ERROR_IO,
+  /**
+   * a value cannot be represented: a required pointer is NULL, a !lazy field
+   * has not been forced, an enum has an unknown value, or a !custom type has
+   * no dumper. error_type names the type of the value.
+   */
+  YAML_DUMPER_ERROR_VALUE
+} yaml_dumper_error_t;
+
+/**
+ * A block collection that is being written. Private, do not touch.
+ */
+typedef struct {
+  size_t indent, count;
+  bool mapping;
+} yaml_dumper_level_t;
+
+/**
+ * A value that has been written with an anchor. Private, do not touch.
+ */
+typedef struct {
+  const void *value;
+  size_t id;
+} yaml_dumper_anchor_t;
+
+/**
+ * Writes YAML in block style into a growable buffer. Generated yaml_dump_*
+ * functions write one node each; a node written at top level forms a
+ * document, and documents following the first one are separated by "---".
+ */
+typedef struct {
+  /**
+   * output that has not been written to file yet. Not null-terminated.
+   */
+  unsigned char *buffer;
+  size_t size, capacity;
+  /**
+   * file the buffer is written to when it is full and on yaml_dumper_flush,
+   * NULL if all output is kept in the buffer.
+   */
+  FILE *file;
+  yaml_dumper_error_t error;
+  /**
+   * for YAML_DUMPER_ERROR_VALUE: spelling of the type of the value.
+   */
+  const char *error_type;
+  /**
+   * number of documents written so far.
+   */
+  size_t documents;
+  /**
+   * internal state, do not touch.
+   */
+  struct {
+    struct {
+      yaml_dumper_level_t *data;
+      size_t count, capacity;
+    } levels;
+    const char *tag;
+    int position;
+    bool cbor;
+    /**
+     * values written with an anchor in the current document, as open
+     * addressing hash table whose size is a power of two (empty slots have a
+     * NULL value), and the anchor of the next node, 0 for none.
+     */
+    struct {
+      yaml_dumper_anchor_t *data;
+      size_t count, capacity;
+    } anchors;
+    size_t anchor;
+  } internal;
+} yaml_dumper_t;
+
+/**
+ * Initialize a dumper that keeps all output in its buffer.
+ */
+void yaml_dumper_init(yaml_dumper_t *dumper);
+
+/**
+ * Initialize a dumper that writes its output to the given file. Output is
+ * buffered; call yaml_dumper_flush after the last document.
+ */
+void yaml_dumper_init_file(yaml_dumper_t *dumper, FILE *file);
+
+/**
+ * Make the dumper write CBOR (RFC 8949) instead of YAML. Must be called right
+ * after initialization. Each document becomes a top-level data item, so
+ * multiple documents form a CBOR sequence. Numbers and booleans are written
+ * in their binary formats, strings as text strings, collections with
+ * indefinite length, and tagged nodes as tag 27 around [tag, node].
+ * yaml_loader_init_cbor loads the output.
+ */
+void yaml_dumper_use_cbor(yaml_dumper_t *dumper);
+
+/**
+ * Write the buffered output to the dumper's file, if it has one.
+ * @return false iff writing failed or an error occurred earlier.
+ */
+bool yaml_dumper_flush(yaml_dumper_t *dumper);
+
+/**
+ * Deallocate the dumper's buffers. Does not flush.
+ */
+void yaml_dumper_delete(yaml_dumper_t *dumper);
+
+/* low-level functions; only necessary when writing custom dumpers */
+
+/**
+ * Set the local tag (without the leading '!') of the next node. The string
+ * must stay valid until that node has been started.
+ */
+bool yaml_dumper_tag(yaml_dumper_t *dumper, const char *tag);
+
+/**
+ * Write a scalar with the given content, which must be valid UTF-8. It is
+ * written plain where possible and double-quoted otherwise.
+ */
+bool yaml_dumper_scalar(yaml_dumper_t *dumper, const char *value,
+                        size_t length);
+
+/**
+ * Write an alias instead of the given value, which has the given number of
+ * references, if it has already been written with an anchor in the current
+ * document. Else, if it has more than one reference, the next node, which
+ * must be the value, gets an anchor. Used for !shared fields; CBOR output
+ * repeats shared values instead.
+ * @return true iff an alias has been written or writing has failed.
+ */
+bool yaml_dumper_alias(yaml_dumper_t *dumper, const void *value, size_t refs);
+
+bool yaml_dumper_mapping_start(yaml_dumper_t *dumper);
+/**
+ * Write the key of the next mapping entry. The key is written as is and
+ * must be a valid plain scalar, like a C identifier.
+ */
+bool yaml_dumper_key(yaml_dumper_t *dumper, const char *key, size_t length);
+bool yaml_dumper_mapping_end(yaml_dumper_t *dumper);
+
+bool yaml_dumper_sequence_start(yaml_dumper_t *dumper);
+bool yaml_dumper_sequence_end(yaml_dumper_t *dumper);
+
+/**
+ * Fail with YAML_DUMPER_ERROR_VALUE for a value of the given type.
+ * @return false
+ */
+bool yaml_dumper_fail(yaml_dumper_t *dumper, const char *type);
+
+/* dumpers for predefined types */
+
+bool yaml_dump_short(const short *value, yaml_dumper_t *dumper);
+bool yaml_dump_int(const int *value, yaml_dumper_t *dumper);
+bool yaml_dump_long(const long *value, yaml_dumper_t *dumper);
+bool yaml_dump_long_long(const long long *value, yaml_dumper_t *dumper);
+
+bool yaml_dump_unsigned_char(const unsigned char *value,
+                             yaml_dumper_t *dumper);
+bool yaml_dump_unsigned_short(const unsigned short *value,
+                              yaml_dumper_t *dumper);
+bool yaml_dump_unsigned(const unsigned *value, yaml_dumper_t *dumper);
+bool yaml_dump_unsigned_long(const unsigned long *value,
+                             yaml_dumper_t *dumper);
+bool yaml_dump_unsigned_long_long(const unsigned long long *value,
+                                  yaml_dumper_t *dumper);
+bool yaml_dump_size_t(const size_t *value, yaml_dumper_t *dumper);
+
+/**
+ * floating point values are written with the fewest digits that read back
+ * as the same value.
+ */
+bool yaml_dump_float(const float *value, yaml_dumper_t *dumper);
+bool yaml_dump_double(const double *value, yaml_dumper_t *dumper);
+bool yaml_dump_long_double(const long double *value, yaml_dumper_t *dumper);
+
+bool yaml_dump_char(const char *value, yaml_dumper_t *dumper);
+bool yaml_dump_bool(const bool *value, yaml_dumper_t *dumper);
+
+/**
+ * Write a null-terminated string.
+ */
+bool yaml_dump_string(const char *value, yaml_dumper_t *dumper);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef YAML_HASH_H
+#define YAML_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Structural hashing used by the generated yaml_hash_* functions. A hash is
+ * threaded through the hashed parts of a value: each function takes the hash
+ * of everything before its value and returns it combined with the value.
+ * Hashes are not stable across platforms or versions of this library.
+ */
+
+#define YAML_HASH_P0 UINT64_C(0xa0761d6478bd642f)
+#define YAML_HASH_P1 UINT64_C(0xe7037ed1a0b428db)
+#define YAML_HASH_P2 UINT64_C(0x8ebc6af09c88c6e3)
+
+/**
+ * Multiply the given values to 128 bits and fold the halves.
+ */
+static inline uint64_t yaml_hash_mix(uint64_t const a, uint64_t const b) {
+#ifdef __SIZEOF_INT128__
+  __uint128_t const product = (__uint128_t)a * b;
+  return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+  uint64_t const a_lo = a & 0xffffffff, a_hi = a >> 32;
+  uint64_t const b_lo = b & 0xffffffff, b_hi = b >> 32;
+  uint64_t const lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  uint64_t const lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  uint64_t const cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+  uint64_t const high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+  return ((cross << 32) | (lo_lo & 0xffffffff)) ^ high;
+#endif
+}
+
+static inline uint64_t yaml_hash_integer(uint64_t const value,
+                                         uint64_t const hash) {
+  return yaml_hash_mix(value ^ YAML_HASH_P0, hash ^ YAML_HASH_P1);
+}
+
+/**
+ * Hash of a missing value, i.e. a NULL pointer.
+ */
+static inline uint64_t yaml_hash_null(uint64_t const hash) {
+  return yaml_hash_mix(YAML_HASH_P2, hash ^ YAML_HASH_P0);
+}
+
+uint64_t yaml_hash_bytes(const void *data, size_t length, uint64_t hash);
+
+/**
+ * Equal values hash equally: 0.0 and -0.0 are equal, and so are all NaNs.
+ */
+static inline uint64_t yaml_hash_floating(double const value,
+                                          uint64_t const hash) {
+  uint64_t bits = 0;
+  if (value != value) bits = UINT64_C(0x7ff8000000000000);
+  else if (value != 0) memcpy(&bits, &value, sizeof(bits));
+  return yaml_hash_integer(bits, hash);
+}
+
+/* hash and equality of predefined types */
+
+#define YAML_HASH_DEFINE_INTEGER(suffix, type)\
+  static inline uint64_t yaml_hash_##suffix(const type *const value,\
+                                            uint64_t const hash) {\
+    return yaml_hash_integer((uint64_t)*value, hash);\
+  }\
+  static inline bool yaml_equal_##suffix(const type *const left,\
+                                         const type *const right) {\
+    return *left == *right;\
+  }
+
+#define YAML_HASH_DEFINE_FLOATING(suffix, type)\
+  static inline uint64_t yaml_hash_##suffix(const type *const value,\
+                                            uint64_t const hash) {\
+    return yaml_hash_floating((double)*value, hash);\
+  }\
+  static inline bool yaml_equal_##suffix(const type *const left,\
+                                         const type *const right) {\
+    return *left == *right || (*left != *left && *right != *right);\
+  }
+
+YAML_HASH_DEFINE_INTEGER(short, short)
+YAML_HASH_DEFINE_INTEGER(int, int)
+YAML_HASH_DEFINE_INTEGER(long, long)
+YAML_HASH_DEFINE_INTEGER(long_long, long long)
+YAML_HASH_DEFINE_INTEGER(unsigned_char, unsigned char)
+YAML_HASH_DEFINE_INTEGER(unsigned_short, unsigned short)
+YAML_HASH_DEFINE_INTEGER(unsigned, unsigned)
+YAML_HASH_DEFINE_INTEGER(unsigned_long, unsigned long)
+YAML_HASH_DEFINE_INTEGER(unsigned_long_long, unsigned long long)
+YAML_HASH_DEFINE_INTEGER(size_t, size_t)
+YAML_HASH_DEFINE_FLOATING(float, float)
+YAML_HASH_DEFINE_FLOATING(double, double)
+YAML_HASH_DEFINE_FLOATING(long_double, long double)
+YAML_HASH_DEFINE_INTEGER(char, char)
+YAML_HASH_DEFINE_INTEGER(bool, bool)
+
+/**
+ * Hash of a null-terminated string, which may be NULL.
+ */
+static inline uint64_t yaml_hash_string(const char *const value,
+                                        uint64_t const hash) {
+  return value == NULL ? yaml_hash_null(hash) :
+                         yaml_hash_bytes(value, strlen(value), hash);
+}
+
+static inline bool yaml_equal_string(const char *const left,
+                                     const char *const right) {
+  return left == right ||
+         (left != NULL && right != NULL && strcmp(left, right) == 0);
+}
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <yaml.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <yaml_tape.h>
 
 /**
  * List of possible errors that may have occurred.
@@ -63,14 +66,176 @@ typedef enum {
    */
   YAML_LOADER_ERROR_OUT_OF_MEMORY = 8,
   /**
-   * A user-defined error in a custom constructor has been encountered.
+   * A user-defined error in a custom constructor has been encountered, or the
+   * handler of a stream item returned false.
    *
    * event must be set to the event at which the error occurred. Other
-   * information must be transported via the data field.
+   * information must be transported via the data field. For stream handlers,
+   * event is set to the start event of the rejected item.
    */
-  YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR = 9
+  YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR = 9,
+  /**
+   * An input file could not be opened. Only reported by batch loading.
+   */
+  YAML_LOADER_ERROR_FILE = 10,
+  /**
+   * Loading has been aborted because the loader's deadline has passed or its
+   * cancellation flag has been set, or because the loader has been deleted
+   * while loading was suspended.
+   */
+  YAML_LOADER_ERROR_CANCELLED = 11,
+  /**
+   * A limit set with yaml_loader_set_limits has been exceeded.
+   *
+   * event will be set to the event at which the limit has been exceeded,
+   * expected to the name of the limit's field (e.g. "max_depth").
+   */
+  YAML_LOADER_ERROR_LIMIT = 12,
+  /**
+   * An alias refers to an anchor that has not been constructed as value of a
+   * !shared field in the current document, or to one of a different type.
+   *
+   * event will be set to the alias, expected to the expected type.
+   */
+  YAML_LOADER_ERROR_ALIAS = 13
 } yaml_loader_error_type_t;
 
+/**
+ * Result of loading the next document from a stream.
+ */
+typedef enum {
+  /**
+   * A document has been loaded into the given value.
+   */
+  YAML_LOADER_DOCUMENT = 0,
+  /**
+   * The stream does not contain any more documents. Nothing has been loaded.
+   */
+  YAML_LOADER_END_OF_STREAM = 1,
+  /**
+   * Loading has failed. The loader's error_info describes the error.
+   */
+  YAML_LOADER_FAILED = 2,
+  /**
+   * A loader fed with yaml_loader_feed has consumed all input given to it
+   * and waits for more.
+   */
+  YAML_LOADER_NEED_MORE = 3,
+  /**
+   * A loader advanced with yaml_loader_step has used up the step's budget
+   * without completing the document.
+   */
+  YAML_LOADER_SUSPENDED = 4
+} yaml_loader_status_t;
+
+/**
+ * Source range of a subtree whose construction has been deferred with !lazy.
+ * Private, do not touch.
+ */
+typedef struct {
+  /**
+   * input buffer the range lies in, and its size.
+   */
+  const unsigned char *input;
+  size_t input_size;
+  /**
+   * byte offsets of the subtree's first and past-the-end bytes.
+   */
+  size_t start, end;
+  /**
+   * position of the subtree's first character in the input.
+   */
+  size_t line, column;
+} yaml_loader_lazy_t;
+
+/**
+ * Type of the values of !shared fields. The generated code defines one for
+ * each type that is the target of such a field.
+ */
+typedef struct {
+  /**
+   * spelling of the type.
+   */
+  const char *name;
+  /**
+   * drops a reference to a value, destroying and deallocating it if it has
+   * been the last one.
+   */
+  void (*release)(void *value);
+  /**
+   * structural hash and equality of two values. NULL unless the type is
+   * !dedup.
+   */
+  uint64_t (*hash)(const void *value);
+  bool (*equal)(const void *left, const void *right);
+} yaml_loader_shared_type_t;
+
+/**
+ * Value of a !shared field that has been constructed from a node with an
+ * anchor. Holds a reference to the value. Private, do not touch.
+ */
+typedef struct {
+  char *name;
+  void *value;
+  const yaml_loader_shared_type_t *type;
+} yaml_loader_anchor_t;
+
+/**
+ * Value of a !dedup type that other equal values are replaced with. Holds a
+ * reference to the value. Private, do not touch.
+ */
+typedef struct {
+  void *value;
+  uint64_t hash;
+  const yaml_loader_shared_type_t *type;
+} yaml_loader_dedup_t;
+
+/**
+ * number of buckets of recycled buffers, one per binary order of magnitude of
+ * their size.
+ */
+#define YAML_LOADER_BUCKETS 64
+
+/**
+ * Buffers of a previous value that constructors may reuse, see
+ * yaml_loader_recycle. A bucket holds buffers whose size has the bucket's
+ * index as binary logarithm, rounded down. Private, do not touch.
+ */
+typedef struct {
+  struct {
+    void *buffer;
+    size_t size;
+  } *data;
+  size_t count, capacity;
+} yaml_loader_bucket_t;
+
+/**
+ * Limits on the resources a single load may use, see yaml_loader_set_limits.
+ * A limit of 0 means no limit.
+ */
+typedef struct {
+  /**
+   * total number of bytes allocated for strings and for the storage of lists.
+   */
+  size_t max_bytes;
+  /**
+   * total number of nodes, i.e. scalars, sequences, mappings and aliases.
+   */
+  size_t max_nodes;
+  /**
+   * number of items of a single list.
+   */
+  size_t max_items;
+  /**
+   * length of a single scalar in bytes.
+   */
+  size_t max_string_length;
+  /**
+   * nesting depth of sequences and mappings.
+   */
+  size_t max_depth;
+} yaml_loader_limits_t;
+
 typedef struct {
   struct {
     /**
@@ -112,6 +277,113 @@ typedef struct {
    */
   struct {
     bool external_parser;
+    /**
+     * input buffer of string loaders, NULL for other loaders. Used for
+     * constructing views into the input.
+     */
+    const unsigned char *input;
+    size_t input_size;
+    /**
+     * last position (character index and byte offset) that has been mapped
+     * from a libyaml mark to the input buffer.
+     */
+    size_t mapped_index, mapped_offset;
+    /**
+     * character index and byte offset at which the input starts. Mapping
+     * restarts from here when a mark lies before the last mapped position.
+     */
+    size_t base_index, base_offset;
+    /**
+     * subtree being parsed by a loader initialized with yaml_loader_init_lazy,
+     * and the number of bytes of it that have already been handed to the
+     * parser (including padding). NULL for other loaders.
+     */
+    const yaml_loader_lazy_t *lazy;
+    size_t lazy_pos;
+    /**
+     * tape events are read from, NULL if they are read from the parser.
+     * tape_pos is the index of the next event, tape_current the index of the
+     * most recently read one.
+     */
+    const yaml_tape_t *tape;
+    size_t tape_pos, tape_current;
+    /**
+     * tape JSON and CBOR input is recorded into without the parser, NULL if
+     * the loader has not read such input yet. tape points to it while reading
+     * such input.
+     */
+    yaml_tape_t *scanned;
+    /**
+     * CBOR input being read, NULL while reading text. input is NULL then.
+     */
+    const unsigned char *binary;
+    size_t binary_size;
+    /**
+     * ring buffer filled by a parser thread, NULL if events are read from the
+     * parser on the calling thread. See yaml_loader_use_pipeline.
+     */
+    struct yaml_loader_pipeline_s *pipeline;
+    /**
+     * state of a loader fed with yaml_loader_feed or advanced with
+     * yaml_loader_step, NULL for other loaders.
+     */
+    struct yaml_loader_resumable_s *resumable;
+    /**
+     * maximum number of threads used for constructing a list.
+     */
+    unsigned threads;
+    /**
+     * deadline of loading (0 for none), the cancellation flag (NULL for
+     * none), and the number of events until they are checked again.
+     */
+    uint64_t deadline;
+    const volatile bool *cancel;
+    unsigned check_countdown;
+    /**
+     * limits set with yaml_loader_set_limits, whether any have been set, and
+     * the resources used so far. depth is only tracked if limited is set.
+     */
+    yaml_loader_limits_t limits;
+    bool limited;
+    size_t bytes, nodes, depth;
+    /**
+     * copies of scalars that could not be viewed in the input buffer. They
+     * are freed by yaml_loader_release_view_copies.
+     */
+    struct {
+      char **data;
+      size_t count, capacity;
+    } view_copies;
+    /**
+     * anchored values of !shared fields in the current document, and an open
+     * addressing hash table of indexes into data by name (SIZE_MAX marks
+     * empty slots) whose size is a power of two.
+     */
+    struct {
+      yaml_loader_anchor_t *data;
+      size_t count, capacity;
+      size_t *slots;
+      size_t slot_count;
+    } anchors;
+    /**
+     * values of !dedup types constructed in the current document, as open
+     * addressing hash table whose size is a power of two (empty slots have a
+     * NULL value).
+     */
+    struct {
+      yaml_loader_dedup_t *slots;
+      size_t count, slot_count;
+    } dedup;
+    /**
+     * buffers handed to yaml_loader_recycle, in YAML_LOADER_BUCKETS buckets
+     * (NULL until the loader first recycles), their total count, and whether
+     * the loader is recycling at all.
+     */
+    struct {
+      yaml_loader_bucket_t *buckets;
+      size_t count;
+      bool active;
+    } recycled;
   } internal;
 } yaml_loader_t;
 
@@ -125,11 +397,102 @@ bool yaml_loader_init_file(yaml_loader_t *loader, FILE *input);
 /**
  * Initialize the given loader to read the given string. If successful, it is
  * the caller's responsibility to destroy the loader with yaml_loader_destroy.
+ *
+ * Input starting with '{' or '[' (after whitespace) is scanned as JSON first,
+ * see yaml_loader_init_json; if it is not valid JSON, it is parsed as YAML.
+ *
+ * Values of types annotated with !view point into input, so input must
+ * outlive them. Scalars that cannot be viewed in input are copied into
+ * storage the loader frees when it is reset or deleted, see
+ * yaml_loader_release_view_copies.
  * @return true on success, false on failure.
  */
 bool yaml_loader_init_string(yaml_loader_t *loader, const unsigned char *input,
                              size_t size);
 
+/**
+ * Initialize the given loader to read the given JSON string. The input is
+ * recorded with yaml_tape_record_json into a tape owned by the loader, which
+ * is much faster than libyaml's parser, and loaded from that tape as if
+ * yaml_loader_use_tape had been called. Syntax errors are reported as
+ * YAML_LOADER_ERROR_PARSER with the parser's problem and problem_mark set.
+ * @return true on success, false on failure.
+ */
+bool yaml_loader_init_json(yaml_loader_t *loader, const unsigned char *input,
+                           size_t size);
+
+/**
+ * Initialize the given loader to read the given CBOR data, e.g. written by a
+ * dumper with yaml_dumper_use_cbor. The input is recorded with
+ * yaml_tape_record_cbor into a tape owned by the loader and loaded from that
+ * tape, so the generated constructors load it like the equivalent YAML.
+ * Since the input is not text, values of !view types are copied and !lazy
+ * fields are constructed right away. Malformed input is reported as
+ * YAML_LOADER_ERROR_PARSER with the parser's problem and problem_mark set;
+ * the mark's index and column hold the byte offset.
+ * @return true on success, false on failure.
+ */
+bool yaml_loader_init_cbor(yaml_loader_t *loader, const unsigned char *input,
+                           size_t size);
+
+/**
+ * Re-target a loader initialized with yaml_loader_init_string or
+ * yaml_loader_init_file at the given string, as if it had been deleted and
+ * initialized again, but keep the parser's and the loader's buffers instead
+ * of reallocating them. The thread count set with yaml_loader_set_threads
+ * and the limits set with yaml_loader_set_limits are kept; a tape or
+ * pipeline is detached. Like yaml_loader_delete, this deallocates scalars
+ * that have been copied for !view values.
+ * @return true on success, false if the loader uses an external parser or
+ *         the parser cannot be initialized (error_info.type is then
+ *         YAML_LOADER_ERROR_OUT_OF_MEMORY; the loader must be deleted).
+ */
+bool yaml_loader_reset_string(yaml_loader_t *loader,
+                              const unsigned char *input, size_t size);
+
+/**
+ * Like yaml_loader_reset_string, but re-target the loader at the given file.
+ */
+bool yaml_loader_reset_file(yaml_loader_t *loader, FILE *input);
+
+/**
+ * Take a loader for the given string from the calling thread's pool of
+ * loaders, or initialize a new one if the pool is empty. The loader must be
+ * given back with yaml_loader_release instead of being deleted.
+ * @return the loader, or NULL if there is not enough memory.
+ */
+yaml_loader_t *yaml_loader_acquire_string(const unsigned char *input,
+                                          size_t size);
+
+/**
+ * Give a loader obtained from yaml_loader_acquire_string back to the calling
+ * thread's pool, which keeps a few loaders for reuse and deletes the others.
+ * Like yaml_loader_delete, this deallocates scalars that have been copied for
+ * !view values.
+ */
+void yaml_loader_release(yaml_loader_t *loader);
+
+/**
+ * Delete all loaders in the calling thread's pool and the stack kept by
+ * yaml_loader_call_on_stack. Threads that have used
+ * yaml_loader_acquire_string or code generated with -s should call this
+ * before they exit.
+ */
+void yaml_loader_pool_clear(void);
+
+/**
+ * Call func(arg) on a heap-allocated stack of at least stack_size bytes
+ * instead of the calling thread's stack, so that deeply nested documents can
+ * be constructed on threads with small stacks. The stack is kept for the next
+ * call on the same thread. Code generated with -s runs its loading functions
+ * this way. While func runs, loading a mapping or sequence fails with
+ * YAML_LOADER_ERROR_LIMIT for the limit "stack_size" once less than 64 KiB
+ * (or half of stack_size, if smaller) of the stack are left.
+ * @return true if func has been called, false if there is not enough memory.
+ */
+bool yaml_loader_call_on_stack(size_t stack_size, void (*func)(void*),
+                               void *arg);
+
 /**
  * Initialize the given loader to use the given parser. The parser may already
  * have read documents successfully, the next event must be a document start or
@@ -140,8 +503,355 @@ bool yaml_loader_init_string(yaml_loader_t *loader, const unsigned char *input,
  */
 bool yaml_loader_init_parser(yaml_loader_t *loader, yaml_parser_t *parser);
 
+/**
+ * Initialize the given loader to construct a subtree whose construction has
+ * been deferred with !lazy. value is the content of the !lazy field. If it
+ * refers to a recorded subtree, the loader is set up to parse it and root is
+ * set to the subtree's first event, which is owned by the caller. If the
+ * subtree has already been constructed, root->type is set to YAML_NO_EVENT.
+ *
+ * The loader is initialized even if this function fails and must always be
+ * destroyed with yaml_loader_delete. It reports errors at the subtree's
+ * position in the original input.
+ *
+ * This function is called by the generated yaml_force_* functions; there is
+ * usually no need to call it directly.
+ * @return true on success, false on failure (error_info describes the error).
+ */
+bool yaml_loader_init_lazy(yaml_loader_t *loader, const void *value,
+                           yaml_event_t *root);
+
+/**
+ * Record all remaining events of the loader's parser into the given tape and
+ * read events from the tape afterwards. The tape keeps its buffers between
+ * recordings, so reusing one tape for multiple loads avoids reallocation.
+ *
+ * A parser error is reported when loading reaches the position where it
+ * occurred. The tape must outlive the loader, since events in error_info
+ * refer to it.
+ * @return true on success, false if recording ran out of memory.
+ */
+bool yaml_loader_use_tape(yaml_loader_t *loader, yaml_tape_t *tape);
+
+/**
+ * Run the loader's parser on a separate thread, so that parsing overlaps with
+ * constructing values. The parser thread hands events to the loader through a
+ * ring buffer; the events' strings are passed on without being copied.
+ *
+ * The parser thread reads ahead up to the end of the stream. When the loader
+ * is deleted, the thread is stopped and unread events are discarded, so a
+ * loader initialized with yaml_loader_init_parser leaves its parser at an
+ * unspecified position. Must not be combined with yaml_loader_use_tape, which
+ * consumes the whole input before loading anyway.
+ * @return true on success, false if the thread could not be started
+ *         (error_info is set).
+ */
+bool yaml_loader_use_pipeline(yaml_loader_t *loader);
+
+/**
+ * Abort loading with YAML_LOADER_ERROR_CANCELLED once yaml_loader_clock() has
+ * reached the given deadline (in nanoseconds). 0 removes the deadline. The
+ * deadline is checked every few events, so loading may run slightly over it.
+ */
+void yaml_loader_set_deadline(yaml_loader_t *loader, uint64_t deadline);
+
+/**
+ * Abort loading with YAML_LOADER_ERROR_CANCELLED once *cancel has become true.
+ * The flag may be set from any thread and is checked every few events; it
+ * must outlive loading. NULL removes the flag.
+ */
+void yaml_loader_set_cancel_flag(yaml_loader_t *loader,
+                                 const volatile bool *cancel);
+
+/**
+ * Limit the resources loading may use, so that hostile input cannot exhaust
+ * memory or the stack. Exceeding a limit fails loading with
+ * YAML_LOADER_ERROR_LIMIT. Must be called before loading starts. Subtrees
+ * deferred with !lazy are constructed by separate loaders, which are not
+ * subject to these limits; nor is recording an event tape.
+ */
+void yaml_loader_set_limits(yaml_loader_t *loader,
+                            yaml_loader_limits_t const *limits);
+
+/**
+ * Fail with YAML_LOADER_ERROR_LIMIT because the limit with the given name has
+ * been exceeded at the given event, which is moved into error_info. Used by
+ * constructors checking the limits set with yaml_loader_set_limits.
+ * @return false
+ */
+bool yaml_loader_limit_error(yaml_loader_t *loader, yaml_event_t *event,
+                             const char *limit);
+
+/**
+ * Record the given value of a !shared field of the given type under the given
+ * anchor, so that aliases later in the document resolve to it. A later anchor
+ * with the same name replaces it. The loader holds a reference to the value
+ * until the end of the document.
+ * @return false iff memory runs out.
+ */
+bool yaml_loader_add_anchor(yaml_loader_t *loader, const char *anchor,
+                            void *value,
+                            const yaml_loader_shared_type_t *type);
+
+/**
+ * Return the most recent anchor of the current document with the given name,
+ * NULL if there is none.
+ */
+const yaml_loader_anchor_t *yaml_loader_find_anchor(
+    yaml_loader_t const *loader, const char *anchor);
+
+/**
+ * Return a value of the given !dedup type that has been recorded in the
+ * current document and is equal to the given one, which has the given hash.
+ * If there is none, record the given value, holding a reference to it until
+ * the end of the document, and return it.
+ * Running out of memory is not an error; the value is returned unrecorded.
+ */
+void *yaml_loader_dedup(yaml_loader_t *loader, void *value, uint64_t hash,
+                        const yaml_loader_shared_type_t *type);
+
+/**
+ * Make the loader collect the buffers given to yaml_loader_recycle, so that
+ * constructors reuse them until yaml_loader_end_recycling is called. Used by
+ * the generated yaml_load_into_* functions.
+ */
+void yaml_loader_begin_recycling(yaml_loader_t *loader);
+
+/**
+ * Give a buffer of at least size bytes, allocated with malloc, to the loader
+ * for reuse by constructors. Frees the buffer if the loader is not
+ * recycling.
+ */
+void yaml_loader_recycle(yaml_loader_t *loader, void *buffer, size_t size);
+
+/**
+ * Free the recycled buffers that have not been reused and stop recycling.
+ * The loader keeps its bookkeeping for the next time it recycles.
+ */
+void yaml_loader_end_recycling(yaml_loader_t *loader);
+
+/**
+ * Take a recycled buffer of at least the given size, or allocate one if
+ * there is none. Use yaml_loader_alloc instead.
+ */
+void *yaml_loader_reuse(yaml_loader_t *loader, size_t size);
+
+/**
+ * Allocate a buffer of the given size for a value being constructed,
+ * reusing a recycled one if possible. The buffer is freed with free.
+ */
+static inline void *yaml_loader_alloc(yaml_loader_t *const loader,
+                                      size_t const size) {
+  return loader->internal.recycled.count == 0 ?
+      malloc(size) : yaml_loader_reuse(loader, size);
+}
+
+/**
+ * Read the next event into the given event. On failure, error_info is set.
+ * Constructors must use this instead of yaml_parser_parse, because the event
+ * may come from a tape.
+ * @return true on success, false on failure.
+ */
+bool yaml_loader_next_event(yaml_loader_t *loader, yaml_event_t *event);
+
+/**
+ * Delete an event read by yaml_loader_next_event. Constructors must use this
+ * instead of yaml_event_delete.
+ */
+void yaml_loader_event_delete(yaml_loader_t *loader, yaml_event_t *event);
+
+/**
+ * Skip the remaining events of the node starting with the given event, which
+ * has been the last one read. When reading from a tape, this takes constant
+ * time unless limits are set, in which case the skipped nodes are counted.
+ * end_mark is set to the end of the node.
+ * @return true on success, false on failure (error_info is set).
+ */
+bool yaml_loader_skip(yaml_loader_t *loader, yaml_event_t const *start,
+                      yaml_mark_t *end_mark);
+
+/**
+ * Return the number of items of the sequence starting with the given event,
+ * which has been the last one read, if known (i.e. when reading from a tape),
+ * else 0. Used for sizing lists.
+ */
+size_t yaml_loader_sequence_length(yaml_loader_t const *loader,
+                                   yaml_event_t const *start);
+
+/**
+ * Set the maximum number of threads used for constructing the items of a
+ * single list. Lists are only constructed in parallel when reading from a
+ * tape (see yaml_loader_use_tape) and when they are large enough. The default
+ * is 1, i.e. no parallel construction.
+ *
+ * Custom constructors must be thread-safe when this is used.
+ */
+void yaml_loader_set_threads(yaml_loader_t *loader, unsigned threads);
+
+/**
+ * Constructor of a single list item, called with a pointer to the item's slot.
+ */
+typedef bool (*yaml_loader_item_constructor_t)(void *item,
+    yaml_loader_t *loader, yaml_event_t *cur);
+
+/**
+ * Destructor of a single list item.
+ */
+typedef void (*yaml_loader_item_destructor_t)(void *item);
+
+/**
+ * Return true iff the items of the sequence starting with the given event,
+ * which has been the last one read, should be constructed in parallel with
+ * yaml_loader_construct_items.
+ */
+bool yaml_loader_parallel(yaml_loader_t const *loader,
+                          yaml_event_t const *start);
+
+/**
+ * Construct all items of the current sequence into data, which must have
+ * room for yaml_loader_sequence_length items of the given size, on multiple
+ * threads. Consumes the sequence including its end event.
+ *
+ * If constructing any item fails, all constructed items are destroyed and
+ * error_info describes the first error in document order.
+ * @return true on success, false on failure.
+ */
+bool yaml_loader_construct_items(yaml_loader_t *loader, void *data,
+                                 size_t item_size,
+                                 yaml_loader_item_constructor_t constructor,
+                                 yaml_loader_item_destructor_t destructor);
+
+/**
+ * Outcome of loading a single file with yaml_loader_load_batch.
+ */
+typedef struct {
+  /**
+   * YAML_LOADER_ERROR_NONE if the file has been loaded, else the error that
+   * occurred.
+   */
+  yaml_loader_error_type_t type;
+  /**
+   * Position of the error in the file: the parser's problem mark on
+   * YAML_LOADER_ERROR_PARSER, else the start of the violating event, if any.
+   */
+  yaml_mark_t mark;
+  /**
+   * Description of a parser error (a static string), else NULL.
+   */
+  const char *problem;
+  /**
+   * error_info.expected, if the error type defines it, else NULL. Owned by the
+   * caller, who must free it.
+   */
+  char *expected;
+} yaml_loader_batch_result_t;
+
+/**
+ * Function loading a whole document into value, e.g. a yaml_load_* function.
+ */
+typedef bool (*yaml_loader_document_loader_t)(void *value,
+                                              yaml_loader_t *loader);
+
+/**
+ * Load each of count files into the corresponding slot of values, whose items
+ * have the given size, on up to the given number of threads (including the
+ * calling one). Threads that run out of files take over a part of the
+ * remaining files of another thread. Each thread reuses its loader and parser
+ * for all of its files.
+ *
+ * The outcome of loading paths[i] is stored in results[i]; values[i] is only
+ * valid if loading succeeded. The generated yaml_load_batch_* functions call
+ * this for their root type; there is usually no need to call it directly.
+ * Types with !view fields must not be loaded this way, since the loaders
+ * owning copied scalars do not outlive the batch.
+ * @return true iff all files have been loaded successfully.
+ */
+bool yaml_loader_load_batch(const char *const *paths, size_t count,
+                            void *values, size_t value_size,
+                            yaml_loader_document_loader_t load,
+                            yaml_loader_batch_result_t *results,
+                            unsigned threads);
+
+/**
+ * Initialize the given loader to load a document into value with the given
+ * function while the input is handed to it piece by piece with
+ * yaml_loader_feed. Loading runs on a separate stack and is suspended when
+ * the loader runs out of input, so the calling thread never blocks. The
+ * generated yaml_push_* functions call this for their root type.
+ *
+ * The separate stack has 1 MiB. Documents nested too deeply for it fail with
+ * YAML_LOADER_ERROR_LIMIT, and error_info.expected is "stack_size".
+ *
+ * As with yaml_loader_init_file, !view values are copied and !lazy fields are
+ * constructed immediately.
+ * @return true on success, false if there is not enough memory.
+ */
+bool yaml_loader_init_push(yaml_loader_t *loader,
+                           yaml_loader_document_loader_t load, void *value);
+
+/**
+ * Continue loading with the given input, which may end anywhere, even within
+ * a token. The input is consumed completely before this function returns, so
+ * the buffer may be reused afterwards. A length of 0 marks the end of the
+ * input.
+ * @return YAML_LOADER_NEED_MORE if all input has been consumed without
+ *         completing the document, YAML_LOADER_DOCUMENT if the document has
+ *         been loaded, YAML_LOADER_FAILED on failure (error_info describes the
+ *         error). Once loading has finished, further calls return the same
+ *         status.
+ */
+yaml_loader_status_t yaml_loader_feed(yaml_loader_t *loader,
+                                      const unsigned char *input,
+                                      size_t length);
+
+/**
+ * Prepare loading a document into value with the given function in steps
+ * of yaml_loader_step. The loader may have been initialized with any function
+ * but yaml_loader_init_push. Like loaders fed with yaml_loader_feed, loading
+ * runs on a separate stack of 1 MiB, and documents nested too deeply for it
+ * fail with YAML_LOADER_ERROR_LIMIT. The generated yaml_start_* functions
+ * call this for their root type.
+ * @return true on success, false if there is not enough memory or the loader
+ *         already loads in steps or from pushed input.
+ */
+bool yaml_loader_start(yaml_loader_t *loader,
+                       yaml_loader_document_loader_t load, void *value);
+
+/**
+ * Continue loading a document started with yaml_loader_start for at most
+ * max_events events (0 for no limit) and until the given deadline of
+ * yaml_loader_clock, which is checked every few events (0 for none). Each step
+ * reads at least one event.
+ * @return YAML_LOADER_SUSPENDED if the document is not complete yet,
+ *         YAML_LOADER_DOCUMENT if the document has been loaded,
+ *         YAML_LOADER_FAILED on failure (error_info describes the error).
+ *         Once loading has finished, further calls return the same status.
+ */
+yaml_loader_status_t yaml_loader_step(yaml_loader_t *loader,
+                                      size_t max_events, uint64_t deadline);
+
+/**
+ * Return the time of a monotonic clock in nanoseconds, for computing
+ * deadlines.
+ */
+uint64_t yaml_loader_clock(void);
+
+/**
+ * Free the scalars the loader has copied for !view values because they could
+ * not be viewed in the input, so values referring to them must no longer be
+ * used. The generated yaml_load_all functions call this after each callback
+ * so that memory does not grow with the number of documents.
+ */
+void yaml_loader_release_view_copies(yaml_loader_t *loader);
+
 /**
  * Destroys a loader that has successfully been initialized.
+ *
+ * This also deallocates scalars that have been copied for !view values
+ * because they could not be viewed in the input, so the loader must outlive
+ * such values. If a loader fed with yaml_loader_feed or advanced with
+ * yaml_loader_step has not finished, loading is aborted and the partially
+ * constructed value is deallocated.
  */
 void yaml_loader_delete(yaml_loader_t *loader);
 
@@ -0,0 +1,82 @@
+#ifndef YAML_PREFETCH_H
+#define YAML_PREFETCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A file that has been submitted for reading. Private, do not touch.
+ */
+typedef struct {
+  size_t id;
+  int fd;
+  /**
+   * buffer holding the file's content. Kept for the next file read into this
+   * slot.
+   */
+  unsigned char *buffer;
+  size_t capacity;
+  /**
+   * size of the file when it was opened, and number of bytes read so far.
+   */
+  size_t size, filled;
+  /**
+   * true if all of the file has been read or reading has failed.
+   */
+  bool done, failed;
+} yaml_prefetch_slot_t;
+
+/**
+ * Reads files ahead of loading them. Up to depth files are read in the
+ * background while the oldest one is being loaded. On Linux, the reads are
+ * submitted to an io_uring; where that is not available, each file is read
+ * with pread when it is requested.
+ */
+typedef struct {
+  /**
+   * ring of depth + 1 slots: the submitted files, oldest first, and the slot
+   * of the file most recently handed out by yaml_prefetch_next.
+   */
+  yaml_prefetch_slot_t *slots;
+  size_t depth, first, pending;
+  /**
+   * the io_uring, NULL if files are read synchronously.
+   */
+  struct yaml_prefetch_ring_s *ring;
+} yaml_prefetch_t;
+
+/**
+ * Initialize the given prefetcher for reading up to depth files ahead.
+ * @return true on success, false if there is not enough memory.
+ */
+bool yaml_prefetch_init(yaml_prefetch_t *prefetch, unsigned depth);
+
+/**
+ * Start reading the file at the given path, which will be handed out by
+ * yaml_prefetch_next together with the given id after all files submitted
+ * before.
+ * @return true on success, false if depth files are already pending.
+ */
+bool yaml_prefetch_submit(yaml_prefetch_t *prefetch, const char *path,
+                          size_t id);
+
+/**
+ * Wait until the oldest pending file has been read and hand it out. data is
+ * set to its content and stays valid until the next call of this function;
+ * it is set to NULL if the file could not be opened or read.
+ * @return true on success, false if no file is pending.
+ */
+bool yaml_prefetch_next(yaml_prefetch_t *prefetch, size_t *id,
+                        const unsigned char **data, size_t *size);
+
+/**
+ * Return true iff the prefetcher reads files in the background.
+ */
+bool yaml_prefetch_is_async(yaml_prefetch_t const *prefetch);
+
+/**
+ * Wait for pending reads, then deallocate all buffers.
+ */
+void yaml_prefetch_delete(yaml_prefetch_t *prefetch);
+
+#endif
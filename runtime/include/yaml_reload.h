@@ -0,0 +1,84 @@
+#ifndef YAML_RELOAD_H
+#define YAML_RELOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Paths of the values that differ between a reloaded document and the value
+ * it replaces, as reported by the generated yaml_reload_* functions. A path
+ * consists of field names separated by '.' and list indexes in brackets,
+ * e.g. "items[3].limits"; the root itself has the empty path.
+ */
+typedef struct {
+  /**
+   * changed paths in document order. Each path is allocated separately.
+   */
+  char **paths;
+  size_t count;
+  /**
+   * true iff memory ran out while recording, so that paths are missing.
+   */
+  bool incomplete;
+  /**
+   * internal state, do not touch.
+   */
+  struct {
+    size_t capacity;
+    /**
+     * path of the value currently being compared.
+     */
+    char *path;
+    size_t path_len, path_capacity;
+  } internal;
+} yaml_reload_changes_t;
+
+void yaml_reload_changes_init(yaml_reload_changes_t *changes);
+
+/**
+ * Deallocates the recorded paths. changes may be initialized again
+ * afterwards.
+ */
+void yaml_reload_changes_delete(yaml_reload_changes_t *changes);
+
+/* used by generated code */
+
+/**
+ * Append the given field name to the current path. Returns the length of the
+ * path before, which must be given to yaml_reload_leave.
+ */
+size_t yaml_reload_enter_field(yaml_reload_changes_t *changes,
+                               const char *name);
+
+/**
+ * Append the given list index to the current path. Returns the length of the
+ * path before, which must be given to yaml_reload_leave.
+ */
+size_t yaml_reload_enter_item(yaml_reload_changes_t *changes, size_t index);
+
+static inline void yaml_reload_leave(yaml_reload_changes_t *const changes,
+                                     size_t const len) {
+  changes->internal.path_len = len;
+  if (changes->internal.path != NULL) changes->internal.path[len] = '\0';
+}
+
+/**
+ * Exchange the contents of the given objects of the given size.
+ */
+static inline void yaml_reload_swap(void *const left, void *const right,
+                                    size_t const size) {
+  unsigned char *const l = (unsigned char*)left;
+  unsigned char *const r = (unsigned char*)right;
+  for (size_t i = 0; i < size; ++i) {
+    unsigned char const tmp = l[i];
+    l[i] = r[i];
+    r[i] = tmp;
+  }
+}
+
+/**
+ * Record the current path as changed.
+ */
+void yaml_reload_changed(yaml_reload_changes_t *changes);
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef YAML_TAPE_H
+#define YAML_TAPE_H
+
+#include <yaml.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A recorded event. Strings are stored as offsets into the tape's arena.
+ */
+typedef struct {
+  yaml_event_type_t type;
+  /**
+   * style of scalars, sequences and mappings; encoding of stream starts.
+   */
+  int style;
+  /**
+   * implicit flag of document and collection events; plain_implicit flag of
+   * scalars.
+   */
+  bool implicit;
+  /**
+   * quoted_implicit flag of scalars.
+   */
+  bool quoted_implicit;
+  /**
+   * arena offsets of anchor and tag, SIZE_MAX if the event has none.
+   */
+  size_t anchor, tag;
+  /**
+   * arena offset and length of a scalar's value.
+   */
+  size_t value, length;
+  /**
+   * for sequence and mapping starts: index of the matching end event.
+   */
+  size_t end;
+  /**
+   * for sequence and mapping starts: number of nodes directly contained in
+   * the collection (for mappings, keys and values both count).
+   */
+  size_t children;
+  yaml_mark_t start_mark, end_mark;
+} yaml_tape_entry_t;
+
+/**
+ * Flat recording of all events of a YAML stream. A tape can be reused for
+ * multiple loads; recording keeps the allocated buffers.
+ */
+typedef struct {
+  struct {
+    yaml_tape_entry_t *data;
+    size_t count, capacity;
+  } entries;
+  /**
+   * null-terminated strings referenced by the entries.
+   */
+  struct {
+    char *data;
+    size_t count, capacity;
+  } arena;
+  /**
+   * indexes of the collections that are open while recording.
+   */
+  struct {
+    size_t *data;
+    size_t count, capacity;
+  } open;
+  /**
+   * offsets of the structural characters of the input, only used while
+   * recording JSON.
+   */
+  struct {
+    uint32_t *data;
+    size_t count, capacity;
+  } structurals;
+  /**
+   * error that stopped the recording, YAML_LOADER_ERROR_NONE (0) if the whole
+   * stream has been recorded.
+   */
+  int error;
+  /**
+   * number of alias events recorded.
+   */
+  size_t aliases;
+  /**
+   * description and position of a syntax error found by yaml_tape_record_json
+   * or yaml_tape_record_cbor, NULL otherwise. yaml_tape_record leaves
+   * describing errors to the parser.
+   */
+  const char *problem;
+  yaml_mark_t problem_mark;
+} yaml_tape_t;
+
+/**
+ * Initialize an empty tape.
+ */
+void yaml_tape_init(yaml_tape_t *tape);
+
+/**
+ * Discard the tape's content and record all remaining events of the given
+ * parser into it. Recording stops at the end of the stream or at the first
+ * error, which is stored in the tape's error field.
+ * @return true iff the whole stream has been recorded.
+ */
+bool yaml_tape_record(yaml_tape_t *tape, yaml_parser_t *parser);
+
+/**
+ * Discard the tape's content and record the events of the given JSON text
+ * without going through libyaml. The input is first scanned for structural
+ * characters 64 bytes at a time with SIMD instructions (SWAR where none are
+ * available); the events are then generated from the structural characters
+ * alone. They are the events libyaml generates for the same text, including
+ * marks, except that UTF-16 surrogate pairs in escapes are decoded.
+ * Recording stops at the first syntax error, which is stored in the tape's
+ * error, problem and problem_mark fields. The input must be UTF-8 and smaller
+ * than 4 GiB.
+ * @return true iff the whole text has been recorded.
+ */
+bool yaml_tape_record_json(yaml_tape_t *tape, const unsigned char *input,
+                           size_t size);
+
+/**
+ * Discard the tape's content and record the events equivalent to the given
+ * CBOR data (RFC 8949) without going through libyaml. Each top-level data
+ * item is a document. Unsigned and negative integers, floating point values,
+ * booleans and null (and undefined) become plain scalars spelled like in
+ * YAML; text strings become double-quoted scalars. Arrays and maps of definite
+ * and indefinite length become sequences and mappings. Tag 27 around a
+ * [name, node] array gives node the local tag !name, tag 55799 is skipped.
+ * Byte strings, other tags and other simple values are rejected. Marks give
+ * byte offsets as index and column. Recording stops at the first error, which
+ * is stored in the tape's error, problem and problem_mark fields.
+ * @return true iff the whole input has been recorded.
+ */
+bool yaml_tape_record_cbor(yaml_tape_t *tape, const unsigned char *input,
+                           size_t size);
+
+/**
+ * Fill event with the content of the tape's entry at the given index. The
+ * event's strings point into the tape, so it must not be deleted with
+ * yaml_event_delete and is invalidated when the tape is changed.
+ */
+void yaml_tape_event(yaml_tape_t const *tape, size_t index,
+                     yaml_event_t *event);
+
+/**
+ * Deallocate the tape's buffers.
+ */
+void yaml_tape_delete(yaml_tape_t *tape);
+
+#endif
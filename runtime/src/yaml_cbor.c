@@ -0,0 +1,620 @@
+/*
+ * Records the events of CBOR data (RFC 8949) into a tape without going through
+ * libyaml. Each top-level item of the input is a document, so a CBOR sequence
+ * (RFC 8742) yields a stream of documents. Integers, floating point values,
+ * booleans and null become plain scalars spelled like their YAML
+ * counterparts, text strings become double-quoted scalars, and tag 27 around
+ * [name, value] gives value the local tag !name.
+ */
+
+#include <yaml_tape.h>
+#include <yaml_loader.h>
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaml_tape_internal.h"
+
+/*
+ * Serialised language-independent object: [type name, value].
+ */
+#define TAG_OBJECT 27
+/*
+ * Self-described CBOR: marks data as CBOR and carries no meaning.
+ */
+#define TAG_SELF_DESCRIBED 55799
+
+/*
+ * Additional information of an item with indefinite length, and the break
+ * byte ending it.
+ */
+#define INDEFINITE 31
+#define BREAK 0xff
+
+#define HIGH_BITS UINT64_C(0x8080808080808080)
+
+typedef struct {
+  const unsigned char *input;
+  size_t size, offset;
+  /*
+   * arena offset of the tag for the next node, SIZE_MAX if it has none.
+   */
+  size_t tag;
+} cbor_reader_t;
+
+/*
+ * CBOR has no lines, so marks give the byte offset as index and column.
+ */
+static yaml_mark_t mark_at(size_t const offset) {
+  yaml_mark_t mark;
+  mark.index = mark.column = offset;
+  mark.line = 0;
+  return mark;
+}
+
+static bool syntax_error(yaml_tape_t *const tape, size_t const offset,
+                         const char *const problem) {
+  tape->error = YAML_LOADER_ERROR_PARSER;
+  tape->problem = problem;
+  tape->problem_mark = mark_at(offset);
+  return false;
+}
+
+static bool out_of_memory(yaml_tape_t *const tape) {
+  tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+  return false;
+}
+
+/*
+ * Append an entry of the given type starting at the given offset, or return
+ * NULL if memory runs out.
+ */
+static yaml_tape_entry_t *add_entry(yaml_tape_t *const tape,
+                                    yaml_event_type_t const type,
+                                    size_t const offset) {
+  if (!YAML_TAPE_RESERVE(&tape->entries, 1)) return NULL;
+  yaml_tape_entry_t *const entry = &tape->entries.data[tape->entries.count++];
+  entry->type = type;
+  entry->style = 0;
+  entry->implicit = entry->quoted_implicit = false;
+  entry->anchor = entry->tag = entry->value = SIZE_MAX;
+  entry->length = entry->end = entry->children = 0;
+  entry->start_mark = entry->end_mark = mark_at(offset);
+  switch (type) {
+    case YAML_SCALAR_EVENT:
+    case YAML_SEQUENCE_START_EVENT:
+    case YAML_MAPPING_START_EVENT:
+      if (tape->open.count > 0) {
+        tape->entries.data[tape->open.data[tape->open.count - 1]].children++;
+      }
+      break;
+    default:
+      break;
+  }
+  return entry;
+}
+
+/*
+ * Read the head of the item at the reader's offset: its major type, its
+ * additional information and the argument that follows. Returns false if the
+ * input ends before the argument or uses reserved additional information.
+ */
+static bool read_head(yaml_tape_t *const tape, cbor_reader_t *const reader,
+                      unsigned *const major, unsigned *const info,
+                      uint64_t *const argument) {
+  size_t const start = reader->offset;
+  if (start == reader->size) {
+    return syntax_error(tape, start, "found unexpected end of input");
+  }
+  unsigned char const initial = reader->input[start];
+  *major = initial >> 5;
+  *info = initial & 0x1f;
+  size_t length;
+  if (*info < 24) {
+    *argument = *info;
+    reader->offset = start + 1;
+    return true;
+  } else if (*info <= 27) {
+    length = (size_t)1 << (*info - 24);
+  } else if (*info == INDEFINITE) {
+    *argument = 0;
+    reader->offset = start + 1;
+    return true;
+  } else {
+    return syntax_error(tape, start,
+                        "found reserved additional information");
+  }
+  if (reader->size - start - 1 < length) {
+    return syntax_error(tape, start, "found unexpected end of input");
+  }
+  uint64_t value = 0;
+  for (size_t i = 1; i <= length; ++i) {
+    value = value << 8 | reader->input[start + i];
+  }
+  *argument = value;
+  reader->offset = start + 1 + length;
+  return true;
+}
+
+/*
+ * Return the length of the valid UTF-8 sequence at input[offset], 0 if it is
+ * invalid.
+ */
+static size_t utf8_length(const unsigned char *const input, size_t const size,
+                          size_t const offset) {
+  unsigned char const c = input[offset];
+  size_t length;
+  uint32_t code, min;
+  if (c < 0x80) return 1;
+  if ((c & 0xe0) == 0xc0) {
+    length = 2;
+    code = c & 0x1f;
+    min = 0x80;
+  } else if ((c & 0xf0) == 0xe0) {
+    length = 3;
+    code = c & 0x0f;
+    min = 0x800;
+  } else if ((c & 0xf8) == 0xf0) {
+    length = 4;
+    code = c & 0x07;
+    min = 0x10000;
+  } else return 0;
+  if (size - offset < length) return 0;
+  for (size_t i = 1; i < length; ++i) {
+    if ((input[offset + i] & 0xc0) != 0x80) return 0;
+    code = code << 6 | (input[offset + i] & 0x3f);
+  }
+  if (code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff)) {
+    return 0;
+  }
+  return length;
+}
+
+/*
+ * Append the given bytes to the arena after checking that they are valid
+ * UTF-8 without null characters, which YAML strings cannot hold.
+ */
+static bool append_text(yaml_tape_t *const tape, cbor_reader_t *const reader,
+                        size_t const start, size_t const length) {
+  const unsigned char *const input = reader->input;
+  size_t const end = start + length;
+  for (size_t i = start; i < end;) {
+    if (end - i >= 8) {
+      // skip 8 bytes at a time while they are ASCII and not null.
+      uint64_t word;
+      memcpy(&word, input + i, sizeof(word));
+      // adding 0x7f to a byte below 0x80 sets its high bit iff it is not 0.
+      if ((word & HIGH_BITS) == 0 &&
+          ((word + ~HIGH_BITS) & HIGH_BITS) == HIGH_BITS) {
+        i += 8;
+        continue;
+      }
+    }
+    size_t const n = input[i] == 0 ? 0 : utf8_length(input, end, i);
+    if (n == 0) {
+      return syntax_error(tape, i, input[i] == 0 ?
+          "found null character in text string" : "found invalid UTF-8");
+    }
+    i += n;
+  }
+  if (!YAML_TAPE_RESERVE(&tape->arena, length + 1)) return out_of_memory(tape);
+  memcpy(tape->arena.data + tape->arena.count, input + start, length);
+  tape->arena.count += length;
+  return true;
+}
+
+/*
+ * Read the content of a text string whose head has been read into the arena,
+ * concatenating the chunks of a string of indefinite length. The content is
+ * null-terminated; returns its length in *length.
+ */
+static bool read_text(yaml_tape_t *const tape, cbor_reader_t *const reader,
+                      unsigned const info, uint64_t const argument,
+                      size_t *const length) {
+  size_t const value = tape->arena.count;
+  if (info != INDEFINITE) {
+    if (argument > reader->size - reader->offset) {
+      return syntax_error(tape, reader->offset,
+                          "found unexpected end of input");
+    }
+    if (!append_text(tape, reader, reader->offset, (size_t)argument)) {
+      return false;
+    }
+    reader->offset += (size_t)argument;
+  } else {
+    while (true) {
+      if (reader->offset < reader->size &&
+          reader->input[reader->offset] == BREAK) {
+        reader->offset++;
+        break;
+      }
+      size_t const chunk = reader->offset;
+      unsigned chunk_major, chunk_info;
+      uint64_t chunk_length;
+      if (!read_head(tape, reader, &chunk_major, &chunk_info, &chunk_length)) {
+        return false;
+      }
+      if (chunk_major != 3 || chunk_info == INDEFINITE) {
+        return syntax_error(tape, chunk, "found invalid text string chunk");
+      }
+      if (chunk_length > reader->size - reader->offset) {
+        return syntax_error(tape, reader->offset,
+                            "found unexpected end of input");
+      }
+      // chunks must be valid UTF-8 on their own.
+      if (!append_text(tape, reader, reader->offset, (size_t)chunk_length)) {
+        return false;
+      }
+      reader->offset += (size_t)chunk_length;
+    }
+  }
+  if (!YAML_TAPE_RESERVE(&tape->arena, 1)) return out_of_memory(tape);
+  tape->arena.data[tape->arena.count++] = '\0';
+  *length = tape->arena.count - 1 - value;
+  return true;
+}
+
+/*
+ * Append the given null-terminated string to the arena.
+ */
+static bool store(yaml_tape_t *const tape, const char *const string,
+                  size_t const length) {
+  if (!YAML_TAPE_RESERVE(&tape->arena, length + 1)) return out_of_memory(tape);
+  memcpy(tape->arena.data + tape->arena.count, string, length + 1);
+  tape->arena.count += length + 1;
+  return true;
+}
+
+/*
+ * Write the decimal digits of value so that they end before end and return
+ * where they start.
+ */
+static char *format_unsigned(char *end, uint64_t value) {
+  do {
+    *--end = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+/*
+ * Write value with the fewest fractional digits that read back as the same
+ * value without going through snprintf and strtod, which dominate decoding
+ * otherwise. Returns 0 if value has no such representation of at most 15
+ * significant digits, or if reading it back could round differently.
+ */
+static int format_fixed(char *const buffer, double const value,
+                        bool const single) {
+  static const double powers[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+      1e13, 1e14, 1e15};
+  double const magnitude = value < 0 ? -value : value;
+  // zero keeps its sign on the slow path.
+  if (!(magnitude >= 1e-6 && magnitude < 1e15)) return 0;
+  for (int digits = 0; digits < 16; ++digits) {
+    double const scaled = magnitude * powers[digits];
+    if (scaled >= 1e15) return 0;
+    double const rounded = (double)(uint64_t)(scaled + 0.5);
+    // powers and rounded are exact, so the quotient is rounded correctly
+    // like strtod would round the decimal.
+    double const candidate = rounded / powers[digits];
+    if (single) {
+      float const narrow = (float)candidate;
+      if (narrow != (float)magnitude) continue;
+      // rounding twice differs from rounding once only if the first rounding
+      // hit the midpoint between two floats.
+      if ((double)narrow != candidate) {
+        // the neighbour of a positive float has the adjacent bit pattern.
+        uint32_t bits;
+        memcpy(&bits, &narrow, sizeof(bits));
+        bits = candidate > narrow ? bits + 1 : bits - 1;
+        float other;
+        memcpy(&other, &bits, sizeof(other));
+        if (((double)narrow + (double)other) / 2 == candidate) return 0;
+      }
+    } else if (candidate != magnitude) continue;
+    char digits_buffer[24];
+    char *const end = digits_buffer + sizeof(digits_buffer);
+    char *start = format_unsigned(end, (uint64_t)rounded);
+    while (end - start <= digits) *--start = '0';
+    char *out = buffer;
+    if (value < 0) *out++ = '-';
+    size_t const integral = (size_t)(end - start) - (size_t)digits;
+    memcpy(out, start, integral);
+    out += integral;
+    if (digits > 0) {
+      *out++ = '.';
+      memcpy(out, start + integral, (size_t)digits);
+      out += digits;
+    }
+    *out = '\0';
+    return (int)(out - buffer);
+  }
+  return 0;
+}
+
+/*
+ * Format the given floating point value with the fewest digits that read back
+ * as the same value, at single precision if single is true.
+ */
+static int format_float(char *const buffer, size_t const size,
+                        double const value, bool const single) {
+  // the spellings the YAML constructors accept, as the dumper writes them.
+  if (isnan(value)) return snprintf(buffer, size, ".nan");
+  if (isinf(value)) return snprintf(buffer, size, value < 0 ? "-.inf" : ".inf");
+  int length = format_fixed(buffer, value, single);
+  if (length > 0) return length;
+  int const min_digits = single ? FLT_DIG : DBL_DIG;
+  int const max_digits = single ? FLT_DIG + 3 : DBL_DIG + 2;
+  for (int precision = min_digits; precision <= max_digits; ++precision) {
+    length = snprintf(buffer, size, "%.*g", precision, value);
+    if (single ? strtof(buffer, NULL) == (float)value :
+                 strtod(buffer, NULL) == value) break;
+  }
+  char const point = localeconv()->decimal_point[0];
+  if (point != '.') {
+    for (int i = 0; i < length; ++i) {
+      if (buffer[i] == point) buffer[i] = '.';
+    }
+  }
+  return length;
+}
+
+static double decode_half(uint64_t const half) {
+  int const exponent = (int)(half >> 10) & 0x1f;
+  double const mantissa = (double)(half & 0x3ff);
+  double value;
+  if (exponent == 0) value = mantissa / 16777216.0;  // 2^-24
+  else if (exponent != 31) {
+    value = (mantissa + 1024) * (double)((uint64_t)1 << exponent) /
+        33554432.0;  // 2^-25
+  } else value = mantissa == 0 ? INFINITY : NAN;
+  return (half & 0x8000) != 0 ? -value : value;
+}
+
+/*
+ * Add a scalar with the given value, which has been stored in the arena at
+ * offset value, and consume the reader's pending tag.
+ */
+static bool add_scalar(yaml_tape_t *const tape, cbor_reader_t *const reader,
+                       size_t const start, size_t const value,
+                       size_t const length, bool const quoted) {
+  yaml_tape_entry_t *const entry =
+      add_entry(tape, YAML_SCALAR_EVENT, start);
+  if (entry == NULL) return out_of_memory(tape);
+  entry->style = quoted ? (int)YAML_DOUBLE_QUOTED_SCALAR_STYLE :
+                          (int)YAML_PLAIN_SCALAR_STYLE;
+  entry->tag = reader->tag;
+  entry->implicit = reader->tag == SIZE_MAX && !quoted;
+  entry->quoted_implicit = reader->tag == SIZE_MAX && quoted;
+  entry->value = value;
+  entry->length = length;
+  entry->end_mark = mark_at(reader->offset);
+  reader->tag = SIZE_MAX;
+  return true;
+}
+
+/*
+ * Read the scalar whose head has been read and add its event.
+ */
+static bool record_scalar(yaml_tape_t *const tape, cbor_reader_t *const reader,
+                          size_t const start, unsigned const major,
+                          unsigned const info, uint64_t const argument) {
+  char buffer[32];
+  int length;
+  switch (major) {
+    case 0:
+    case 1: {
+      char *const end = buffer + sizeof(buffer);
+      char *digits;
+      // -1 - argument does not fit into 64 bits for the largest argument.
+      if (major == 1 && argument == UINT64_MAX) {
+        digits = end - sizeof("18446744073709551616") + 1;
+        memcpy(digits, "18446744073709551616", (size_t)(end - digits));
+      } else {
+        digits = format_unsigned(end, major == 1 ? argument + 1 : argument);
+      }
+      if (major == 1) *--digits = '-';
+      length = (int)(end - digits);
+      memmove(buffer, digits, (size_t)length);
+      buffer[length] = '\0';
+      break;
+    }
+    case 3: {
+      size_t const value = tape->arena.count;
+      size_t text_length;
+      if (!read_text(tape, reader, info, argument, &text_length)) return false;
+      return add_scalar(tape, reader, start, value, text_length, true);
+    }
+    case 7:
+      switch (info) {
+        case 20: length = sprintf(buffer, "false"); break;
+        case 21: length = sprintf(buffer, "true"); break;
+        case 22:
+        case 23: length = sprintf(buffer, "null"); break;
+        case 25:
+          length = format_float(buffer, sizeof(buffer), decode_half(argument),
+                                true);
+          break;
+        case 26: {
+          uint32_t const bits = (uint32_t)argument;
+          float value;
+          memcpy(&value, &bits, sizeof(value));
+          length = format_float(buffer, sizeof(buffer), value, true);
+          break;
+        }
+        case 27: {
+          double value;
+          memcpy(&value, &argument, sizeof(value));
+          length = format_float(buffer, sizeof(buffer), value, false);
+          break;
+        }
+        default:
+          return syntax_error(tape, start, "found unsupported simple value");
+      }
+      break;
+    default:
+      return syntax_error(tape, start, "found unsupported byte string");
+  }
+  size_t const value = tape->arena.count;
+  if (!store(tape, buffer, (size_t)length)) return false;
+  return add_scalar(tape, reader, start, value, (size_t)length, false);
+}
+
+/*
+ * Read the head of tag 27's content, [name, value], and store !name as tag
+ * of the next node.
+ */
+static bool read_object_tag(yaml_tape_t *const tape,
+                            cbor_reader_t *const reader, size_t const start) {
+  unsigned major, info;
+  uint64_t argument;
+  if (reader->tag != SIZE_MAX) {
+    return syntax_error(tape, start, "found node with more than one tag");
+  }
+  if (!read_head(tape, reader, &major, &info, &argument)) return false;
+  if (major != 4 || info == INDEFINITE || argument != 2) {
+    return syntax_error(tape, start, "found invalid tagged value");
+  }
+  size_t const name = reader->offset;
+  if (!read_head(tape, reader, &major, &info, &argument)) return false;
+  if (major != 3) {
+    return syntax_error(tape, name, "found invalid tag name");
+  }
+  size_t const tag = tape->arena.count;
+  if (!YAML_TAPE_RESERVE(&tape->arena, 1)) return out_of_memory(tape);
+  tape->arena.data[tape->arena.count++] = '!';
+  size_t length;
+  if (!read_text(tape, reader, info, argument, &length)) return false;
+  if (length == 0) return syntax_error(tape, name, "found invalid tag name");
+  reader->tag = tag;
+  return true;
+}
+
+/*
+ * Add the end event of the innermost open collection.
+ */
+static bool close_collection(yaml_tape_t *const tape, size_t const start,
+                             size_t const end) {
+  size_t const open = tape->open.data[--tape->open.count];
+  yaml_tape_entry_t *const start_entry = &tape->entries.data[open];
+  yaml_event_type_t const type =
+      start_entry->type == YAML_MAPPING_START_EVENT ?
+      YAML_MAPPING_END_EVENT : YAML_SEQUENCE_END_EVENT;
+  start_entry->length = 0;
+  start_entry->end = tape->entries.count;
+  start_entry->end_mark = mark_at(end);
+  yaml_tape_entry_t *const entry = add_entry(tape, type, start);
+  if (entry == NULL) return out_of_memory(tape);
+  entry->end_mark = mark_at(end);
+  return true;
+}
+
+/*
+ * Record the next data item and, while it is a collection, all items in it.
+ * While a collection is open, its start entry's length field holds the number
+ * of items it must have, SIZE_MAX for collections of indefinite length.
+ */
+static bool record_item(yaml_tape_t *const tape, cbor_reader_t *const reader) {
+  while (true) {
+    size_t const start = reader->offset;
+    // a pending tag belongs to the next item, which cannot be a break.
+    if (tape->open.count > 0 && reader->tag == SIZE_MAX) {
+      yaml_tape_entry_t *const open =
+          &tape->entries.data[tape->open.data[tape->open.count - 1]];
+      bool closed = false;
+      if (open->length == SIZE_MAX) {
+        if (start < reader->size && reader->input[start] == BREAK) {
+          if (open->type == YAML_MAPPING_START_EVENT &&
+              open->children % 2 != 0) {
+            return syntax_error(tape, start, "found map key without value");
+          }
+          reader->offset++;
+          closed = true;
+        }
+      } else closed = open->children == open->length;
+      if (closed) {
+        if (!close_collection(tape, start, reader->offset)) return false;
+        if (tape->open.count == 0) return true;
+        continue;
+      }
+    }
+    unsigned major, info;
+    uint64_t argument;
+    if (!read_head(tape, reader, &major, &info, &argument)) return false;
+    if (info == INDEFINITE && (major == 0 || major == 1 || major == 6)) {
+      return syntax_error(tape, start,
+                          "found reserved additional information");
+    } else if (major == 7 && info == INDEFINITE) {
+      return syntax_error(tape, start, "found unexpected break");
+    } else if (major == 6) {
+      if (argument == TAG_OBJECT) {
+        if (!read_object_tag(tape, reader, start)) return false;
+      } else if (argument != TAG_SELF_DESCRIBED) {
+        return syntax_error(tape, start, "found unsupported tag");
+      }
+    } else if (major == 4 || major == 5) {
+      // every item takes at least one byte.
+      uint64_t const remaining = reader->size - reader->offset;
+      if (info != INDEFINITE && (argument > remaining ||
+                                 (major == 5 && argument > remaining / 2))) {
+        return syntax_error(tape, start, "found unexpected end of input");
+      }
+      if (!YAML_TAPE_RESERVE(&tape->open, 1)) return out_of_memory(tape);
+      size_t const index = tape->entries.count;
+      yaml_tape_entry_t *const entry = add_entry(
+          tape, major == 5 ? YAML_MAPPING_START_EVENT :
+                             YAML_SEQUENCE_START_EVENT, start);
+      if (entry == NULL) return out_of_memory(tape);
+      entry->style = major == 5 ? (int)YAML_BLOCK_MAPPING_STYLE :
+                                  (int)YAML_BLOCK_SEQUENCE_STYLE;
+      entry->tag = reader->tag;
+      entry->implicit = reader->tag == SIZE_MAX;
+      entry->length = info == INDEFINITE ? SIZE_MAX :
+                      (size_t)(major == 5 ? argument * 2 : argument);
+      reader->tag = SIZE_MAX;
+      tape->open.data[tape->open.count++] = index;
+    } else {
+      if (!record_scalar(tape, reader, start, major, info, argument)) {
+        return false;
+      }
+      if (tape->open.count == 0) return true;
+    }
+  }
+}
+
+bool yaml_tape_record_cbor(yaml_tape_t *tape, const unsigned char *input,
+                           size_t size) {
+  tape->entries.count = 0;
+  tape->arena.count = 0;
+  tape->open.count = 0;
+  tape->error = YAML_LOADER_ERROR_NONE;
+  tape->aliases = 0;
+  tape->problem = NULL;
+  cbor_reader_t reader;
+  reader.input = input;
+  reader.size = size;
+  reader.offset = 0;
+  reader.tag = SIZE_MAX;
+  yaml_tape_entry_t *entry = add_entry(tape, YAML_STREAM_START_EVENT, 0);
+  if (entry == NULL) return out_of_memory(tape);
+  entry->style = YAML_UTF8_ENCODING;
+  while (reader.offset < size) {
+    size_t const start = reader.offset;
+    entry = add_entry(tape, YAML_DOCUMENT_START_EVENT, start);
+    if (entry == NULL) return out_of_memory(tape);
+    entry->implicit = true;
+    if (!record_item(tape, &reader)) return false;
+    entry = add_entry(tape, YAML_DOCUMENT_END_EVENT, reader.offset);
+    if (entry == NULL) return out_of_memory(tape);
+    entry->implicit = true;
+  }
+  entry = add_entry(tape, YAML_STREAM_END_EVENT, size);
+  if (entry == NULL) return out_of_memory(tape);
+  return true;
+}
@@ -1,11 +1,23 @@
 #include <yaml_constructor.h>
 
 #include <stdint.h>
+#include <errno.h>
 #include <math.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <locale.h>
 #include <yaml_loader.h>
+#include <yaml_hash.h>
+
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "yaml_threads.h"
 
 char* yaml_constructor_escape(const char* const string, size_t* const size) {
 	size_t needed = 0;
@@ -32,6 +44,21 @@ char* yaml_constructor_escape(const char* const string, size_t* const size) {
 	return res;
 }
 
+bool yaml_constructor_error(yaml_loader_t *loader, yaml_event_t *event,
+    yaml_loader_error_type_t type, const char *expected) {
+  size_t const len = strlen(expected) + 1;
+  loader->error_info.expected = malloc(len);
+  if (loader->error_info.expected == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    yaml_loader_event_delete(loader, event);
+  } else {
+    loader->error_info.type = type;
+    memcpy(loader->error_info.expected, expected, len);
+    loader->error_info.event = *event;
+  }
+  return false;
+}
+
 const char* yaml_constructor_event_spelling(yaml_event_type_t type) {
 	switch (type) {
 	case YAML_STREAM_START_EVENT:   return "STREAM_START";
@@ -69,17 +96,8 @@ bool name(value_type *const value, yaml_loader_t *const loader,\
   char* result;\
   long long res = strtoll((const char*)cur->data.scalar.value, &result, 10);\
   if (*result != '\0' || res < min || res > max) {\
-    const char typename[] = #value_type;\
-    loader->error_info.expected = malloc(sizeof(typename));\
-    if (loader->error_info.expected == NULL) {\
-      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\
-      yaml_event_delete(cur);\
-    } else {\
-      loader->error_info.type = YAML_LOADER_ERROR_VALUE;\
-      memcpy(loader->error_info.expected, typename, sizeof(typename));\
-      loader->error_info.event = *cur;\
-    }\
-    return false;\
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_VALUE,\
+                                  #value_type);\
   }\
   *value = (value_type)res;\
   return true;\
@@ -100,17 +118,8 @@ bool name(value_type *const value, yaml_loader_t *const loader,\
   unsigned long long res =\
       strtoull((const char*)cur->data.scalar.value, &result, 10);\
    if (*result != '\0' || res > max) {\
-    const char typename[] = #value_type;\
-    loader->error_info.expected = malloc(sizeof(typename));\
-    if (loader->error_info.expected == NULL) {\
-      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\
-      yaml_event_delete(cur);\
-    } else {\
-      loader->error_info.type = YAML_LOADER_ERROR_VALUE;\
-      memcpy(loader->error_info.expected, typename, sizeof(typename));\
-      loader->error_info.event = *cur;\
-    }\
-    return false;\
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_VALUE,\
+                                  #value_type);\
   }\
   *value = (value_type)res;\
   return true;\
@@ -125,39 +134,300 @@ DEFINE_UNSIGNED_CONSTRUCTOR(yaml_construct_unsigned_long, unsigned long,
 	ULLONG_MAX)
 DEFINE_UNSIGNED_CONSTRUCTOR(yaml_construct_unsigned_long_long,
 	unsigned long long, ULLONG_MAX)
+DEFINE_UNSIGNED_CONSTRUCTOR(yaml_construct_size_t, size_t, SIZE_MAX)
 
  bool yaml_construct_string(char** const value, yaml_loader_t *const loader,
 		yaml_event_t* cur) {
   if (!yaml_constructor_check_event_type(loader, cur, YAML_SCALAR_EVENT))
     return false;
 	size_t len = strlen((char*)cur->data.scalar.value) + 1;
-	*value = malloc(len);
+	if (!yaml_constructor_reserve(loader, cur, len)) return false;
+	*value = yaml_loader_alloc(loader, len);
 	if (*value == NULL) {
 	  loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
-	  yaml_event_delete(cur);
+	  yaml_loader_event_delete(loader, cur);
 	  return false;
 	}
 	memcpy(*value, cur->data.scalar.value, len);
 	return true;
 }
 
+/*
+ * libyaml marks count characters, not bytes. Map the given character index to
+ * a byte offset into the input, continuing from the previously mapped position
+ * since marks are usually queried in ascending order.
+ * Returns SIZE_MAX if the offset lies beyond the input.
+ */
+static size_t input_offset(yaml_loader_t *const loader, size_t const index) {
+  const unsigned char *const input = loader->internal.input;
+  size_t const size = loader->internal.input_size;
+  if (index < loader->internal.mapped_index) {
+    loader->internal.mapped_index = loader->internal.base_index;
+    loader->internal.mapped_offset = loader->internal.base_offset;
+  }
+  size_t offset = loader->internal.mapped_offset;
+  for (size_t i = loader->internal.mapped_index; i < index; ++i) {
+    if (offset >= size) return SIZE_MAX;
+    do { ++offset; } while (offset < size && (input[offset] & 0xc0) == 0x80);
+  }
+  loader->internal.mapped_index = index;
+  loader->internal.mapped_offset = offset;
+  return offset;
+}
+
+bool yaml_construct_view(char const **const ptr, size_t *const len,
+		yaml_loader_t *const loader, yaml_event_t* cur) {
+  if (!yaml_constructor_check_event_type(loader, cur, YAML_SCALAR_EVENT))
+    return false;
+  size_t const length = cur->data.scalar.length;
+  if (loader->internal.input != NULL) {
+    size_t start = input_offset(loader, cur->start_mark.index);
+    switch (cur->data.scalar.style) {
+      case YAML_PLAIN_SCALAR_STYLE:
+        break;
+      case YAML_SINGLE_QUOTED_SCALAR_STYLE:
+      case YAML_DOUBLE_QUOTED_SCALAR_STYLE:
+        if (start != SIZE_MAX) ++start;
+        break;
+      default:
+        // block scalars are always subject to indentation and chomping
+        start = SIZE_MAX;
+        break;
+    }
+    if (start != SIZE_MAX && start <= loader->internal.input_size &&
+        length <= loader->internal.input_size - start &&
+        memcmp(loader->internal.input + start, cur->data.scalar.value,
+               length) == 0) {
+      *ptr = (const char*)loader->internal.input + start;
+      *len = length;
+      return true;
+    }
+  }
+  if (loader->internal.view_copies.count ==
+      loader->internal.view_copies.capacity) {
+    size_t const new_capacity = loader->internal.view_copies.capacity == 0 ?
+        16 : loader->internal.view_copies.capacity * 2;
+    char **const new_data = realloc(loader->internal.view_copies.data,
+                                    new_capacity * sizeof(char*));
+    if (new_data == NULL) {
+      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+      yaml_loader_event_delete(loader, cur);
+      return false;
+    }
+    loader->internal.view_copies.data = new_data;
+    loader->internal.view_copies.capacity = new_capacity;
+  }
+  if (!yaml_constructor_reserve(loader, cur, length + 1)) return false;
+  char *const copy = malloc(length + 1);
+  if (copy == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    yaml_loader_event_delete(loader, cur);
+    return false;
+  }
+  memcpy(copy, cur->data.scalar.value, length + 1);
+  loader->internal.view_copies.data[loader->internal.view_copies.count++] =
+      copy;
+  *ptr = copy;
+  *len = length;
+  return true;
+}
+
+bool yaml_construct_lazy(void **const value, yaml_loader_t *const loader,
+		yaml_event_t* cur) {
+  switch (cur->type) {
+    case YAML_MAPPING_START_EVENT:
+    case YAML_SEQUENCE_START_EVENT:
+    case YAML_SCALAR_EVENT:
+      break;
+    default:
+      return yaml_constructor_check_event_type(loader, cur,
+                                               YAML_MAPPING_START_EVENT);
+  }
+  yaml_mark_t end;
+  if (!yaml_loader_skip(loader, cur, &end)) {
+    yaml_loader_event_delete(loader, cur);
+    return false;
+  }
+  yaml_loader_lazy_t *const lazy = malloc(sizeof(yaml_loader_lazy_t));
+  if (lazy == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    yaml_loader_event_delete(loader, cur);
+    return false;
+  }
+  lazy->input = loader->internal.input;
+  lazy->input_size = loader->internal.input_size;
+  lazy->start = input_offset(loader, cur->start_mark.index);
+  lazy->end = input_offset(loader, end.index);
+  if (lazy->end == SIZE_MAX) lazy->end = loader->internal.input_size;
+  lazy->line = cur->start_mark.line;
+  lazy->column = cur->start_mark.column;
+  // malloc'd memory is suitably aligned for any type, so the lowest bit is
+  // free to mark the pointer as referring to a lazy subtree.
+  *value = (void*)((uintptr_t)lazy | 1);
+  return true;
+}
+
+void yaml_constructor_lazy_free(void *const value) {
+  free((void*)((uintptr_t)value & ~(uintptr_t)1));
+}
+
+uint64_t yaml_constructor_lazy_hash(void const *const value,
+                                    uint64_t const hash) {
+  yaml_loader_lazy_t const *const lazy =
+      (yaml_loader_lazy_t const*)((uintptr_t)value & ~(uintptr_t)1);
+  return yaml_hash_bytes(lazy->input + lazy->start, lazy->end - lazy->start,
+                         yaml_hash_null(hash));
+}
+
+bool yaml_constructor_lazy_equal(void const *const left,
+                                 void const *const right) {
+  if (!yaml_constructor_is_lazy(left) || !yaml_constructor_is_lazy(right)) {
+    return false;
+  }
+  yaml_loader_lazy_t const *const l =
+      (yaml_loader_lazy_t const*)((uintptr_t)left & ~(uintptr_t)1);
+  yaml_loader_lazy_t const *const r =
+      (yaml_loader_lazy_t const*)((uintptr_t)right & ~(uintptr_t)1);
+  return l->end - l->start == r->end - r->start &&
+         memcmp(l->input + l->start, r->input + r->start,
+                l->end - l->start) == 0;
+}
+
+bool yaml_constructor_shared_alloc(void **const value, size_t const size,
+		yaml_loader_t *const loader, yaml_event_t* cur) {
+  yaml_constructor_shared_t *const header =
+      malloc(sizeof(yaml_constructor_shared_t) + size);
+  if (header == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    yaml_loader_event_delete(loader, cur);
+    return false;
+  }
+  header->refs = 1;
+  *value = header + 1;
+  return true;
+}
+
+void yaml_constructor_shared_free(void *const value) {
+  free((yaml_constructor_shared_t*)value - 1);
+}
+
+/*
+ * values recorded by yaml_constructor_free_deferred while it is running on
+ * this thread. next is the index of the next item to destroy.
+ */
+typedef struct {
+  char *data;
+  size_t count, size, next;
+  void (*destroy)(void*);
+} deferred_free_t;
+
+static YAML_THREAD_LOCAL deferred_free_t *deferred_data = NULL;
+static YAML_THREAD_LOCAL size_t deferred_count = 0, deferred_capacity = 0;
+static YAML_THREAD_LOCAL bool deferred_running = false;
+
+static bool record_deferred(void *const data, size_t const count,
+                            size_t const size, void (*const destroy)(void*)) {
+  if (deferred_count == deferred_capacity) {
+    size_t const capacity =
+        deferred_capacity == 0 ? 64 : deferred_capacity * 2;
+    deferred_free_t *const new_data =
+        realloc(deferred_data, capacity * sizeof(deferred_free_t));
+    if (new_data == NULL) return false;
+    deferred_data = new_data;
+    deferred_capacity = capacity;
+  }
+  deferred_free_t *const record = &deferred_data[deferred_count++];
+  record->data = (char*)data;
+  record->count = count;
+  record->size = size;
+  record->next = 0;
+  record->destroy = destroy;
+  return true;
+}
+
+void yaml_constructor_free_deferred(void *const data, size_t const count,
+    size_t const size, void (*const destroy)(void*)) {
+  if (!record_deferred(data, count, size, destroy)) {
+    // without memory for the record, deallocate right away.
+    for (size_t i = 0; i < count; ++i) destroy((char*)data + i * size);
+    free(data);
+    return;
+  }
+  if (deferred_running) return;
+  deferred_running = true;
+  while (deferred_count > 0) {
+    deferred_free_t *const record = &deferred_data[deferred_count - 1];
+    if (record->next == record->count) {
+      free(record->data);
+      deferred_count--;
+    } else {
+      // may record further values, which moves the records.
+      record->destroy(record->data + record->next++ * record->size);
+    }
+  }
+  free(deferred_data);
+  deferred_data = NULL;
+  deferred_capacity = 0;
+  deferred_running = false;
+}
+
+bool yaml_construct_alias(void **const value,
+		yaml_loader_shared_type_t const *const type, yaml_loader_t *const loader,
+		yaml_event_t* cur) {
+  yaml_loader_anchor_t const *const anchor = yaml_loader_find_anchor(
+      loader, (char const*)cur->data.alias.anchor);
+  // types are compared by name, since each generated file has its own
+  // descriptors.
+  if (anchor == NULL || (anchor->type != type &&
+                         strcmp(anchor->type->name, type->name) != 0)) {
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_ALIAS,
+                                  type->name);
+  }
+  ((yaml_constructor_shared_t*)anchor->value - 1)->refs++;
+  *value = anchor->value;
+  return true;
+}
+
+bool yaml_constructor_anchor(yaml_loader_t *const loader, yaml_event_t* cur,
+		void *const value, yaml_loader_shared_type_t const *const type) {
+  yaml_char_t const *anchor;
+  switch (cur->type) {
+    case YAML_SCALAR_EVENT: anchor = cur->data.scalar.anchor; break;
+    // sequence_start and mapping_start have the same layout.
+    case YAML_SEQUENCE_START_EVENT:
+    case YAML_MAPPING_START_EVENT:
+      anchor = cur->data.sequence_start.anchor;
+      break;
+    default: anchor = NULL; break;
+  }
+  if (anchor == NULL ||
+      yaml_loader_add_anchor(loader, (char const*)anchor, value, type)) {
+    return true;
+  }
+  loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+  yaml_loader_event_delete(loader, cur);
+  return false;
+}
+
+void *yaml_constructor_dedup(yaml_loader_t *const loader, void *const value,
+		yaml_loader_shared_type_t const *const type) {
+  void *const canonical =
+      yaml_loader_dedup(loader, value, type->hash(value), type);
+  if (canonical != value) {
+    ((yaml_constructor_shared_t*)canonical - 1)->refs++;
+    type->release(value);
+  }
+  return canonical;
+}
+
 bool yaml_construct_char(char *const value, yaml_loader_t *const loader,
                          yaml_event_t* cur) {
   if (!yaml_constructor_check_event_type(loader, cur, YAML_SCALAR_EVENT)) {
     return false;
   } else if (cur->data.scalar.value[0] == '\0' ||
              cur->data.scalar.value[1] != '\0') {
-    const char typename[] = "char";
-    loader->error_info.expected = malloc(sizeof(typename));
-    if (loader->error_info.expected == NULL) {
-      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
-      yaml_event_delete(cur);
-    } else {
-      loader->error_info.type = YAML_LOADER_ERROR_VALUE;
-      memcpy(loader->error_info.expected, typename, sizeof(typename));
-      loader->error_info.event = *cur;
-    }
-    return false;
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_VALUE,
+                                  "char");
   }
 	*value = cur->data.scalar.value[0];
 	return true;
@@ -172,45 +442,102 @@ bool yaml_construct_bool(bool *const value, yaml_loader_t *const loader,
 	} else if (strcmp("false", (const char*)cur->data.scalar.value) == 0) {
 		*value = false;
 	} else {
-    const char typename[] = "bool";
-    loader->error_info.expected = malloc(sizeof(typename));
-    if (loader->error_info.expected == NULL) {
-      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
-      yaml_event_delete(cur);
-    } else {
-      loader->error_info.type = YAML_LOADER_ERROR_VALUE;
-      memcpy(loader->error_info.expected, typename, sizeof(typename));
-      loader->error_info.event = *cur;
-    }
-    return false;
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_VALUE,
+                                  "bool");
 	}
 	return true;
 }
 
-#define DEFINE_FP_CONSTRUCTOR(name, value_type, overflow, func) \
+/*
+ * Recognize the YAML spellings of infinity and not-a-number (.inf, -.inf,
+ * .nan and their capitalized forms), which strtod does not accept.
+ */
+static bool special_float(char const *text, long double *const value) {
+  static char const *const infinities[] = {".inf", ".Inf", ".INF"};
+  static char const *const nans[] = {".nan", ".NaN", ".NAN"};
+  bool const signed_value = *text == '-' || *text == '+';
+  bool const negative = *text == '-';
+  if (signed_value) ++text;
+  for (size_t i = 0; i < sizeof(infinities) / sizeof(*infinities); ++i) {
+    if (strcmp(text, infinities[i]) == 0) {
+      *value = negative ? -INFINITY : INFINITY;
+      return true;
+    }
+  }
+  if (signed_value) return false;
+  for (size_t i = 0; i < sizeof(nans) / sizeof(*nans); ++i) {
+    if (strcmp(text, nans[i]) == 0) {
+      *value = NAN;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Finite values beyond the range of the type are errors, whereas infinity
+ * is accepted when it is written as such.
+ */
+#define DEFINE_FP_CONSTRUCTOR(name, value_type, func) \
 bool name(value_type *const value, yaml_loader_t *const loader,\
                   yaml_event_t* cur) {\
   if (!yaml_constructor_check_event_type(loader, cur, YAML_SCALAR_EVENT))\
     return false;\
+  long double special;\
+  if (special_float((const char*)cur->data.scalar.value, &special)) {\
+    *value = (value_type)special;\
+    return true;\
+  }\
   char* end_ptr;\
+  errno = 0;\
   *value = func((const char*)cur->data.scalar.value, &end_ptr);\
-  if (*end_ptr != '\0' || *value == (overflow)) {\
-    const char typename[] = #value_type;\
-    loader->error_info.expected = malloc(sizeof(typename));\
-    if (loader->error_info.expected == NULL) {\
-      loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;\
-      yaml_event_delete(cur);\
-    } else {\
-      loader->error_info.type = YAML_LOADER_ERROR_VALUE;\
-      memcpy(loader->error_info.expected, typename, sizeof(typename));\
-      loader->error_info.event = *cur;\
-    }\
-    return false;\
+  if (*end_ptr != '\0' || (errno == ERANGE && isinf(*value))) {\
+    return yaml_constructor_error(loader, cur, YAML_LOADER_ERROR_VALUE,\
+                                  #value_type);\
   }\
   return true;\
 }
 
-DEFINE_FP_CONSTRUCTOR(yaml_construct_float, float, HUGE_VALF, strtof)
-DEFINE_FP_CONSTRUCTOR(yaml_construct_double, double, HUGE_VAL, strtod)
-DEFINE_FP_CONSTRUCTOR(yaml_construct_long_double, long double, HUGE_VALL,
-	strtold)
\ No newline at end of file
+DEFINE_FP_CONSTRUCTOR(yaml_construct_float, float, strtof)
+DEFINE_FP_CONSTRUCTOR(yaml_construct_double, double, strtod)
+DEFINE_FP_CONSTRUCTOR(yaml_construct_long_double, long double, strtold)
+
+#ifdef _WIN32
+
+void yaml_constructor_enter_c_locale(yaml_constructor_locale_t *const saved) {
+  saved->per_thread = _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
+  const char *const name = setlocale(LC_NUMERIC, NULL);
+  saved->name = name == NULL ? NULL : malloc(strlen(name) + 1);
+  if (saved->name != NULL) strcpy(saved->name, name);
+  setlocale(LC_NUMERIC, "C");
+}
+
+void yaml_constructor_leave_c_locale(yaml_constructor_locale_t *const saved) {
+  if (saved->name != NULL) {
+    setlocale(LC_NUMERIC, saved->name);
+    free(saved->name);
+  }
+  _configthreadlocale(saved->per_thread);
+}
+
+#else
+
+static locale_t c_locale = (locale_t)0;
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+static void create_c_locale(void) {
+  c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+void yaml_constructor_enter_c_locale(yaml_constructor_locale_t *const saved) {
+  pthread_once(&c_locale_once, &create_c_locale);
+  // if the locale cannot be created, the thread's locale is left untouched.
+  saved->previous =
+      c_locale == (locale_t)0 ? NULL : (void*)uselocale(c_locale);
+}
+
+void yaml_constructor_leave_c_locale(yaml_constructor_locale_t *const saved) {
+  if (saved->previous != NULL) uselocale((locale_t)saved->previous);
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef YAML_COROUTINE_H
+#define YAML_COROUTINE_H
+
+/*
+ * Minimal stackful coroutines used by the runtime to suspend a running
+ * constructor. yaml_coroutine_resume runs the coroutine's function on its own
+ * stack until it calls yaml_coroutine_yield or returns; the next
+ * yaml_coroutine_resume continues after the yield. A coroutine must only be
+ * resumed by the thread that resumed it first. yaml_coroutine_restart lets a
+ * finished coroutine run another function on the same stack.
+ *
+ * Below each stack lies an inaccessible guard page (fibers get one from
+ * Windows), so overflowing the stack faults instead of corrupting memory.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef struct {
+  LPVOID fiber, caller;
+  void (*func)(void*);
+  void *arg;
+  bool finished;
+} yaml_coroutine_t;
+
+static void CALLBACK yaml_coroutine_entry(LPVOID arg) {
+  yaml_coroutine_t *const coroutine = (yaml_coroutine_t*)arg;
+  // a fiber cannot be restarted, so it runs one function after the other.
+  for (;;) {
+    coroutine->func(coroutine->arg);
+    coroutine->finished = true;
+    SwitchToFiber(coroutine->caller);
+  }
+}
+
+static inline bool yaml_coroutine_init(yaml_coroutine_t *const coroutine,
+    size_t const stack_size, void (*func)(void*), void *const arg) {
+  coroutine->func = func;
+  coroutine->arg = arg;
+  coroutine->finished = false;
+  coroutine->fiber = CreateFiber(stack_size, &yaml_coroutine_entry, coroutine);
+  return coroutine->fiber != NULL;
+}
+
+static inline bool yaml_coroutine_restart(yaml_coroutine_t *const coroutine,
+    void (*func)(void*), void *const arg) {
+  coroutine->func = func;
+  coroutine->arg = arg;
+  coroutine->finished = false;
+  return true;
+}
+
+static inline void yaml_coroutine_resume(yaml_coroutine_t *const coroutine) {
+  bool const converted = !IsThreadAFiber();
+  coroutine->caller =
+      converted ? ConvertThreadToFiber(NULL) : GetCurrentFiber();
+  SwitchToFiber(coroutine->fiber);
+  if (converted) ConvertFiberToThread();
+}
+
+static inline void yaml_coroutine_yield(yaml_coroutine_t *const coroutine) {
+  SwitchToFiber(coroutine->caller);
+}
+
+static inline void yaml_coroutine_delete(yaml_coroutine_t *const coroutine) {
+  DeleteFiber(coroutine->fiber);
+}
+#else
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+typedef struct {
+  ucontext_t context, caller;
+  /*
+   * mapping holds the guard page followed by the stack.
+   */
+  void *mapping, *stack;
+  size_t mapping_size, stack_size;
+  void (*func)(void*);
+  void *arg;
+  bool finished;
+} yaml_coroutine_t;
+
+/*
+ * makecontext only passes int arguments, so the coroutine's address is split
+ * into two halves.
+ */
+static void yaml_coroutine_entry(unsigned const high, unsigned const low) {
+  yaml_coroutine_t *const coroutine =
+      (yaml_coroutine_t*)(((uintptr_t)high << 16 << 16) | (uintptr_t)low);
+  coroutine->func(coroutine->arg);
+  // returning continues with uc_link, i.e. the caller.
+  coroutine->finished = true;
+}
+
+static inline bool yaml_coroutine_restart(yaml_coroutine_t *const coroutine,
+    void (*func)(void*), void *const arg) {
+  coroutine->func = func;
+  coroutine->arg = arg;
+  coroutine->finished = false;
+  if (getcontext(&coroutine->context) != 0) return false;
+  coroutine->context.uc_stack.ss_sp = coroutine->stack;
+  coroutine->context.uc_stack.ss_size = coroutine->stack_size;
+  coroutine->context.uc_link = &coroutine->caller;
+  uintptr_t const address = (uintptr_t)coroutine;
+  makecontext(&coroutine->context, (void (*)(void))&yaml_coroutine_entry, 2,
+              (unsigned)(address >> 16 >> 16), (unsigned)(address & 0xffffffff));
+  return true;
+}
+
+static inline bool yaml_coroutine_init(yaml_coroutine_t *const coroutine,
+    size_t const stack_size, void (*func)(void*), void *const arg) {
+  size_t const page = (size_t)sysconf(_SC_PAGESIZE);
+  coroutine->stack_size = (stack_size + page - 1) / page * page;
+  coroutine->mapping_size = coroutine->stack_size + page;
+  coroutine->mapping = mmap(NULL, coroutine->mapping_size,
+      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (coroutine->mapping == MAP_FAILED) return false;
+  // the stack grows downwards, towards the guard page.
+  coroutine->stack = (char*)coroutine->mapping + page;
+  if (mprotect(coroutine->mapping, page, PROT_NONE) != 0 ||
+      !yaml_coroutine_restart(coroutine, func, arg)) {
+    munmap(coroutine->mapping, coroutine->mapping_size);
+    return false;
+  }
+  return true;
+}
+
+static inline void yaml_coroutine_resume(yaml_coroutine_t *const coroutine) {
+  swapcontext(&coroutine->caller, &coroutine->context);
+}
+
+static inline void yaml_coroutine_yield(yaml_coroutine_t *const coroutine) {
+  swapcontext(&coroutine->context, &coroutine->caller);
+}
+
+static inline void yaml_coroutine_delete(yaml_coroutine_t *const coroutine) {
+  munmap(coroutine->mapping, coroutine->mapping_size);
+}
+#endif
+
+#endif
@@ -0,0 +1,703 @@
+#include <yaml_dumper.h>
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * what has last been written to the current line.
+ */
+enum {
+  POSITION_LINE_START, POSITION_KEY, POSITION_DASH, POSITION_TAG
+};
+
+#define MIN_CAPACITY 4096
+#define MIN_LEVELS 8
+#define MIN_ANCHORS 32
+
+static char *format_unsigned(char *end, unsigned long long value);
+
+void yaml_dumper_init(yaml_dumper_t *const dumper) {
+  dumper->buffer = NULL;
+  dumper->size = 0;
+  dumper->capacity = 0;
+  dumper->file = NULL;
+  dumper->error = YAML_DUMPER_ERROR_NONE;
+  dumper->error_type = NULL;
+  dumper->documents = 0;
+  dumper->internal.levels.data = NULL;
+  dumper->internal.levels.count = 0;
+  dumper->internal.levels.capacity = 0;
+  dumper->internal.tag = NULL;
+  dumper->internal.position = POSITION_LINE_START;
+  dumper->internal.cbor = false;
+  dumper->internal.anchors.data = NULL;
+  dumper->internal.anchors.count = 0;
+  dumper->internal.anchors.capacity = 0;
+  dumper->internal.anchor = 0;
+}
+
+void yaml_dumper_init_file(yaml_dumper_t *const dumper, FILE *const file) {
+  yaml_dumper_init(dumper);
+  dumper->file = file;
+}
+
+void yaml_dumper_use_cbor(yaml_dumper_t *const dumper) {
+  dumper->internal.cbor = true;
+}
+
+static bool write_buffer(yaml_dumper_t *const dumper) {
+  if (dumper->size > 0 &&
+      fwrite(dumper->buffer, 1, dumper->size, dumper->file) != dumper->size) {
+    dumper->error = YAML_DUMPER_ERROR_IO;
+    return false;
+  }
+  dumper->size = 0;
+  return true;
+}
+
+bool yaml_dumper_flush(yaml_dumper_t *const dumper) {
+  if (dumper->error != YAML_DUMPER_ERROR_NONE) return false;
+  if (dumper->file == NULL) return true;
+  if (!write_buffer(dumper)) return false;
+  if (fflush(dumper->file) != 0) {
+    dumper->error = YAML_DUMPER_ERROR_IO;
+    return false;
+  }
+  return true;
+}
+
+void yaml_dumper_delete(yaml_dumper_t *const dumper) {
+  free(dumper->buffer);
+  free(dumper->internal.levels.data);
+  free(dumper->internal.anchors.data);
+}
+
+bool yaml_dumper_fail(yaml_dumper_t *const dumper, const char *const type) {
+  if (dumper->error == YAML_DUMPER_ERROR_NONE) {
+    dumper->error = YAML_DUMPER_ERROR_VALUE;
+    dumper->error_type = type;
+  }
+  return false;
+}
+
+/*
+ * make room for length more bytes in the buffer, writing it to the file
+ * or growing it.
+ */
+static bool grow(yaml_dumper_t *const dumper, size_t const length) {
+  if (dumper->error != YAML_DUMPER_ERROR_NONE) return false;
+  if (dumper->file != NULL) {
+    if (!write_buffer(dumper)) return false;
+    if (length <= dumper->capacity) return true;
+  }
+  size_t capacity =
+      dumper->capacity == 0 ? MIN_CAPACITY : dumper->capacity * 2;
+  while (capacity < dumper->size + length) capacity *= 2;
+  unsigned char *const buffer = realloc(dumper->buffer, capacity);
+  if (buffer == NULL) {
+    dumper->error = YAML_DUMPER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  dumper->buffer = buffer;
+  dumper->capacity = capacity;
+  return true;
+}
+
+static inline bool reserve(yaml_dumper_t *const dumper, size_t const length) {
+  return dumper->capacity - dumper->size >= length || grow(dumper, length);
+}
+
+/*
+ * append to the buffer; room must have been reserved.
+ */
+static inline void put(yaml_dumper_t *const dumper, const char *const data,
+                       size_t const length) {
+  memcpy(dumper->buffer + dumper->size, data, length);
+  dumper->size += length;
+}
+
+static inline void put_char(yaml_dumper_t *const dumper, char const c) {
+  dumper->buffer[dumper->size++] = (unsigned char)c;
+}
+
+/*
+ * append the head of a CBOR data item with the given major type and argument,
+ * using the shortest encoding of the argument.
+ */
+static bool put_head(yaml_dumper_t *const dumper, unsigned const major,
+                     uint64_t const argument) {
+  if (!reserve(dumper, 9)) return false;
+  unsigned char const type = (unsigned char)(major << 5);
+  if (argument < 24) {
+    dumper->buffer[dumper->size++] = type | (unsigned char)argument;
+    return true;
+  }
+  unsigned const length =
+      argument <= 0xff ? 1 : argument <= 0xffff ? 2 :
+      argument <= 0xffffffff ? 4 : 8;
+  dumper->buffer[dumper->size++] =
+      type | (unsigned char)(length == 1 ? 24 : length == 2 ? 25 :
+                             length == 4 ? 26 : 27);
+  for (unsigned i = length; i > 0; --i) {
+    dumper->buffer[dumper->size++] =
+        (unsigned char)(argument >> (8 * (i - 1)));
+  }
+  return true;
+}
+
+/*
+ * append a CBOR text string.
+ */
+static bool put_text(yaml_dumper_t *const dumper, const char *const value,
+                     size_t const length) {
+  if (!put_head(dumper, 3, length) || !reserve(dumper, length)) return false;
+  put(dumper, value, length);
+  return true;
+}
+
+/*
+ * start a key or sequence item of the given collection on a new line unless
+ * it directly follows the dash of an enclosing sequence item.
+ */
+static bool begin_entry(yaml_dumper_t *const dumper,
+                        yaml_dumper_level_t *const level) {
+  int const position = dumper->internal.position;
+  size_t const indent = position == POSITION_DASH ? 0 : level->indent;
+  if (!reserve(dumper, indent + 3)) return false;
+  if (position == POSITION_KEY || position == POSITION_TAG) {
+    put_char(dumper, '\n');
+  }
+  memset(dumper->buffer + dumper->size, ' ', indent);
+  dumper->size += indent;
+  ++level->count;
+  return true;
+}
+
+/*
+ * write what precedes a node: the document separator, the dash of a
+ * sequence item and the tag.
+ */
+static bool begin_node(yaml_dumper_t *const dumper) {
+  if (dumper->internal.cbor) {
+    // tag 27 wraps the node as [tag, node].
+    const char *const tag = dumper->internal.tag;
+    dumper->internal.tag = NULL;
+    return tag == NULL ||
+        (put_head(dumper, 6, 27) && put_head(dumper, 4, 2) &&
+         put_text(dumper, tag, strlen(tag)));
+  }
+  size_t const depth = dumper->internal.levels.count;
+  if (depth == 0) {
+    if (dumper->documents > 0) {
+      if (!reserve(dumper, 4)) return false;
+      put(dumper, "---\n", 4);
+    }
+  } else {
+    yaml_dumper_level_t *const level =
+        &dumper->internal.levels.data[depth - 1];
+    // in mappings, yaml_dumper_key has already started the entry.
+    if (!level->mapping) {
+      if (!begin_entry(dumper, level)) return false;
+      put(dumper, "- ", 2);
+      dumper->internal.position = POSITION_DASH;
+    }
+  }
+  size_t const anchor = dumper->internal.anchor;
+  if (anchor != 0) {
+    char digits[24];
+    char *const end = digits + sizeof(digits);
+    char *const start = format_unsigned(end, anchor);
+    size_t const length = (size_t)(end - start);
+    if (!reserve(dumper, length + 3)) return false;
+    if (dumper->internal.position == POSITION_KEY) put_char(dumper, ' ');
+    put(dumper, "&a", 2);
+    put(dumper, start, length);
+    dumper->internal.anchor = 0;
+    dumper->internal.position = POSITION_TAG;
+  }
+  const char *const tag = dumper->internal.tag;
+  if (tag != NULL) {
+    size_t const length = strlen(tag);
+    if (!reserve(dumper, length + 2)) return false;
+    if (dumper->internal.position == POSITION_KEY ||
+        dumper->internal.position == POSITION_TAG) put_char(dumper, ' ');
+    put_char(dumper, '!');
+    put(dumper, tag, length);
+    dumper->internal.tag = NULL;
+    dumper->internal.position = POSITION_TAG;
+  }
+  return true;
+}
+
+static inline void end_node(yaml_dumper_t *const dumper) {
+  dumper->internal.position = POSITION_LINE_START;
+  if (dumper->internal.levels.count == 0) {
+    ++dumper->documents;
+    // anchors are local to their document.
+    if (dumper->internal.anchors.count != 0) {
+      memset(dumper->internal.anchors.data, 0, dumper->internal.anchors.capacity
+             * sizeof(yaml_dumper_anchor_t));
+      dumper->internal.anchors.count = 0;
+    }
+  }
+}
+
+/*
+ * return true iff the given string can be written as plain scalar. Strings
+ * that other YAML implementations would read as number, boolean or null are
+ * quoted.
+ */
+static bool is_plain(const unsigned char *const value, size_t const length) {
+  static const char *const reserved[] = {
+      "null", "true", "false", "yes", "no", "on", "off", "y", "n"
+  };
+  if (length == 0) return false;
+  unsigned char const first = value[0];
+  if (!((first >= 'a' && first <= 'z') || (first >= 'A' && first <= 'Z') ||
+        first == '_' || first == '/')) {
+    return false;
+  }
+  if (value[length - 1] == ' ') return false;
+  for (size_t i = 1; i < length; ++i) {
+    unsigned char const c = value[i];
+    if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+          (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' ||
+          c == '/' || c == '+' || c == ' ')) {
+      return false;
+    }
+  }
+  if (length <= 5) {
+    for (size_t i = 0; i < sizeof(reserved) / sizeof(*reserved); ++i) {
+      size_t j = 0;
+      while (j < length && reserved[i][j] != '\0' &&
+             (value[j] | 0x20) == (unsigned char)reserved[i][j]) ++j;
+      if (j == length && reserved[i][j] == '\0') return false;
+    }
+  }
+  return true;
+}
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/*
+ * append the given code point as escape sequence.
+ */
+static void put_escape(yaml_dumper_t *const dumper, uint32_t const code_point) {
+  int digits;
+  put_char(dumper, '\\');
+  if (code_point <= 0xff) {
+    put_char(dumper, 'x');
+    digits = 2;
+  } else if (code_point <= 0xffff) {
+    put_char(dumper, 'u');
+    digits = 4;
+  } else {
+    put_char(dumper, 'U');
+    digits = 8;
+  }
+  for (int i = digits - 1; i >= 0; --i) {
+    put_char(dumper, hex_digits[(code_point >> (i * 4)) & 0xf]);
+  }
+}
+
+/*
+ * append the given UTF-8 string as double-quoted scalar. Characters YAML
+ * does not allow in the input, and line breaks, are escaped.
+ */
+static bool put_quoted(yaml_dumper_t *const dumper,
+                       const unsigned char *const value, size_t const length) {
+  // an escape sequence is at most four times as long as the input it
+  // replaces.
+  if (!reserve(dumper, length * 4 + 2)) return false;
+  put_char(dumper, '"');
+  size_t i = 0;
+  while (i < length) {
+    unsigned char const c = value[i];
+    if (c < 0x80) {
+      switch (c) {
+        case '"': put(dumper, "\\\"", 2); break;
+        case '\\': put(dumper, "\\\\", 2); break;
+        case '\0': put(dumper, "\\0", 2); break;
+        case '\t': put(dumper, "\\t", 2); break;
+        case '\n': put(dumper, "\\n", 2); break;
+        case '\r': put(dumper, "\\r", 2); break;
+        default:
+          if (c < 0x20 || c == 0x7f) put_escape(dumper, c);
+          else put_char(dumper, (char)c);
+      }
+      ++i;
+      continue;
+    }
+    size_t const count = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+    uint32_t code_point = c & (0x7fu >> count);
+    bool valid = count > 1 && i + count <= length;
+    for (size_t j = 1; valid && j < count; ++j) {
+      valid = (value[i + j] & 0xc0) == 0x80;
+      code_point = (code_point << 6) | (value[i + j] & 0x3fu);
+    }
+    if (!valid) {
+      // not UTF-8; this changes the string, but keeps the output readable.
+      put_escape(dumper, c);
+      ++i;
+      continue;
+    }
+    switch (code_point) {
+      case 0x85: put(dumper, "\\N", 2); break;
+      case 0x2028: put(dumper, "\\L", 2); break;
+      case 0x2029: put(dumper, "\\P", 2); break;
+      default:
+        if ((code_point >= 0xa0 && code_point <= 0xd7ff) ||
+            (code_point >= 0xe000 && code_point <= 0xfffd &&
+             code_point != 0xfeff) ||
+            (code_point >= 0x10000 && code_point <= 0x10ffff)) {
+          put(dumper, (const char*)value + i, count);
+        } else {
+          put_escape(dumper, code_point);
+        }
+    }
+    i += count;
+  }
+  put_char(dumper, '"');
+  return true;
+}
+
+static bool write_scalar(yaml_dumper_t *const dumper, const char *const value,
+                         size_t const length, bool const quoted) {
+  if (!begin_node(dumper)) return false;
+  if (dumper->internal.cbor) {
+    if (!put_text(dumper, value, length)) return false;
+    end_node(dumper);
+    return true;
+  }
+  int const position = dumper->internal.position;
+  if (!reserve(dumper, 1)) return false;
+  if (position == POSITION_KEY || position == POSITION_TAG) {
+    put_char(dumper, ' ');
+  }
+  if (quoted) {
+    if (!put_quoted(dumper, (const unsigned char*)value, length)) return false;
+  } else {
+    if (!reserve(dumper, length)) return false;
+    put(dumper, value, length);
+  }
+  if (!reserve(dumper, 1)) return false;
+  put_char(dumper, '\n');
+  end_node(dumper);
+  return true;
+}
+
+bool yaml_dumper_tag(yaml_dumper_t *const dumper, const char *const tag) {
+  dumper->internal.tag = tag;
+  return dumper->error == YAML_DUMPER_ERROR_NONE;
+}
+
+bool yaml_dumper_scalar(yaml_dumper_t *const dumper, const char *const value,
+                        size_t const length) {
+  return write_scalar(dumper, value, length,
+                      !is_plain((const unsigned char*)value, length));
+}
+
+static bool start_collection(yaml_dumper_t *const dumper, bool const mapping) {
+  if (!begin_node(dumper)) return false;
+  size_t const depth = dumper->internal.levels.count;
+  if (depth == dumper->internal.levels.capacity) {
+    size_t const capacity = depth == 0 ? MIN_LEVELS : depth * 2;
+    yaml_dumper_level_t *const levels = realloc(
+        dumper->internal.levels.data, capacity * sizeof(yaml_dumper_level_t));
+    if (levels == NULL) {
+      dumper->error = YAML_DUMPER_ERROR_OUT_OF_MEMORY;
+      return false;
+    }
+    dumper->internal.levels.data = levels;
+    dumper->internal.levels.capacity = capacity;
+  }
+  yaml_dumper_level_t *const level = &dumper->internal.levels.data[depth];
+  level->indent =
+      depth == 0 ? 0 : dumper->internal.levels.data[depth - 1].indent + 2;
+  level->count = 0;
+  level->mapping = mapping;
+  dumper->internal.levels.count = depth + 1;
+  if (dumper->internal.cbor) {
+    // CBOR collections have indefinite length and end with a break.
+    if (!reserve(dumper, 1)) return false;
+    put_char(dumper, (char)(mapping ? 0xbf : 0x9f));
+  }
+  return true;
+}
+
+static bool end_collection(yaml_dumper_t *const dumper) {
+  yaml_dumper_level_t const *const level =
+      &dumper->internal.levels.data[dumper->internal.levels.count - 1];
+  if (dumper->internal.cbor) {
+    if (!reserve(dumper, 1)) return false;
+    put_char(dumper, (char)0xff);
+  } else if (level->count == 0) {
+    // empty collections are written in flow style.
+    if (!reserve(dumper, 4)) return false;
+    int const position = dumper->internal.position;
+    if (position == POSITION_KEY || position == POSITION_TAG) {
+      put_char(dumper, ' ');
+    }
+    put(dumper, level->mapping ? "{}\n" : "[]\n", 3);
+  }
+  --dumper->internal.levels.count;
+  end_node(dumper);
+  return dumper->error == YAML_DUMPER_ERROR_NONE;
+}
+
+bool yaml_dumper_mapping_start(yaml_dumper_t *const dumper) {
+  return start_collection(dumper, true);
+}
+
+bool yaml_dumper_key(yaml_dumper_t *const dumper, const char *const key,
+                     size_t const length) {
+  yaml_dumper_level_t *const level =
+      &dumper->internal.levels.data[dumper->internal.levels.count - 1];
+  if (dumper->internal.cbor) {
+    ++level->count;
+    return put_text(dumper, key, length);
+  }
+  if (!begin_entry(dumper, level) || !reserve(dumper, length + 1)) {
+    return false;
+  }
+  put(dumper, key, length);
+  put_char(dumper, ':');
+  dumper->internal.position = POSITION_KEY;
+  return true;
+}
+
+bool yaml_dumper_mapping_end(yaml_dumper_t *const dumper) {
+  return end_collection(dumper);
+}
+
+bool yaml_dumper_sequence_start(yaml_dumper_t *const dumper) {
+  return start_collection(dumper, false);
+}
+
+bool yaml_dumper_sequence_end(yaml_dumper_t *const dumper) {
+  return end_collection(dumper);
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+
+/*
+ * format the given value into the bytes before end, two digits at a time.
+ * returns the start of the formatted value.
+ */
+static char *format_unsigned(char *end, unsigned long long value) {
+  while (value >= 100) {
+    unsigned const pair = (unsigned)(value % 100) * 2;
+    value /= 100;
+    *--end = digit_pairs[pair + 1];
+    *--end = digit_pairs[pair];
+  }
+  if (value >= 10) {
+    *--end = digit_pairs[value * 2 + 1];
+    *--end = digit_pairs[value * 2];
+  } else {
+    *--end = (char)('0' + value);
+  }
+  return end;
+}
+
+static bool write_signed(yaml_dumper_t *const dumper, long long const value) {
+  if (dumper->internal.cbor) {
+    // -1 - value is the argument of a negative integer.
+    if (!begin_node(dumper) ||
+        !(value < 0 ? put_head(dumper, 1, (uint64_t)(-1 - value)) :
+                      put_head(dumper, 0, (uint64_t)value))) return false;
+    end_node(dumper);
+    return true;
+  }
+  char buffer[24];
+  char *const end = buffer + sizeof(buffer);
+  // negate as unsigned, which is defined for the minimum as well.
+  char *start = format_unsigned(
+      end, value < 0 ? 0ULL - (unsigned long long)value :
+                       (unsigned long long)value);
+  if (value < 0) *--start = '-';
+  return write_scalar(dumper, start, (size_t)(end - start), false);
+}
+
+static bool write_unsigned(yaml_dumper_t *const dumper,
+                           unsigned long long const value) {
+  if (dumper->internal.cbor) {
+    if (!begin_node(dumper) || !put_head(dumper, 0, value)) return false;
+    end_node(dumper);
+    return true;
+  }
+  char buffer[24];
+  char *const end = buffer + sizeof(buffer);
+  char *const start = format_unsigned(end, value);
+  return write_scalar(dumper, start, (size_t)(end - start), false);
+}
+
+/*
+ * return the slot of the anchor table that holds the given value, or the
+ * empty slot where it belongs.
+ */
+static yaml_dumper_anchor_t *anchor_slot(yaml_dumper_t *const dumper,
+                                         const void *const value) {
+  size_t const mask = dumper->internal.anchors.capacity - 1;
+  // Fibonacci hashing; the lowest bits of pointers are mostly zero.
+  size_t i = (size_t)(((uint64_t)(uintptr_t)value *
+                       UINT64_C(0x9e3779b97f4a7c15)) >> 32) & mask;
+  yaml_dumper_anchor_t *const data = dumper->internal.anchors.data;
+  while (data[i].value != NULL && data[i].value != value) i = (i + 1) & mask;
+  return &data[i];
+}
+
+bool yaml_dumper_alias(yaml_dumper_t *const dumper, const void *const value,
+                       size_t const refs) {
+  if (refs < 2 || dumper->internal.cbor) return false;
+  size_t const count = dumper->internal.anchors.count;
+  // keep the table at most half full.
+  if (2 * (count + 1) > dumper->internal.anchors.capacity) {
+    size_t const old_capacity = dumper->internal.anchors.capacity;
+    yaml_dumper_anchor_t *const old_data = dumper->internal.anchors.data;
+    size_t const capacity = old_capacity == 0 ? MIN_ANCHORS : old_capacity * 2;
+    yaml_dumper_anchor_t *const data =
+        calloc(capacity, sizeof(yaml_dumper_anchor_t));
+    if (data == NULL) {
+      dumper->error = YAML_DUMPER_ERROR_OUT_OF_MEMORY;
+      return true;
+    }
+    dumper->internal.anchors.data = data;
+    dumper->internal.anchors.capacity = capacity;
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_data[i].value != NULL) {
+        *anchor_slot(dumper, old_data[i].value) = old_data[i];
+      }
+    }
+    free(old_data);
+  }
+  yaml_dumper_anchor_t *const slot = anchor_slot(dumper, value);
+  if (slot->value == NULL) {
+    slot->value = value;
+    slot->id = dumper->internal.anchors.count = count + 1;
+    dumper->internal.anchor = slot->id;
+    return false;
+  }
+  // an alias cannot have a tag; write the value again instead.
+  if (dumper->internal.tag != NULL) return false;
+  char buffer[24];
+  char *const end = buffer + sizeof(buffer);
+  char *start = format_unsigned(end, slot->id);
+  *--start = 'a';
+  *--start = '*';
+  write_scalar(dumper, start, (size_t)(end - start), false);
+  return true;
+}
+
+#define DEFINE_INT_DUMPER(name, value_type, writer)\
+bool name(const value_type *const value, yaml_dumper_t *const dumper) {\
+  if (value == NULL) return yaml_dumper_fail(dumper, #value_type);\
+  return writer(dumper, *value);\
+}
+
+DEFINE_INT_DUMPER(yaml_dump_short, short, write_signed)
+DEFINE_INT_DUMPER(yaml_dump_int, int, write_signed)
+DEFINE_INT_DUMPER(yaml_dump_long, long, write_signed)
+DEFINE_INT_DUMPER(yaml_dump_long_long, long long, write_signed)
+DEFINE_INT_DUMPER(yaml_dump_unsigned_char, unsigned char, write_unsigned)
+DEFINE_INT_DUMPER(yaml_dump_unsigned_short, unsigned short, write_unsigned)
+DEFINE_INT_DUMPER(yaml_dump_unsigned, unsigned, write_unsigned)
+DEFINE_INT_DUMPER(yaml_dump_unsigned_long, unsigned long, write_unsigned)
+DEFINE_INT_DUMPER(yaml_dump_unsigned_long_long, unsigned long long,
+                  write_unsigned)
+DEFINE_INT_DUMPER(yaml_dump_size_t, size_t, write_unsigned)
+
+/*
+ * append a floating point value in CBOR's single or double precision format.
+ */
+static bool write_binary_float(yaml_dumper_t *const dumper, double const value,
+                               bool const single) {
+  uint64_t bits;
+  if (single) {
+    float const narrow = (float)value;
+    uint32_t narrow_bits;
+    memcpy(&narrow_bits, &narrow, sizeof(narrow_bits));
+    bits = narrow_bits;
+  } else memcpy(&bits, &value, sizeof(bits));
+  unsigned const length = single ? 4 : 8;
+  if (!begin_node(dumper) || !reserve(dumper, length + 1)) return false;
+  put_char(dumper, (char)(single ? 0xfa : 0xfb));
+  for (unsigned i = length; i > 0; --i) {
+    put_char(dumper, (char)(unsigned char)(bits >> (8 * (i - 1))));
+  }
+  end_node(dumper);
+  return true;
+}
+
+/*
+ * the value is formatted with increasing precision, starting at the number
+ * of digits any decimal with that many digits survives, until it reads back
+ * unchanged. Most values written by humans take a single attempt. The
+ * loaders parse in the C locale, so the locale's decimal point is replaced.
+ * Infinity and not-a-number are written as .inf, -.inf and .nan, which YAML
+ * reads back. CBOR has binary formats for all values a double can hold;
+ * other values are written as text.
+ */
+#define DEFINE_FP_DUMPER(name, value_type, min_digits, max_digits, format,\
+                         func)\
+bool name(const value_type *const value, yaml_dumper_t *const dumper) {\
+  if (value == NULL) return yaml_dumper_fail(dumper, #value_type);\
+  if (dumper->internal.cbor &&\
+      (isnan(*value) || (long double)(double)*value == *value)) {\
+    return write_binary_float(dumper, (double)*value,\
+                              sizeof(value_type) == sizeof(float));\
+  }\
+  if (isnan(*value)) return write_scalar(dumper, ".nan", 4, false);\
+  if (isinf(*value)) {\
+    return *value < 0 ? write_scalar(dumper, "-.inf", 5, false) :\
+                        write_scalar(dumper, ".inf", 4, false);\
+  }\
+  char buffer[64];\
+  int length;\
+  for (int precision = (min_digits);; ++precision) {\
+    length = snprintf(buffer, sizeof(buffer), format, precision, *value);\
+    if (precision >= (max_digits) || func(buffer, NULL) == *value) break;\
+  }\
+  char const point = localeconv()->decimal_point[0];\
+  if (point != '.') {\
+    for (int i = 0; i < length; ++i) {\
+      if (buffer[i] == point) buffer[i] = '.';\
+    }\
+  }\
+  return write_scalar(dumper, buffer, (size_t)length, false);\
+}
+
+DEFINE_FP_DUMPER(yaml_dump_float, float, FLT_DIG, FLT_DIG + 3, "%.*g", strtof)
+DEFINE_FP_DUMPER(yaml_dump_double, double, DBL_DIG, DBL_DIG + 2, "%.*g",
+                 strtod)
+DEFINE_FP_DUMPER(yaml_dump_long_double, long double, LDBL_DIG, DECIMAL_DIG,
+                 "%.*Lg", strtold)
+
+bool yaml_dump_char(const char *const value, yaml_dumper_t *const dumper) {
+  if (value == NULL) return yaml_dumper_fail(dumper, "char");
+  return yaml_dumper_scalar(dumper, value, 1);
+}
+
+bool yaml_dump_bool(const bool *const value, yaml_dumper_t *const dumper) {
+  if (value == NULL) return yaml_dumper_fail(dumper, "bool");
+  if (dumper->internal.cbor) {
+    if (!begin_node(dumper) || !reserve(dumper, 1)) return false;
+    put_char(dumper, (char)(*value ? 0xf5 : 0xf4));
+    end_node(dumper);
+    return true;
+  }
+  return *value ? write_scalar(dumper, "true", 4, false) :
+                  write_scalar(dumper, "false", 5, false);
+}
+
+bool yaml_dump_string(const char *const value, yaml_dumper_t *const dumper) {
+  if (value == NULL) return yaml_dumper_fail(dumper, "string");
+  return yaml_dumper_scalar(dumper, value, strlen(value));
+}
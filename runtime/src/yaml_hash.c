@@ -0,0 +1,23 @@
+#include <yaml_hash.h>
+
+static inline uint64_t read_word(const unsigned char *const bytes) {
+  uint64_t word;
+  memcpy(&word, bytes, sizeof(word));
+  return word;
+}
+
+uint64_t yaml_hash_bytes(const void *data, size_t length, uint64_t hash) {
+  const unsigned char *bytes = (const unsigned char*)data;
+  // the length comes first, so that zero padding of the tail is unambiguous.
+  hash = yaml_hash_integer(length, hash);
+  while (length > 16) {
+    hash = yaml_hash_mix(read_word(bytes) ^ YAML_HASH_P0,
+                         read_word(bytes + 8) ^ hash);
+    bytes += 16;
+    length -= 16;
+  }
+  unsigned char tail[16] = {0};
+  memcpy(tail, bytes, length);
+  return yaml_hash_mix(read_word(tail) ^ YAML_HASH_P1,
+                       read_word(tail + 8) ^ hash ^ YAML_HASH_P2);
+}
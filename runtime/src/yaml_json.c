@@ -0,0 +1,740 @@
+/*
+ * Records the events of JSON text into a tape without going through libyaml,
+ * in two stages like simdjson: the first stage classifies the input 64 bytes
+ * at a time and collects the offsets of all structural characters (brackets,
+ * braces, colons, commas and the first byte of each scalar outside strings);
+ * the second stage walks these offsets, checks the grammar and records the
+ * events.
+ */
+
+#include <yaml_tape.h>
+#include <yaml_loader.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "yaml_tape_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define YAML_JSON_SSE2
+#endif
+#ifdef __PCLMUL__
+#include <wmmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Number of bytes classified at once by the first stage. Each byte is
+ * represented by one bit of a 64-bit mask.
+ */
+#define BLOCK_SIZE 64
+
+#define ONES UINT64_C(0x0101010101010101)
+#define HIGH_BITS UINT64_C(0x8080808080808080)
+#define ODD_BITS UINT64_C(0xaaaaaaaaaaaaaaaa)
+
+static inline unsigned count_trailing_zeros(uint64_t const x) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return (unsigned)index;
+#else
+  unsigned n = 0;
+  while (((x >> n) & 1) == 0) ++n;
+  return n;
+#endif
+}
+
+static inline unsigned count_ones(uint64_t x) {
+#if defined(__GNUC__)
+  return (unsigned)__builtin_popcountll(x);
+#else
+  x -= (x >> 1) & UINT64_C(0x5555555555555555);
+  x = (x & UINT64_C(0x3333333333333333)) +
+      ((x >> 2) & UINT64_C(0x3333333333333333));
+  x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (unsigned)((x * ONES) >> 56);
+#endif
+}
+
+/*
+ * Load 8 bytes so that the first one is the least significant, regardless of
+ * the machine's byte order. Compilers turn this into a single load.
+ */
+static inline uint64_t load_word(const unsigned char *const bytes) {
+  return (uint64_t)bytes[0] | (uint64_t)bytes[1] << 8 |
+      (uint64_t)bytes[2] << 16 | (uint64_t)bytes[3] << 24 |
+      (uint64_t)bytes[4] << 32 | (uint64_t)bytes[5] << 40 |
+      (uint64_t)bytes[6] << 48 | (uint64_t)bytes[7] << 56;
+}
+
+/*
+ * Set the highest bit of each byte of word that equals c, clear all others.
+ */
+static inline uint64_t equal_bytes(uint64_t const word, unsigned char const c) {
+  uint64_t const x = word ^ (ONES * c);
+  return ~(((x & ~HIGH_BITS) + ~HIGH_BITS) | x) & HIGH_BITS;
+}
+
+/*
+ * Bit i of the result is set iff any bit up to and including bit i is set an
+ * odd number of times in x, i.e. bits between an opening and a closing quote.
+ */
+static inline uint64_t prefix_xor(uint64_t x) {
+#ifdef __PCLMUL__
+  return (uint64_t)_mm_cvtsi128_si64(_mm_clmulepi64_si128(
+      _mm_set_epi64x(0, (long long)x), _mm_set1_epi8((char)0xff), 0));
+#else
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+#endif
+}
+
+typedef struct {
+  uint64_t backslash, quote, op, whitespace;
+} block_masks_t;
+
+#ifdef YAML_JSON_SSE2
+static void classify(const unsigned char *const block,
+                     block_masks_t *const masks) {
+  __m128i const backslash = _mm_set1_epi8('\\'), quote = _mm_set1_epi8('"'),
+      colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(','),
+      opening_bracket = _mm_set1_epi8('['),
+      closing_bracket = _mm_set1_epi8(']'),
+      opening_brace = _mm_set1_epi8('{'), closing_brace = _mm_set1_epi8('}'),
+      space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'),
+      line_feed = _mm_set1_epi8('\n'), carriage_return = _mm_set1_epi8('\r');
+  memset(masks, 0, sizeof(block_masks_t));
+  for (unsigned i = 0; i < BLOCK_SIZE / 16; ++i) {
+    __m128i const v = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+    __m128i const op = _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, colon),
+                                  _mm_cmpeq_epi8(v, comma)),
+                     _mm_or_si128(_mm_cmpeq_epi8(v, opening_bracket),
+                                  _mm_cmpeq_epi8(v, closing_bracket))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, opening_brace),
+                     _mm_cmpeq_epi8(v, closing_brace)));
+    __m128i const whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, line_feed),
+                     _mm_cmpeq_epi8(v, carriage_return)));
+    masks->backslash |= (uint64_t)(unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(v, backslash)) << (16 * i);
+    masks->quote |= (uint64_t)(unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(v, quote)) << (16 * i);
+    masks->op |= (uint64_t)(unsigned)_mm_movemask_epi8(op) << (16 * i);
+    masks->whitespace |=
+        (uint64_t)(unsigned)_mm_movemask_epi8(whitespace) << (16 * i);
+  }
+}
+#else
+/*
+ * Gather the highest bits of the bytes of x into the lowest 8 bits.
+ */
+static inline uint64_t pack_bytes(uint64_t const x) {
+  return ((x >> 7) * UINT64_C(0x0102040810204080)) >> 56;
+}
+
+static void classify(const unsigned char *const block,
+                     block_masks_t *const masks) {
+  memset(masks, 0, sizeof(block_masks_t));
+  for (unsigned i = 0; i < BLOCK_SIZE / 8; ++i) {
+    uint64_t const w = load_word(block + 8 * i);
+    uint64_t const op = equal_bytes(w, ':') | equal_bytes(w, ',') |
+        equal_bytes(w, '[') | equal_bytes(w, ']') | equal_bytes(w, '{') |
+        equal_bytes(w, '}');
+    uint64_t const whitespace = equal_bytes(w, ' ') | equal_bytes(w, '\t') |
+        equal_bytes(w, '\n') | equal_bytes(w, '\r');
+    masks->backslash |= pack_bytes(equal_bytes(w, '\\')) << (8 * i);
+    masks->quote |= pack_bytes(equal_bytes(w, '"')) << (8 * i);
+    masks->op |= pack_bytes(op) << (8 * i);
+    masks->whitespace |= pack_bytes(whitespace) << (8 * i);
+  }
+}
+#endif
+
+/*
+ * Stage 1: store the offsets of the structural characters of input[start,
+ * size) in the tape. The last partial block is padded with spaces.
+ */
+static bool find_structurals(yaml_tape_t *const tape,
+                             const unsigned char *const input,
+                             size_t const start, size_t const size) {
+  // no block has more structural characters than bytes.
+  if (!YAML_TAPE_CAPACITY(&tape->structurals, size - start + 1)) return false;
+  uint32_t *out = tape->structurals.data;
+  // whether the first byte of the next block is escaped, lies inside a
+  // string, or follows a scalar that does not end with a quote.
+  uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0;
+  for (size_t base = start; base < size; base += BLOCK_SIZE) {
+    const unsigned char *block = input + base;
+    unsigned char padded[BLOCK_SIZE];
+    if (size - base < BLOCK_SIZE) {
+      memset(padded, ' ', BLOCK_SIZE);
+      memcpy(padded, block, size - base);
+      block = padded;
+    }
+    block_masks_t masks;
+    classify(block, &masks);
+
+    // a backslash escapes the next character iff it starts a run of odd
+    // length. Subtracting the run starts from the odd bits carries through
+    // each run and ends on an odd bit for runs starting on even positions.
+    uint64_t escaped;
+    if (masks.backslash == 0) {
+      escaped = prev_escaped;
+      prev_escaped = 0;
+    } else {
+      uint64_t const starts = masks.backslash & ~prev_escaped;
+      uint64_t const ends =
+          (((starts << 1) | ODD_BITS) - starts) ^ ODD_BITS;
+      escaped = ends ^ (masks.backslash | prev_escaped);
+      prev_escaped = (ends & masks.backslash) >> 63;
+    }
+    uint64_t const quote = masks.quote & ~escaped;
+    uint64_t const in_string = prefix_xor(quote) ^ prev_in_string;
+    prev_in_string = 0 - (in_string >> 63);
+
+    uint64_t const scalar = ~(masks.op | masks.whitespace);
+    uint64_t const unquoted = scalar & ~quote;
+    uint64_t const follows_scalar = (unquoted << 1) | prev_scalar;
+    prev_scalar = unquoted >> 63;
+    // an opening quote is structural even right after a scalar, so that the
+    // scalar cannot swallow the string. String contents and closing quotes
+    // are not structural.
+    uint64_t structurals = (masks.op | quote | (scalar & ~follows_scalar)) &
+        ~(in_string ^ quote);
+    while (structurals != 0) {
+      *out++ = (uint32_t)(base + count_trailing_zeros(structurals));
+      structurals &= structurals - 1;
+    }
+  }
+  tape->structurals.count = (size_t)(out - tape->structurals.data);
+  return true;
+}
+
+/*
+ * Position in the input for which a mark has been computed last. Marks count
+ * characters like libyaml's, so they are computed by walking the input
+ * between two events, 8 bytes at a time where there is no line break.
+ */
+typedef struct {
+  const unsigned char *input;
+  /*
+   * offset at which the first character starts, i.e. after a byte order mark.
+   */
+  size_t start;
+  size_t size, offset;
+  /*
+   * character index at which the current line starts.
+   */
+  size_t line_start;
+  yaml_mark_t mark;
+} json_position_t;
+
+static void position_init(json_position_t *const pos,
+                          const unsigned char *const input, size_t const size,
+                          size_t const start) {
+  pos->input = input;
+  pos->start = pos->offset = start;
+  pos->size = size;
+  pos->line_start = 0;
+  memset(&pos->mark, 0, sizeof(yaml_mark_t));
+}
+
+static yaml_mark_t mark_at(json_position_t *const pos, size_t const offset) {
+  const unsigned char *const input = pos->input;
+  size_t index = pos->mark.index, line = pos->mark.line;
+  size_t line_start = pos->line_start, cur = pos->offset;
+  while (cur < offset) {
+    if (pos->size - cur >= 8) {
+      // the word may extend past offset, its excess bytes are masked out.
+      size_t const n = offset - cur < 8 ? offset - cur : 8;
+      uint64_t const keep = n == 8 ? HIGH_BITS :
+          ((UINT64_C(1) << (8 * n)) - 1) & HIGH_BITS;
+      uint64_t const w = load_word(input + cur);
+      if ((equal_bytes(w, '\r') & keep) == 0) {
+        // every byte that is not a continuation byte starts a character.
+        uint64_t const starts = keep & ~(w & ~(w << 1));
+        uint64_t breaks = equal_bytes(w, '\n') & keep;
+        if (breaks != 0) {
+          line += count_ones(breaks);
+          // mark all bytes up to the last line break.
+          breaks |= breaks >> 8;
+          breaks |= breaks >> 16;
+          breaks |= breaks >> 32;
+          line_start = index + count_ones(starts & breaks);
+        }
+        index += count_ones(starts);
+        cur += n;
+        continue;
+      }
+    }
+    unsigned char const c = input[cur++];
+    if ((c & 0xc0) != 0x80) ++index;
+    if (c == '\n' ||
+        (c == '\r' && (cur == pos->size || input[cur] != '\n'))) {
+      ++line;
+      line_start = index;
+    }
+  }
+  pos->offset = cur;
+  pos->line_start = line_start;
+  pos->mark.index = index;
+  pos->mark.line = line;
+  pos->mark.column = index - line_start;
+  return pos->mark;
+}
+
+static bool syntax_error(yaml_tape_t *const tape, json_position_t *const pos,
+                         size_t const offset, const char *const problem) {
+  if (offset < pos->offset) {
+    position_init(pos, pos->input, pos->size, pos->start);
+  }
+  tape->error = YAML_LOADER_ERROR_PARSER;
+  tape->problem = problem;
+  tape->problem_mark = mark_at(pos, offset);
+  return false;
+}
+
+/*
+ * Append an entry of the given type. Entries and the arena have been reserved
+ * for the whole input before.
+ */
+static yaml_tape_entry_t *add_entry(yaml_tape_t *const tape,
+                                    yaml_event_type_t const type) {
+  yaml_tape_entry_t *const entry = &tape->entries.data[tape->entries.count++];
+  entry->type = type;
+  entry->style = 0;
+  entry->implicit = entry->quoted_implicit = false;
+  entry->anchor = entry->tag = entry->value = SIZE_MAX;
+  entry->length = entry->end = entry->children = 0;
+  switch (type) {
+    case YAML_SCALAR_EVENT:
+    case YAML_SEQUENCE_START_EVENT:
+    case YAML_MAPPING_START_EVENT:
+      if (tape->open.count > 0) {
+        tape->entries.data[tape->open.data[tape->open.count - 1]].children++;
+      }
+      break;
+    default:
+      break;
+  }
+  return entry;
+}
+
+static unsigned hex_value(unsigned char const c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return 16;
+}
+
+/*
+ * Read the four hex digits of a \u escape at input[offset]. Returns a value
+ * above 0xffff if they are invalid.
+ */
+static uint32_t read_hex4(const unsigned char *const input, size_t const size,
+                          size_t const offset) {
+  if (size - offset < 4) return UINT32_MAX;
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    unsigned const digit = hex_value(input[offset + i]);
+    if (digit == 16) return UINT32_MAX;
+    value = value << 4 | digit;
+  }
+  return value;
+}
+
+static size_t encode_utf8(uint32_t const code, char *const out) {
+  if (code < 0x80) {
+    out[0] = (char)code;
+    return 1;
+  } else if (code < 0x800) {
+    out[0] = (char)(0xc0 | code >> 6);
+    out[1] = (char)(0x80 | (code & 0x3f));
+    return 2;
+  } else if (code < 0x10000) {
+    out[0] = (char)(0xe0 | code >> 12);
+    out[1] = (char)(0x80 | ((code >> 6) & 0x3f));
+    out[2] = (char)(0x80 | (code & 0x3f));
+    return 3;
+  } else {
+    out[0] = (char)(0xf0 | code >> 18);
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (code & 0x3f));
+    return 4;
+  }
+}
+
+/*
+ * Return the length of the valid UTF-8 sequence at input[offset], 0 if it is
+ * invalid.
+ */
+static size_t utf8_length(const unsigned char *const input, size_t const size,
+                          size_t const offset) {
+  unsigned char const c = input[offset];
+  size_t length;
+  uint32_t code, min;
+  if ((c & 0xe0) == 0xc0) {
+    length = 2;
+    code = c & 0x1f;
+    min = 0x80;
+  } else if ((c & 0xf0) == 0xe0) {
+    length = 3;
+    code = c & 0x0f;
+    min = 0x800;
+  } else if ((c & 0xf8) == 0xf0) {
+    length = 4;
+    code = c & 0x07;
+    min = 0x10000;
+  } else return 0;
+  if (size - offset < length) return 0;
+  for (size_t i = 1; i < length; ++i) {
+    if ((input[offset + i] & 0xc0) != 0x80) return 0;
+    code = code << 6 | (input[offset + i] & 0x3f);
+  }
+  if (code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff)) {
+    return 0;
+  }
+  return length;
+}
+
+/*
+ * Record the string whose opening quote is at input[start] as double-quoted
+ * scalar. Escape sequences are replaced while copying, which never makes the
+ * string longer. Returns the offset after the closing quote, 0 on error.
+ */
+static size_t record_string(yaml_tape_t *const tape,
+                            json_position_t *const pos, size_t const start) {
+  const unsigned char *const input = pos->input;
+  size_t const size = pos->size;
+  yaml_mark_t const start_mark = mark_at(pos, start);
+  char *const begin = tape->arena.data + tape->arena.count;
+  char *out = begin;
+  size_t cur = start + 1;
+  for (;;) {
+    // copy everything up to the next quote, backslash, control character or
+    // non-ASCII byte in one go.
+    size_t run = cur;
+    while (size - run >= 8) {
+      uint64_t const w = load_word(input + run);
+      uint64_t const special = equal_bytes(w, '"') | equal_bytes(w, '\\') |
+          ((w - ONES * 0x20) & ~w) | (w & HIGH_BITS);
+      if ((special & HIGH_BITS) != 0) {
+        run += count_trailing_zeros(special & HIGH_BITS) / 8;
+        break;
+      }
+      run += 8;
+    }
+    while (run < size && input[run] != '"' && input[run] != '\\' &&
+           input[run] >= 0x20 && input[run] < 0x80) ++run;
+    memcpy(out, input + cur, run - cur);
+    out += run - cur;
+    cur = run;
+    if (cur == size) {
+      syntax_error(tape, pos, start, "found unterminated string");
+      return 0;
+    }
+    unsigned char const c = input[cur];
+    if (c == '"') break;
+    if (c < 0x20) {
+      syntax_error(tape, pos, cur, "found control character in string");
+      return 0;
+    } else if (c >= 0x80) {
+      size_t const length = utf8_length(input, size, cur);
+      if (length == 0) {
+        syntax_error(tape, pos, cur, "found invalid UTF-8");
+        return 0;
+      }
+      memcpy(out, input + cur, length);
+      out += length;
+      cur += length;
+      continue;
+    }
+    if (size - cur < 2) {
+      syntax_error(tape, pos, start, "found unterminated string");
+      return 0;
+    }
+    switch (input[cur + 1]) {
+      case '"': *out++ = '"'; break;
+      case '\\': *out++ = '\\'; break;
+      case '/': *out++ = '/'; break;
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u': {
+        uint32_t code = read_hex4(input, size, cur + 2);
+        if (code >= 0xd800 && code <= 0xdbff && size - cur >= 12 &&
+            input[cur + 6] == '\\' && input[cur + 7] == 'u') {
+          uint32_t const low = read_hex4(input, size, cur + 8);
+          if (low >= 0xdc00 && low <= 0xdfff) {
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+            cur += 6;
+          }
+        }
+        if (code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff)) {
+          syntax_error(tape, pos, cur,
+                       "found invalid Unicode character escape code");
+          return 0;
+        }
+        out += encode_utf8(code, out);
+        cur += 4;
+        break;
+      }
+      default:
+        syntax_error(tape, pos, cur, "found unknown escape character");
+        return 0;
+    }
+    cur += 2;
+  }
+  *out = '\0';
+  // the entry is only added now so that no partial scalar is recorded.
+  yaml_tape_entry_t *const entry = add_entry(tape, YAML_SCALAR_EVENT);
+  entry->style = YAML_DOUBLE_QUOTED_SCALAR_STYLE;
+  entry->quoted_implicit = true;
+  entry->value = tape->arena.count;
+  entry->length = (size_t)(out - begin);
+  tape->arena.count += entry->length + 1;
+  entry->start_mark = start_mark;
+  entry->end_mark = mark_at(pos, cur + 1);
+  return cur + 1;
+}
+
+static size_t skip_digits(const unsigned char *const input, size_t const end,
+                          size_t cur) {
+  while (cur < end && input[cur] >= '0' && input[cur] <= '9') ++cur;
+  return cur;
+}
+
+/*
+ * Return whether input[start, end) is a JSON number.
+ */
+static bool is_number(const unsigned char *const input, size_t const start,
+                      size_t const end) {
+  size_t cur = start;
+  if (cur < end && input[cur] == '-') ++cur;
+  if (cur == end) return false;
+  if (input[cur] == '0') ++cur;
+  else {
+    size_t const digits = skip_digits(input, end, cur);
+    if (digits == cur) return false;
+    cur = digits;
+  }
+  if (cur < end && input[cur] == '.') {
+    size_t const digits = skip_digits(input, end, cur + 1);
+    if (digits == cur + 1) return false;
+    cur = digits;
+  }
+  if (cur < end && (input[cur] == 'e' || input[cur] == 'E')) {
+    ++cur;
+    if (cur < end && (input[cur] == '+' || input[cur] == '-')) ++cur;
+    size_t const digits = skip_digits(input, end, cur);
+    if (digits == cur) return false;
+    cur = digits;
+  }
+  return cur == end;
+}
+
+/*
+ * Record the number or literal starting at input[start] as plain scalar.
+ * Returns false on error.
+ */
+static bool record_plain(yaml_tape_t *const tape, json_position_t *const pos,
+                         size_t const start) {
+  const unsigned char *const input = pos->input;
+  size_t end = start;
+  while (end < pos->size) {
+    unsigned char const c = input[end];
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' ||
+        c == ':' || c == ']' || c == '}' || c == '[' || c == '{' ||
+        c == '"') break;
+    ++end;
+  }
+  size_t const length = end - start;
+  if (!is_number(input, start, end) &&
+      !(length == 4 && memcmp(input + start, "true", 4) == 0) &&
+      !(length == 5 && memcmp(input + start, "false", 5) == 0) &&
+      !(length == 4 && memcmp(input + start, "null", 4) == 0)) {
+    return syntax_error(tape, pos, start, "found invalid JSON value");
+  }
+  yaml_tape_entry_t *const entry = add_entry(tape, YAML_SCALAR_EVENT);
+  entry->style = YAML_PLAIN_SCALAR_STYLE;
+  entry->implicit = true;
+  entry->value = tape->arena.count;
+  entry->length = length;
+  memcpy(tape->arena.data + tape->arena.count, input + start, length);
+  tape->arena.data[tape->arena.count + length] = '\0';
+  tape->arena.count += length + 1;
+  entry->start_mark = mark_at(pos, start);
+  entry->end_mark = mark_at(pos, end);
+  return true;
+}
+
+static void set_marks(yaml_tape_entry_t *const entry,
+                      json_position_t *const pos, size_t const offset,
+                      size_t const length) {
+  entry->start_mark = mark_at(pos, offset);
+  entry->end_mark = mark_at(pos, offset + length);
+}
+
+/*
+ * States of the second stage, named after what is expected next.
+ */
+typedef enum {
+  EXPECT_VALUE, EXPECT_KEY, EXPECT_COLON, EXPECT_SEPARATOR
+} json_state_t;
+
+/*
+ * Stage 2: check the grammar and record the events, visiting only the
+ * structural characters found by stage 1.
+ */
+static bool record_events(yaml_tape_t *const tape, json_position_t *const pos,
+                          size_t const start) {
+  const unsigned char *const input = pos->input;
+  uint32_t const *const structurals = tape->structurals.data;
+  size_t const count = tape->structurals.count;
+  yaml_tape_entry_t *entry = add_entry(tape, YAML_STREAM_START_EVENT);
+  entry->style = YAML_UTF8_ENCODING;
+  set_marks(entry, pos, start, 0);
+  if (count == 0) {
+    return syntax_error(tape, pos, pos->size, "did not find a JSON value");
+  }
+  entry = add_entry(tape, YAML_DOCUMENT_START_EVENT);
+  entry->implicit = true;
+  set_marks(entry, pos, structurals[0], 0);
+
+  json_state_t state = EXPECT_VALUE;
+  size_t i = 0;
+  do {
+    size_t const offset = i < count ? structurals[i] : pos->size;
+    unsigned char const c = i < count ? input[offset] : '\0';
+    ++i;
+    switch (state) {
+      case EXPECT_VALUE:
+        if (c == '{' || c == '[') {
+          if (!YAML_TAPE_RESERVE(&tape->open, 1)) {
+            tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+            return false;
+          }
+          tape->open.data[tape->open.count] = tape->entries.count;
+          entry = add_entry(tape, c == '{' ? YAML_MAPPING_START_EVENT :
+                            YAML_SEQUENCE_START_EVENT);
+          tape->open.count++;
+          entry->implicit = true;
+          entry->style = c == '{' ? (int)YAML_FLOW_MAPPING_STYLE :
+                         (int)YAML_FLOW_SEQUENCE_STYLE;
+          set_marks(entry, pos, offset, 1);
+          // empty collections are closed by the separator state.
+          bool const empty = i < count &&
+              input[structurals[i]] == (c == '{' ? '}' : ']');
+          state = empty ? EXPECT_SEPARATOR :
+                  c == '{' ? EXPECT_KEY : EXPECT_VALUE;
+        } else if (c == '"') {
+          if (record_string(tape, pos, offset) == 0) return false;
+          state = EXPECT_SEPARATOR;
+        } else if (i > count || c == ',' || c == ':' || c == ']' ||
+                   c == '}') {
+          return syntax_error(tape, pos, offset, "did not find expected node");
+        } else {
+          if (!record_plain(tape, pos, offset)) return false;
+          state = EXPECT_SEPARATOR;
+        }
+        break;
+      case EXPECT_KEY:
+        if (i > count || c != '"') {
+          return syntax_error(tape, pos, offset, "did not find expected key");
+        }
+        if (record_string(tape, pos, offset) == 0) return false;
+        state = EXPECT_COLON;
+        break;
+      case EXPECT_COLON:
+        if (i > count || c != ':') {
+          return syntax_error(tape, pos, offset, "did not find expected ':'");
+        }
+        state = EXPECT_VALUE;
+        break;
+      case EXPECT_SEPARATOR: {
+        if (tape->open.count == 0) {
+          return syntax_error(tape, pos, offset,
+                              "did not find expected end of input");
+        }
+        size_t const open = tape->open.data[tape->open.count - 1];
+        bool const mapping =
+            tape->entries.data[open].type == YAML_MAPPING_START_EVENT;
+        if (c == ',' && i <= count) {
+          state = mapping ? EXPECT_KEY : EXPECT_VALUE;
+        } else if (i <= count && c == (mapping ? '}' : ']')) {
+          tape->entries.data[open].end = tape->entries.count;
+          tape->open.count--;
+          entry = add_entry(tape, mapping ? YAML_MAPPING_END_EVENT :
+                            YAML_SEQUENCE_END_EVENT);
+          set_marks(entry, pos, offset, 1);
+        } else {
+          return syntax_error(tape, pos, offset, mapping ?
+              "did not find expected ',' or '}'" :
+              "did not find expected ',' or ']'");
+        }
+        break;
+      }
+    }
+  } while (state != EXPECT_SEPARATOR || tape->open.count > 0 || i < count);
+
+  // like libyaml, end the stream on a new line.
+  yaml_mark_t end = mark_at(pos, pos->size);
+  if (end.column != 0) {
+    end.line++;
+    end.column = 0;
+  }
+  entry = add_entry(tape, YAML_DOCUMENT_END_EVENT);
+  entry->implicit = true;
+  entry->start_mark = entry->end_mark = end;
+  entry = add_entry(tape, YAML_STREAM_END_EVENT);
+  entry->start_mark = entry->end_mark = end;
+  return true;
+}
+
+bool yaml_tape_record_json(yaml_tape_t *tape, const unsigned char *input,
+                           size_t size) {
+  tape->entries.count = 0;
+  tape->arena.count = 0;
+  tape->open.count = 0;
+  tape->structurals.count = 0;
+  tape->error = YAML_LOADER_ERROR_NONE;
+  tape->aliases = 0;
+  tape->problem = NULL;
+  size_t const start = size >= 3 && input[0] == 0xef && input[1] == 0xbb &&
+      input[2] == 0xbf ? 3 : 0;
+  json_position_t pos;
+  position_init(&pos, input, size, start);
+  if (size >= UINT32_MAX) {
+    return syntax_error(tape, &pos, start, "input is too large");
+  }
+  if (!find_structurals(tape, input, start, size)) {
+    tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  // every structural character yields at most one event and every scalar
+  // at most its length plus a terminator.
+  size_t const count = tape->structurals.count;
+  if (!YAML_TAPE_CAPACITY(&tape->entries, count + 4) ||
+      !YAML_TAPE_CAPACITY(&tape->arena, size + count + 1)) {
+    tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  return record_events(tape, &pos, start);
+}
@@ -1,4 +1,178 @@
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+// required for the ucontext functions.
+#define _XOPEN_SOURCE 600
+#endif
+
 #include <yaml_loader.h>
+#include <yaml_constructor.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include <yaml_prefetch.h>
+#include <time.h>
+
+#include "yaml_coroutine.h"
+#include "yaml_threads.h"
+
+/*
+ * Minimal number of list items constructed by one thread.
+ */
+#define ITEMS_PER_THREAD_MIN 32
+
+/*
+ * Number of events in the ring buffer of a pipelined loader. Must be a power
+ * of two.
+ */
+#define PIPELINE_CAPACITY 256
+
+/*
+ * Number of times a pipeline thread polls the ring buffer before yielding.
+ */
+#define PIPELINE_SPIN 64
+
+/*
+ * Maximum number of idle loaders kept by the pool of each thread.
+ */
+#define LOADER_POOL_MAX 8
+
+/*
+ * Number of files each batch thread reads ahead.
+ */
+#define BATCH_PREFETCH_DEPTH 8
+
+/*
+ * Size of the stack a resumable loader constructs on.
+ */
+#define RESUMABLE_STACK_SIZE (1024 * 1024)
+
+/*
+ * Number of events between two checks of the deadline of a step.
+ */
+#define STEP_CLOCK_INTERVAL 32
+
+/*
+ * Number of events between two checks of a loader's deadline and
+ * cancellation flag.
+ */
+#define CANCEL_CHECK_INTERVAL 64
+
+/*
+ * State of a loader whose loading can be suspended: one fed with
+ * yaml_loader_feed, or one advanced with yaml_loader_step. The document is
+ * loaded by a coroutine that yields when the pushed input has been consumed,
+ * or when the step's budget is exhausted.
+ */
+struct yaml_loader_resumable_s {
+  yaml_coroutine_t coroutine;
+  yaml_loader_document_loader_t load;
+  void *value;
+  /*
+   * YAML_LOADER_NEED_MORE or YAML_LOADER_SUSPENDED while loading has not
+   * finished.
+   */
+  yaml_loader_status_t status;
+  /*
+   * started is set once loading has been resumed for the first time,
+   * cancelled if the loader is deleted before loading has finished.
+   */
+  bool started, cancelled;
+  /*
+   * parser reading the pushed input, which is only used by loaders fed with
+   * yaml_loader_feed.
+   */
+  yaml_parser_t parser;
+  /*
+   * unread part of the piece of input currently being fed, and whether the
+   * end of the input has been fed.
+   */
+  const unsigned char *input;
+  size_t length;
+  bool end;
+  /*
+   * for loaders advanced with yaml_loader_step: number of events the current
+   * step may still read, its deadline (0 for none), and the number of events
+   * until the deadline is checked again.
+   */
+  size_t budget;
+  uint64_t deadline;
+  unsigned countdown;
+  /*
+   * bounds of the reserve of the stack the coroutine has last yielded on,
+   * see stack_reserve_start.
+   */
+  uintptr_t reserve_start, reserve_end;
+};
+
+typedef enum {
+  PIPELINE_RUNNING, PIPELINE_FINISHED, PIPELINE_FAILED
+} pipeline_state_t;
+
+/*
+ * Single-producer single-consumer ring buffer between the parser thread and
+ * the loader. Events are parsed directly into their slot and moved out of it
+ * by the loader, which takes over ownership of their strings. head is only
+ * written by the loader, tail and state only by the parser thread, stop only
+ * by the loader. The indexes grow monotonically and are kept on separate
+ * cache lines.
+ */
+struct yaml_loader_pipeline_s {
+  size_t volatile head;
+  char head_padding[64 - sizeof(size_t)];
+  size_t volatile tail;
+  char tail_padding[64 - sizeof(size_t)];
+  size_t volatile state, stop;
+  yaml_parser_t *parser;
+  yaml_thread_t thread;
+  yaml_event_t events[PIPELINE_CAPACITY];
+};
+
+static void init_internal(yaml_loader_t *loader, bool external_parser,
+                          const unsigned char *input, size_t size) {
+  loader->error_info.type = YAML_LOADER_ERROR_NONE;
+  loader->internal.external_parser = external_parser;
+  loader->internal.mapped_index = 0;
+  loader->internal.mapped_offset = 0;
+  if (input != NULL && size >= 2 && ((input[0] == 0xfe && input[1] == 0xff) ||
+                                     (input[0] == 0xff && input[1] == 0xfe))) {
+    // UTF-16 input is transcoded by libyaml and cannot be viewed.
+    input = NULL;
+  } else if (input != NULL && size >= 3 && input[0] == 0xef &&
+             input[1] == 0xbb && input[2] == 0xbf) {
+    loader->internal.mapped_offset = 3;
+  }
+  loader->internal.input = input;
+  loader->internal.input_size = size;
+  loader->internal.base_index = 0;
+  loader->internal.base_offset = loader->internal.mapped_offset;
+  loader->internal.lazy = NULL;
+  loader->internal.lazy_pos = 0;
+  loader->internal.tape = NULL;
+  loader->internal.tape_pos = loader->internal.tape_current = 0;
+  loader->internal.scanned = NULL;
+  loader->internal.binary = NULL;
+  loader->internal.binary_size = 0;
+  loader->internal.pipeline = NULL;
+  loader->internal.resumable = NULL;
+  loader->internal.threads = 1;
+  loader->internal.deadline = 0;
+  loader->internal.cancel = NULL;
+  loader->internal.check_countdown = CANCEL_CHECK_INTERVAL;
+  memset(&loader->internal.limits, 0, sizeof(yaml_loader_limits_t));
+  loader->internal.limited = false;
+  loader->internal.bytes = loader->internal.nodes = loader->internal.depth = 0;
+  loader->internal.view_copies.data = NULL;
+  loader->internal.view_copies.count = 0;
+  loader->internal.view_copies.capacity = 0;
+  loader->internal.anchors.data = NULL;
+  loader->internal.anchors.count = loader->internal.anchors.capacity = 0;
+  loader->internal.anchors.slots = NULL;
+  loader->internal.anchors.slot_count = 0;
+  loader->internal.dedup.slots = NULL;
+  loader->internal.dedup.count = loader->internal.dedup.slot_count = 0;
+  loader->internal.recycled.buckets = NULL;
+  loader->internal.recycled.count = 0;
+  loader->internal.recycled.active = false;
+}
 
 bool yaml_loader_init_file(yaml_loader_t *loader, FILE *input) {
   loader->parser = malloc(sizeof(yaml_parser_t));
@@ -8,8 +182,53 @@ bool yaml_loader_init_file(yaml_loader_t *loader, FILE *input) {
     return false;
   }
   yaml_parser_set_input_file(loader->parser, input);
-  loader->error_info.type = YAML_LOADER_ERROR_NONE;
-  loader->internal.external_parser = false;
+  init_internal(loader, false, NULL, 0);
+  return true;
+}
+
+/*
+ * Whether the input starts with '{' or '[', possibly after a byte order mark
+ * and whitespace.
+ */
+static bool looks_like_json(const unsigned char *input, size_t size) {
+  size_t pos = size >= 3 && input[0] == 0xef && input[1] == 0xbb &&
+      input[2] == 0xbf ? 3 : 0;
+  while (pos < size && (input[pos] == ' ' || input[pos] == '\t' ||
+                        input[pos] == '\n' || input[pos] == '\r')) ++pos;
+  return pos < size && (input[pos] == '{' || input[pos] == '[');
+}
+
+/*
+ * Return the loader's own tape for scanned input, allocating it on first use.
+ * Returns NULL iff memory ran out.
+ */
+static yaml_tape_t *scanned_tape(yaml_loader_t *loader) {
+  if (loader->internal.scanned == NULL) {
+    yaml_tape_t *const tape = malloc(sizeof(yaml_tape_t));
+    if (tape == NULL) return NULL;
+    yaml_tape_init(tape);
+    loader->internal.scanned = tape;
+  }
+  return loader->internal.scanned;
+}
+
+/*
+ * Record the given input with the JSON scanner into the loader's own tape,
+ * and read events from that tape. If strict is false, the loader keeps reading
+ * from its parser if the input is not JSON or memory runs out; otherwise,
+ * syntax errors are reported when loading reaches them.
+ * Returns false iff memory ran out.
+ */
+static bool use_json(yaml_loader_t *loader, const unsigned char *input,
+                     size_t size, bool strict) {
+  yaml_tape_t *const tape = scanned_tape(loader);
+  if (tape == NULL) return false;
+  if (!yaml_tape_record_json(tape, input, size) &&
+      (!strict || tape->error == YAML_LOADER_ERROR_OUT_OF_MEMORY)) {
+    return tape->error != YAML_LOADER_ERROR_OUT_OF_MEMORY;
+  }
+  loader->internal.tape = tape;
+  loader->internal.tape_pos = loader->internal.tape_current = 0;
   return true;
 }
 
@@ -22,40 +241,1691 @@ bool yaml_loader_init_string(yaml_loader_t *loader, const unsigned char *input,
     return false;
   }
   yaml_parser_set_input_string(loader->parser, input, size);
-  loader->error_info.type = YAML_LOADER_ERROR_NONE;
-  loader->internal.external_parser = false;
+  init_internal(loader, false, input, size);
+  // running out of memory is no reason to fail, the parser can take over.
+  if (looks_like_json(input, size)) use_json(loader, input, size, false);
+  return true;
+}
+
+bool yaml_loader_init_json(yaml_loader_t *loader, const unsigned char *input,
+                           size_t size) {
+  if (!yaml_loader_init_string(loader, input, size)) return false;
+  if (loader->internal.tape == NULL && !use_json(loader, input, size, true)) {
+    yaml_loader_delete(loader);
+    return false;
+  }
+  return true;
+}
+
+bool yaml_loader_init_cbor(yaml_loader_t *loader, const unsigned char *input,
+                           size_t size) {
+  static const unsigned char empty[] = "";
+  // the parser never reads; it only reports syntax errors.
+  if (!yaml_loader_init_string(loader, empty, 0)) return false;
+  // views and lazy fields cannot refer to binary input.
+  loader->internal.input = NULL;
+  loader->internal.binary = input;
+  loader->internal.binary_size = size;
+  yaml_tape_t *const tape = scanned_tape(loader);
+  if (tape == NULL || (!yaml_tape_record_cbor(tape, input, size) &&
+                       tape->error == YAML_LOADER_ERROR_OUT_OF_MEMORY)) {
+    yaml_loader_delete(loader);
+    return false;
+  }
+  loader->internal.tape = tape;
   return true;
 }
 
 bool yaml_loader_init_parser(yaml_loader_t *loader, yaml_parser_t *parser) {
   loader->parser = parser;
-  loader->error_info.type = YAML_LOADER_ERROR_NONE;
-  loader->internal.external_parser = true;
+  init_internal(loader, true, NULL, 0);
   return true;
 }
 
-/**
- * Destroys a loader that has successfully been initialized.
+/*
+ * Deallocate the resources held by the loader's error_info.
  */
-void yaml_loader_delete(yaml_loader_t *loader) {
-  if (!loader->internal.external_parser) {
-    yaml_parser_delete(loader->parser);
+static void release_error(yaml_loader_t *loader);
+
+/*
+ * Forget the anchored and deduplicated values of the current document,
+ * releasing the references held to them.
+ */
+static void clear_shared(yaml_loader_t *loader);
+
+/*
+ * Stop the parser thread and discard the events it has not handed over yet.
+ */
+static void pipeline_delete(struct yaml_loader_pipeline_s *pipeline);
+
+/*
+ * Return the given parser to the state yaml_parser_initialize leaves it in,
+ * but keep the buffer, token queue and stacks it has allocated. libyaml has
+ * no function for this: the tokens and tag directives still held are freed
+ * like yaml_parser_delete does, then the parser is cleared like
+ * yaml_parser_initialize does, and the storage is put back empty. Returns
+ * false if the parser has no storage yet and cannot be initialized.
+ */
+static bool reset_parser(yaml_parser_t *parser) {
+  if (parser->raw_buffer.start == NULL) {
+    yaml_parser_delete(parser);
+    return yaml_parser_initialize(parser) != 0;
+  }
+  while (parser->tokens.head != parser->tokens.tail) {
+    yaml_token_delete(parser->tokens.head++);
+  }
+  while (parser->tag_directives.top != parser->tag_directives.start) {
+    yaml_tag_directive_t *const directive = --parser->tag_directives.top;
+    free(directive->handle);
+    free(directive->prefix);
+  }
+  yaml_parser_t const kept = *parser;
+  memset(parser, 0, sizeof(yaml_parser_t));
+  parser->raw_buffer.start = parser->raw_buffer.pointer =
+      parser->raw_buffer.last = kept.raw_buffer.start;
+  parser->raw_buffer.end = kept.raw_buffer.end;
+  parser->buffer.start = parser->buffer.pointer = parser->buffer.last =
+      kept.buffer.start;
+  parser->buffer.end = kept.buffer.end;
+  parser->tokens.start = parser->tokens.head = parser->tokens.tail =
+      kept.tokens.start;
+  parser->tokens.end = kept.tokens.end;
+  parser->indents.start = parser->indents.top = kept.indents.start;
+  parser->indents.end = kept.indents.end;
+  parser->simple_keys.start = parser->simple_keys.top =
+      kept.simple_keys.start;
+  parser->simple_keys.end = kept.simple_keys.end;
+  parser->states.start = parser->states.top = kept.states.start;
+  parser->states.end = kept.states.end;
+  parser->marks.start = parser->marks.top = kept.marks.start;
+  parser->marks.end = kept.marks.end;
+  parser->tag_directives.start = parser->tag_directives.top =
+      kept.tag_directives.start;
+  parser->tag_directives.end = kept.tag_directives.end;
+  return true;
+}
+
+void yaml_loader_release_view_copies(yaml_loader_t *loader) {
+  for (size_t i = 0; i < loader->internal.view_copies.count; ++i) {
+    free(loader->internal.view_copies.data[i]);
+  }
+  loader->internal.view_copies.count = 0;
+}
+
+/*
+ * Discard everything the loader holds for its current input, and reset its
+ * parser. Returns false if the parser is not owned by the loader or cannot
+ * be reset.
+ */
+static bool reset_loader(yaml_loader_t *loader) {
+  if (loader->internal.external_parser) return false;
+  if (loader->internal.pipeline != NULL) {
+    pipeline_delete(loader->internal.pipeline);
+    loader->internal.pipeline = NULL;
+  }
+  release_error(loader);
+  yaml_loader_release_view_copies(loader);
+  clear_shared(loader);
+  if (!reset_parser(loader->parser)) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Like init_internal, but keep the loader's configuration and buffers.
+ */
+static void reinit_internal(yaml_loader_t *loader, const unsigned char *input,
+                            size_t size) {
+  unsigned const threads = loader->internal.threads;
+  yaml_loader_limits_t const limits = loader->internal.limits;
+  bool const limited = loader->internal.limited;
+  char **const copies = loader->internal.view_copies.data;
+  size_t const capacity = loader->internal.view_copies.capacity;
+  yaml_tape_t *const scanned = loader->internal.scanned;
+  yaml_loader_anchor_t *const anchors = loader->internal.anchors.data;
+  size_t const anchors_capacity = loader->internal.anchors.capacity;
+  size_t *const slots = loader->internal.anchors.slots;
+  size_t const slot_count = loader->internal.anchors.slot_count;
+  yaml_loader_dedup_t *const dedup = loader->internal.dedup.slots;
+  size_t const dedup_count = loader->internal.dedup.slot_count;
+  yaml_loader_bucket_t *const buckets = loader->internal.recycled.buckets;
+  init_internal(loader, false, input, size);
+  loader->internal.scanned = scanned;
+  loader->internal.threads = threads;
+  loader->internal.limits = limits;
+  loader->internal.limited = limited;
+  loader->internal.view_copies.data = copies;
+  loader->internal.view_copies.capacity = capacity;
+  loader->internal.anchors.data = anchors;
+  loader->internal.anchors.capacity = anchors_capacity;
+  loader->internal.anchors.slots = slots;
+  loader->internal.anchors.slot_count = slot_count;
+  loader->internal.dedup.slots = dedup;
+  loader->internal.dedup.slot_count = dedup_count;
+  loader->internal.recycled.buckets = buckets;
+}
+
+bool yaml_loader_reset_string(yaml_loader_t *loader,
+                              const unsigned char *input, size_t size) {
+  if (!reset_loader(loader)) return false;
+  yaml_parser_set_input_string(loader->parser, input, size);
+  reinit_internal(loader, input, size);
+  if (looks_like_json(input, size)) use_json(loader, input, size, false);
+  return true;
+}
+
+bool yaml_loader_reset_file(yaml_loader_t *loader, FILE *input) {
+  if (!reset_loader(loader)) return false;
+  yaml_parser_set_input_file(loader->parser, input);
+  reinit_internal(loader, NULL, 0);
+  return true;
+}
+
+/*
+ * Loader handed out by a thread's pool.
+ */
+typedef struct pooled_loader_s {
+  yaml_loader_t loader;
+  struct pooled_loader_s *next;
+} pooled_loader_t;
+
+/*
+ * idle loaders of the current thread.
+ */
+static YAML_THREAD_LOCAL pooled_loader_t *loader_pool = NULL;
+static YAML_THREAD_LOCAL size_t loader_pool_size = 0;
+
+yaml_loader_t *yaml_loader_acquire_string(const unsigned char *input,
+                                          size_t size) {
+  pooled_loader_t *pooled = loader_pool;
+  if (pooled != NULL) {
+    loader_pool = pooled->next;
+    loader_pool_size--;
+    if (yaml_loader_reset_string(&pooled->loader, input, size)) {
+      pooled->loader.internal.threads = 1;
+      memset(&pooled->loader.internal.limits, 0,
+             sizeof(yaml_loader_limits_t));
+      pooled->loader.internal.limited = false;
+    } else {
+      yaml_loader_delete(&pooled->loader);
+      free(pooled);
+      pooled = NULL;
+    }
+  }
+  if (pooled == NULL) {
+    pooled = malloc(sizeof(pooled_loader_t));
+    if (pooled == NULL) return NULL;
+    if (!yaml_loader_init_string(&pooled->loader, input, size)) {
+      free(pooled);
+      return NULL;
+    }
+  }
+  pooled->loader.data = NULL;
+  return &pooled->loader;
+}
+
+void yaml_loader_release(yaml_loader_t *loader) {
+  pooled_loader_t *const pooled = (pooled_loader_t*)loader;
+  if (loader_pool_size == LOADER_POOL_MAX) {
+    yaml_loader_delete(loader);
+    free(pooled);
+    return;
+  }
+  // the input may be gone before the loader is acquired again.
+  reset_loader(loader);
+  pooled->next = loader_pool;
+  loader_pool = pooled;
+  loader_pool_size++;
+}
+
+/*
+ * Stack kept by yaml_loader_call_on_stack for the next call on this thread,
+ * NULL if none has been allocated yet, and whether it is in use.
+ */
+static YAML_THREAD_LOCAL yaml_coroutine_t *call_stack = NULL;
+static YAML_THREAD_LOCAL size_t call_stack_size = 0;
+static YAML_THREAD_LOCAL bool call_stack_busy = false;
+
+/*
+ * Part of the stack at its low end that yaml_loader_call_on_stack and
+ * resumable loaders keep in reserve: 64 KiB, or half of the stack if it is
+ * smaller.
+ */
+#define STACK_RESERVE(size) ((size) / 2 < 65536 ? (size) / 2 : 65536)
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define STACK_POSITION() ((uintptr_t)_AddressOfReturnAddress())
+#else
+#define STACK_POSITION() ((uintptr_t)__builtin_frame_address(0))
+#endif
+
+/*
+ * Bounds of the reserve of the stack a function called by
+ * yaml_loader_call_on_stack or a resumable loader runs on, both 0 on other
+ * stacks. Collections starting while the stack reaches into the reserve fail
+ * to load. The stack is assumed to grow downwards.
+ */
+static YAML_THREAD_LOCAL uintptr_t stack_reserve_start = 0;
+static YAML_THREAD_LOCAL uintptr_t stack_reserve_end = 0;
+
+typedef struct {
+  size_t stack_size;
+  void (*func)(void*);
+  void *arg;
+} stack_call_t;
+
+static void run_stack_call(void *arg) {
+  stack_call_t *const call = (stack_call_t*)arg;
+  uintptr_t const start = stack_reserve_start, end = stack_reserve_end;
+  // the stack's top is a bit above, so this underestimates the reserve.
+  stack_reserve_start = STACK_POSITION() - call->stack_size;
+  stack_reserve_end =
+      stack_reserve_start + STACK_RESERVE(call->stack_size);
+  call->func(call->arg);
+  stack_reserve_start = start;
+  stack_reserve_end = end;
+}
+
+/*
+ * Fail with YAML_LOADER_ERROR_LIMIT if the given event, a collection's start,
+ * has been read on a stack of yaml_loader_call_on_stack or of a resumable
+ * loader that reaches into its reserve.
+ */
+static bool check_stack(yaml_loader_t *loader, yaml_event_t *event) {
+  uintptr_t const position = STACK_POSITION();
+  if (position < stack_reserve_start || position >= stack_reserve_end) {
+    return true;
+  }
+  return yaml_loader_limit_error(loader, event, "stack_size");
+}
+
+void yaml_loader_pool_clear(void) {
+  while (loader_pool != NULL) {
+    pooled_loader_t *const pooled = loader_pool;
+    loader_pool = pooled->next;
+    yaml_loader_delete(&pooled->loader);
+    free(pooled);
+  }
+  loader_pool_size = 0;
+  if (call_stack != NULL && !call_stack_busy) {
+    yaml_coroutine_delete(call_stack);
+    free(call_stack);
+    call_stack = NULL;
+  }
+}
+
+bool yaml_loader_call_on_stack(size_t stack_size, void (*func)(void*),
+                               void *arg) {
+  stack_call_t call = {stack_size, func, arg};
+  if (call_stack_busy) {
+    // a nested call, e.g. from a loader suspended on the stack, gets its own.
+    yaml_coroutine_t nested;
+    if (!yaml_coroutine_init(&nested, stack_size, &run_stack_call, &call)) {
+      return false;
+    }
+    yaml_coroutine_resume(&nested);
+    yaml_coroutine_delete(&nested);
+    return true;
+  }
+  if (call_stack != NULL && call_stack_size < stack_size) {
+    yaml_coroutine_delete(call_stack);
+    free(call_stack);
+    call_stack = NULL;
+  }
+  if (call_stack == NULL) {
+    call_stack = malloc(sizeof(yaml_coroutine_t));
+    if (call_stack == NULL) return false;
+    if (!yaml_coroutine_init(call_stack, stack_size, &run_stack_call,
+                             &call)) {
+      free(call_stack);
+      call_stack = NULL;
+      return false;
+    }
+    call_stack_size = stack_size;
+  } else if (!yaml_coroutine_restart(call_stack, &run_stack_call, &call)) {
+    return false;
+  }
+  yaml_coroutine_t *const coroutine = call_stack;
+  call_stack_busy = true;
+  yaml_coroutine_resume(coroutine);
+  call_stack_busy = false;
+  return true;
+}
+
+/*
+ * Input handler of loaders fed with yaml_loader_feed. Yields to the feeding
+ * thread whenever the current piece of input has been consumed.
+ */
+static int read_push(void *data, unsigned char *buffer, size_t size,
+                     size_t *size_read) {
+  struct yaml_loader_resumable_s *const resumable =
+      (struct yaml_loader_resumable_s*)data;
+  while (resumable->length == 0 && !resumable->end && !resumable->cancelled) {
+    yaml_coroutine_yield(&resumable->coroutine);
+  }
+  if (resumable->cancelled) return 0;
+  size_t const n = size < resumable->length ? size : resumable->length;
+  // at the end, input may be NULL.
+  if (n != 0) memcpy(buffer, resumable->input, n);
+  resumable->input += n;
+  resumable->length -= n;
+  *size_read = n;
+  return 1;
+}
+
+static void resumable_main(void *arg) {
+  yaml_loader_t *const loader = (yaml_loader_t*)arg;
+  struct yaml_loader_resumable_s *const resumable = loader->internal.resumable;
+  // like in run_stack_call, the stack's top is a bit above.
+  stack_reserve_start = STACK_POSITION() - RESUMABLE_STACK_SIZE;
+  stack_reserve_end =
+      stack_reserve_start + STACK_RESERVE(RESUMABLE_STACK_SIZE);
+  resumable->status = resumable->load(resumable->value, loader) ?
+      YAML_LOADER_DOCUMENT : YAML_LOADER_FAILED;
+}
+
+static struct yaml_loader_resumable_s *resumable_create(
+    yaml_loader_t *loader, yaml_loader_document_loader_t load, void *value,
+    yaml_loader_status_t status) {
+  struct yaml_loader_resumable_s *const resumable =
+      malloc(sizeof(struct yaml_loader_resumable_s));
+  if (resumable == NULL) return NULL;
+  if (!yaml_coroutine_init(&resumable->coroutine, RESUMABLE_STACK_SIZE,
+                           &resumable_main, loader)) {
+    free(resumable);
+    return NULL;
+  }
+  resumable->load = load;
+  resumable->value = value;
+  resumable->status = status;
+  resumable->started = resumable->cancelled = false;
+  resumable->input = NULL;
+  resumable->length = 0;
+  resumable->end = false;
+  resumable->budget = 0;
+  resumable->deadline = 0;
+  resumable->countdown = STEP_CLOCK_INTERVAL;
+  resumable->reserve_start = resumable->reserve_end = 0;
+  return resumable;
+}
+
+/*
+ * Continue loading until the coroutine yields or finishes.
+ */
+static void resumable_resume(struct yaml_loader_resumable_s *resumable) {
+  resumable->started = true;
+  // the coroutine switches to the C locale, which must not leak into the
+  // caller while loading is suspended.
+  yaml_constructor_locale_t locale;
+  yaml_constructor_enter_c_locale(&locale);
+  // the coroutine continues with the reserve of the stack it yielded on,
+  // which may be one of yaml_loader_call_on_stack.
+  uintptr_t const start = stack_reserve_start, end = stack_reserve_end;
+  stack_reserve_start = resumable->reserve_start;
+  stack_reserve_end = resumable->reserve_end;
+  yaml_coroutine_resume(&resumable->coroutine);
+  resumable->reserve_start = stack_reserve_start;
+  resumable->reserve_end = stack_reserve_end;
+  stack_reserve_start = start;
+  stack_reserve_end = end;
+  yaml_constructor_leave_c_locale(&locale);
+}
+
+/*
+ * Abort loading if it has not finished, then deallocate the resumable state.
+ */
+static void resumable_delete(yaml_loader_t *loader) {
+  struct yaml_loader_resumable_s *const resumable = loader->internal.resumable;
+  if (resumable->started && !resumable->coroutine.finished) {
+    // reading fails, and the constructors clean up on their way out.
+    resumable->cancelled = true;
+    resumable_resume(resumable);
+  }
+  yaml_coroutine_delete(&resumable->coroutine);
+  // the error has been set by the aborted load and may refer to the parser.
+  release_error(loader);
+  if (loader->parser == &resumable->parser) {
+    yaml_parser_delete(&resumable->parser);
+    loader->parser = NULL;
+  }
+  free(resumable);
+  loader->internal.resumable = NULL;
+}
+
+bool yaml_loader_init_push(yaml_loader_t *loader,
+                           yaml_loader_document_loader_t load, void *value) {
+  struct yaml_loader_resumable_s *const resumable =
+      resumable_create(loader, load, value, YAML_LOADER_NEED_MORE);
+  if (resumable == NULL) return false;
+  if (yaml_parser_initialize(&resumable->parser) == 0) {
+    yaml_coroutine_delete(&resumable->coroutine);
+    free(resumable);
+    return false;
+  }
+  yaml_parser_set_input(&resumable->parser, &read_push, resumable);
+  loader->parser = &resumable->parser;
+  init_internal(loader, true, NULL, 0);
+  loader->internal.resumable = resumable;
+  return true;
+}
+
+yaml_loader_status_t yaml_loader_feed(yaml_loader_t *loader,
+                                      const unsigned char *input,
+                                      size_t length) {
+  struct yaml_loader_resumable_s *const resumable = loader->internal.resumable;
+  if (resumable->status != YAML_LOADER_NEED_MORE) return resumable->status;
+  resumable->input = input;
+  resumable->length = length;
+  if (length == 0) resumable->end = true;
+  resumable_resume(resumable);
+  return resumable->status;
+}
+
+bool yaml_loader_start(yaml_loader_t *loader,
+                       yaml_loader_document_loader_t load, void *value) {
+  if (loader->internal.resumable != NULL) return false;
+  loader->internal.resumable =
+      resumable_create(loader, load, value, YAML_LOADER_SUSPENDED);
+  return loader->internal.resumable != NULL;
+}
+
+yaml_loader_status_t yaml_loader_step(yaml_loader_t *loader,
+                                      size_t max_events, uint64_t deadline) {
+  struct yaml_loader_resumable_s *const resumable = loader->internal.resumable;
+  if (resumable->status != YAML_LOADER_SUSPENDED) return resumable->status;
+  resumable->budget = max_events == 0 ? SIZE_MAX : max_events;
+  resumable->deadline = deadline;
+  resumable->countdown = STEP_CLOCK_INTERVAL;
+  resumable_resume(resumable);
+  return resumable->status;
+}
+
+/*
+ * Account for reading an event in a step, yielding to the caller of
+ * yaml_loader_step first if the step is over.
+ */
+static bool step_event(yaml_loader_t *loader,
+                       struct yaml_loader_resumable_s *resumable) {
+  if (resumable->deadline != 0 && --resumable->countdown == 0) {
+    resumable->countdown = STEP_CLOCK_INTERVAL;
+    if (yaml_loader_clock() >= resumable->deadline) resumable->budget = 0;
+  }
+  while (resumable->budget == 0 && !resumable->cancelled) {
+    yaml_coroutine_yield(&resumable->coroutine);
+  }
+  if (resumable->cancelled) {
+    loader->error_info.type = YAML_LOADER_ERROR_CANCELLED;
+    return false;
+  }
+  resumable->budget--;
+  return true;
+}
+
+uint64_t yaml_loader_clock(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart *
+      1000000000u + (uint64_t)counter.QuadPart %
+      (uint64_t)frequency.QuadPart * 1000000000u /
+      (uint64_t)frequency.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/*
+ * Input handler for parsing a lazy subtree. Feeds line breaks and spaces up to
+ * the subtree's position first, so that the parser sees the subtree at the
+ * same line and column as in the original input, then the subtree itself.
+ */
+static int read_lazy(void *data, unsigned char *buffer, size_t size,
+                     size_t *size_read) {
+  yaml_loader_t *const loader = (yaml_loader_t*)data;
+  const yaml_loader_lazy_t *const lazy = loader->internal.lazy;
+  size_t const padding = lazy->line + lazy->column;
+  size_t const total = padding + (lazy->end - lazy->start);
+  size_t pos = loader->internal.lazy_pos;
+  size_t n = 0;
+  while (n < size && pos < lazy->line) {
+    buffer[n++] = '\n';
+    ++pos;
+  }
+  while (n < size && pos < padding) {
+    buffer[n++] = ' ';
+    ++pos;
+  }
+  if (n < size && pos < total) {
+    size_t const chunk = (size - n < total - pos) ? size - n : total - pos;
+    memcpy(buffer + n, lazy->input + lazy->start + (pos - padding), chunk);
+    n += chunk;
+    pos += chunk;
+  }
+  loader->internal.lazy_pos = pos;
+  *size_read = n;
+  return 1;
+}
+
+bool yaml_loader_init_lazy(yaml_loader_t *loader, const void *value,
+                           yaml_event_t *root) {
+  loader->parser = NULL;
+  init_internal(loader, true, NULL, 0);
+  if (((uintptr_t)value & 1) == 0) {
+    root->type = YAML_NO_EVENT;
+    return true;
+  }
+  const yaml_loader_lazy_t *const lazy =
+      (const yaml_loader_lazy_t*)((uintptr_t)value & ~(uintptr_t)1);
+  loader->parser = malloc(sizeof(yaml_parser_t));
+  if (loader->parser == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  if (yaml_parser_initialize(loader->parser) == 0) {
     free(loader->parser);
+    loader->parser = NULL;
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  loader->internal.external_parser = false;
+  yaml_parser_set_input(loader->parser, &read_lazy, loader);
+  // views and nested lazy subtrees refer to the original input.
+  loader->internal.input = lazy->input;
+  loader->internal.input_size = lazy->input_size;
+  loader->internal.base_index = loader->internal.mapped_index =
+      lazy->line + lazy->column;
+  loader->internal.base_offset = loader->internal.mapped_offset = lazy->start;
+  loader->internal.lazy = lazy;
+  while (true) {
+    if (!yaml_loader_next_event(loader, root)) return false;
+    if (root->type != YAML_STREAM_START_EVENT &&
+        root->type != YAML_DOCUMENT_START_EVENT) break;
+    yaml_loader_event_delete(loader, root);
+  }
+  return true;
+}
+
+bool yaml_loader_use_tape(yaml_loader_t *loader, yaml_tape_t *tape) {
+  // JSON and CBOR input is scanned again instead of parsed.
+  bool const scanned = loader->internal.tape != NULL &&
+      loader->internal.tape == loader->internal.scanned;
+  const unsigned char *const binary = loader->internal.binary;
+  loader->internal.tape = tape;
+  loader->internal.tape_pos = loader->internal.tape_current = 0;
+  if (!(!scanned ? yaml_tape_record(tape, loader->parser) :
+        binary != NULL ?
+        yaml_tape_record_cbor(tape, binary, loader->internal.binary_size) :
+        yaml_tape_record_json(tape, loader->internal.input,
+                              loader->internal.input_size)) &&
+      tape->error == YAML_LOADER_ERROR_OUT_OF_MEMORY) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  return true;
+}
+
+static yaml_thread_result_t YAML_THREAD_CALL pipeline_worker(void *arg) {
+  struct yaml_loader_pipeline_s *const pipeline = arg;
+  size_t tail = pipeline->tail;
+  while (yaml_atomic_load(&pipeline->stop) == 0) {
+    if (tail - yaml_atomic_load(&pipeline->head) == PIPELINE_CAPACITY) {
+      for (unsigned i = 0; i < PIPELINE_SPIN &&
+           tail - yaml_atomic_load(&pipeline->head) == PIPELINE_CAPACITY; ++i);
+      yaml_thread_yield();
+      continue;
+    }
+    yaml_event_t *const event =
+        &pipeline->events[tail % PIPELINE_CAPACITY];
+    if (yaml_parser_parse(pipeline->parser, event) == 0) {
+      yaml_atomic_store(&pipeline->state, PIPELINE_FAILED);
+      break;
+    }
+    yaml_atomic_store(&pipeline->tail, ++tail);
+    if (event->type == YAML_STREAM_END_EVENT) {
+      yaml_atomic_store(&pipeline->state, PIPELINE_FINISHED);
+      break;
+    }
+  }
+  return YAML_THREAD_RESULT;
+}
+
+bool yaml_loader_use_pipeline(yaml_loader_t *loader) {
+  // JSON and CBOR input has already been scanned completely.
+  if (loader->internal.tape != NULL &&
+      loader->internal.tape == loader->internal.scanned) return true;
+  struct yaml_loader_pipeline_s *const pipeline =
+      malloc(sizeof(struct yaml_loader_pipeline_s));
+  if (pipeline == NULL) {
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
   }
+  pipeline->head = pipeline->tail = 0;
+  pipeline->state = PIPELINE_RUNNING;
+  pipeline->stop = 0;
+  pipeline->parser = loader->parser;
+  if (!yaml_thread_start(&pipeline->thread, &pipeline_worker, pipeline)) {
+    free(pipeline);
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+  loader->internal.pipeline = pipeline;
+  return true;
+}
+
+/*
+ * Deliver an empty event, as the parser does after the end of the stream.
+ */
+static bool empty_event(yaml_event_t *event) {
+  memset(event, 0, sizeof(yaml_event_t));
+  return true;
+}
+
+/*
+ * Move the next event out of the pipeline's ring buffer, waiting for the
+ * parser thread if necessary.
+ */
+static bool pipeline_next_event(yaml_loader_t *loader, yaml_event_t *event) {
+  struct yaml_loader_pipeline_s *const pipeline = loader->internal.pipeline;
+  size_t const head = pipeline->head;
+  while (yaml_atomic_load(&pipeline->tail) == head) {
+    size_t const state = yaml_atomic_load(&pipeline->state);
+    if (state != PIPELINE_RUNNING) {
+      // the parser thread might have pushed an event before finishing.
+      if (yaml_atomic_load(&pipeline->tail) != head) break;
+      if (state == PIPELINE_FAILED) {
+        loader->error_info.type = YAML_LOADER_ERROR_PARSER;
+        return false;
+      }
+      return empty_event(event);
+    }
+    for (unsigned i = 0; i < PIPELINE_SPIN &&
+         yaml_atomic_load(&pipeline->tail) == head; ++i);
+    yaml_thread_yield();
+  }
+  *event = pipeline->events[head % PIPELINE_CAPACITY];
+  yaml_atomic_store(&pipeline->head, head + 1);
+  return true;
+}
+
+static void pipeline_delete(struct yaml_loader_pipeline_s *pipeline) {
+  yaml_atomic_store(&pipeline->stop, 1);
+  yaml_thread_join(pipeline->thread);
+  for (size_t i = pipeline->head; i != pipeline->tail; ++i) {
+    yaml_event_delete(&pipeline->events[i % PIPELINE_CAPACITY]);
+  }
+  free(pipeline);
+}
+
+void yaml_loader_set_deadline(yaml_loader_t *loader, uint64_t deadline) {
+  loader->internal.deadline = deadline;
+}
+
+void yaml_loader_set_cancel_flag(yaml_loader_t *loader,
+                                 const volatile bool *cancel) {
+  loader->internal.cancel = cancel;
+}
+
+/*
+ * Check the loader's deadline and cancellation flag. Called every
+ * CANCEL_CHECK_INTERVAL events, so that the clock is not read per event.
+ */
+static bool check_cancel(yaml_loader_t *loader) {
+  loader->internal.check_countdown = CANCEL_CHECK_INTERVAL;
+  if ((loader->internal.cancel != NULL &&
+       yaml_atomic_load_bool(loader->internal.cancel)) ||
+      (loader->internal.deadline != 0 &&
+       yaml_loader_clock() >= loader->internal.deadline)) {
+    loader->error_info.type = YAML_LOADER_ERROR_CANCELLED;
+    return false;
+  }
+  return true;
+}
+
+void yaml_loader_set_limits(yaml_loader_t *loader,
+                            yaml_loader_limits_t const *limits) {
+  loader->internal.limits = *limits;
+  loader->internal.limited = limits->max_bytes != 0 ||
+      limits->max_nodes != 0 || limits->max_items != 0 ||
+      limits->max_string_length != 0 || limits->max_depth != 0;
+}
+
+bool yaml_loader_limit_error(yaml_loader_t *loader, yaml_event_t *event,
+                             const char *limit) {
+  return yaml_constructor_error(loader, event, YAML_LOADER_ERROR_LIMIT, limit);
+}
+
+/*
+ * Account for the given event, which has just been read, in the loader's
+ * node count and depth, and check the limits that apply to single events.
+ */
+static bool check_limits(yaml_loader_t *loader, yaml_event_t *event) {
+  yaml_loader_limits_t const *const limits = &loader->internal.limits;
+  switch (event->type) {
+    case YAML_MAPPING_START_EVENT:
+    case YAML_SEQUENCE_START_EVENT:
+      if (++loader->internal.depth > limits->max_depth &&
+          limits->max_depth != 0) {
+        return yaml_loader_limit_error(loader, event, "max_depth");
+      }
+      break;
+    case YAML_MAPPING_END_EVENT:
+    case YAML_SEQUENCE_END_EVENT:
+      loader->internal.depth--;
+      return true;
+    case YAML_SCALAR_EVENT:
+      if (event->data.scalar.length > limits->max_string_length &&
+          limits->max_string_length != 0) {
+        return yaml_loader_limit_error(loader, event, "max_string_length");
+      }
+      break;
+    case YAML_ALIAS_EVENT:
+      break;
+    default:
+      return true;
+  }
+  if (++loader->internal.nodes > limits->max_nodes && limits->max_nodes != 0) {
+    return yaml_loader_limit_error(loader, event, "max_nodes");
+  }
+  return true;
+}
+
+/*
+ * Read the next event from the loader's source.
+ */
+static bool read_event(yaml_loader_t *loader, yaml_event_t *event) {
+  const yaml_tape_t *const tape = loader->internal.tape;
+  if (tape == NULL) {
+    if (loader->internal.pipeline != NULL) {
+      return pipeline_next_event(loader, event);
+    }
+    if (yaml_parser_parse(loader->parser, event) == 0) {
+      loader->error_info.type = YAML_LOADER_ERROR_PARSER;
+      return false;
+    }
+    return true;
+  }
+  if (loader->internal.tape_pos < tape->entries.count) {
+    loader->internal.tape_current = loader->internal.tape_pos++;
+    yaml_tape_event(tape, loader->internal.tape_current, event);
+    return true;
+  } else if (tape->error != YAML_LOADER_ERROR_NONE) {
+    loader->error_info.type = (yaml_loader_error_type_t)tape->error;
+    if (tape->problem != NULL && loader->parser != NULL) {
+      // report syntax errors of scanned input through the parser like
+      // libyaml's.
+      loader->parser->error = YAML_PARSER_ERROR;
+      loader->parser->problem = tape->problem;
+      loader->parser->problem_mark = tape->problem_mark;
+    }
+    return false;
+  } else return empty_event(event);
+}
+
+bool yaml_loader_next_event(yaml_loader_t *loader, yaml_event_t *event) {
+  if (--loader->internal.check_countdown == 0 && !check_cancel(loader)) {
+    return false;
+  }
+  struct yaml_loader_resumable_s *const resumable = loader->internal.resumable;
+  if (resumable != NULL && resumable->status == YAML_LOADER_SUSPENDED &&
+      !step_event(loader, resumable)) return false;
+  if (!read_event(loader, event)) return false;
+  // anchors and deduplication are local to their document.
+  if ((event->type == YAML_DOCUMENT_START_EVENT ||
+       event->type == YAML_DOCUMENT_END_EVENT) &&
+      (loader->internal.anchors.count != 0 ||
+       loader->internal.dedup.count != 0)) clear_shared(loader);
+  if ((event->type == YAML_MAPPING_START_EVENT ||
+       event->type == YAML_SEQUENCE_START_EVENT) &&
+      stack_reserve_end != 0 && !check_stack(loader, event)) return false;
+  return !loader->internal.limited || check_limits(loader, event);
+}
+
+void yaml_loader_event_delete(yaml_loader_t *loader, yaml_event_t *event) {
+  if (loader->internal.tape == NULL) yaml_event_delete(event);
+  else memset(event, 0, sizeof(yaml_event_t));
+}
+
+static void clear_shared(yaml_loader_t *loader) {
+  for (size_t i = 0; i < loader->internal.anchors.count; ++i) {
+    yaml_loader_anchor_t *const anchor = &loader->internal.anchors.data[i];
+    free(anchor->name);
+    anchor->type->release(anchor->value);
+  }
+  loader->internal.anchors.count = 0;
+  for (size_t i = 0; i < loader->internal.anchors.slot_count; ++i) {
+    loader->internal.anchors.slots[i] = SIZE_MAX;
+  }
+  if (loader->internal.dedup.count != 0) {
+    for (size_t i = 0; i < loader->internal.dedup.slot_count; ++i) {
+      yaml_loader_dedup_t *const entry = &loader->internal.dedup.slots[i];
+      if (entry->value != NULL) {
+        entry->type->release(entry->value);
+        entry->value = NULL;
+      }
+    }
+    loader->internal.dedup.count = 0;
+  }
+}
+
+/*
+ * What a slot of one of the loader's hash tables holds, as far as a lookup
+ * is concerned.
+ */
+typedef enum {
+  SLOT_EMPTY, SLOT_MATCH, SLOT_TAKEN
+} slot_state_t;
+
+/*
+ * Return the index of the slot for the given key in a hash table with
+ * slot_count slots, a power of two, by linear probing from the key's hash:
+ * the first slot that probe reports as empty or holding the key. The table
+ * must not be full.
+ */
+static size_t find_slot(void const *table, size_t slot_count, uint64_t hash,
+                        void const *key, slot_state_t (*probe)(
+                            void const *table, size_t slot, void const *key)) {
+  size_t const mask = slot_count - 1;
+  size_t i = (size_t)hash & mask;
+  while (probe(table, i, key) == SLOT_TAKEN) i = (i + 1) & mask;
+  return i;
+}
+
+/*
+ * Return the number of slots a hash table that holds count entries in
+ * slot_count slots must grow to before taking another entry, or 0 if it
+ * need not grow. Keeping tables at most half full keeps probing short.
+ */
+static size_t grown_slot_count(size_t count, size_t slot_count,
+                               size_t initial) {
+  if (2 * (count + 1) <= slot_count) return 0;
+  return slot_count == 0 ? initial : slot_count * 2;
+}
+
+static slot_state_t probe_anchor(void const *table, size_t slot,
+                                 void const *key) {
+  yaml_loader_t const *const loader = (yaml_loader_t const*)table;
+  size_t const index = loader->internal.anchors.slots[slot];
+  if (index == SIZE_MAX) return SLOT_EMPTY;
+  return strcmp(loader->internal.anchors.data[index].name,
+                (const char*)key) == 0 ? SLOT_MATCH : SLOT_TAKEN;
+}
+
+/*
+ * Return the slot of the hash table that holds the anchor with the given
+ * name, or the empty slot where it belongs. The table must not be empty.
+ */
+static size_t *anchor_slot(yaml_loader_t const *loader, const char *name) {
+  // FNV-1a
+  uint64_t hash = UINT64_C(14695981039346656037);
+  for (const unsigned char *c = (const unsigned char*)name; *c != '\0'; ++c) {
+    hash = (hash ^ *c) * UINT64_C(1099511628211);
+  }
+  return &loader->internal.anchors.slots[find_slot(loader,
+      loader->internal.anchors.slot_count, hash, name, &probe_anchor)];
+}
+
+bool yaml_loader_add_anchor(yaml_loader_t *loader, const char *anchor,
+                            void *value,
+                            const yaml_loader_shared_type_t *type) {
+  size_t const count = loader->internal.anchors.count;
+  if (count == loader->internal.anchors.capacity) {
+    size_t const capacity = count == 0 ? 16 : count * 2;
+    yaml_loader_anchor_t *const data = realloc(loader->internal.anchors.data,
+        capacity * sizeof(yaml_loader_anchor_t));
+    if (data == NULL) return false;
+    loader->internal.anchors.data = data;
+    loader->internal.anchors.capacity = capacity;
+  }
+  size_t const slot_count =
+      grown_slot_count(count, loader->internal.anchors.slot_count, 32);
+  if (slot_count != 0) {
+    size_t *const slots = malloc(slot_count * sizeof(size_t));
+    if (slots == NULL) return false;
+    free(loader->internal.anchors.slots);
+    loader->internal.anchors.slots = slots;
+    loader->internal.anchors.slot_count = slot_count;
+    for (size_t i = 0; i < slot_count; ++i) slots[i] = SIZE_MAX;
+    for (size_t i = 0; i < count; ++i) {
+      size_t *const slot =
+          anchor_slot(loader, loader->internal.anchors.data[i].name);
+      // of redefined anchors, the latest wins.
+      *slot = i;
+    }
+  }
+  size_t const length = strlen(anchor) + 1;
+  char *const name = malloc(length);
+  if (name == NULL) return false;
+  memcpy(name, anchor, length);
+  yaml_loader_anchor_t *const entry = &loader->internal.anchors.data[count];
+  entry->name = name;
+  entry->value = value;
+  entry->type = type;
+  ((yaml_constructor_shared_t*)value - 1)->refs++;
+  *anchor_slot(loader, name) = count;
+  loader->internal.anchors.count = count + 1;
+  return true;
+}
+
+const yaml_loader_anchor_t *yaml_loader_find_anchor(
+    yaml_loader_t const *loader, const char *anchor) {
+  if (loader->internal.anchors.count == 0) return NULL;
+  size_t const index = *anchor_slot(loader, anchor);
+  return index == SIZE_MAX ? NULL : &loader->internal.anchors.data[index];
+}
+
+/*
+ * Probe a slot of the dedup table, given as table, for an entry equal to
+ * key. A NULL key matches no entry, which finds a free slot.
+ */
+static slot_state_t probe_dedup(void const *table, size_t slot,
+                                void const *key) {
+  yaml_loader_dedup_t const *const entry =
+      &((yaml_loader_dedup_t const*)table)[slot];
+  yaml_loader_dedup_t const *const wanted = (yaml_loader_dedup_t const*)key;
+  if (entry->value == NULL) return SLOT_EMPTY;
+  return wanted != NULL && entry->hash == wanted->hash &&
+      entry->type == wanted->type &&
+      wanted->type->equal(entry->value, wanted->value) ?
+      SLOT_MATCH : SLOT_TAKEN;
+}
+
+/*
+ * Return the slot of the dedup table that holds a value equal to the given
+ * one, or the empty slot where it belongs. The table must not be empty.
+ */
+static yaml_loader_dedup_t *dedup_slot(yaml_loader_t const *loader,
+    const void *value, uint64_t hash, const yaml_loader_shared_type_t *type) {
+  yaml_loader_dedup_t const wanted = {.value = (void*)value, .hash = hash,
+                                      .type = type};
+  return &loader->internal.dedup.slots[find_slot(loader->internal.dedup.slots,
+      loader->internal.dedup.slot_count, hash, &wanted, &probe_dedup)];
+}
+
+void *yaml_loader_dedup(yaml_loader_t *loader, void *value, uint64_t hash,
+                        const yaml_loader_shared_type_t *type) {
+  size_t const count = loader->internal.dedup.count;
+  if (count != 0) {
+    yaml_loader_dedup_t *const slot = dedup_slot(loader, value, hash, type);
+    if (slot->value != NULL) return slot->value;
+  }
+  size_t const old_count = loader->internal.dedup.slot_count;
+  size_t const slot_count = grown_slot_count(count, old_count, 64);
+  if (slot_count != 0) {
+    yaml_loader_dedup_t *const old = loader->internal.dedup.slots;
+    yaml_loader_dedup_t *const slots =
+        calloc(slot_count, sizeof(yaml_loader_dedup_t));
+    if (slots == NULL) return value;
+    loader->internal.dedup.slots = slots;
+    loader->internal.dedup.slot_count = slot_count;
+    for (size_t i = 0; i < old_count; ++i) {
+      if (old[i].value == NULL) continue;
+      slots[find_slot(slots, slot_count, old[i].hash, NULL, &probe_dedup)] =
+          old[i];
+    }
+    free(old);
+  }
+  yaml_loader_dedup_t *const slot = dedup_slot(loader, value, hash, type);
+  slot->value = value;
+  slot->hash = hash;
+  slot->type = type;
+  ((yaml_constructor_shared_t*)value - 1)->refs++;
+  loader->internal.dedup.count = count + 1;
+  return value;
+}
+
+/*
+ * Return the index of the bucket of recycled buffers of the given size,
+ * which must not be 0.
+ */
+static size_t bucket_index(size_t size) {
+#if defined(__GNUC__) || defined(__clang__)
+  return sizeof(unsigned long long) * CHAR_BIT - 1 -
+         (size_t)__builtin_clzll((unsigned long long)size);
+#else
+  size_t index = 0;
+  while (size >>= 1) ++index;
+  return index;
+#endif
+}
+
+void yaml_loader_begin_recycling(yaml_loader_t *loader) {
+  if (loader->internal.recycled.buckets == NULL) {
+    loader->internal.recycled.buckets =
+        calloc(YAML_LOADER_BUCKETS, sizeof(yaml_loader_bucket_t));
+  }
+  // without buckets, buffers are simply freed.
+  loader->internal.recycled.active = loader->internal.recycled.buckets != NULL;
+}
+
+void yaml_loader_recycle(yaml_loader_t *loader, void *buffer, size_t size) {
+  if (buffer == NULL) return;
+  if (!loader->internal.recycled.active || size == 0) {
+    free(buffer);
+    return;
+  }
+  yaml_loader_bucket_t *const bucket =
+      &loader->internal.recycled.buckets[bucket_index(size)];
+  if (bucket->count == bucket->capacity) {
+    size_t const capacity = bucket->capacity == 0 ? 16 : bucket->capacity * 2;
+    void *const data = realloc(bucket->data, capacity * sizeof(*bucket->data));
+    if (data == NULL) {
+      free(buffer);
+      return;
+    }
+    bucket->data = data;
+    bucket->capacity = capacity;
+  }
+  bucket->data[bucket->count].buffer = buffer;
+  bucket->data[bucket->count].size = size;
+  bucket->count++;
+  loader->internal.recycled.count++;
+}
+
+void *yaml_loader_reuse(yaml_loader_t *loader, size_t size) {
+  if (size == 0) return malloc(size);
+  size_t const index = bucket_index(size);
+  yaml_loader_bucket_t *bucket = &loader->internal.recycled.buckets[index];
+  // buffers of the same order of magnitude may be too small; take the
+  // smallest fitting one of the most recently recycled ones.
+  size_t const last = bucket->count < 8 ? 0 : bucket->count - 8;
+  size_t best = bucket->count;
+  for (size_t i = bucket->count; i > last; --i) {
+    size_t const found = bucket->data[i - 1].size;
+    if (found >= size &&
+        (best == bucket->count || found < bucket->data[best].size)) {
+      best = i - 1;
+      if (found == size) break;
+    }
+  }
+  if (best != bucket->count) {
+    void *const buffer = bucket->data[best].buffer;
+    bucket->data[best] = bucket->data[--bucket->count];
+    loader->internal.recycled.count--;
+    return buffer;
+  }
+  // buffers of the next orders of magnitude are large enough; larger ones
+  // are not taken, since they would waste too much memory.
+  for (size_t i = index + 1; i < YAML_LOADER_BUCKETS && i <= index + 2; ++i) {
+    bucket = &loader->internal.recycled.buckets[i];
+    if (bucket->count != 0) {
+      loader->internal.recycled.count--;
+      return bucket->data[--bucket->count].buffer;
+    }
+  }
+  return malloc(size);
+}
+
+void yaml_loader_end_recycling(yaml_loader_t *loader) {
+  if (loader->internal.recycled.count != 0) {
+    for (size_t i = 0; i < YAML_LOADER_BUCKETS; ++i) {
+      yaml_loader_bucket_t *const bucket =
+          &loader->internal.recycled.buckets[i];
+      for (size_t j = 0; j < bucket->count; ++j) free(bucket->data[j].buffer);
+      bucket->count = 0;
+    }
+    loader->internal.recycled.count = 0;
+  }
+  loader->internal.recycled.active = false;
+}
+
+bool yaml_loader_skip(yaml_loader_t *loader, yaml_event_t const *start,
+                      yaml_mark_t *end_mark) {
+  *end_mark = start->end_mark;
+  if (start->type != YAML_SEQUENCE_START_EVENT &&
+      start->type != YAML_MAPPING_START_EVENT) return true;
+  const yaml_tape_t *const tape = loader->internal.tape;
+  if (tape != NULL) {
+    size_t const end =
+        tape->entries.data[loader->internal.tape_current].end;
+    if (end != 0) {
+      // the skipped nodes count toward the limits as if they had been read.
+      for (size_t i = loader->internal.tape_current + 1;
+           loader->internal.limited && i <= end; ++i) {
+        yaml_event_t event;
+        yaml_tape_event(tape, i, &event);
+        if (!check_limits(loader, &event)) {
+          loader->internal.tape_current = i;
+          loader->internal.tape_pos = i + 1;
+          return false;
+        }
+      }
+      loader->internal.tape_current = end;
+      loader->internal.tape_pos = end + 1;
+      *end_mark = tape->entries.data[end].end_mark;
+      return true;
+    }
+    // the collection has not been closed before recording stopped, so
+    // reading on will report the error.
+  }
+  size_t depth = 1;
+  while (depth > 0) {
+    yaml_event_t event;
+    if (!yaml_loader_next_event(loader, &event)) return false;
+    switch (event.type) {
+      case YAML_MAPPING_START_EVENT:
+      case YAML_SEQUENCE_START_EVENT:
+        ++depth;
+        break;
+      case YAML_MAPPING_END_EVENT:
+      case YAML_SEQUENCE_END_EVENT:
+        --depth;
+        break;
+      default:
+        break;
+    }
+    *end_mark = event.end_mark;
+    yaml_loader_event_delete(loader, &event);
+  }
+  return true;
+}
+
+size_t yaml_loader_sequence_length(yaml_loader_t const *loader,
+                                   yaml_event_t const *start) {
+  const yaml_tape_t *const tape = loader->internal.tape;
+  if (tape == NULL || start->type != YAML_SEQUENCE_START_EVENT) return 0;
+  yaml_tape_entry_t const *const entry =
+      &tape->entries.data[loader->internal.tape_current];
+  if (entry->type != YAML_SEQUENCE_START_EVENT ||
+      entry->start_mark.index != start->start_mark.index) return 0;
+  return entry->children;
+}
+
+void yaml_loader_set_threads(yaml_loader_t *loader, unsigned threads) {
+  loader->internal.threads = threads == 0 ? 1 : threads;
+}
+
+bool yaml_loader_parallel(yaml_loader_t const *loader,
+                          yaml_event_t const *start) {
+  if (loader->internal.threads < 2) return false;
+  size_t const length = yaml_loader_sequence_length(loader, start);
+  // the sequence must have been recorded completely. aliases may refer to
+  // anchors constructed by another thread.
+  return length >= 2 * ITEMS_PER_THREAD_MIN &&
+      loader->internal.tape->entries.data[loader->internal.tape_current].end
+      != 0 && loader->internal.tape->aliases == 0;
+}
+
+/*
+ * Part of a list that is constructed by a single thread.
+ */
+typedef struct {
+  /*
+   * loader reading the chunk's events from the tape.
+   */
+  yaml_loader_t loader;
+  /*
+   * index of the chunk's first item, and number of items in the chunk.
+   */
+  size_t first, count;
+  /*
+   * tape index of the first item's first event.
+   */
+  size_t start;
+  /*
+   * number of items that have been constructed successfully.
+   */
+  size_t constructed;
+  char *data;
+  size_t item_size;
+  yaml_loader_item_constructor_t constructor;
+} chunk_t;
+
+static void construct_chunk(chunk_t *const chunk) {
+  chunk->loader.internal.tape_pos = chunk->start;
+  for (size_t i = 0; i < chunk->count; ++i) {
+    yaml_event_t event;
+    if (!yaml_loader_next_event(&chunk->loader, &event)) return;
+    if (!chunk->constructor(chunk->data + (chunk->first + i) * chunk->item_size,
+                            &chunk->loader, &event)) return;
+    yaml_loader_event_delete(&chunk->loader, &event);
+    chunk->constructed++;
+  }
+}
+
+static yaml_thread_result_t YAML_THREAD_CALL chunk_worker(void *arg) {
+  yaml_constructor_locale_t locale;
+  yaml_constructor_enter_c_locale(&locale);
+  construct_chunk((chunk_t*)arg);
+  yaml_constructor_leave_c_locale(&locale);
+  return YAML_THREAD_RESULT;
+}
+
+static void release_error(yaml_loader_t *loader) {
   switch (loader->error_info.type) {
     case YAML_LOADER_ERROR_TAG:
     case YAML_LOADER_ERROR_VALUE:
     case YAML_LOADER_ERROR_MISSING_KEY:
-      free(loader->error_info.expected);
-    case YAML_LOADER_ERROR_STRUCTURAL:
     case YAML_LOADER_ERROR_DUPLICATE_KEY:
     case YAML_LOADER_ERROR_UNKNOWN_KEY:
+    case YAML_LOADER_ERROR_LIMIT:
+    case YAML_LOADER_ERROR_ALIAS:
+      free(loader->error_info.expected);
+      /* fallthrough */
+    case YAML_LOADER_ERROR_STRUCTURAL:
     case YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR:
-      yaml_event_delete(&loader->error_info.event);
+      yaml_loader_event_delete(loader, &loader->error_info.event);
       break;
     case YAML_LOADER_ERROR_NONE:
     case YAML_LOADER_ERROR_PARSER:
     case YAML_LOADER_ERROR_OUT_OF_MEMORY:
+    case YAML_LOADER_ERROR_FILE:
+    case YAML_LOADER_ERROR_CANCELLED:
       break;
   }
-}
\ No newline at end of file
+  loader->error_info.type = YAML_LOADER_ERROR_NONE;
+}
+
+bool yaml_loader_construct_items(yaml_loader_t *loader, void *data,
+                                 size_t item_size,
+                                 yaml_loader_item_constructor_t constructor,
+                                 yaml_loader_item_destructor_t destructor) {
+  const yaml_tape_t *const tape = loader->internal.tape;
+  yaml_tape_entry_t const *const sequence =
+      &tape->entries.data[loader->internal.tape_current];
+  size_t const length = sequence->children;
+  size_t chunk_count = length / ITEMS_PER_THREAD_MIN;
+  if (chunk_count > loader->internal.threads) {
+    chunk_count = loader->internal.threads;
+  }
+  chunk_t *const chunks = malloc(chunk_count * sizeof(chunk_t));
+  yaml_thread_t *const threads = malloc(chunk_count * sizeof(yaml_thread_t));
+  bool *const started = malloc(chunk_count * sizeof(bool));
+  if (chunks == NULL || threads == NULL || started == NULL) {
+    free(chunks);
+    free(threads);
+    free(started);
+    loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return false;
+  }
+
+  // locate the first item of each chunk by jumping over whole items.
+  size_t index = loader->internal.tape_current + 1;
+  for (size_t c = 0; c < chunk_count; ++c) {
+    chunk_t *const chunk = &chunks[c];
+    chunk->loader = *loader;
+    chunk->loader.error_info.type = YAML_LOADER_ERROR_NONE;
+    chunk->loader.internal.view_copies.data = NULL;
+    chunk->loader.internal.view_copies.count = 0;
+    chunk->loader.internal.view_copies.capacity = 0;
+    // without aliases, anchors recorded by the chunks are never looked up.
+    chunk->loader.internal.anchors.data = NULL;
+    chunk->loader.internal.anchors.count = 0;
+    chunk->loader.internal.anchors.capacity = 0;
+    chunk->loader.internal.anchors.slots = NULL;
+    chunk->loader.internal.anchors.slot_count = 0;
+    // chunks deduplicate the values they construct among themselves only.
+    chunk->loader.internal.dedup.slots = NULL;
+    chunk->loader.internal.dedup.count = 0;
+    chunk->loader.internal.dedup.slot_count = 0;
+    // the recycled buffers are only reused by the calling thread.
+    chunk->loader.internal.recycled.buckets = NULL;
+    chunk->loader.internal.recycled.count = 0;
+    chunk->loader.internal.recycled.active = false;
+    chunk->loader.internal.threads = 1;
+    // steps are only counted on the thread that constructs the list.
+    chunk->loader.internal.resumable = NULL;
+    chunk->first = c * length / chunk_count;
+    chunk->count = (c + 1) * length / chunk_count - chunk->first;
+    chunk->start = index;
+    chunk->constructed = 0;
+    chunk->data = (char*)data;
+    chunk->item_size = item_size;
+    chunk->constructor = constructor;
+    for (size_t i = 0; i < chunk->count; ++i) {
+      yaml_tape_entry_t const *const entry = &tape->entries.data[index];
+      index = (entry->type == YAML_SEQUENCE_START_EVENT ||
+               entry->type == YAML_MAPPING_START_EVENT) ? entry->end + 1 :
+              index + 1;
+    }
+  }
+
+  // the calling thread constructs the first chunk itself. if a thread cannot
+  // be started, its chunk is constructed on the calling thread afterwards.
+  for (size_t c = 1; c < chunk_count; ++c) {
+    started[c] = yaml_thread_start(&threads[c], &chunk_worker, &chunks[c]);
+  }
+  construct_chunk(&chunks[0]);
+  for (size_t c = 1; c < chunk_count; ++c) {
+    if (started[c]) yaml_thread_join(threads[c]);
+    else construct_chunk(&chunks[c]);
+  }
+
+  bool ret = true;
+  size_t copies = loader->internal.view_copies.count;
+  // each chunk has checked the limits against its own usage only.
+  size_t bytes = loader->internal.bytes, nodes = loader->internal.nodes;
+  for (size_t c = 0; c < chunk_count; ++c) {
+    bytes += chunks[c].loader.internal.bytes - loader->internal.bytes;
+    nodes += chunks[c].loader.internal.nodes - loader->internal.nodes;
+    copies += chunks[c].loader.internal.view_copies.count;
+    if (ret && chunks[c].constructed < chunks[c].count) {
+      // report the first error in document order.
+      loader->error_info = chunks[c].loader.error_info;
+      ret = false;
+    } else release_error(&chunks[c].loader);
+  }
+  if (copies > loader->internal.view_copies.capacity) {
+    char **const new_data = realloc(loader->internal.view_copies.data,
+                                    copies * sizeof(char*));
+    if (new_data == NULL) {
+      if (ret) loader->error_info.type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+      ret = false;
+    } else {
+      loader->internal.view_copies.data = new_data;
+      loader->internal.view_copies.capacity = copies;
+    }
+  }
+  for (size_t c = 0; c < chunk_count; ++c) {
+    yaml_loader_t *const chunk_loader = &chunks[c].loader;
+    for (size_t i = 0; i < chunk_loader->internal.view_copies.count; ++i) {
+      if (loader->internal.view_copies.count <
+          loader->internal.view_copies.capacity) {
+        loader->internal.view_copies.data[
+            loader->internal.view_copies.count++] =
+            chunk_loader->internal.view_copies.data[i];
+      } else free(chunk_loader->internal.view_copies.data[i]);
+    }
+    free(chunk_loader->internal.view_copies.data);
+    clear_shared(chunk_loader);
+    free(chunk_loader->internal.anchors.data);
+    free(chunk_loader->internal.anchors.slots);
+    free(chunk_loader->internal.dedup.slots);
+  }
+
+  loader->internal.bytes = bytes;
+  loader->internal.nodes = nodes;
+  yaml_loader_limits_t const *const limits = &loader->internal.limits;
+  if (ret && ((limits->max_bytes != 0 && bytes > limits->max_bytes) ||
+              (limits->max_nodes != 0 && nodes > limits->max_nodes))) {
+    yaml_event_t start;
+    yaml_tape_event(tape, loader->internal.tape_current, &start);
+    ret = yaml_loader_limit_error(loader, &start,
+        nodes > limits->max_nodes && limits->max_nodes != 0 ?
+        "max_nodes" : "max_bytes");
+  }
+  if (ret) {
+    loader->internal.tape_current = sequence->end;
+    loader->internal.tape_pos = sequence->end + 1;
+    if (loader->internal.limited) loader->internal.depth--;
+  } else {
+    for (size_t c = 0; c < chunk_count; ++c) {
+      for (size_t i = 0; i < chunks[c].constructed; ++i) {
+        destructor((char*)data + (chunks[c].first + i) * item_size);
+      }
+    }
+  }
+  free(chunks);
+  free(threads);
+  free(started);
+  return ret;
+}
+
+/*
+ * Files that still need to be loaded by one batch thread: [next, end).
+ */
+typedef struct {
+  yaml_mutex_t mutex;
+  size_t next, end;
+} batch_queue_t;
+
+typedef struct {
+  const char *const *paths;
+  char *values;
+  size_t value_size;
+  yaml_loader_document_loader_t load;
+  yaml_loader_batch_result_t *results;
+  batch_queue_t *queues;
+  size_t queue_count;
+} batch_t;
+
+typedef struct {
+  batch_t *batch;
+  size_t index;
+} batch_worker_t;
+
+/*
+ * Take the next file from the given queue. Returns false if it is empty.
+ */
+static bool batch_take(batch_queue_t *const queue, size_t *const file) {
+  yaml_mutex_lock(&queue->mutex);
+  bool const ret = queue->next < queue->end;
+  if (ret) *file = queue->next++;
+  yaml_mutex_unlock(&queue->mutex);
+  return ret;
+}
+
+/*
+ * Move the back half of another thread's files into the given thread's
+ * queue. Returns false if all other queues are empty.
+ */
+static bool batch_steal(batch_t *const batch, size_t const thief) {
+  for (size_t i = 1; i < batch->queue_count; ++i) {
+    batch_queue_t *const victim =
+        &batch->queues[(thief + i) % batch->queue_count];
+    yaml_mutex_lock(&victim->mutex);
+    size_t const stolen = (victim->end - victim->next + 1) / 2;
+    victim->end -= stolen;
+    size_t const first = victim->end;
+    yaml_mutex_unlock(&victim->mutex);
+    if (stolen > 0) {
+      batch_queue_t *const queue = &batch->queues[thief];
+      yaml_mutex_lock(&queue->mutex);
+      queue->next = first;
+      queue->end = first + stolen;
+      yaml_mutex_unlock(&queue->mutex);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Load the given content of a file with the given parser, which is reset
+ * first, or from the given tape if the content is JSON.
+ */
+static void batch_load_file(batch_t *const batch, size_t const file,
+                            const unsigned char *const data, size_t const size,
+                            yaml_parser_t *const parser,
+                            yaml_tape_t *const tape,
+                            yaml_loader_t *const loader) {
+  yaml_loader_batch_result_t *const result = &batch->results[file];
+  memset(result, 0, sizeof(yaml_loader_batch_result_t));
+  if (data == NULL) {
+    result->type = YAML_LOADER_ERROR_FILE;
+    return;
+  }
+  if (!reset_parser(parser)) {
+    result->type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    return;
+  }
+  yaml_parser_set_input_string(parser, data, size);
+  // the content is overwritten by the next file, so values must not refer to
+  // it, which is ensured by not telling the loader about the buffer.
+  yaml_loader_init_parser(loader, parser);
+  if (looks_like_json(data, size) && yaml_tape_record_json(tape, data, size)) {
+    loader->internal.tape = tape;
+  }
+  if (!batch->load(batch->values + file * batch->value_size, loader)) {
+    result->type = loader->error_info.type;
+    switch (result->type) {
+      case YAML_LOADER_ERROR_PARSER:
+        result->mark = parser->problem_mark;
+        result->problem = parser->problem;
+        break;
+      case YAML_LOADER_ERROR_TAG:
+      case YAML_LOADER_ERROR_VALUE:
+      case YAML_LOADER_ERROR_MISSING_KEY:
+      case YAML_LOADER_ERROR_DUPLICATE_KEY:
+      case YAML_LOADER_ERROR_UNKNOWN_KEY:
+      case YAML_LOADER_ERROR_LIMIT:
+      case YAML_LOADER_ERROR_ALIAS:
+        result->expected = loader->error_info.expected;
+        loader->error_info.expected = NULL;
+        // fallthrough
+      case YAML_LOADER_ERROR_STRUCTURAL:
+      case YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR:
+        result->mark = loader->error_info.event.start_mark;
+        break;
+      default:
+        break;
+    }
+  }
+  yaml_loader_delete(loader);
+}
+
+/*
+ * Submit files of the worker's queue to its prefetcher until it is full.
+ */
+static void batch_fill(batch_t *const batch, size_t const worker,
+                       yaml_prefetch_t *const prefetch) {
+  size_t file;
+  while (prefetch->pending < prefetch->depth &&
+         batch_take(&batch->queues[worker], &file)) {
+    yaml_prefetch_submit(prefetch, batch->paths[file], file);
+  }
+}
+
+static yaml_thread_result_t YAML_THREAD_CALL batch_worker(void *arg) {
+  batch_worker_t const *const worker = (batch_worker_t*)arg;
+  batch_t *const batch = worker->batch;
+  yaml_parser_t parser;
+  yaml_tape_t tape;
+  yaml_loader_t loader;
+  yaml_prefetch_t prefetch;
+  size_t file;
+  bool ready = yaml_parser_initialize(&parser) != 0;
+  if (ready && !yaml_prefetch_init(&prefetch, BATCH_PREFETCH_DEPTH)) {
+    yaml_parser_delete(&parser);
+    ready = false;
+  }
+  if (!ready) {
+    do {
+      while (batch_take(&batch->queues[worker->index], &file)) {
+        memset(&batch->results[file], 0, sizeof(yaml_loader_batch_result_t));
+        batch->results[file].type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+      }
+    } while (batch_steal(batch, worker->index));
+    return YAML_THREAD_RESULT;
+  }
+  const unsigned char *data;
+  size_t size;
+  yaml_tape_init(&tape);
+  do {
+    batch_fill(batch, worker->index, &prefetch);
+    while (yaml_prefetch_next(&prefetch, &file, &data, &size)) {
+      // reading the following files overlaps with loading this one.
+      batch_fill(batch, worker->index, &prefetch);
+      batch_load_file(batch, file, data, size, &parser, &tape, &loader);
+    }
+  } while (batch_steal(batch, worker->index));
+  yaml_tape_delete(&tape);
+  yaml_prefetch_delete(&prefetch);
+  yaml_parser_delete(&parser);
+  // the started threads exit now, so the stacks kept for code generated with
+  // -s must go; the calling thread keeps its own.
+  if (worker->index != 0) yaml_loader_pool_clear();
+  return YAML_THREAD_RESULT;
+}
+
+bool yaml_loader_load_batch(const char *const *paths, size_t count,
+                            void *values, size_t value_size,
+                            yaml_loader_document_loader_t load,
+                            yaml_loader_batch_result_t *results,
+                            unsigned threads) {
+  size_t thread_count = threads == 0 ? 1 : threads;
+  if (thread_count > count) thread_count = count == 0 ? 1 : count;
+  batch_queue_t *const queues = malloc(thread_count * sizeof(batch_queue_t));
+  batch_worker_t *const workers =
+      malloc(thread_count * sizeof(batch_worker_t));
+  yaml_thread_t *const handles = malloc(thread_count * sizeof(yaml_thread_t));
+  bool *const started = malloc(thread_count * sizeof(bool));
+  size_t initialized = 0;
+  if (queues != NULL && workers != NULL && handles != NULL &&
+      started != NULL) {
+    while (initialized < thread_count &&
+           yaml_mutex_init(&queues[initialized].mutex)) ++initialized;
+  }
+  if (initialized < thread_count) {
+    for (size_t i = 0; i < initialized; ++i) {
+      yaml_mutex_destroy(&queues[i].mutex);
+    }
+    free(queues);
+    free(workers);
+    free(handles);
+    free(started);
+    for (size_t i = 0; i < count; ++i) {
+      memset(&results[i], 0, sizeof(yaml_loader_batch_result_t));
+      results[i].type = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+    }
+    return false;
+  }
+
+  batch_t batch = {paths, (char*)values, value_size, load, results, queues,
+                   thread_count};
+  for (size_t i = 0; i < thread_count; ++i) {
+    queues[i].next = i * count / thread_count;
+    queues[i].end = (i + 1) * count / thread_count;
+    workers[i].batch = &batch;
+    workers[i].index = i;
+  }
+  // the calling thread is the first worker. if a thread cannot be started,
+  // its files are stolen by the others.
+  for (size_t i = 1; i < thread_count; ++i) {
+    started[i] = yaml_thread_start(&handles[i], &batch_worker, &workers[i]);
+  }
+  batch_worker(&workers[0]);
+  for (size_t i = 1; i < thread_count; ++i) {
+    if (started[i]) yaml_thread_join(handles[i]);
+  }
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    yaml_mutex_destroy(&queues[i].mutex);
+  }
+  free(queues);
+  free(workers);
+  free(handles);
+  free(started);
+  bool ret = true;
+  for (size_t i = 0; i < count; ++i) {
+    if (results[i].type != YAML_LOADER_ERROR_NONE) ret = false;
+  }
+  return ret;
+}
+
+/**
+ * Destroys a loader that has successfully been initialized.
+ */
+void yaml_loader_delete(yaml_loader_t *loader) {
+  if (loader->internal.pipeline != NULL) {
+    pipeline_delete(loader->internal.pipeline);
+  }
+  if (loader->internal.resumable != NULL) resumable_delete(loader);
+  if (!loader->internal.external_parser) {
+    yaml_parser_delete(loader->parser);
+    free(loader->parser);
+  }
+  yaml_loader_release_view_copies(loader);
+  free(loader->internal.view_copies.data);
+  clear_shared(loader);
+  free(loader->internal.anchors.data);
+  free(loader->internal.anchors.slots);
+  free(loader->internal.dedup.slots);
+  yaml_loader_end_recycling(loader);
+  if (loader->internal.recycled.buckets != NULL) {
+    for (size_t i = 0; i < YAML_LOADER_BUCKETS; ++i) {
+      free(loader->internal.recycled.buckets[i].data);
+    }
+    free(loader->internal.recycled.buckets);
+  }
+  release_error(loader);
+  if (loader->internal.scanned != NULL) {
+    yaml_tape_delete(loader->internal.scanned);
+    free(loader->internal.scanned);
+  }
+}
@@ -0,0 +1,344 @@
+#include <yaml_prefetch.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef YAML_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#ifndef __NR_io_uring_setup
+// the C library does not know the system calls.
+#undef YAML_HAVE_IO_URING
+#endif
+#endif
+
+/*
+ * Make room for at least size bytes in the slot's buffer.
+ */
+static bool reserve(yaml_prefetch_slot_t *const slot, size_t const size) {
+  if (slot->capacity >= size && slot->buffer != NULL) return true;
+  size_t new_capacity = slot->capacity == 0 ? 4096 : slot->capacity;
+  while (new_capacity < size) new_capacity *= 2;
+  unsigned char *const new_buffer = realloc(slot->buffer, new_capacity);
+  if (new_buffer == NULL) return false;
+  slot->buffer = new_buffer;
+  slot->capacity = new_capacity;
+  return true;
+}
+
+#ifdef _WIN32
+
+/*
+ * Read the whole file at the given path into the slot.
+ */
+static void read_file(yaml_prefetch_slot_t *const slot, const char *path) {
+  slot->done = true;
+  slot->failed = true;
+  FILE *const file = fopen(path, "rb");
+  if (file == NULL) return;
+  slot->filled = 0;
+  while (reserve(slot, slot->filled + 4096)) {
+    size_t const n = fread(slot->buffer + slot->filled, 1,
+                           slot->capacity - slot->filled, file);
+    slot->filled += n;
+    if (n == 0) {
+      slot->failed = ferror(file) != 0;
+      break;
+    }
+  }
+  slot->size = slot->filled;
+  fclose(file);
+}
+
+#else
+
+/*
+ * Open the file at the given path and allocate room for its content in the
+ * slot. Sets slot->failed and returns false on failure.
+ */
+static bool open_file(yaml_prefetch_slot_t *const slot, const char *path) {
+  slot->fd = open(path, O_RDONLY);
+  struct stat info;
+  if (slot->fd < 0 || fstat(slot->fd, &info) != 0 ||
+      !reserve(slot, (size_t)info.st_size)) {
+    slot->failed = true;
+    return false;
+  }
+  slot->size = (size_t)info.st_size;
+  slot->filled = 0;
+  return true;
+}
+
+static void read_file(yaml_prefetch_slot_t *const slot, const char *path) {
+  slot->done = true;
+  if (!open_file(slot, path)) return;
+  while (slot->filled < slot->size) {
+    ssize_t const n = pread(slot->fd, slot->buffer + slot->filled,
+                            slot->size - slot->filled, (off_t)slot->filled);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      slot->failed = true;
+      break;
+    }
+    // the file has been truncated since it has been opened.
+    if (n == 0) slot->size = slot->filled;
+    else slot->filled += (size_t)n;
+  }
+}
+
+#endif
+
+#ifdef YAML_HAVE_IO_URING
+
+struct yaml_prefetch_ring_s {
+  int fd;
+  unsigned *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring, *cq_ring;
+  size_t sq_ring_size, cq_ring_size, sqes_size;
+  /*
+   * one iovec per slot, read into by the slot's pending request.
+   */
+  struct iovec *iovecs;
+  /*
+   * number of submitted requests whose completion has not been seen yet.
+   */
+  size_t in_flight;
+};
+
+static int ring_enter(int const fd, unsigned const to_submit,
+                      unsigned const min_complete, unsigned const flags) {
+  int ret;
+  do {
+    ret = (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                       NULL, 0);
+  } while (ret < 0 && errno == EINTR);
+  return ret;
+}
+
+static void ring_delete(struct yaml_prefetch_ring_s *const ring) {
+  if (ring->sqes != NULL) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  if (ring->sq_ring != NULL) munmap(ring->sq_ring, ring->sq_ring_size);
+  if (ring->fd >= 0) close(ring->fd);
+  free(ring->iovecs);
+  free(ring);
+}
+
+/*
+ * Set up an io_uring for the given number of slots. Returns NULL if io_uring
+ * is not available, e.g. on old kernels or inside restricted containers.
+ */
+static struct yaml_prefetch_ring_s *ring_create(size_t const slots) {
+  struct yaml_prefetch_ring_s *const ring =
+      calloc(1, sizeof(struct yaml_prefetch_ring_s));
+  if (ring == NULL) return NULL;
+  ring->iovecs = malloc(slots * sizeof(struct iovec));
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring->fd = ring->iovecs == NULL ? -1 :
+      (int)syscall(__NR_io_uring_setup, (unsigned)slots, &params);
+  if (ring->fd < 0) {
+    ring_delete(ring);
+    return NULL;
+  }
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries *
+      sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries *
+      sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_ring_size > ring->sq_ring_size) {
+      ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+  void *mapped = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (mapped == MAP_FAILED) {
+    ring_delete(ring);
+    return NULL;
+  }
+  ring->sq_ring = mapped;
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    mapped = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (mapped == MAP_FAILED) {
+      ring_delete(ring);
+      return NULL;
+    }
+    ring->cq_ring = mapped;
+  }
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  mapped = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (mapped == MAP_FAILED) {
+    ring_delete(ring);
+    return NULL;
+  }
+  ring->sqes = mapped;
+  char *const sq = ring->sq_ring;
+  char *const cq = ring->cq_ring;
+  ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  return ring;
+}
+
+/*
+ * Submit a read of the remaining content of the slot with the given index.
+ * There is at most one request per slot, so the submission queue never
+ * overflows.
+ */
+static bool ring_read(yaml_prefetch_t *const prefetch, size_t const index) {
+  struct yaml_prefetch_ring_s *const ring = prefetch->ring;
+  yaml_prefetch_slot_t *const slot = &prefetch->slots[index];
+  struct iovec *const iovec = &ring->iovecs[index];
+  iovec->iov_base = slot->buffer + slot->filled;
+  iovec->iov_len = slot->size - slot->filled;
+  unsigned const tail = *ring->sq_tail;
+  unsigned const position = tail & *ring->sq_mask;
+  struct io_uring_sqe *const sqe = &ring->sqes[position];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = slot->fd;
+  sqe->addr = (unsigned long)iovec;
+  sqe->len = 1;
+  sqe->off = slot->filled;
+  sqe->user_data = index;
+  ring->sq_array[position] = position;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  if (ring_enter(ring->fd, 1, 0, 0) != 1) {
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+  ring->in_flight++;
+  return true;
+}
+
+/*
+ * Wait for at least one completion and process all available ones.
+ */
+static void ring_wait(yaml_prefetch_t *const prefetch) {
+  struct yaml_prefetch_ring_s *const ring = prefetch->ring;
+  unsigned head = *ring->cq_head;
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+    ring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+  }
+  while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+    struct io_uring_cqe const *const cqe = &ring->cqes[head & *ring->cq_mask];
+    yaml_prefetch_slot_t *const slot = &prefetch->slots[cqe->user_data];
+    int const res = cqe->res;
+    size_t const index = (size_t)cqe->user_data;
+    __atomic_store_n(ring->cq_head, ++head, __ATOMIC_RELEASE);
+    ring->in_flight--;
+    if (res == -EINTR || res == -EAGAIN) {
+      if (!ring_read(prefetch, index)) slot->failed = slot->done = true;
+    } else if (res < 0) {
+      slot->failed = slot->done = true;
+    } else {
+      if (res == 0) slot->size = slot->filled;
+      else slot->filled += (size_t)res;
+      if (slot->filled == slot->size) slot->done = true;
+      else if (!ring_read(prefetch, index)) slot->failed = slot->done = true;
+    }
+  }
+}
+
+#endif
+
+bool yaml_prefetch_init(yaml_prefetch_t *prefetch, unsigned depth) {
+  prefetch->depth = depth == 0 ? 1 : depth;
+  prefetch->first = prefetch->pending = 0;
+  prefetch->ring = NULL;
+  prefetch->slots = calloc(prefetch->depth + 1, sizeof(yaml_prefetch_slot_t));
+  if (prefetch->slots == NULL) return false;
+  for (size_t i = 0; i <= prefetch->depth; ++i) {
+    prefetch->slots[i].fd = -1;
+  }
+#ifdef YAML_HAVE_IO_URING
+  if (depth > 0) prefetch->ring = ring_create(prefetch->depth + 1);
+#endif
+  return true;
+}
+
+bool yaml_prefetch_submit(yaml_prefetch_t *prefetch, const char *path,
+                          size_t id) {
+  if (prefetch->pending == prefetch->depth) return false;
+  size_t const index =
+      (prefetch->first + prefetch->pending) % (prefetch->depth + 1);
+  yaml_prefetch_slot_t *const slot = &prefetch->slots[index];
+  prefetch->pending++;
+  slot->id = id;
+  slot->done = slot->failed = false;
+#ifdef YAML_HAVE_IO_URING
+  if (prefetch->ring != NULL) {
+    if (!open_file(slot, path)) slot->done = true;
+    else if (slot->size == 0) slot->done = true;
+    else if (!ring_read(prefetch, index)) slot->failed = slot->done = true;
+    return true;
+  }
+#endif
+  read_file(slot, path);
+  return true;
+}
+
+bool yaml_prefetch_next(yaml_prefetch_t *prefetch, size_t *id,
+                        const unsigned char **data, size_t *size) {
+  if (prefetch->pending == 0) return false;
+  yaml_prefetch_slot_t *const slot = &prefetch->slots[prefetch->first];
+#ifdef YAML_HAVE_IO_URING
+  while (!slot->done) ring_wait(prefetch);
+#endif
+#ifndef _WIN32
+  if (slot->fd >= 0) {
+    close(slot->fd);
+    slot->fd = -1;
+  }
+#endif
+  *id = slot->id;
+  *data = slot->failed ? NULL : slot->buffer;
+  *size = slot->failed ? 0 : slot->size;
+  prefetch->first = (prefetch->first + 1) % (prefetch->depth + 1);
+  prefetch->pending--;
+  return true;
+}
+
+bool yaml_prefetch_is_async(yaml_prefetch_t const *prefetch) {
+  return prefetch->ring != NULL;
+}
+
+void yaml_prefetch_delete(yaml_prefetch_t *prefetch) {
+#ifdef YAML_HAVE_IO_URING
+  if (prefetch->ring != NULL) {
+    while (prefetch->ring->in_flight > 0) ring_wait(prefetch);
+    ring_delete(prefetch->ring);
+  }
+#endif
+  for (size_t i = 0; i <= prefetch->depth; ++i) {
+#ifndef _WIN32
+    if (prefetch->slots[i].fd >= 0) close(prefetch->slots[i].fd);
+#endif
+    free(prefetch->slots[i].buffer);
+  }
+  free(prefetch->slots);
+}
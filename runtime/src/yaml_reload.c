@@ -0,0 +1,96 @@
+#include <yaml_reload.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void yaml_reload_changes_init(yaml_reload_changes_t *const changes) {
+  changes->paths = NULL;
+  changes->count = 0;
+  changes->incomplete = false;
+  changes->internal.capacity = 0;
+  changes->internal.path = NULL;
+  changes->internal.path_len = 0;
+  changes->internal.path_capacity = 0;
+}
+
+void yaml_reload_changes_delete(yaml_reload_changes_t *const changes) {
+  for (size_t i = 0; i < changes->count; ++i) free(changes->paths[i]);
+  free(changes->paths);
+  free(changes->internal.path);
+  yaml_reload_changes_init(changes);
+}
+
+/*
+ * Make room for appending len characters to the current path. Returns false
+ * and marks the changes as incomplete if memory runs out.
+ */
+static bool reserve_path(yaml_reload_changes_t *const changes,
+                         size_t const len) {
+  size_t const needed = changes->internal.path_len + len + 1;
+  if (needed <= changes->internal.path_capacity) return true;
+  size_t capacity = changes->internal.path_capacity == 0 ?
+      64 : changes->internal.path_capacity;
+  while (capacity < needed) capacity *= 2;
+  char *const path = realloc(changes->internal.path, capacity);
+  if (path == NULL) {
+    changes->incomplete = true;
+    return false;
+  }
+  changes->internal.path = path;
+  changes->internal.path_capacity = capacity;
+  return true;
+}
+
+size_t yaml_reload_enter_field(yaml_reload_changes_t *const changes,
+                               const char *const name) {
+  size_t const prev = changes->internal.path_len;
+  size_t const len = strlen(name);
+  // paths are not extended after running out of memory, and thus wrong;
+  // nothing is recorded from then on.
+  if (!reserve_path(changes, len + 1)) return prev;
+  char *const end = changes->internal.path + prev;
+  if (prev == 0) {
+    memcpy(end, name, len + 1);
+    changes->internal.path_len = len;
+  } else {
+    end[0] = '.';
+    memcpy(end + 1, name, len + 1);
+    changes->internal.path_len = prev + len + 1;
+  }
+  return prev;
+}
+
+size_t yaml_reload_enter_item(yaml_reload_changes_t *const changes,
+                              size_t const index) {
+  size_t const prev = changes->internal.path_len;
+  // brackets, at most 20 digits and the terminator.
+  if (!reserve_path(changes, 23)) return prev;
+  changes->internal.path_len +=
+      (size_t)sprintf(changes->internal.path + prev, "[%zu]", index);
+  return prev;
+}
+
+void yaml_reload_changed(yaml_reload_changes_t *const changes) {
+  if (changes->incomplete) return;
+  if (changes->count == changes->internal.capacity) {
+    size_t const capacity = changes->internal.capacity == 0 ?
+        16 : changes->internal.capacity * 2;
+    char **const paths = realloc(changes->paths, capacity * sizeof(char*));
+    if (paths == NULL) {
+      changes->incomplete = true;
+      return;
+    }
+    changes->paths = paths;
+    changes->internal.capacity = capacity;
+  }
+  size_t const len = changes->internal.path_len;
+  char *const path = malloc(len + 1);
+  if (path == NULL) {
+    changes->incomplete = true;
+    return;
+  }
+  if (len > 0) memcpy(path, changes->internal.path, len);
+  path[len] = '\0';
+  changes->paths[changes->count++] = path;
+}
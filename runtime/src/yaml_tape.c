@@ -0,0 +1,201 @@
+#include <yaml_tape.h>
+#include <yaml_loader.h>
+
+#include <stdint.h>
+
+#include "yaml_tape_internal.h"
+
+void yaml_tape_init(yaml_tape_t *tape) {
+  tape->entries.data = NULL;
+  tape->entries.count = tape->entries.capacity = 0;
+  tape->arena.data = NULL;
+  tape->arena.count = tape->arena.capacity = 0;
+  tape->open.data = NULL;
+  tape->open.count = tape->open.capacity = 0;
+  tape->structurals.data = NULL;
+  tape->structurals.count = tape->structurals.capacity = 0;
+  tape->error = YAML_LOADER_ERROR_NONE;
+  tape->aliases = 0;
+  tape->problem = NULL;
+}
+
+/*
+ * Copy the given string into the tape's arena. Returns SIZE_MAX if string is
+ * NULL, and stores SIZE_MAX in *failed if allocation fails.
+ */
+static size_t store(yaml_tape_t *const tape, yaml_char_t const *const string,
+                    size_t const length, bool *const failed) {
+  if (string == NULL) return SIZE_MAX;
+  if (!YAML_TAPE_RESERVE(&tape->arena, length + 1)) {
+    *failed = true;
+    return SIZE_MAX;
+  }
+  size_t const offset = tape->arena.count;
+  memcpy(tape->arena.data + offset, string, length);
+  tape->arena.data[offset + length] = '\0';
+  tape->arena.count += length + 1;
+  return offset;
+}
+
+bool yaml_tape_record(yaml_tape_t *tape, yaml_parser_t *parser) {
+  tape->entries.count = 0;
+  tape->arena.count = 0;
+  tape->open.count = 0;
+  tape->error = YAML_LOADER_ERROR_NONE;
+  tape->aliases = 0;
+  tape->problem = NULL;
+  yaml_event_t event;
+  do {
+    if (yaml_parser_parse(parser, &event) == 0) {
+      tape->error = YAML_LOADER_ERROR_PARSER;
+      return false;
+    }
+    if (!YAML_TAPE_RESERVE(&tape->entries, 1)) {
+      yaml_event_delete(&event);
+      tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+      return false;
+    }
+    size_t const index = tape->entries.count;
+    yaml_tape_entry_t *const entry = &tape->entries.data[index];
+    bool failed = false;
+    entry->type = event.type;
+    entry->style = 0;
+    entry->implicit = entry->quoted_implicit = false;
+    entry->anchor = entry->tag = entry->value = SIZE_MAX;
+    entry->length = entry->end = entry->children = 0;
+    entry->start_mark = event.start_mark;
+    entry->end_mark = event.end_mark;
+    switch (event.type) {
+      case YAML_SCALAR_EVENT:
+      case YAML_ALIAS_EVENT:
+      case YAML_SEQUENCE_START_EVENT:
+      case YAML_MAPPING_START_EVENT:
+        if (tape->open.count > 0) {
+          tape->entries.data[tape->open.data[tape->open.count - 1]].children++;
+        }
+        break;
+      default:
+        break;
+    }
+    switch (event.type) {
+      case YAML_STREAM_START_EVENT:
+        entry->style = event.data.stream_start.encoding;
+        break;
+      case YAML_DOCUMENT_START_EVENT:
+        entry->implicit = event.data.document_start.implicit != 0;
+        break;
+      case YAML_DOCUMENT_END_EVENT:
+        entry->implicit = event.data.document_end.implicit != 0;
+        break;
+      case YAML_ALIAS_EVENT:
+        tape->aliases++;
+        entry->anchor = store(tape, event.data.alias.anchor,
+            strlen((char*)event.data.alias.anchor), &failed);
+        break;
+      case YAML_SCALAR_EVENT:
+        if (event.data.scalar.anchor != NULL) {
+          entry->anchor = store(tape, event.data.scalar.anchor,
+              strlen((char*)event.data.scalar.anchor), &failed);
+        }
+        if (event.data.scalar.tag != NULL) {
+          entry->tag = store(tape, event.data.scalar.tag,
+              strlen((char*)event.data.scalar.tag), &failed);
+        }
+        entry->value = store(tape, event.data.scalar.value,
+                             event.data.scalar.length, &failed);
+        entry->length = event.data.scalar.length;
+        entry->implicit = event.data.scalar.plain_implicit != 0;
+        entry->quoted_implicit = event.data.scalar.quoted_implicit != 0;
+        entry->style = event.data.scalar.style;
+        break;
+      case YAML_SEQUENCE_START_EVENT:
+      case YAML_MAPPING_START_EVENT:
+        // sequence_start and mapping_start have the same layout.
+        if (event.data.sequence_start.anchor != NULL) {
+          entry->anchor = store(tape, event.data.sequence_start.anchor,
+              strlen((char*)event.data.sequence_start.anchor), &failed);
+        }
+        if (event.data.sequence_start.tag != NULL) {
+          entry->tag = store(tape, event.data.sequence_start.tag,
+              strlen((char*)event.data.sequence_start.tag), &failed);
+        }
+        entry->implicit = event.data.sequence_start.implicit != 0;
+        entry->style = event.data.sequence_start.style;
+        if (!YAML_TAPE_RESERVE(&tape->open, 1)) failed = true;
+        else tape->open.data[tape->open.count++] = index;
+        break;
+      case YAML_SEQUENCE_END_EVENT:
+      case YAML_MAPPING_END_EVENT:
+        tape->entries.data[tape->open.data[--tape->open.count]].end = index;
+        break;
+      default:
+        break;
+    }
+    yaml_event_delete(&event);
+    if (failed) {
+      tape->error = YAML_LOADER_ERROR_OUT_OF_MEMORY;
+      return false;
+    }
+    tape->entries.count++;
+  } while (tape->entries.data[tape->entries.count - 1].type !=
+           YAML_STREAM_END_EVENT);
+  return true;
+}
+
+void yaml_tape_event(yaml_tape_t const *tape, size_t index,
+                     yaml_event_t *event) {
+  yaml_tape_entry_t const *const entry = &tape->entries.data[index];
+  memset(event, 0, sizeof(yaml_event_t));
+  event->type = entry->type;
+  event->start_mark = entry->start_mark;
+  event->end_mark = entry->end_mark;
+  yaml_char_t *const anchor = entry->anchor == SIZE_MAX ? NULL :
+      (yaml_char_t*)tape->arena.data + entry->anchor;
+  yaml_char_t *const tag = entry->tag == SIZE_MAX ? NULL :
+      (yaml_char_t*)tape->arena.data + entry->tag;
+  switch (entry->type) {
+    case YAML_STREAM_START_EVENT:
+      event->data.stream_start.encoding = (yaml_encoding_t)entry->style;
+      break;
+    case YAML_DOCUMENT_START_EVENT:
+      event->data.document_start.implicit = entry->implicit;
+      break;
+    case YAML_DOCUMENT_END_EVENT:
+      event->data.document_end.implicit = entry->implicit;
+      break;
+    case YAML_ALIAS_EVENT:
+      event->data.alias.anchor = anchor;
+      break;
+    case YAML_SCALAR_EVENT:
+      event->data.scalar.anchor = anchor;
+      event->data.scalar.tag = tag;
+      event->data.scalar.value = (yaml_char_t*)tape->arena.data + entry->value;
+      event->data.scalar.length = entry->length;
+      event->data.scalar.plain_implicit = entry->implicit;
+      event->data.scalar.quoted_implicit = entry->quoted_implicit;
+      event->data.scalar.style = (yaml_scalar_style_t)entry->style;
+      break;
+    case YAML_SEQUENCE_START_EVENT:
+      event->data.sequence_start.anchor = anchor;
+      event->data.sequence_start.tag = tag;
+      event->data.sequence_start.implicit = entry->implicit;
+      event->data.sequence_start.style = (yaml_sequence_style_t)entry->style;
+      break;
+    case YAML_MAPPING_START_EVENT:
+      event->data.mapping_start.anchor = anchor;
+      event->data.mapping_start.tag = tag;
+      event->data.mapping_start.implicit = entry->implicit;
+      event->data.mapping_start.style = (yaml_mapping_style_t)entry->style;
+      break;
+    default:
+      break;
+  }
+}
+
+void yaml_tape_delete(yaml_tape_t *tape) {
+  free(tape->entries.data);
+  free(tape->arena.data);
+  free(tape->open.data);
+  free(tape->structurals.data);
+  yaml_tape_init(tape);
+}
@@ -0,0 +1,44 @@
+#ifndef YAML_TAPE_INTERNAL_H
+#define YAML_TAPE_INTERNAL_H
+
+/*
+ * Growth of the lists of a tape, shared by the code recording events from
+ * libyaml, JSON and CBOR. A list is a struct with the members data, count and
+ * capacity; its capacity starts at 64 items and doubles.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * Make room for at least the given number of items in the given list.
+ * Evaluates to false iff allocation fails.
+ */
+#define YAML_TAPE_CAPACITY(list, needed) \
+  ((list)->capacity >= (needed) || \
+   yaml_tape_grow((void**)&(list)->data, &(list)->capacity, (needed), \
+                  sizeof(*(list)->data)))
+
+/*
+ * Make room for at least the given number of additional items in the given
+ * list. Evaluates to false iff allocation fails.
+ */
+#define YAML_TAPE_RESERVE(list, additional) \
+  ((list)->capacity - (list)->count >= (additional) || \
+   yaml_tape_grow((void**)&(list)->data, &(list)->capacity, \
+                  (list)->count + (additional), sizeof(*(list)->data)))
+
+static inline bool yaml_tape_grow(void **const data, size_t *const capacity,
+                                  size_t const needed,
+                                  size_t const item_size) {
+  size_t new_capacity = *capacity == 0 ? 64 : *capacity;
+  while (new_capacity < needed) new_capacity *= 2;
+  void *const new_data = realloc(*data, new_capacity * item_size);
+  if (new_data == NULL) return false;
+  *data = new_data;
+  *capacity = new_capacity;
+  return true;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef YAML_THREADS_H
+#define YAML_THREADS_H
+
+/*
+ * Minimal thread abstraction used by the runtime. Thread functions are
+ * declared as
+ *
+ *   static yaml_thread_result_t YAML_THREAD_CALL func(void *arg);
+ *
+ * and return YAML_THREAD_RESULT.
+ *
+ * yaml_mutex_t is a non-recursive mutex. YAML_THREAD_LOCAL declares a variable
+ * with thread storage duration.
+ *
+ * yaml_atomic_load and yaml_atomic_store access a size_t shared between
+ * threads with acquire and release semantics, respectively;
+ * yaml_atomic_load_bool reads a flag set by another thread.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE yaml_thread_t;
+typedef CRITICAL_SECTION yaml_mutex_t;
+typedef DWORD yaml_thread_result_t;
+#define YAML_THREAD_CALL WINAPI
+#define YAML_THREAD_RESULT 0
+#define YAML_THREAD_LOCAL __declspec(thread)
+
+static inline bool yaml_thread_start(yaml_thread_t *const thread,
+    yaml_thread_result_t (YAML_THREAD_CALL *func)(void*), void *const arg) {
+  *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+  return *thread != NULL;
+}
+
+static inline void yaml_thread_join(yaml_thread_t const thread) {
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+}
+
+static inline void yaml_thread_yield(void) {
+  SwitchToThread();
+}
+
+static inline bool yaml_mutex_init(yaml_mutex_t *const mutex) {
+  InitializeCriticalSection(mutex);
+  return true;
+}
+
+static inline void yaml_mutex_lock(yaml_mutex_t *const mutex) {
+  EnterCriticalSection(mutex);
+}
+
+static inline void yaml_mutex_unlock(yaml_mutex_t *const mutex) {
+  LeaveCriticalSection(mutex);
+}
+
+static inline void yaml_mutex_destroy(yaml_mutex_t *const mutex) {
+  DeleteCriticalSection(mutex);
+}
+
+static inline size_t yaml_atomic_load(size_t const volatile *const value) {
+  size_t const ret = *value;
+  MemoryBarrier();
+  return ret;
+}
+
+static inline bool yaml_atomic_load_bool(bool const volatile *const value) {
+  bool const ret = *value;
+  MemoryBarrier();
+  return ret;
+}
+
+static inline void yaml_atomic_store(size_t volatile *const value,
+                                     size_t const content) {
+  MemoryBarrier();
+  *value = content;
+}
+#else
+#include <pthread.h>
+#include <sched.h>
+
+typedef pthread_t yaml_thread_t;
+typedef pthread_mutex_t yaml_mutex_t;
+typedef void *yaml_thread_result_t;
+#define YAML_THREAD_CALL
+#define YAML_THREAD_RESULT NULL
+#define YAML_THREAD_LOCAL __thread
+
+static inline bool yaml_thread_start(yaml_thread_t *const thread,
+    yaml_thread_result_t (YAML_THREAD_CALL *func)(void*), void *const arg) {
+  return pthread_create(thread, NULL, func, arg) == 0;
+}
+
+static inline void yaml_thread_join(yaml_thread_t const thread) {
+  pthread_join(thread, NULL);
+}
+
+static inline void yaml_thread_yield(void) {
+  sched_yield();
+}
+
+static inline bool yaml_mutex_init(yaml_mutex_t *const mutex) {
+  return pthread_mutex_init(mutex, NULL) == 0;
+}
+
+static inline void yaml_mutex_lock(yaml_mutex_t *const mutex) {
+  pthread_mutex_lock(mutex);
+}
+
+static inline void yaml_mutex_unlock(yaml_mutex_t *const mutex) {
+  pthread_mutex_unlock(mutex);
+}
+
+static inline void yaml_mutex_destroy(yaml_mutex_t *const mutex) {
+  pthread_mutex_destroy(mutex);
+}
+
+static inline size_t yaml_atomic_load(size_t const volatile *const value) {
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline bool yaml_atomic_load_bool(bool const volatile *const value) {
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void yaml_atomic_store(size_t volatile *const value,
+                                     size_t const content) {
+  __atomic_store_n(value, content, __ATOMIC_RELEASE);
+}
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+#include "batch.h"
+#include <batch_loading.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+#define FILE_COUNT 100
+
+// these files are broken: one is missing, one has a syntax error and one has
+// an invalid value.
+#define MISSING_FILE 17
+#define SYNTAX_ERROR_FILE 42
+#define VALUE_ERROR_FILE 77
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  char names[FILE_COUNT][32];
+  const char *paths[FILE_COUNT];
+  for (size_t i = 0; i < FILE_COUNT; ++i) {
+    sprintf(names[i], "batch_input_%zu.yaml", i);
+    paths[i] = names[i];
+    if (i == MISSING_FILE) {
+      remove(names[i]);
+      continue;
+    }
+    FILE *const file = fopen(names[i], "w");
+    if (file == NULL) {
+      fprintf(stderr, "unable to write %s.\n", names[i]);
+      return 1;
+    }
+    if (i == SYNTAX_ERROR_FILE) {
+      fputs("name: broken\n- id: 1\n", file);
+    } else if (i == VALUE_ERROR_FILE) {
+      fputs("name: wrong\nid: many\nquota: 1.0\n", file);
+    } else {
+      fprintf(file, "name: tenant %zu\nid: %zu\nquota: %zu.5\n", i, i, i);
+    }
+    fclose(file);
+  }
+
+  // numbers must be read independently of the user's locale.
+  setlocale(LC_NUMERIC, "de_DE.UTF-8");
+
+  struct root values[FILE_COUNT];
+  yaml_loader_batch_result_t results[FILE_COUNT];
+  ASSERT_EQUALS_BOOL(false, yaml_load_batch_struct_root(
+      paths, FILE_COUNT, values, results, 4), success);
+  for (size_t i = 0; i < FILE_COUNT; ++i) {
+    switch (i) {
+      case MISSING_FILE:
+        ASSERT_EQUALS_INT(YAML_LOADER_ERROR_FILE, results[i].type, success);
+        break;
+      case SYNTAX_ERROR_FILE:
+        ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, results[i].type, success);
+        ASSERT_EQUALS_SIZE((size_t)1, results[i].mark.line, success);
+        ASSERT_EQUALS_BOOL(true, results[i].problem != NULL, success);
+        break;
+      case VALUE_ERROR_FILE:
+        ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, results[i].type, success);
+        ASSERT_EQUALS_SIZE((size_t)1, results[i].mark.line, success);
+        ASSERT_EQUALS_STRING("int", results[i].expected, success);
+        free(results[i].expected);
+        break;
+      default: {
+        char expected[32];
+        sprintf(expected, "tenant %zu", i);
+        ASSERT_EQUALS_INT(YAML_LOADER_ERROR_NONE, results[i].type, success);
+        if (results[i].type != YAML_LOADER_ERROR_NONE) break;
+        ASSERT_EQUALS_STRING(expected, values[i].name, success);
+        ASSERT_EQUALS_INT((int)i, values[i].id, success);
+        if (values[i].quota != (double)i + 0.5) {
+          fprintf(stderr, "wrong quota in file %zu\n", i);
+          success = false;
+        }
+        yaml_free_struct_root(&values[i]);
+      }
+    }
+    remove(names[i]);
+  }
+
+  return success ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <stdlib.h>
+
+struct root {
+  //!string
+  char *name;
+  int id;
+  double quota;
+};
+
+#endif
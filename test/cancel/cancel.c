@@ -0,0 +1,84 @@
+#include "cancel.h"
+#include <cancel_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#define ENTRY_COUNT 300
+
+static char *render_input(void) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "owner: alice\nentries:\n");
+  for (int i = 0; i < ENTRY_COUNT; ++i) {
+    test_text_append(&input, "- {key: k%d, value: v%d}\n", i, i);
+  }
+  return input.data;
+}
+
+/*
+ * Load the input with the given deadline and cancellation flag. Partially
+ * constructed values must be cleaned up when loading is aborted.
+ */
+static bool load(const char *const input, uint64_t const deadline,
+                 const volatile bool *const cancel, bool const use_tape,
+                 struct root *const value, yaml_loader_error_type_t *error) {
+  yaml_loader_t loader;
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  yaml_loader_set_deadline(&loader, deadline);
+  yaml_loader_set_cancel_flag(&loader, cancel);
+  bool ret;
+  if (use_tape) {
+    yaml_loader_set_threads(&loader, 4);
+    ret = yaml_loader_use_tape(&loader, &tape);
+  } else ret = true;
+  ret = ret && yaml_load_struct_root(value, &loader);
+  *error = loader.error_info.type;
+  yaml_loader_delete(&loader);
+  yaml_tape_delete(&tape);
+  return ret;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  char *const input = render_input();
+  struct root value;
+  yaml_loader_error_type_t error;
+  volatile bool cancel = false;
+
+  ASSERT_EQUALS_BOOL(true, load(input, yaml_loader_clock() + 60000000000u,
+                                &cancel, false, &value, &error), success);
+  ASSERT_EQUALS_SIZE((size_t)ENTRY_COUNT, value.entries.count, success);
+  ASSERT_EQUALS_STRING("v299", value.entries.data[299].value, success);
+  yaml_free_struct_root(&value);
+
+  // a deadline that has already passed.
+  ASSERT_EQUALS_BOOL(false, load(input, 1, NULL, false, &value, &error),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_CANCELLED, error, success);
+
+  cancel = true;
+  ASSERT_EQUALS_BOOL(false, load(input, 0, &cancel, false, &value, &error),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_CANCELLED, error, success);
+
+  // the flag is also seen by the threads constructing list items.
+  ASSERT_EQUALS_BOOL(false, load(input, 0, &cancel, true, &value, &error),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_CANCELLED, error, success);
+
+  cancel = false;
+  ASSERT_EQUALS_BOOL(true, load(input, 0, &cancel, true, &value, &error),
+                     success);
+  ASSERT_EQUALS_SIZE((size_t)ENTRY_COUNT, value.entries.count, success);
+  yaml_free_struct_root(&value);
+
+  free(input);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef _CANCEL_H
+#define _CANCEL_H
+
+#include <stdlib.h>
+
+struct entry {
+  //!string
+  char *key;
+  //!string
+  char *value;
+};
+
+//!list
+struct entry_list {
+  struct entry *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char *owner;
+  struct entry_list entries;
+};
+
+#endif
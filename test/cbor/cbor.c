@@ -0,0 +1,233 @@
+#include "cbor.h"
+#include <cbor_loading.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <yaml_constructor.h>
+#include <yaml_dumper.h>
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char* input =
+    "title: \"Binary \\\"config\\\" \\u00e4\\u00f6\\u00fc\"\n"
+    "short_name: cfg\n"
+    "level: error\n"
+    "verbose: true\n"
+    "limits:\n"
+    "  small: -32768\n"
+    "  min: -9223372036854775808\n"
+    "  max: 18446744073709551615\n"
+    "  ratio: 0.1\n"
+    "  huge: 1e300\n"
+    "  precise: 0.1\n"
+    "retries: 3\n"
+    "shapes:\n"
+    "  - !circle 1.5\n"
+    "  - !polygon [{x: 0, y: 0}, {x: 1, y: -1}]\n"
+    "  - !label 'null'\n"
+    "  - !point\n"
+    "details: {description: loaded}\n";
+
+/*
+ * Written by hand: a self-described map of definite length holding a text
+ * string in chunks, half, single and double precision floats, a tagged
+ * polygon and an empty point, and a map of indefinite length.
+ */
+static const unsigned char encoded[] =
+    "\xd9\xd9\xf7\xa7\x65\x74\x69\x74\x6c\x65\x7f\x63\x61\x62\x63\x62"
+    "\xc3\xa4\xff\x6a\x73\x68\x6f\x72\x74\x5f\x6e\x61\x6d\x65\x62\x69"
+    "\x64\x65\x6c\x65\x76\x65\x6c\x65\x65\x72\x72\x6f\x72\x67\x76\x65"
+    "\x72\x62\x6f\x73\x65\xf5\x66\x6c\x69\x6d\x69\x74\x73\xa6\x65\x73"
+    "\x6d\x61\x6c\x6c\x39\x7f\xff\x63\x6d\x69\x6e\x3b\x7f\xff\xff\xff"
+    "\xff\xff\xff\xff\x63\x6d\x61\x78\x1b\xff\xff\xff\xff\xff\xff\xff"
+    "\xff\x65\x72\x61\x74\x69\x6f\xf9\x3c\x00\x64\x68\x75\x67\x65\xfa"
+    "\x47\xc3\x50\x00\x67\x70\x72\x65\x63\x69\x73\x65\xfb\x3f\xe0\x00"
+    "\x00\x00\x00\x00\x00\x66\x73\x68\x61\x70\x65\x73\x9f\xd8\x1b\x82"
+    "\x66\x63\x69\x72\x63\x6c\x65\xf9\x3e\x00\xd8\x1b\x82\x67\x70\x6f"
+    "\x6c\x79\x67\x6f\x6e\x81\xa2\x61\x78\x20\x61\x79\x18\x64\xd8\x1b"
+    "\x82\x65\x70\x6f\x69\x6e\x74\x60\xff\x67\x64\x65\x74\x61\x69\x6c"
+    "\x73\xbf\x6b\x64\x65\x73\x63\x72\x69\x70\x74\x69\x6f\x6e\x63\x79"
+    "\x65\x73\xff";
+
+static bool equal_roots(const struct root *a, const struct root *b) {
+  if (strcmp(a->title, b->title) != 0 ||
+      a->short_name.len != b->short_name.len ||
+      strncmp(a->short_name.ptr, b->short_name.ptr, a->short_name.len) != 0 ||
+      a->level != b->level || a->verbose != b->verbose ||
+      (a->retries == NULL) != (b->retries == NULL) ||
+      (a->retries != NULL && *a->retries != *b->retries)) {
+    fputs("scalar fields differ\n", stderr);
+    return false;
+  }
+  const struct limits *const x = &a->limits, *const y = &b->limits;
+  if (x->small != y->small || x->min != y->min || x->max != y->max ||
+      x->ratio != y->ratio || x->huge != y->huge || x->precise != y->precise) {
+    fputs("limits differ\n", stderr);
+    return false;
+  }
+  if (a->shapes.count != b->shapes.count) {
+    fputs("shapes differ\n", stderr);
+    return false;
+  }
+  for (size_t i = 0; i < a->shapes.count; i++) {
+    const struct shape *const s = &a->shapes.data[i], *const t =
+        &b->shapes.data[i];
+    bool same = s->kind == t->kind;
+    if (same && s->kind == SHAPE_CIRCLE) same = s->radius == t->radius;
+    if (same && s->kind == SHAPE_LABEL) same = strcmp(s->text, t->text) == 0;
+    if (same && s->kind == SHAPE_POLYGON) {
+      same = s->corners.count == t->corners.count;
+      for (size_t j = 0; same && j < s->corners.count; j++) {
+        same = s->corners.data[j].x == t->corners.data[j].x &&
+               s->corners.data[j].y == t->corners.data[j].y;
+      }
+    }
+    if (!same) {
+      fprintf(stderr, "shape %zu differs\n", i);
+      return false;
+    }
+  }
+  if (yaml_constructor_is_lazy(b->details) ||
+      strcmp(a->details->description, b->details->description) != 0) {
+    fputs("details differ\n", stderr);
+    return false;
+  }
+  return true;
+}
+
+/* dumps the value as CBOR into a buffer owned by the caller. */
+static unsigned char *dump_cbor(const struct root *value, size_t *size) {
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  yaml_dumper_use_cbor(&dumper);
+  unsigned char *result = NULL;
+  if (yaml_dump_struct_root(value, &dumper)) {
+    result = malloc(dumper.size);
+    memcpy(result, dumper.buffer, dumper.size);
+    *size = dumper.size;
+  } else {
+    fprintf(stderr, "dumping failed with error %d\n", (int)dumper.error);
+  }
+  yaml_dumper_delete(&dumper);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_loader_t loader, reloader;
+  struct root original, reloaded;
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  if (!yaml_load_struct_root(&original, &loader)) {
+    fputs("loading the input failed\n", stderr);
+    yaml_loader_delete(&loader);
+    return 1;
+  }
+  yaml_loader_t forcer;
+  ASSERT_EQUALS_BOOL(true, yaml_force_struct_details(&original.details,
+                                                     &forcer), success);
+  yaml_loader_delete(&forcer);
+  size_t first_size, second_size;
+  unsigned char *const first = dump_cbor(&original, &first_size);
+  ASSERT_NOT_NULL(first, success);
+  if (first == NULL) return 1;
+
+  // the binary encoding must load back as the same value ...
+  yaml_loader_init_cbor(&reloader, first, first_size);
+  if (!yaml_load_struct_root(&reloaded, &reloader)) {
+    fprintf(stderr, "loading the CBOR data failed: %s\n",
+            reloader.parser->problem);
+    return 1;
+  }
+  if (!equal_roots(&original, &reloaded)) success = false;
+  // views are copied since they cannot point into binary input.
+  ASSERT_EQUALS_BOOL(false, reloaded.short_name.ptr >= (const char*)first &&
+                     reloaded.short_name.ptr < (const char*)first + first_size,
+                     success);
+  // ... and encode exactly as before.
+  unsigned char *const second = dump_cbor(&reloaded, &second_size);
+  ASSERT_NOT_NULL(second, success);
+  if (second != NULL) {
+    ASSERT_EQUALS_SIZE(first_size, second_size, success);
+    ASSERT_EQUALS_BOOL(true, first_size == second_size &&
+                       memcmp(first, second, first_size) == 0, success);
+    free(second);
+  }
+  yaml_free_struct_root(&reloaded);
+  yaml_loader_delete(&reloader);
+  free(first);
+  yaml_free_struct_root(&original);
+  yaml_loader_delete(&loader);
+
+  // a CBOR sequence holds one document per item.
+  size_t const size = sizeof(encoded) - 1;
+  unsigned char sequence[2 * (sizeof(encoded) - 1)];
+  memcpy(sequence, encoded, size);
+  memcpy(sequence + size, encoded, size);
+  yaml_loader_init_cbor(&loader, sequence, 2 * size);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT,
+                      yaml_load_next_struct_root(&reloaded, &loader), success);
+    if (loader.error_info.type != YAML_LOADER_ERROR_NONE) break;
+    ASSERT_EQUALS_STRING("abc\xc3\xa4", reloaded.title, success);
+    ASSERT_EQUALS_SIZE((size_t)2, reloaded.short_name.len, success);
+    ASSERT_EQUALS_INT(LEVEL_ERROR, reloaded.level, success);
+    ASSERT_EQUALS_BOOL(true, reloaded.verbose, success);
+    ASSERT_EQUALS_INT(-32768, reloaded.limits.small, success);
+    ASSERT_EQUALS_BOOL(true, reloaded.limits.min == -9223372036854775807LL - 1,
+                       success);
+    ASSERT_EQUALS_BOOL(true, reloaded.limits.max == 18446744073709551615ULL,
+                       success);
+    ASSERT_EQUALS_BOOL(true, reloaded.limits.ratio == 1.0f &&
+                       reloaded.limits.huge == 100000.0 &&
+                       reloaded.limits.precise == 0.5, success);
+    ASSERT_NULL(reloaded.retries, success);
+    ASSERT_EQUALS_SIZE((size_t)3, reloaded.shapes.count, success);
+    if (reloaded.shapes.count == 3) {
+      ASSERT_EQUALS_INT(SHAPE_CIRCLE, reloaded.shapes.data[0].kind, success);
+      ASSERT_EQUALS_BOOL(true, reloaded.shapes.data[0].radius == 1.5, success);
+      ASSERT_EQUALS_INT(SHAPE_POLYGON, reloaded.shapes.data[1].kind, success);
+      ASSERT_EQUALS_SIZE((size_t)1, reloaded.shapes.data[1].corners.count,
+                         success);
+      ASSERT_EQUALS_INT(SHAPE_POINT, reloaded.shapes.data[2].kind, success);
+    }
+    ASSERT_EQUALS_STRING("yes", reloaded.details->description, success);
+    yaml_free_struct_root(&reloaded);
+  }
+  ASSERT_EQUALS_INT(YAML_LOADER_END_OF_STREAM,
+                    yaml_load_next_struct_root(&reloaded, &loader), success);
+  yaml_loader_delete(&loader);
+
+  // errors in values are reported at the offset of the offending item.
+  unsigned char *const wrong = sequence;
+  size_t const verbose = 53;
+  ASSERT_EQUALS_INT(0xf5, wrong[verbose], success);
+  wrong[verbose] = 0x01;
+  yaml_loader_init_cbor(&loader, wrong, size);
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&reloaded, &loader),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE(verbose, loader.error_info.event.start_mark.index,
+                     success);
+  yaml_loader_delete(&loader);
+
+  // malformed data is reported through the parser.
+  yaml_loader_init_cbor(&loader, encoded, 80);
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&reloaded, &loader),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, loader.error_info.type, success);
+  ASSERT_EQUALS_STRING("found unexpected end of input",
+                       loader.parser->problem, success);
+  ASSERT_EQUALS_SIZE((size_t)75, loader.parser->problem_mark.index, success);
+  yaml_loader_delete(&loader);
+
+  static const unsigned char epoch[] = "\xc1\x1a\x51\x4b\x67\xb0";
+  yaml_loader_init_cbor(&loader, epoch, sizeof(epoch) - 1);
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&reloaded, &loader),
+                     success);
+  ASSERT_EQUALS_STRING("found unsupported tag", loader.parser->problem,
+                       success);
+  yaml_loader_delete(&loader);
+  return success ? 0 : 1;
+}
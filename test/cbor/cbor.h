@@ -0,0 +1,88 @@
+#ifndef _CBOR_H
+#define _CBOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum level {
+  //!repr debug
+  LEVEL_DEBUG,
+  //!repr error
+  LEVEL_ERROR
+};
+
+struct point {
+  int x, y;
+};
+
+//!list
+struct points {
+  struct point* data;
+  size_t count;
+  size_t capacity;
+};
+
+enum shape_kind {
+  //!repr circle
+  SHAPE_CIRCLE,
+  //!repr polygon
+  SHAPE_POLYGON,
+  //!repr label
+  SHAPE_LABEL,
+  //!repr point
+  SHAPE_POINT
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    double radius;
+    struct points corners;
+    //!string
+    char* text;
+  };
+};
+
+//!list
+struct shapes {
+  struct shape* data;
+  size_t count;
+  size_t capacity;
+};
+
+//!view
+struct name_view {
+  const char *ptr;
+  size_t len;
+};
+
+struct details {
+  //!string
+  char* description;
+};
+
+struct limits {
+  short small;
+  long long min;
+  unsigned long long max;
+  float ratio;
+  double huge;
+  long double precise;
+};
+
+struct root {
+  //!string
+  char* title;
+  struct name_view short_name;
+  enum level level;
+  bool verbose;
+  struct limits limits;
+  //!optional
+  int* retries;
+  struct shapes shapes;
+  //!lazy
+  struct details* details;
+};
+
+#endif
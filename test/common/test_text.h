@@ -0,0 +1,56 @@
+#ifndef _TEST_TEXT_H
+#define _TEST_TEXT_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Text rendered piece by piece, for inputs too large to spell out. data is
+ * NUL-terminated once something has been appended and must be freed. Running
+ * out of memory ends the test.
+ */
+typedef struct {
+  char *data;
+  size_t length, capacity;
+} test_text_t;
+
+static inline void test_text_init(test_text_t *const text) {
+  text->data = NULL;
+  text->length = text->capacity = 0;
+}
+
+/*
+ * Append the string formatted like printf would to the text.
+ */
+static inline void test_text_append(test_text_t *const text,
+                                    const char *const format, ...) {
+  for (;;) {
+    size_t const available = text->capacity - text->length;
+    va_list args;
+    va_start(args, format);
+    int const length = vsnprintf(
+        text->data == NULL ? NULL : text->data + text->length, available,
+        format, args);
+    va_end(args);
+    if (length < 0) {
+      fputs("formatting the test input failed\n", stderr);
+      exit(1);
+    }
+    if ((size_t)length < available) {
+      text->length += (size_t)length;
+      return;
+    }
+    size_t capacity = text->capacity == 0 ? 4096 : text->capacity;
+    while (capacity - text->length <= (size_t)length) capacity *= 2;
+    char *const data = realloc(text->data, capacity);
+    if (data == NULL) {
+      fputs("out of memory while rendering the test input\n", stderr);
+      exit(1);
+    }
+    text->data = data;
+    text->capacity = capacity;
+  }
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "dedup.h"
+#include <dedup_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_constructor.h>
+#include <yaml_loader.h>
+#include <yaml_dumper.h>
+#include <yaml_tape.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#define ITEM_COUNT 1000
+
+static const char *input =
+    "items:\n"
+    "- name: a\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !fixed 3}\n"
+    "  labels: {items: [{key: app, value: web}]}\n"
+    "- name: b\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !fixed 3}\n"
+    "  labels: {items: [{key: app, value: web}]}\n"
+    "- name: c\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !fixed 4}\n"
+    "- name: d\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !ratio 3}\n"
+    "- name: e\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !fixed 3, note: x}\n"
+    "- name: f\n"
+    "  limits: {cpu: 2, memory: 1.5, tier: gold, size: !fixed 3}\n"
+    "  labels: {items: [{key: app, value: db}]}\n"
+    "- name: g\n"
+    "  limits: &l {cpu: 9, memory: 0, tier: silver, size: !ratio 0.5}\n"
+    "- name: h\n"
+    "  limits: *l\n"
+    "- name: i\n"
+    "  limits: {cpu: 9, memory: 0, tier: silver, size: !ratio 0.5}\n";
+
+/*
+ * Streamed items are destroyed after this returns, while later items may
+ * still refer to their limits.
+ */
+bool yaml_handle_struct_item_stream(struct item *const item,
+                                    yaml_loader_t *const loader) {
+  (void)loader;
+  return item->limits->memory == (double)item->limits->cpu;
+}
+
+static bool check_dedup(struct root const *const data) {
+  bool success = true;
+  ASSERT_EQUALS_SIZE((size_t)9, data->items.count, success);
+  if (data->items.count != 9) return false;
+  struct item const *const items = data->items.data;
+  // equal values are the same value.
+  ASSERT_EQUALS_BOOL(true, items[0].limits == items[1].limits, success);
+  ASSERT_EQUALS_BOOL(true, items[0].limits == items[5].limits, success);
+  ASSERT_EQUALS_SIZE((size_t)3, yaml_constructor_shared_refs(items[0].limits),
+                     success);
+  ASSERT_EQUALS_BOOL(true, items[0].labels == items[1].labels, success);
+  ASSERT_EQUALS_SIZE((size_t)2, yaml_constructor_shared_refs(items[0].labels),
+                     success);
+  // values differing anywhere are not.
+  for (size_t i = 2; i < 5; ++i) {
+    ASSERT_EQUALS_BOOL(false, items[i].limits == items[0].limits, success);
+    ASSERT_EQUALS_SIZE((size_t)1,
+                       yaml_constructor_shared_refs(items[i].limits), success);
+  }
+  ASSERT_EQUALS_INT(4, items[2].limits->size.fixed, success);
+  ASSERT_EQUALS_INT(ratio, items[3].limits->size.kind, success);
+  ASSERT_EQUALS_STRING("x", items[4].limits->note, success);
+  ASSERT_EQUALS_BOOL(false, items[5].labels == items[0].labels, success);
+  ASSERT_EQUALS_STRING("db", items[5].labels->items.data[0].value, success);
+  ASSERT_EQUALS_BOOL(true, items[2].labels == NULL, success);
+  // aliases and deduplication agree.
+  ASSERT_EQUALS_BOOL(true, items[6].limits == items[7].limits, success);
+  ASSERT_EQUALS_BOOL(true, items[6].limits == items[8].limits, success);
+  ASSERT_EQUALS_SIZE((size_t)3, yaml_constructor_shared_refs(items[6].limits),
+                     success);
+  ASSERT_EQUALS_INT(silver, items[8].limits->tier, success);
+  return success;
+}
+
+/*
+ * Render an input with ITEM_COUNT items, cycling through three different
+ * limits.
+ */
+static char *render_input(void) {
+  test_text_t rendered;
+  test_text_init(&rendered);
+  test_text_append(&rendered, "items:\n");
+  for (size_t i = 0; i < ITEM_COUNT; ++i) {
+    test_text_append(&rendered, "- name: item %zu\n"
+                     "  limits: {cpu: %zu, memory: 2, tier: gold, "
+                     "size: !fixed 1}\n", i, i % 3);
+  }
+  return rendered.data;
+}
+
+/*
+ * Load the rendered input on the given number of threads and check that
+ * items have at most the given number of distinct limits.
+ */
+static bool check_many(char const *const rendered, unsigned const threads,
+                       size_t const max_distinct) {
+  bool success = true;
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)rendered,
+                          strlen(rendered));
+  yaml_loader_set_threads(&loader, threads);
+  struct root data;
+  if (!yaml_loader_use_tape(&loader, &tape) ||
+      !yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading %zu items.\n", (size_t)ITEM_COUNT);
+    yaml_loader_delete(&loader);
+    yaml_tape_delete(&tape);
+    return false;
+  }
+  yaml_loader_delete(&loader);
+  yaml_tape_delete(&tape);
+  ASSERT_EQUALS_SIZE((size_t)ITEM_COUNT, data.items.count, success);
+  struct limits const *distinct[ITEM_COUNT];
+  size_t distinct_count = 0;
+  for (size_t i = 0; i < data.items.count && success; ++i) {
+    struct limits const *const limits = data.items.data[i].limits;
+    ASSERT_EQUALS_INT((int)(i % 3), limits->cpu, success);
+    size_t j = 0;
+    while (j < distinct_count && distinct[j] != limits) ++j;
+    if (j == distinct_count) distinct[distinct_count++] = limits;
+  }
+  if (distinct_count > max_distinct) {
+    fprintf(stderr, "  %zu distinct limits with %u threads, expected at most "
+            "%zu\n", distinct_count, threads, max_distinct);
+    success = false;
+  }
+  yaml_free_struct_root(&data);
+  return success;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; (void)argv;
+  bool success = true;
+  yaml_loader_t loader;
+  struct root data;
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  if (!yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading YAML.\n");
+    yaml_loader_delete(&loader);
+    return 1;
+  }
+  yaml_loader_delete(&loader);
+  success = check_dedup(&data) && success;
+
+  // deduplicated values are dumped once and then aliased, so they stay
+  // shared when dumping and loading again.
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  ASSERT_EQUALS_BOOL(true, yaml_dump_struct_root(&data, &dumper), success);
+  struct root reloaded;
+  yaml_loader_init_string(&loader, dumper.buffer, dumper.size);
+  if (yaml_load_struct_root(&reloaded, &loader)) {
+    success = check_dedup(&reloaded) && success;
+    yaml_free_struct_root(&reloaded);
+  } else {
+    fprintf(stderr, "error while loading dumped YAML:\n%.*s",
+            (int)dumper.size, (const char*)dumper.buffer);
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+  yaml_dumper_delete(&dumper);
+  yaml_free_struct_root(&data);
+
+  // the loader keeps anchored and deduplicated values alive until the end
+  // of the document, even if the items of a stream have been destroyed.
+  static const char streamed[] =
+      "items: []\n"
+      "stream:\n"
+      "- {name: a, limits: &a {cpu: 1, memory: 1, tier: gold, size: !fixed 1}}\n"
+      "- {name: b, limits: {cpu: 2, memory: 2, tier: gold, size: !fixed 1}}\n"
+      "- {name: c, limits: *a}\n"
+      "- {name: d, limits: {cpu: 2, memory: 2, tier: gold, size: !fixed 1}}\n";
+  yaml_loader_init_string(&loader, (const unsigned char*)streamed,
+                          sizeof(streamed) - 1);
+  if (yaml_load_struct_root(&data, &loader)) {
+    ASSERT_EQUALS_SIZE((size_t)4, data.stream.count, success);
+    yaml_free_struct_root(&data);
+  } else {
+    fprintf(stderr, "error while loading a stream.\n");
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+
+  // threads constructing parts of a list deduplicate among their own values.
+  char *const rendered = render_input();
+  success = check_many(rendered, 1, 3) && success;
+  success = check_many(rendered, 4, 3 * 4) && success;
+  free(rendered);
+  return success ? 0 : 1;
+}
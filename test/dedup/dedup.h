@@ -0,0 +1,84 @@
+#ifndef _DEDUP_H
+#define _DEDUP_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <yaml_loader.h>
+
+enum tier {
+  gold, silver
+};
+
+enum size_kind {
+  fixed, ratio
+};
+
+//!tagged
+struct size {
+  enum size_kind kind;
+  union {
+    int fixed;
+    float ratio;
+  };
+};
+
+//!dedup
+struct limits {
+  int cpu;
+  double memory;
+  enum tier tier;
+  struct size size;
+  //!optional_string
+  char *note;
+};
+
+struct label {
+  //!string
+  char *key;
+  //!string
+  char *value;
+};
+
+//!list
+struct label_list {
+  struct label *data;
+  size_t count;
+  size_t capacity;
+};
+
+//!dedup
+struct labels {
+  struct label_list items;
+};
+
+struct item {
+  //!string
+  char *name;
+  struct limits *limits;
+  //!optional
+  struct labels *labels;
+};
+
+//!list
+struct item_list {
+  struct item *data;
+  size_t count;
+  size_t capacity;
+};
+
+//!stream
+struct item_stream {
+  struct item *data;
+  size_t count, capacity;
+};
+
+bool yaml_handle_struct_item_stream(struct item *const item,
+                                    yaml_loader_t *const loader);
+
+struct root {
+  struct item_list items;
+  //!default
+  struct item_stream stream;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "deep.h"
+#include <deep_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// deep enough to overflow the small stack below when constructed recursively.
+#define DEPTH 2000
+#define THREAD_STACK_SIZE (64 * 1024)
+
+// deep enough to exhaust the separate stack.
+#define EXCESSIVE_DEPTH 200000
+// built by hand, and deallocated on the small stack.
+#define BUILT_DEPTH 1000000
+
+static char *render_input(int const depth) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "name: chain\ntree: ");
+  for (int i = 0; i < depth; ++i) {
+    test_text_append(&input, i == depth - 1 ? "{value: %d" :
+                                              "{value: %d, child: ", i);
+  }
+  for (int i = 0; i < depth; ++i) test_text_append(&input, "}");
+  test_text_append(&input, "\n");
+  return input.data;
+}
+
+static char *render_json(int const depth) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "{\"name\": \"chain\", \"tree\": ");
+  for (int i = 0; i < depth; ++i) {
+    test_text_append(&input, i == depth - 1 ? "{\"value\": %d" :
+                                              "{\"value\": %d, \"child\": ", i);
+  }
+  for (int i = 0; i <= depth; ++i) test_text_append(&input, "}");
+  test_text_append(&input, "\n");
+  return input.data;
+}
+
+static bool run_tests(char *const input) {
+  bool success = true;
+
+  // load twice to reuse the stack kept by the first load.
+  for (int run = 0; run < 2; ++run) {
+    yaml_loader_t loader;
+    yaml_loader_init_string(&loader, (const unsigned char*)input,
+                            strlen(input));
+    struct root value;
+    bool const ret = yaml_load_struct_root(&value, &loader);
+    ASSERT_EQUALS_BOOL(true, ret, success);
+    if (ret) {
+      ASSERT_EQUALS_STRING("chain", value.name, success);
+      size_t depth = 0;
+      bool in_order = true;
+      for (struct node const *node = &value.tree; node != NULL;
+           node = node->child) {
+        if (node->value != (int)depth) in_order = false;
+        ++depth;
+      }
+      ASSERT_EQUALS_SIZE((size_t)DEPTH, depth, success);
+      ASSERT_EQUALS_BOOL(true, in_order, success);
+      yaml_free_struct_root(&value);
+    }
+    yaml_loader_delete(&loader);
+  }
+
+  // an error at the deepest level is cleaned up on the separate stack, too.
+  char *const broken = strstr(input, "{value: 1999");
+  broken[8] = 'x';
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  struct root value;
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&value, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, loader.error_info.type, success);
+  yaml_loader_delete(&loader);
+
+  // input too deep for the separate stack fails instead of overflowing it.
+  // it is JSON, which is recorded in linear time, unlike libyaml's parsing
+  // of deeply nested flow collections.
+  char *const excessive = render_json(EXCESSIVE_DEPTH);
+  yaml_loader_init_string(&loader, (const unsigned char*)excessive,
+                          strlen(excessive));
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&value, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_LIMIT, loader.error_info.type, success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_LIMIT) {
+    ASSERT_EQUALS_STRING("stack_size", loader.error_info.expected, success);
+  }
+  yaml_loader_delete(&loader);
+  free(excessive);
+
+  // deallocating does not recurse, so values of any depth are deallocated
+  // on the thread's small stack.
+  value.name = malloc(sizeof("built"));
+  strcpy(value.name, "built");
+  value.tree.value = 0;
+  value.tree.child = NULL;
+  struct node **next = &value.tree.child;
+  for (int i = 1; i < BUILT_DEPTH; ++i) {
+    struct node *const node = malloc(sizeof(struct node));
+    if (node == NULL) break;
+    node->value = i;
+    node->child = NULL;
+    *next = node;
+    next = &node->child;
+  }
+  yaml_free_struct_root(&value);
+
+  yaml_loader_pool_clear();
+  return success;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI test_thread(LPVOID arg) {
+  return run_tests((char*)arg) ? 0 : 1;
+}
+#else
+static void *test_thread(void *arg) {
+  return run_tests((char*)arg) ? arg : NULL;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  char *const input = render_input(DEPTH);
+  // run on a thread with a small stack, like a worker thread of a server.
+#ifdef _WIN32
+  HANDLE const thread = CreateThread(NULL, THREAD_STACK_SIZE, &test_thread,
+      input, STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
+  WaitForSingleObject(thread, INFINITE);
+  DWORD result;
+  GetExitCodeThread(thread, &result);
+  CloseHandle(thread);
+  bool const success = result == 0;
+#else
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+  pthread_t thread;
+  pthread_create(&thread, &attr, &test_thread, input);
+  pthread_attr_destroy(&attr);
+  void *result;
+  pthread_join(thread, &result);
+  bool const success = result != NULL;
+#endif
+  free(input);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#ifndef _DEEP_H
+#define _DEEP_H
+
+#include <stdlib.h>
+
+struct node {
+  int value;
+  //!optional
+  struct node *child;
+};
+
+struct root {
+  //!string
+  char *name;
+  struct node tree;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "documents.h"
+#include <documents_loading.h>
+#include <stdbool.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char* input =
+    "host: alpha\n"
+    "port: 1\n"
+    "---\n"
+    "host: beta\n"
+    "port: 2\n"
+    "---\n"
+    "host: gamma\n"
+    "port: 3\n";
+
+struct totals {
+  int documents, ports;
+};
+
+static bool sum_up(struct root *value, void *context) {
+  struct totals *const totals = (struct totals*)context;
+  totals->documents++;
+  totals->ports += value->port;
+  yaml_free_struct_root(value);
+  return true;
+}
+
+static bool stop_early(struct root *value, void *context) {
+  (*(int*)context)++;
+  yaml_free_struct_root(value);
+  return false;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_loader_t loader;
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  struct totals totals = {0, 0};
+  bool ret = yaml_load_all_struct_root(&loader, &sum_up, &totals);
+  yaml_loader_delete(&loader);
+  ASSERT_EQUALS_BOOL(true, ret, success);
+  ASSERT_EQUALS_INT(3, totals.documents, success);
+  ASSERT_EQUALS_INT(6, totals.ports, success);
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  int calls = 0;
+  ret = yaml_load_all_struct_root(&loader, &stop_early, &calls);
+  yaml_loader_delete(&loader);
+  ASSERT_EQUALS_BOOL(true, ret, success);
+  ASSERT_EQUALS_INT(1, calls, success);
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  static const char *hosts[] = {"alpha", "beta", "gamma"};
+  struct root data;
+  int count = 0;
+  yaml_loader_status_t status;
+  while ((status = yaml_load_next_struct_root(&data, &loader)) ==
+         YAML_LOADER_DOCUMENT) {
+    if (count < 3) ASSERT_EQUALS_STRING(hosts[count], data.host, success);
+    yaml_free_struct_root(&data);
+    count++;
+  }
+  ASSERT_EQUALS_INT(YAML_LOADER_END_OF_STREAM, status, success);
+  ASSERT_EQUALS_INT(3, count, success);
+  ASSERT_EQUALS_INT(YAML_LOADER_END_OF_STREAM,
+                    yaml_load_next_struct_root(&data, &loader), success);
+  yaml_loader_delete(&loader);
+
+  return success ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#ifndef _DOCUMENTS_H
+#define _DOCUMENTS_H
+
+struct root {
+  //!string
+  char *host;
+  int port;
+};
+
+#endif
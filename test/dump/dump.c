@@ -0,0 +1,243 @@
+#include "dump.h"
+#include <dump_loading.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <yaml_dumper.h>
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char* input =
+    "title: \"Dumped \\\"config\\\"?\\nsecond line: \\u00e4\\u00f6\\u00fc\\t\"\n"
+    "short_name: cfg\n"
+    "level: error\n"
+    "verbose: true\n"
+    "separator: ':'\n"
+    "limits:\n"
+    "  small: -32768\n"
+    "  min: -9223372036854775808\n"
+    "  max: 18446744073709551615\n"
+    "  byte: 255\n"
+    "  ratio: 0.1\n"
+    "  tiny: -2.5e-300\n"
+    "  huge: 1e300\n"
+    "  precise: 0.1\n"
+    "  infinite: .inf\n"
+    "  negative: -.Inf\n"
+    "  missing: .NaN\n"
+    "options:\n"
+    "  retries: 3\n"
+    "texts:\n"
+    "  - value: plain text\n"
+    "  - value: 'true'\n"
+    "  - value: '123'\n"
+    "  - value: 'key: value'\n"
+    "  - value: ''\n"
+    "  - value: ' padded '\n"
+    "  - value: '- dash'\n"
+    "  - value: \"control \\x01 \\u2028\"\n"
+    "shapes:\n"
+    "  - !circle 1.5\n"
+    "  - !square 4\n"
+    "  - !polygon [{x: 0, y: 0}, {x: 1, y: -1}]\n"
+    "  - !polygon []\n"
+    "  - !label 'null'\n"
+    "  - !point\n"
+    "grid: [[1, 2], [], [3]]\n"
+    "empty: []\n";
+
+static bool equal_numbers(const struct numbers *a, const struct numbers *b) {
+  if (a->count != b->count) return false;
+  for (size_t i = 0; i < a->count; i++) {
+    if (a->data[i] != b->data[i]) return false;
+  }
+  return true;
+}
+
+static bool equal_shapes(const struct shapes *a, const struct shapes *b) {
+  if (a->count != b->count) return false;
+  for (size_t i = 0; i < a->count; i++) {
+    const struct shape *const x = &a->data[i], *const y = &b->data[i];
+    if (x->kind != y->kind) return false;
+    switch (x->kind) {
+      case SHAPE_CIRCLE:
+        if (x->radius != y->radius) return false;
+        break;
+      case SHAPE_SQUARE:
+        if (*x->side != *y->side) return false;
+        break;
+      case SHAPE_POLYGON:
+        if (x->corners.count != y->corners.count) return false;
+        for (size_t j = 0; j < x->corners.count; j++) {
+          if (x->corners.data[j].x != y->corners.data[j].x ||
+              x->corners.data[j].y != y->corners.data[j].y) return false;
+        }
+        break;
+      case SHAPE_LABEL:
+        if (strcmp(x->text, y->text) != 0) return false;
+        break;
+      case SHAPE_POINT:
+        break;
+    }
+  }
+  return true;
+}
+
+static bool equal_roots(const struct root *a, const struct root *b) {
+  if (strcmp(a->title, b->title) != 0 ||
+      a->short_name.len != b->short_name.len ||
+      strncmp(a->short_name.ptr, b->short_name.ptr, a->short_name.len) != 0 ||
+      a->level != b->level ||
+      a->verbose != b->verbose || a->separator != b->separator) {
+    fputs("scalar fields differ\n", stderr);
+    return false;
+  }
+  const struct limits *const x = &a->limits, *const y = &b->limits;
+  if (x->small != y->small || x->min != y->min || x->max != y->max ||
+      x->byte != y->byte || x->ratio != y->ratio || x->tiny != y->tiny ||
+      x->huge != y->huge || x->precise != y->precise ||
+      x->infinite != y->infinite || x->negative != y->negative ||
+      isnan(x->missing) != isnan(y->missing)) {
+    fputs("limits differ\n", stderr);
+    return false;
+  }
+  if ((a->options->retries == NULL) != (b->options->retries == NULL) ||
+      (a->options->retries != NULL &&
+       *a->options->retries != *b->options->retries) ||
+      (a->options->comment == NULL) != (b->options->comment == NULL) ||
+      (a->fallback == NULL) != (b->fallback == NULL)) {
+    fputs("optional fields differ\n", stderr);
+    return false;
+  }
+  if (a->texts.count != b->texts.count) {
+    fputs("texts differ\n", stderr);
+    return false;
+  }
+  for (size_t i = 0; i < a->texts.count; i++) {
+    if (strcmp(a->texts.data[i].value, b->texts.data[i].value) != 0) {
+      fprintf(stderr, "text %zu differs\n", i);
+      return false;
+    }
+  }
+  if (!equal_shapes(&a->shapes, &b->shapes)) {
+    fputs("shapes differ\n", stderr);
+    return false;
+  }
+  if (a->grid.count != b->grid.count || !equal_numbers(&a->empty, &b->empty)) {
+    fputs("lists differ\n", stderr);
+    return false;
+  }
+  for (size_t i = 0; i < a->grid.count; i++) {
+    if (!equal_numbers(&a->grid.data[i], &b->grid.data[i])) {
+      fputs("grid differs\n", stderr);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* dumps the value into a null-terminated string owned by the caller. */
+static char *dump(const struct root *value) {
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  char *result = NULL;
+  if (yaml_dump_struct_root(value, &dumper)) {
+    result = malloc(dumper.size + 1);
+    memcpy(result, dumper.buffer, dumper.size);
+    result[dumper.size] = '\0';
+  } else {
+    fprintf(stderr, "dumping failed with error %d\n", (int)dumper.error);
+  }
+  yaml_dumper_delete(&dumper);
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_loader_t loader, reloader;
+  struct root original, reloaded;
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  if (!yaml_load_struct_root(&original, &loader)) {
+    fputs("loading the input failed\n", stderr);
+    yaml_loader_delete(&loader);
+    return 1;
+  }
+  char *const first = dump(&original);
+  ASSERT_NOT_NULL(first, success);
+  if (first == NULL) return 1;
+  // infinity and not-a-number are written in the form YAML reads.
+  ASSERT_NOT_NULL(strstr(first, "infinite: .inf\n"), success);
+  ASSERT_NOT_NULL(strstr(first, "negative: -.inf\n"), success);
+  ASSERT_NOT_NULL(strstr(first, "missing: .nan\n"), success);
+
+  // the dumped document must load back as the same value ...
+  yaml_loader_init_string(&reloader, (const unsigned char*)first,
+                          strlen(first));
+  if (!yaml_load_struct_root(&reloaded, &reloader)) {
+    fprintf(stderr, "loading the dumped document failed:\n%s", first);
+    return 1;
+  }
+  if (!equal_roots(&original, &reloaded)) {
+    fprintf(stderr, "dumped document:\n%s", first);
+    success = false;
+  }
+  // ... and dump exactly as before.
+  char *const second = dump(&reloaded);
+  ASSERT_NOT_NULL(second, success);
+  if (second != NULL) {
+    ASSERT_EQUALS_STRING(first, second, success);
+    free(second);
+  }
+  yaml_free_struct_root(&reloaded);
+  yaml_loader_delete(&reloader);
+
+  // several documents dumped to a file are separated and load one by one.
+  FILE *const file = tmpfile();
+  ASSERT_NOT_NULL(file, success);
+  if (file != NULL) {
+    yaml_dumper_t dumper;
+    yaml_dumper_init_file(&dumper, file);
+    ASSERT_EQUALS_BOOL(true, yaml_dump_struct_root(&original, &dumper),
+                       success);
+    ASSERT_EQUALS_BOOL(true, yaml_dump_struct_root(&original, &dumper),
+                       success);
+    ASSERT_EQUALS_BOOL(true, yaml_dumper_flush(&dumper), success);
+    ASSERT_EQUALS_SIZE((size_t)2, dumper.documents, success);
+    yaml_dumper_delete(&dumper);
+    rewind(file);
+    yaml_loader_init_file(&reloader, file);
+    int count = 0;
+    yaml_loader_status_t status;
+    while ((status = yaml_load_next_struct_root(&reloaded, &reloader)) ==
+           YAML_LOADER_DOCUMENT) {
+      count++;
+      if (!equal_roots(&original, &reloaded)) success = false;
+      yaml_free_struct_root(&reloaded);
+    }
+    ASSERT_EQUALS_INT(YAML_LOADER_END_OF_STREAM, status, success);
+    ASSERT_EQUALS_INT(2, count, success);
+    yaml_loader_delete(&reloader);
+    fclose(file);
+  }
+
+  // values that have no YAML representation make the dumper fail.
+  unsigned *const side = original.shapes.data[1].side;
+  original.shapes.data[1].side = NULL;
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  ASSERT_EQUALS_BOOL(false, yaml_dump_struct_root(&original, &dumper),
+                     success);
+  ASSERT_EQUALS_INT(YAML_DUMPER_ERROR_VALUE, dumper.error, success);
+  ASSERT_EQUALS_STRING("unsigned", dumper.error_type, success);
+  yaml_dumper_delete(&dumper);
+  original.shapes.data[1].side = side;
+
+  free(first);
+  yaml_free_struct_root(&original);
+  yaml_loader_delete(&loader);
+  return success ? 0 : 1;
+}
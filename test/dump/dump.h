@@ -0,0 +1,129 @@
+#ifndef _DUMP_H
+#define _DUMP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum level {
+  //!repr debug
+  LEVEL_DEBUG,
+  //!repr info
+  LEVEL_INFO,
+  //!repr error
+  LEVEL_ERROR
+};
+
+//!list
+struct numbers {
+  long long* data;
+  size_t count;
+  size_t capacity;
+};
+
+//!list
+struct grid {
+  struct numbers* data;
+  size_t count;
+  size_t capacity;
+};
+
+struct point {
+  int x, y;
+};
+
+//!list
+struct points {
+  struct point* data;
+  size_t count;
+  size_t capacity;
+};
+
+enum shape_kind {
+  //!repr circle
+  SHAPE_CIRCLE,
+  //!repr square
+  SHAPE_SQUARE,
+  //!repr polygon
+  SHAPE_POLYGON,
+  //!repr label
+  SHAPE_LABEL,
+  //!repr point
+  SHAPE_POINT
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    double radius;
+    unsigned* side;
+    struct points corners;
+    //!string
+    char* text;
+  };
+};
+
+//!list
+struct shapes {
+  struct shape* data;
+  size_t count;
+  size_t capacity;
+};
+
+struct text {
+  //!string
+  char* value;
+};
+
+//!list
+struct texts {
+  struct text* data;
+  size_t count;
+  size_t capacity;
+};
+
+//!view
+struct name_view {
+  const char *ptr;
+  size_t len;
+};
+
+struct options {
+  //!optional
+  int* retries;
+  //!optional_string
+  char* comment;
+};
+
+struct limits {
+  short small;
+  long long min;
+  unsigned long long max;
+  unsigned char byte;
+  float ratio;
+  double tiny;
+  double huge;
+  long double precise;
+  double infinite;
+  float negative;
+  double missing;
+};
+
+struct root {
+  //!string
+  char* title;
+  struct name_view short_name;
+  enum level level;
+  bool verbose;
+  char separator;
+  struct limits limits;
+  struct options* options;
+  //!optional
+  struct options* fallback;
+  struct texts texts;
+  struct shapes shapes;
+  struct grid grid;
+  struct numbers empty;
+};
+
+#endif
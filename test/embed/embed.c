@@ -0,0 +1,68 @@
+#include "embed.h"
+#include <embed_loading.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <../common/test_common.h>
+
+int main(int argc, char* argv[]) {
+  // the value has been embedded at generation time; nothing is loaded here.
+  const struct root *const data = &yaml_embedded_struct_root;
+  static const char* level_repr[] = {"LEVEL_DEBUG", "LEVEL_INFO", "LEVEL_ERROR"};
+  static const char* kind_repr[] =
+      {"SHAPE_CIRCLE", "SHAPE_SQUARE", "SHAPE_POINT"};
+  bool success = true;
+  ASSERT_EQUALS_STRING("Embedded \"config\"?\nsecond line: \xc3\xa4\xc3\xb6\xc3\xbc",
+                       data->title, success);
+  ASSERT_EQUALS_SIZE((size_t)3, data->short_name.len, success);
+  if (strncmp("cfg", data->short_name.ptr, 3) != 0) {
+    fputs("wrong value for \"data->short_name\"\n", stderr);
+    success = false;
+  }
+  ASSERT_EQUALS_ENUM(LEVEL_ERROR, data->level, success, level_repr);
+  ASSERT_EQUALS_BOOL(true, data->verbose, success);
+  ASSERT_EQUALS_CHAR(';', data->separator, success);
+  // floating point values must be exactly what the runtime would construct.
+  if (data->ratio != strtof("0.1", NULL) ||
+      data->scale != strtod("-2.5e-3", NULL)) {
+    fputs("wrong floating point values\n", stderr);
+    success = false;
+  }
+
+  ASSERT_NOT_NULL(data->primary, success);
+  ASSERT_EQUALS_STRING("example.org", data->primary->host, success);
+  ASSERT_EQUALS_INT(443, (int)data->primary->port, success);
+  ASSERT_NULL(data->primary->user, success);
+
+  ASSERT_EQUALS_SIZE((size_t)2, data->mirrors.count, success);
+  ASSERT_EQUALS_STRING("example.org", data->mirrors.data[0].host, success);
+  ASSERT_EQUALS_INT(443, (int)data->mirrors.data[0].port, success);
+  ASSERT_EQUALS_STRING("mirror.example.org", data->mirrors.data[1].host,
+                       success);
+  ASSERT_EQUALS_INT(8080, (int)data->mirrors.data[1].port, success);
+  ASSERT_NOT_NULL(data->mirrors.data[1].user, success);
+  ASSERT_EQUALS_STRING("anonymous", data->mirrors.data[1].user, success);
+
+  ASSERT_EQUALS_SIZE((size_t)3, data->shapes.count, success);
+  ASSERT_EQUALS_ENUM(SHAPE_CIRCLE, data->shapes.data[0].kind, success,
+                     kind_repr);
+  ASSERT_EQUALS_FLOAT(1.5, data->shapes.data[0].radius, success);
+  ASSERT_EQUALS_ENUM(SHAPE_SQUARE, data->shapes.data[1].kind, success,
+                     kind_repr);
+  ASSERT_NOT_NULL(data->shapes.data[1].side, success);
+  ASSERT_EQUALS_INT(4, (int)*data->shapes.data[1].side, success);
+  ASSERT_EQUALS_ENUM(SHAPE_POINT, data->shapes.data[2].kind, success,
+                     kind_repr);
+
+  ASSERT_EQUALS_SIZE((size_t)3, data->limits.count, success);
+  if (data->limits.data[0] != LLONG_MIN || data->limits.data[1] != 0 ||
+      data->limits.data[2] != LLONG_MAX) {
+    fputs("wrong value for \"data->limits\"\n", stderr);
+    success = false;
+  }
+  ASSERT_EQUALS_SIZE((size_t)0, data->unused.count, success);
+  ASSERT_NULL(data->unused.data, success);
+  ASSERT_NULL(data->fallback, success);
+  return success ? 0 : 1;
+}
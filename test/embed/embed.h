@@ -0,0 +1,88 @@
+#ifndef _EMBED_H
+#define _EMBED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+enum level {
+  //!repr debug
+  LEVEL_DEBUG,
+  //!repr info
+  LEVEL_INFO,
+  //!repr error
+  LEVEL_ERROR
+};
+
+enum shape_kind {
+  //!repr circle
+  SHAPE_CIRCLE,
+  //!repr square
+  SHAPE_SQUARE,
+  //!repr point
+  SHAPE_POINT
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    double radius;
+    unsigned* side;
+  };
+};
+
+//!list
+struct shapes {
+  struct shape* data;
+  size_t count;
+  size_t capacity;
+};
+
+//!view
+struct name_view {
+  const char *ptr;
+  size_t len;
+};
+
+struct endpoint {
+  //!string
+  char* host;
+  unsigned short port;
+  //!optional_string
+  char* user;
+};
+
+//!list
+struct endpoints {
+  struct endpoint* data;
+  size_t count;
+  size_t capacity;
+};
+
+//!list
+struct numbers {
+  long long* data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char* title;
+  struct name_view short_name;
+  enum level level;
+  bool verbose;
+  char separator;
+  float ratio;
+  double scale;
+  struct endpoint* primary;
+  struct endpoints mirrors;
+  struct shapes shapes;
+  struct numbers limits;
+  //!default
+  struct numbers unused;
+  //!optional
+  struct endpoint* fallback;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "hash.h"
+#include <hash_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_constructor.h>
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char *base =
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 1}]\n";
+
+// equal to base, but written differently outside of the lazy subtree.
+static const char *reformatted =
+    "name: 'a'\n"
+    "version: \"1.2\"\n"
+    "points:\n"
+    "- {x: -0.0, y: NAN}\n"
+    "- x: 1.50\n"
+    "  y: 2e0\n"
+    "shape: !circle 2.0\n"
+    "path: [{x: 1, y: 1}]\n";
+
+// each differs from base in one place.
+static const char *changed[] = {
+    "name: b\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.3\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2.5}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}, {x: 0, y: 0}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "shape: !square 2\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "path: [{x: 1, y: 1}]\n",
+    "name: a\n"
+    "version: 1.2\n"
+    "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+    "shape: !circle 2\n"
+    "path: [{x: 1, y: 2}]\n"
+};
+
+bool yaml_construct_struct_version(struct version *const value,
+                                   yaml_loader_t *const loader,
+                                   yaml_event_t *cur) {
+  if (cur->type != YAML_SCALAR_EVENT) {
+    loader->error_info.type = YAML_LOADER_ERROR_STRUCTURAL;
+    loader->error_info.event = *cur;
+    loader->error_info.expected_event_type = YAML_SCALAR_EVENT;
+    return false;
+  }
+  if (sscanf((const char*)cur->data.scalar.value, "%u.%u", &value->major,
+             &value->minor) != 2) {
+    loader->error_info.type = YAML_LOADER_ERROR_VALUE;
+    loader->error_info.event = *cur;
+    return false;
+  }
+  return true;
+}
+
+void yaml_delete_struct_version(struct version *const value) {}
+
+uint64_t yaml_hash_struct_version(const struct version *const value,
+                                  uint64_t hash) {
+  hash = yaml_hash_unsigned(&value->major, hash);
+  return yaml_hash_unsigned(&value->minor, hash);
+}
+
+bool yaml_equal_struct_version(const struct version *const left,
+                               const struct version *const right) {
+  return left->major == right->major && left->minor == right->minor;
+}
+
+bool yaml_construct_struct_opaque(struct opaque *const value,
+                                  yaml_loader_t *const loader,
+                                  yaml_event_t *cur) {
+  return yaml_construct_int(&value->value, loader, cur);
+}
+
+void yaml_delete_struct_opaque(struct opaque *const value) {}
+
+static bool load(const char *const input, struct root *const data) {
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  bool const ret = yaml_load_struct_root(data, &loader);
+  yaml_loader_delete(&loader);
+  if (!ret) fprintf(stderr, "error while loading:\n%s", input);
+  return ret;
+}
+
+static bool force_path(struct root *const data) {
+  yaml_loader_t loader;
+  bool const ret = yaml_force_struct_point_list(&data->path, &loader);
+  yaml_loader_delete(&loader);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  bool success = true;
+  struct root expected, actual;
+  if (!load(base, &expected)) return 1;
+  ASSERT_EQUALS_BOOL(true, yaml_equal_struct_root(&expected, &expected),
+                     success);
+
+  if (!load(reformatted, &actual)) return 1;
+  ASSERT_EQUALS_BOOL(true, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  ASSERT_EQUALS_BOOL(true, yaml_hash_struct_root(&expected, 0) ==
+                     yaml_hash_struct_root(&actual, 0), success);
+  yaml_free_struct_root(&actual);
+
+  uint64_t const base_hash = yaml_hash_struct_root(&expected, 0);
+  for (size_t i = 0; i < sizeof(changed) / sizeof(char*); ++i) {
+    if (!load(changed[i], &actual)) return 1;
+    if (yaml_equal_struct_root(&expected, &actual) ||
+        yaml_hash_struct_root(&actual, 0) == base_hash) {
+      fprintf(stderr, "  not detected as changed:\n%s", changed[i]);
+      success = false;
+    }
+    yaml_free_struct_root(&actual);
+  }
+
+  // lazy subtrees are compared by their text until they are constructed.
+  if (!load("name: a\n"
+            "version: 1.2\n"
+            "points: [{x: 0, y: nan}, {x: 1.5, y: 2}]\n"
+            "shape: !circle 2\n"
+            "path:\n"
+            "- x: 1\n"
+            "  y: 1\n", &actual)) return 1;
+  ASSERT_EQUALS_BOOL(false, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  ASSERT_EQUALS_BOOL(true, force_path(&expected), success);
+  ASSERT_EQUALS_BOOL(false, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  ASSERT_EQUALS_BOOL(true, force_path(&actual), success);
+  ASSERT_EQUALS_BOOL(true, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  ASSERT_EQUALS_BOOL(true, yaml_hash_struct_root(&expected, 0) ==
+                     yaml_hash_struct_root(&actual, 0), success);
+  yaml_free_struct_root(&actual);
+  yaml_free_struct_root(&expected);
+
+  // custom types without hash and equality functions are only equal to
+  // themselves.
+  static const char *with_extra =
+      "name: a\n"
+      "version: 1.2\n"
+      "points: []\n"
+      "path: []\n"
+      "extra: {opaque: 1}\n";
+  if (!load(with_extra, &expected)) return 1;
+  if (!load(with_extra, &actual)) return 1;
+  ASSERT_EQUALS_BOOL(true, yaml_equal_struct_root(&expected, &expected),
+                     success);
+  ASSERT_EQUALS_BOOL(false, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  yaml_free_struct_root(&actual);
+  yaml_free_struct_root(&expected);
+
+  // size_t values are hashed and compared as size_t.
+  if (!load("{name: a, version: 1.2, points: [], path: [], limit: 3}",
+            &expected)) return 1;
+  if (!load("{name: a, version: 1.2, points: [], path: [], limit: '3'}",
+            &actual)) return 1;
+  ASSERT_EQUALS_BOOL(true, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  ASSERT_EQUALS_BOOL(true, yaml_hash_struct_root(&expected, 0) ==
+                     yaml_hash_struct_root(&actual, 0), success);
+  yaml_free_struct_root(&actual);
+  if (!load("{name: a, version: 1.2, points: [], path: [], "
+            "limit: 4294967299}", &actual)) return 1;
+  ASSERT_EQUALS_BOOL(false, yaml_equal_struct_root(&expected, &actual),
+                     success);
+  yaml_free_struct_root(&actual);
+  yaml_free_struct_root(&expected);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <yaml_loader.h>
+
+//!custom
+struct version {
+  unsigned major, minor;
+};
+
+bool yaml_construct_struct_version(struct version *const value,
+                                   yaml_loader_t *const loader,
+                                   yaml_event_t *cur);
+void yaml_delete_struct_version(struct version *const value);
+uint64_t yaml_hash_struct_version(const struct version *const value,
+                                  uint64_t hash);
+bool yaml_equal_struct_version(const struct version *const left,
+                               const struct version *const right);
+
+//!custom
+struct opaque {
+  int value;
+};
+
+bool yaml_construct_struct_opaque(struct opaque *const value,
+                                  yaml_loader_t *const loader,
+                                  yaml_event_t *cur);
+void yaml_delete_struct_opaque(struct opaque *const value);
+
+enum shape_kind {
+  circle, square
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    float radius;
+    int side;
+  };
+};
+
+struct point {
+  double x, y;
+};
+
+//!list
+struct point_list {
+  struct point *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct extra {
+  struct opaque opaque;
+};
+
+struct root {
+  //!string
+  char *name;
+  struct version version;
+  struct point_list points;
+  //!optional
+  struct shape *shape;
+  //!lazy
+  struct point_list *path;
+  //!optional
+  struct extra *extra;
+  //!optional
+  size_t *limit;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "into.h"
+#include <into_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char *input =
+    "name: app\n"
+    "services:\n"
+    "- name: web\n"
+    "  limits: {cpu: 2, memory: 4}\n"
+    "  ports: [80, 443]\n"
+    "- name: db\n"
+    "  ports: [5432]\n"
+    "shape: !label hello\n";
+
+static const char *grown =
+    "name: application\n"
+    "services:\n"
+    "- name: web\n"
+    "  limits: {cpu: 2, memory: 4}\n"
+    "  ports: [80, 443, 8080]\n"
+    "- name: db\n"
+    "  limits: {cpu: 4, memory: 16}\n"
+    "  ports: [5432]\n"
+    "- name: cache\n"
+    "  ports: [6379]\n"
+    "shape: !circle 2\n";
+
+/*
+ * Collect the heap buffers of the given value into buffers, which must be
+ * large enough, and return their count.
+ */
+static size_t collect(struct root const *const data, void **const buffers) {
+  size_t count = 0;
+  buffers[count++] = data->name;
+  buffers[count++] = data->services.data;
+  for (size_t i = 0; i < data->services.count; ++i) {
+    struct service const *const service = &data->services.data[i];
+    buffers[count++] = service->name;
+    if (service->limits != NULL) buffers[count++] = service->limits;
+    buffers[count++] = service->ports.data;
+  }
+  if (data->shape.kind == label) buffers[count++] = data->shape.text;
+  return count;
+}
+
+static bool load_into(struct root *const data, yaml_loader_t *const loader,
+                      const char *const text) {
+  yaml_loader_reset_string(loader, (const unsigned char*)text, strlen(text));
+  bool const ret = yaml_load_into_struct_root(data, loader);
+  if (!ret) fprintf(stderr, "error while loading into value:\n%s", text);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  bool success = true;
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  struct root data;
+  if (!yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading YAML doc.\n");
+    return 1;
+  }
+  void *old[16], *reused[16];
+  size_t const old_count = collect(&data, old);
+
+  // loading the same document again needs no new buffers.
+  for (int round = 0; round < 3; ++round) {
+    if (!load_into(&data, &loader, input)) return 1;
+    size_t const count = collect(&data, reused);
+    ASSERT_EQUALS_SIZE(old_count, count, success);
+    for (size_t i = 0; i < count; ++i) {
+      bool found = false;
+      for (size_t j = 0; j < old_count; ++j) found |= reused[i] == old[j];
+      if (!found) {
+        fprintf(stderr, "  buffer %zu has not been reused.\n", i);
+        success = false;
+      }
+    }
+    ASSERT_EQUALS_STRING("app", data.name, success);
+    ASSERT_EQUALS_SIZE((size_t)2, data.services.count, success);
+    ASSERT_EQUALS_STRING("web", data.services.data[0].name, success);
+    ASSERT_EQUALS_INT(4, data.services.data[0].limits->memory, success);
+    ASSERT_EQUALS_INT(443, data.services.data[0].ports.data[1], success);
+    ASSERT_EQUALS_STRING("db", data.services.data[1].name, success);
+    ASSERT_EQUALS_BOOL(true, data.services.data[1].limits == NULL, success);
+    ASSERT_EQUALS_STRING("hello", data.shape.text, success);
+  }
+
+  // larger values allocate what cannot be reused.
+  if (!load_into(&data, &loader, grown)) return 1;
+  ASSERT_EQUALS_STRING("application", data.name, success);
+  ASSERT_EQUALS_SIZE((size_t)3, data.services.count, success);
+  ASSERT_EQUALS_INT(8080, data.services.data[0].ports.data[2], success);
+  ASSERT_EQUALS_INT(16, data.services.data[1].limits->memory, success);
+  ASSERT_EQUALS_STRING("cache", data.services.data[2].name, success);
+  ASSERT_EQUALS_INT(6379, data.services.data[2].ports.data[0], success);
+  ASSERT_EQUALS_INT(circle, data.shape.kind, success);
+  ASSERT_EQUALS_INT(2, data.shape.radius, success);
+
+  // smaller ones free the buffers that are left over.
+  if (!load_into(&data, &loader, input)) return 1;
+  ASSERT_EQUALS_STRING("app", data.name, success);
+  ASSERT_EQUALS_SIZE((size_t)2, data.services.count, success);
+  ASSERT_EQUALS_STRING("hello", data.shape.text, success);
+
+  // on failure, the old value is gone and there is nothing left to free.
+  static const char *broken = "name: [broken]\n";
+  yaml_loader_reset_string(&loader, (const unsigned char*)broken,
+                           strlen(broken));
+  ASSERT_EQUALS_BOOL(false, yaml_load_into_struct_root(&data, &loader),
+                     success);
+  yaml_loader_reset_string(&loader, (const unsigned char*)input,
+                           strlen(input));
+  if (!yaml_load_struct_root(&data, &loader)) return 1;
+  ASSERT_EQUALS_STRING("web", data.services.data[0].name, success);
+  yaml_free_struct_root(&data);
+  yaml_loader_delete(&loader);
+  return success ? 0 : 1;
+}
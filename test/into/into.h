@@ -0,0 +1,55 @@
+#ifndef _INTO_H
+#define _INTO_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+struct limits {
+  int cpu;
+  int memory;
+};
+
+//!list
+struct port_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct service {
+  //!string
+  char *name;
+  //!optional
+  struct limits *limits;
+  struct port_list ports;
+};
+
+//!list
+struct service_list {
+  struct service *data;
+  size_t count;
+  size_t capacity;
+};
+
+enum shape_kind {
+  circle, label
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    int radius;
+    //!string
+    char *text;
+  };
+};
+
+struct root {
+  //!string
+  char *name;
+  struct service_list services;
+  struct shape shape;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "json.h"
+#include <json_loading.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <yaml_loader.h>
+#include <yaml_tape.h>
+#include <../common/test_common.h>
+
+static const char* input =
+    "{\r\n"
+    "  \"name\": \"sample\",\n"
+    "  \"text\": \"J\\u00f6rg \\\"quoted\\\"\\n\\ud83d\\ude00 \\/ \xc3\xa4\",\n"
+    "  \"big\": -9223372036854775808,\n"
+    "  \"items\": [\n"
+    "    {\"label\": \"first\", \"count\": 1, \"color\": \"red\",\n"
+    "     \"values\": [1.5, -2e-3, 0], \"active\": true},\n"
+    "    {\"label\": \"\", \"count\": -7, \"color\": \"green\", \"values\": []}\n"
+    "  ],\n"
+    "  \"details\": {\"description\": \"loaded on demand\"}\n"
+    "}\n";
+
+static void check_root(struct root *data, bool *success) {
+  ASSERT_EQUALS_SIZE((size_t)6, data->name.len, *success);
+  // views point directly into the input.
+  ASSERT_EQUALS_BOOL(true, data->name.ptr == input + 14, *success);
+  ASSERT_EQUALS_STRING("J\xc3\xb6rg \"quoted\"\n\xf0\x9f\x98\x80 / \xc3\xa4",
+                       data->text, *success);
+  ASSERT_EQUALS_BOOL(true, data->big == -9223372036854775807LL - 1,
+                     *success);
+  ASSERT_EQUALS_SIZE((size_t)2, data->items.count, *success);
+  if (data->items.count != 2) return;
+  struct item *const first = &data->items.data[0];
+  ASSERT_EQUALS_STRING("first", first->label, *success);
+  ASSERT_EQUALS_INT(1, first->count, *success);
+  ASSERT_EQUALS_INT(COLOR_RED, first->color, *success);
+  ASSERT_EQUALS_SIZE((size_t)3, first->values.count, *success);
+  if (first->values.count == 3 && (first->values.data[0] != 1.5 ||
+      first->values.data[1] != -2e-3 || first->values.data[2] != 0)) {
+    fputs("wrong values of first item\n", stderr);
+    *success = false;
+  }
+  ASSERT_NOT_NULL(first->active, *success);
+  if (first->active != NULL) ASSERT_EQUALS_BOOL(true, *first->active, *success);
+  struct item *const second = &data->items.data[1];
+  ASSERT_EQUALS_STRING("", second->label, *success);
+  ASSERT_EQUALS_INT(-7, second->count, *success);
+  ASSERT_EQUALS_INT(COLOR_GREEN, second->color, *success);
+  ASSERT_EQUALS_SIZE((size_t)0, second->values.count, *success);
+  ASSERT_NULL(second->active, *success);
+  // lazy subtrees are parsed from the original input when forced.
+  yaml_loader_t loader;
+  if (yaml_force_struct_details(&data->details, &loader)) {
+    ASSERT_EQUALS_STRING("loaded on demand", data->details->description,
+                         *success);
+  } else {
+    fputs("error while forcing details\n", stderr);
+    *success = false;
+  }
+  yaml_loader_delete(&loader);
+}
+
+static const char *records[] = {
+  "[\"a\", \"b\"]", "{\"a\": [true, null, 1e5]}", "[[], {}, [[\"x\\ty\"]]]", NULL
+};
+
+/*
+ * JSON the scanner must reject, so that loading falls back to the parser.
+ * The last one has the quote at the start of the second block.
+ */
+static const char *invalid[] = {
+  "[1\"x\"]", "[true\"b\"]", "{\"a\": null\"c\"}",
+  "[                               "
+  "                               1\"x\"]", NULL
+};
+
+/*
+ * The JSON scanner must record exactly the events the parser generates.
+ */
+static bool same_events(const char *const text) {
+  yaml_tape_t parsed, scanned;
+  yaml_tape_init(&parsed);
+  yaml_tape_init(&scanned);
+  yaml_parser_t parser;
+  yaml_parser_initialize(&parser);
+  yaml_parser_set_input_string(&parser, (const unsigned char*)text,
+                               strlen(text));
+  bool ret = yaml_tape_record(&parsed, &parser) &&
+      yaml_tape_record_json(&scanned, (const unsigned char*)text,
+                            strlen(text)) &&
+      parsed.entries.count == scanned.entries.count;
+  for (size_t i = 0; ret && i < parsed.entries.count; ++i) {
+    yaml_event_t a, b;
+    yaml_tape_event(&parsed, i, &a);
+    yaml_tape_event(&scanned, i, &b);
+    ret = a.type == b.type && a.start_mark.index == b.start_mark.index &&
+        a.start_mark.line == b.start_mark.line &&
+        a.start_mark.column == b.start_mark.column &&
+        a.end_mark.index == b.end_mark.index &&
+        (a.type != YAML_SCALAR_EVENT ||
+         (a.data.scalar.length == b.data.scalar.length &&
+          a.data.scalar.style == b.data.scalar.style &&
+          memcmp(a.data.scalar.value, b.data.scalar.value,
+                 a.data.scalar.length) == 0));
+  }
+  if (!ret) fprintf(stderr, "events differ for %s\n", text);
+  yaml_parser_delete(&parser);
+  yaml_tape_delete(&parsed);
+  yaml_tape_delete(&scanned);
+  return ret;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_loader_t loader;
+  struct root data;
+
+  // JSON input is detected by yaml_loader_init_string.
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  if (yaml_load_struct_root(&data, &loader)) {
+    check_root(&data, &success);
+    yaml_free_struct_root(&data);
+  } else {
+    fputs("loading detected JSON failed\n", stderr);
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+
+  // recording the JSON into an external tape works the same.
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  yaml_loader_init_json(&loader, (const unsigned char*)input, strlen(input));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_tape(&loader, &tape), success);
+  if (yaml_load_struct_root(&data, &loader)) {
+    check_root(&data, &success);
+    yaml_free_struct_root(&data);
+  } else {
+    fputs("loading JSON from a tape failed\n", stderr);
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+  yaml_tape_delete(&tape);
+
+  for (size_t i = 0; records[i] != NULL; ++i) {
+    if (!same_events(records[i])) success = false;
+  }
+  for (size_t i = 0; invalid[i] != NULL; ++i) {
+    yaml_tape_init(&tape);
+    if (yaml_tape_record_json(&tape, (const unsigned char*)invalid[i],
+                              strlen(invalid[i]))) {
+      fprintf(stderr, "recorded invalid JSON %s\n", invalid[i]);
+      success = false;
+    }
+    yaml_tape_delete(&tape);
+  }
+
+  // syntax errors are reported like the parser's.
+  static const char *const broken =
+      "{\"name\": \"x\", \"text\": \"y\",\n \"big\": 1,\n \"items\": [{\"label\" \"x\"}]}";
+  yaml_loader_init_json(&loader, (const unsigned char*)broken,
+                        strlen(broken));
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, loader.error_info.type, success);
+  ASSERT_NOT_NULL(loader.parser->problem, success);
+  ASSERT_EQUALS_SIZE((size_t)2, loader.parser->problem_mark.line, success);
+  ASSERT_EQUALS_SIZE((size_t)20, loader.parser->problem_mark.column, success);
+  yaml_loader_delete(&loader);
+
+  // values are checked at the same positions as with the parser.
+  static const char *const wrong =
+      "{\"name\": \"x\", \"text\": \"y\",\n \"big\": \"huge\", \"items\": []}";
+  yaml_loader_init_string(&loader, (const unsigned char*)wrong, strlen(wrong));
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)1, loader.error_info.event.start_mark.line,
+                     success);
+  ASSERT_EQUALS_SIZE((size_t)8, loader.error_info.event.start_mark.column,
+                     success);
+
+  // YAML that merely starts like JSON is still parsed as YAML.
+  static const char *const flow =
+      "{name: x, text: y, big: 2, items: [{label: z, count: 3, color: red,"
+      " values: [1,]}], details: {description: d}}";
+  ASSERT_EQUALS_BOOL(true, yaml_loader_reset_string(&loader,
+      (const unsigned char*)flow, strlen(flow)), success);
+  if (yaml_load_struct_root(&data, &loader)) {
+    ASSERT_EQUALS_SIZE((size_t)1, data.items.count, success);
+    ASSERT_EQUALS_SIZE((size_t)1, data.items.data[0].values.count, success);
+    yaml_free_struct_root(&data);
+  } else {
+    fputs("loading flow YAML failed\n", stderr);
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+  return success ? 0 : 1;
+}
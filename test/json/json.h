@@ -0,0 +1,59 @@
+#ifndef _JSON_H
+#define _JSON_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+enum color {
+  //!repr red
+  COLOR_RED,
+  //!repr green
+  COLOR_GREEN
+};
+
+//!view
+struct name_view {
+  const char *ptr;
+  size_t len;
+};
+
+//!list
+struct numbers {
+  double *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct item {
+  //!string
+  char *label;
+  int count;
+  enum color color;
+  struct numbers values;
+  //!optional
+  bool *active;
+};
+
+//!list
+struct items {
+  struct item *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct details {
+  //!string
+  char *description;
+};
+
+struct root {
+  struct name_view name;
+  //!string
+  char *text;
+  long long big;
+  struct items items;
+  //!lazy
+  struct details *details;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "lazy.h"
+#include <lazy_loading.h>
+#include <stdbool.h>
+
+#include <yaml_constructor.h>
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char* input =
+    "name: lazy\n"
+    "details:\n"
+    "  description: \"spans\n"
+    "    lines\"\n"
+    "  points:\n"
+    "  - {x: 1, y: 2}\n"
+    "  - x: 3\n"
+    "    y: 4\n"
+    "  more: [{x: 5, y: 6}]\n"
+    "flow: [{x: 7, y: 8}, {x: 9, y: 10}]\n"
+    "broken:\n"
+    "  description: never checked\n"
+    "  points: []\n"
+    "  more: []\n"
+    "  unknown: 42\n";
+
+static const char* valid_input =
+    "name: eager\n"
+    "details: {description: d, points: [], more: [{x: 1, y: 1}]}\n"
+    "flow: []\n"
+    "broken: {description: b, points: [], more: []}\n";
+
+static bool test_lazy(void) {
+  bool success = true;
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  struct root data;
+  if (!yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading YAML.\n");
+    yaml_loader_delete(&loader);
+    return false;
+  }
+  yaml_loader_delete(&loader);
+  ASSERT_EQUALS_STRING("lazy", data.name, success);
+  ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(data.details), success);
+  ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(data.flow), success);
+  ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(data.broken), success);
+
+  if (!yaml_force_struct_details(&data.details, &loader)) {
+    fprintf(stderr, "error while forcing details.\n");
+    success = false;
+  } else {
+    ASSERT_EQUALS_STRING("spans lines", data.details->description, success);
+    ASSERT_EQUALS_SIZE((size_t)2, data.details->points.count, success);
+    if (data.details->points.count == 2) {
+      ASSERT_EQUALS_INT(1, data.details->points.data[0].x, success);
+      ASSERT_EQUALS_INT(4, data.details->points.data[1].y, success);
+    }
+    ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(data.details->more),
+                       success);
+  }
+  yaml_loader_delete(&loader);
+
+  // forcing again does nothing
+  ASSERT_EQUALS_BOOL(true, yaml_force_struct_details(&data.details, &loader),
+                     success);
+  yaml_loader_delete(&loader);
+
+  // nested subtrees refer to the original input, not to the forcing loader
+  if (!yaml_constructor_is_lazy(data.details) &&
+      yaml_force_struct_point_list(&data.details->more, &loader)) {
+    ASSERT_EQUALS_SIZE((size_t)1, data.details->more->count, success);
+    if (data.details->more->count == 1) {
+      ASSERT_EQUALS_INT(6, data.details->more->data[0].y, success);
+    }
+  } else {
+    fprintf(stderr, "error while forcing details.more.\n");
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+
+  if (yaml_force_struct_point_list(&data.flow, &loader)) {
+    ASSERT_EQUALS_SIZE((size_t)2, data.flow->count, success);
+    if (data.flow->count == 2) {
+      ASSERT_EQUALS_INT(9, data.flow->data[1].x, success);
+      ASSERT_EQUALS_INT(10, data.flow->data[1].y, success);
+    }
+  } else {
+    fprintf(stderr, "error while forcing flow.\n");
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+
+  // errors inside the subtree only surface when it is forced
+  ASSERT_EQUALS_BOOL(false, yaml_force_struct_details(&data.broken, &loader),
+                     success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_UNKNOWN_KEY, loader.error_info.type,
+                    success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_UNKNOWN_KEY) {
+    ASSERT_EQUALS_SIZE((size_t)14, loader.error_info.event.start_mark.line,
+                       success);
+    ASSERT_EQUALS_SIZE((size_t)2, loader.error_info.event.start_mark.column,
+                       success);
+  }
+  yaml_loader_delete(&loader);
+  ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(data.broken), success);
+
+  yaml_free_struct_root(&data);
+  return success;
+}
+
+static bool test_eager(void) {
+  bool success = true;
+  yaml_parser_t parser;
+  yaml_parser_initialize(&parser);
+  yaml_parser_set_input_string(&parser, (const unsigned char*)valid_input,
+                               strlen(valid_input));
+  yaml_loader_t loader;
+  yaml_loader_init_parser(&loader, &parser);
+  struct root data;
+  bool const ret = yaml_load_struct_root(&data, &loader);
+  yaml_loader_delete(&loader);
+  yaml_parser_delete(&parser);
+  if (!ret) {
+    fprintf(stderr, "error while loading YAML without input buffer.\n");
+    return false;
+  }
+  // without an input buffer, nothing can be deferred.
+  ASSERT_EQUALS_BOOL(false, yaml_constructor_is_lazy(data.details), success);
+  ASSERT_EQUALS_BOOL(false, yaml_constructor_is_lazy(data.details->more),
+                     success);
+  ASSERT_EQUALS_INT(1, data.details->more->data[0].x, success);
+  ASSERT_EQUALS_BOOL(true, yaml_force_struct_details(&data.details, &loader),
+                     success);
+  yaml_loader_delete(&loader);
+  yaml_free_struct_root(&data);
+  return success;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = test_lazy();
+  if (!test_eager()) success = false;
+  return success ? 0 : 1;
+}
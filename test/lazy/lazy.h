@@ -0,0 +1,37 @@
+#ifndef _LAZY_H
+#define _LAZY_H
+
+#include <stdlib.h>
+
+struct point {
+  int x;
+  int y;
+};
+
+//!list
+struct point_list {
+  struct point *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct details {
+  //!string
+  char *description;
+  struct point_list points;
+  //!lazy
+  struct point_list *more;
+};
+
+struct root {
+  //!string
+  char *name;
+  //!lazy
+  struct details *details;
+  //!lazy
+  struct point_list *flow;
+  //!lazy
+  struct details *broken;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "limits.h"
+#include <limits_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#define VALUE_COUNT 200
+
+static char *render_input(void) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input,
+      "name: fleet\n"
+      "groups:\n"
+      "- {label: red, members: [1, 2, 3]}\n"
+      "- {label: green, members: [4, 5]}\n"
+      "- {label: blue, members: [6]}\n"
+      "- {label: yellow, members: []}\n"
+      "values: [");
+  for (int i = 0; i < VALUE_COUNT; ++i) {
+    test_text_append(&input, i == 0 ? "%d" : ", %d", i);
+  }
+  test_text_append(&input, "]\n"
+                   "archive: [{label: gray, members: [7, 8, 9]}]\n");
+  return input.data;
+}
+
+/*
+ * Load the input with the given limits and check that loading fails with the
+ * given exceeded limit at the given line, or succeeds if limit is NULL.
+ */
+static void check(const char *const input, yaml_loader_limits_t const limits,
+                  bool const use_tape, const char *const limit,
+                  size_t const line, bool *const success) {
+  yaml_loader_t loader;
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  yaml_loader_set_limits(&loader, &limits);
+  if (use_tape) {
+    yaml_loader_set_threads(&loader, 4);
+    yaml_loader_use_tape(&loader, &tape);
+  }
+  struct root value;
+  bool const ret = yaml_load_struct_root(&value, &loader);
+  if (limit == NULL) {
+    ASSERT_EQUALS_BOOL(true, ret, *success);
+    if (ret) {
+      ASSERT_EQUALS_SIZE((size_t)4, value.groups.count, *success);
+      ASSERT_EQUALS_SIZE((size_t)VALUE_COUNT, value.values.count, *success);
+      yaml_free_struct_root(&value);
+    }
+  } else {
+    ASSERT_EQUALS_BOOL(false, ret, *success);
+    ASSERT_EQUALS_INT(YAML_LOADER_ERROR_LIMIT, loader.error_info.type,
+                      *success);
+    if (loader.error_info.type == YAML_LOADER_ERROR_LIMIT) {
+      ASSERT_EQUALS_STRING(limit, loader.error_info.expected, *success);
+      ASSERT_EQUALS_SIZE(line, loader.error_info.event.start_mark.line + 1,
+                         *success);
+    }
+  }
+  yaml_loader_delete(&loader);
+  yaml_tape_delete(&tape);
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  char *const input = render_input();
+
+  yaml_loader_limits_t limits = {0};
+  check(input, limits, false, NULL, 0, &success);
+
+  limits.max_items = 3;
+  check(input, limits, false, "max_items", 3, &success);
+  limits.max_items = 150;
+  check(input, limits, false, "max_items", 7, &success);
+  // when reading from a tape, the list's length is checked up front.
+  check(input, limits, true, "max_items", 7, &success);
+
+  limits.max_items = 0;
+  limits.max_string_length = 5;
+  check(input, limits, false, "max_string_length", 2, &success);
+
+  limits.max_string_length = 0;
+  limits.max_depth = 3;
+  check(input, limits, false, "max_depth", 3, &success);
+
+  limits.max_depth = 0;
+  limits.max_nodes = 20;
+  check(input, limits, false, "max_nodes", 5, &success);
+  // items constructed on other threads count as well.
+  limits.max_nodes = 150;
+  check(input, limits, true, "max_nodes", 7, &success);
+
+  // the nodes of a lazy subtree count although they are skipped.
+  limits.max_nodes = 240;
+  check(input, limits, false, "max_nodes", 8, &success);
+  check(input, limits, true, "max_nodes", 8, &success);
+
+  limits.max_nodes = 0;
+  limits.max_bytes = 256;
+  check(input, limits, false, "max_bytes", 3, &success);
+
+  limits.max_bytes = 1 << 20;
+  limits.max_nodes = 1000;
+  limits.max_items = VALUE_COUNT;
+  limits.max_string_length = 7;
+  limits.max_depth = 4;
+  check(input, limits, false, NULL, 0, &success);
+  check(input, limits, true, NULL, 0, &success);
+
+  free(input);
+  return success ? 0 : 1;
+}
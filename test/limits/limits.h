@@ -0,0 +1,35 @@
+#ifndef _LIMITS_H
+#define _LIMITS_H
+
+#include <stdlib.h>
+
+//!list
+struct int_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct group {
+  //!string
+  char *label;
+  struct int_list members;
+};
+
+//!list
+struct group_list {
+  struct group *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char *name;
+  struct group_list groups;
+  struct int_list values;
+  //!lazy
+  struct group_list *archive;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "parallel.h"
+#include <parallel_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <yaml_tape.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#define RECORD_COUNT 1000
+
+/*
+ * Render an input with RECORD_COUNT records. If broken_a or broken_b are
+ * valid record indexes, the id of that record is not a number.
+ */
+static char *render_input(size_t const broken_a, size_t const broken_b) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "records:\n");
+  for (size_t i = 0; i < RECORD_COUNT; ++i) {
+    bool const broken = i == broken_a || i == broken_b;
+    if (i % 2 == 0) {
+      test_text_append(&input, "- id: %s%zu\n  name: record %zu\n"
+                       "  label: \"escaped\\t%zu\"\n  values: [%zu, 1]\n",
+                       broken ? "x" : "", i, i, i, i);
+    } else {
+      test_text_append(&input, "- {id: %s%zu, name: r%zu, label: plain, "
+                       "values: []}\n", broken ? "x" : "", i, i);
+    }
+  }
+  return input.data;
+}
+
+static bool load(char const *const input, unsigned const threads,
+                 struct root *const data, yaml_tape_t *const tape,
+                 yaml_loader_t *const loader) {
+  yaml_loader_init_string(loader, (const unsigned char*)input, strlen(input));
+  yaml_loader_set_threads(loader, threads);
+  if (!yaml_loader_use_tape(loader, tape)) return false;
+  return yaml_load_struct_root(data, loader);
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+
+  char *const input = render_input(RECORD_COUNT, RECORD_COUNT);
+  yaml_loader_t loader;
+  struct root data;
+  if (!load(input, 4, &data, &tape, &loader)) {
+    fprintf(stderr, "error while loading YAML.\n");
+    success = false;
+  } else {
+    ASSERT_EQUALS_SIZE((size_t)RECORD_COUNT, data.records.count, success);
+    for (size_t i = 0; i < data.records.count && success; ++i) {
+      struct record const *const record = &data.records.data[i];
+      char expected[32];
+      ASSERT_EQUALS_INT((int)i, record->id, success);
+      if (i % 2 == 0) {
+        sprintf(expected, "record %zu", i);
+        ASSERT_EQUALS_STRING(expected, record->name, success);
+        sprintf(expected, "escaped\t%zu", i);
+        ASSERT_EQUALS_SIZE(strlen(expected), record->label.len, success);
+        ASSERT_EQUALS_SIZE((size_t)2, record->values.count, success);
+        ASSERT_EQUALS_INT((int)i, record->values.data[0], success);
+      } else {
+        ASSERT_EQUALS_SIZE((size_t)5, record->label.len, success);
+        ASSERT_EQUALS_SIZE((size_t)0, record->values.count, success);
+      }
+    }
+    yaml_free_struct_root(&data);
+  }
+  yaml_loader_delete(&loader);
+  free(input);
+
+  // with two broken records, the first one in the document is reported.
+  char *const broken = render_input(901, 333);
+  ASSERT_EQUALS_BOOL(false, load(broken, 4, &data, &tape, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, loader.error_info.type, success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_VALUE) {
+    // record 333 is the 167th record in flow style after 167 block records.
+    ASSERT_EQUALS_SIZE((size_t)(1 + 167 * 4 + 166),
+                       loader.error_info.event.start_mark.line, success);
+  }
+  yaml_loader_delete(&loader);
+  free(broken);
+
+  yaml_tape_delete(&tape);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <stdlib.h>
+
+//!view
+struct label {
+  const char *ptr;
+  size_t len;
+};
+
+//!list
+struct int_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct record {
+  int id;
+  //!string
+  char *name;
+  struct label label;
+  struct int_list values;
+};
+
+//!list
+struct record_list {
+  struct record *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  struct record_list records;
+};
+
+#endif
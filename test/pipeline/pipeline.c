@@ -0,0 +1,77 @@
+#include "pipeline.h"
+#include <pipeline_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+// more entries than fit into the pipeline's ring buffer at once.
+#define ENTRY_COUNT 2000
+
+/*
+ * Render an input with ENTRY_COUNT entries. The entry with index broken, if
+ * any, breaks the syntax.
+ */
+static char *render_input(size_t const broken) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "entries:\n");
+  for (size_t i = 0; i < ENTRY_COUNT; ++i) {
+    test_text_append(&input, "- {id: %zu, name: entry %zu%s\n", i, i,
+                     i == broken ? "" : "}");
+  }
+  return input.data;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  struct root data;
+
+  char *const input = render_input(ENTRY_COUNT);
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_pipeline(&loader), success);
+  if (!yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading YAML.\n");
+    success = false;
+  } else {
+    ASSERT_EQUALS_SIZE((size_t)ENTRY_COUNT, data.entries.count, success);
+    for (size_t i = 0; i < data.entries.count && success; ++i) {
+      char expected[32];
+      sprintf(expected, "entry %zu", i);
+      ASSERT_EQUALS_INT((int)i, data.entries.data[i].id, success);
+      ASSERT_EQUALS_STRING(expected, data.entries.data[i].name, success);
+    }
+    yaml_free_struct_root(&data);
+  }
+  yaml_loader_delete(&loader);
+
+  // an early error stops loading while the parser thread is still ahead.
+  static const char *const wrong_key = "unknown: 1\n";
+  yaml_loader_init_string(&loader, (const unsigned char*)wrong_key,
+                          strlen(wrong_key));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_pipeline(&loader), success);
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_UNKNOWN_KEY, loader.error_info.type,
+                    success);
+  yaml_loader_delete(&loader);
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_pipeline(&loader), success);
+  yaml_loader_delete(&loader);
+  free(input);
+
+  // parser errors are reported when loading reaches them.
+  char *const broken = render_input(1500);
+  yaml_loader_init_string(&loader, (const unsigned char*)broken,
+                          strlen(broken));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_pipeline(&loader), success);
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)1502, loader.parser->problem_mark.line, success);
+  yaml_loader_delete(&loader);
+  free(broken);
+
+  return success ? 0 : 1;
+}
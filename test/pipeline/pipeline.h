@@ -0,0 +1,23 @@
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#include <stdlib.h>
+
+struct entry {
+  int id;
+  //!string
+  char *name;
+};
+
+//!list
+struct entry_list {
+  struct entry *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  struct entry_list entries;
+};
+
+#endif
@@ -24,6 +24,11 @@ int main(int argc, char* argv[]) {
     ASSERT_EQUALS_INT(47, data.first->number, success);
     ASSERT_EQUALS_STRING("spam egg sausage and spam", data.second->string, success);
 
+    // fields of typedef'd anonymous structs take part in equality.
+    second_object other = {.string = "spam"};
+    ASSERT_EQUALS_BOOL(false, yaml_equal_second_object(data.second, &other),
+                       success);
+
     return success ? 0 : 1;
   }
 }
\ No newline at end of file
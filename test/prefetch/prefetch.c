@@ -0,0 +1,109 @@
+#include "prefetch.h"
+#include <prefetch_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <yaml_prefetch.h>
+#include <../common/test_common.h>
+
+#define FILE_COUNT 20
+#define MISSING_FILE 5
+#define EMPTY_FILE 6
+// this file is larger than the initial buffer.
+#define LARGE_FILE 7
+#define LARGE_COUNT 2000
+
+static void write_files(char names[FILE_COUNT][32]) {
+  for (size_t i = 0; i < FILE_COUNT; ++i) {
+    sprintf(names[i], "prefetch_input_%zu.yaml", i);
+    remove(names[i]);
+    if (i == MISSING_FILE) continue;
+    FILE *const file = fopen(names[i], "w");
+    if (i == LARGE_FILE) {
+      fprintf(file, "name: file %zu\nvalues:\n", i);
+      for (int j = 0; j < LARGE_COUNT; ++j) fprintf(file, "- %d\n", j);
+    } else if (i != EMPTY_FILE) {
+      fprintf(file, "name: file %zu\nvalues: [%zu]\n", i, i);
+    }
+    fclose(file);
+  }
+}
+
+static bool check(char names[FILE_COUNT][32], unsigned const depth) {
+  bool success = true;
+  yaml_prefetch_t prefetch;
+  yaml_loader_t loader;
+  yaml_prefetch_init(&prefetch, depth);
+  yaml_loader_init_string(&loader, (const unsigned char*)"", 0);
+  size_t submitted = 0, delivered = 0;
+  while (submitted < FILE_COUNT &&
+         yaml_prefetch_submit(&prefetch, names[submitted], submitted)) {
+    ++submitted;
+  }
+  size_t id, size;
+  const unsigned char *data;
+  while (yaml_prefetch_next(&prefetch, &id, &data, &size)) {
+    ASSERT_EQUALS_SIZE(delivered, id, success);
+    ++delivered;
+    if (submitted < FILE_COUNT) {
+      ASSERT_EQUALS_BOOL(true, yaml_prefetch_submit(
+          &prefetch, names[submitted], submitted), success);
+      ++submitted;
+    }
+    if (id == MISSING_FILE) {
+      ASSERT_EQUALS_BOOL(true, data == NULL, success);
+      continue;
+    }
+    ASSERT_EQUALS_BOOL(true, data != NULL, success);
+    if (id == EMPTY_FILE) {
+      ASSERT_EQUALS_SIZE((size_t)0, size, success);
+      continue;
+    }
+    yaml_loader_reset_string(&loader, data, size);
+    struct root value;
+    if (!yaml_load_struct_root(&value, &loader)) {
+      fprintf(stderr, "error while loading file %zu.\n", id);
+      success = false;
+      continue;
+    }
+    char expected[32];
+    sprintf(expected, "file %zu", id);
+    ASSERT_EQUALS_STRING(expected, value.name, success);
+    if (id == LARGE_FILE) {
+      ASSERT_EQUALS_SIZE((size_t)LARGE_COUNT, value.values.count, success);
+    } else {
+      ASSERT_EQUALS_SIZE((size_t)1, value.values.count, success);
+      ASSERT_EQUALS_INT((int)id, value.values.data[0], success);
+    }
+    yaml_free_struct_root(&value);
+  }
+  ASSERT_EQUALS_SIZE((size_t)FILE_COUNT, delivered, success);
+  yaml_loader_delete(&loader);
+  yaml_prefetch_delete(&prefetch);
+  return success;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  char names[FILE_COUNT][32];
+  write_files(names);
+
+  // reading ahead, with io_uring where available.
+  if (!check(names, 4)) success = false;
+  // reading each file when it is submitted.
+  if (!check(names, 0)) success = false;
+
+  // deleting the prefetcher with pending reads.
+  yaml_prefetch_t prefetch;
+  yaml_prefetch_init(&prefetch, 4);
+  for (size_t i = 0; i < 4; ++i) {
+    yaml_prefetch_submit(&prefetch, names[LARGE_FILE], i);
+  }
+  ASSERT_EQUALS_BOOL(false, yaml_prefetch_submit(
+      &prefetch, names[LARGE_FILE], 4), success);
+  yaml_prefetch_delete(&prefetch);
+
+  for (size_t i = 0; i < FILE_COUNT; ++i) remove(names[i]);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#ifndef _PREFETCH_H
+#define _PREFETCH_H
+
+#include <stdlib.h>
+
+//!list
+struct int_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char *name;
+  struct int_list values;
+};
+
+#endif
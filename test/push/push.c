@@ -0,0 +1,131 @@
+#include "push.h"
+#include <push_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+// deep enough to exhaust the stack a pushed document is constructed on.
+#define EXCESSIVE_DEPTH 10000
+
+static const char *const input =
+    "name: \"a quoted name\"\n"
+    "scale: 2.5\n"
+    "points:\n"
+    "- {x: 1, y: 2}\n"
+    "- x: 3\n"
+    "  y: 4\n"
+    "- {x: 5, y: 6}\n";
+
+static char *render_deep_input(int const depth) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "name: deep\nscale: 1\npoints: []\ntree: ");
+  for (int i = 0; i < depth; ++i) {
+    test_text_append(&input, i == depth - 1 ? "{value: %d" :
+                                              "{value: %d, child: ", i);
+  }
+  for (int i = 0; i < depth; ++i) test_text_append(&input, "}");
+  test_text_append(&input, "\n");
+  return input.data;
+}
+
+static void check_value(struct root const *const value, bool *const success) {
+  ASSERT_EQUALS_STRING("a quoted name", value->name, *success);
+  ASSERT_EQUALS_BOOL(true, value->scale == 2.5, *success);
+  ASSERT_EQUALS_SIZE((size_t)3, value->points.count, *success);
+  if (value->points.count == 3) {
+    ASSERT_EQUALS_INT(4, value->points.data[1].y, *success);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  size_t const length = strlen(input);
+
+  // two loaders fed alternately in pieces of different sizes, as from two
+  // connections.
+  yaml_loader_t first, second;
+  struct root first_value, second_value;
+  ASSERT_EQUALS_BOOL(true, yaml_push_struct_root(&first_value, &first),
+                     success);
+  ASSERT_EQUALS_BOOL(true, yaml_push_struct_root(&second_value, &second),
+                     success);
+  size_t first_pos = 0, second_pos = 0;
+  yaml_loader_status_t first_status = YAML_LOADER_NEED_MORE,
+                       second_status = YAML_LOADER_NEED_MORE;
+  while (first_pos < length || second_pos < length) {
+    if (first_pos < length) {
+      first_status = yaml_loader_feed(
+          &first, (const unsigned char*)input + first_pos, 1);
+      ASSERT_EQUALS_INT(YAML_LOADER_NEED_MORE, first_status, success);
+      first_pos++;
+    }
+    if (second_pos < length) {
+      size_t const piece = length - second_pos < 7 ? length - second_pos : 7;
+      second_status = yaml_loader_feed(
+          &second, (const unsigned char*)input + second_pos, piece);
+      ASSERT_EQUALS_INT(YAML_LOADER_NEED_MORE, second_status, success);
+      second_pos += piece;
+    }
+  }
+  // the parser can only tell the document is complete at the end of input.
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, yaml_loader_feed(&first, NULL, 0),
+                    success);
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, yaml_loader_feed(&second, NULL, 0),
+                    success);
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, yaml_loader_feed(&second, NULL, 0),
+                    success);
+  check_value(&first_value, &success);
+  check_value(&second_value, &success);
+  yaml_free_struct_root(&first_value);
+  yaml_free_struct_root(&second_value);
+  yaml_loader_delete(&first);
+  yaml_loader_delete(&second);
+
+  // errors are reported as soon as they are encountered.
+  static const char *const broken = "name: x\nscale: big\npoints: []\n";
+  yaml_loader_t loader;
+  struct root value;
+  yaml_push_struct_root(&value, &loader);
+  ASSERT_EQUALS_INT(YAML_LOADER_FAILED, yaml_loader_feed(
+      &loader, (const unsigned char*)broken, strlen(broken)), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_VALUE, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)1, loader.error_info.event.start_mark.line,
+                     success);
+  yaml_loader_delete(&loader);
+
+  // deleting a loader in the middle of the document frees what has been
+  // constructed so far.
+  yaml_push_struct_root(&value, &loader);
+  ASSERT_EQUALS_INT(YAML_LOADER_NEED_MORE, yaml_loader_feed(
+      &loader, (const unsigned char*)input, length - 10), success);
+  yaml_loader_delete(&loader);
+
+  // a loader that has never been fed.
+  yaml_push_struct_root(&value, &loader);
+  yaml_loader_delete(&loader);
+
+  // input too deep for the loader's stack fails instead of overflowing it.
+  char *const deep = render_deep_input(EXCESSIVE_DEPTH);
+  size_t const deep_length = strlen(deep);
+  yaml_push_struct_root(&value, &loader);
+  yaml_loader_status_t status = YAML_LOADER_NEED_MORE;
+  for (size_t pos = 0; pos < deep_length && status == YAML_LOADER_NEED_MORE;
+       pos += 4096) {
+    size_t const piece = deep_length - pos < 4096 ? deep_length - pos : 4096;
+    status = yaml_loader_feed(&loader, (const unsigned char*)deep + pos,
+                              piece);
+  }
+  ASSERT_EQUALS_INT(YAML_LOADER_FAILED, status, success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_LIMIT, loader.error_info.type, success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_LIMIT) {
+    ASSERT_EQUALS_STRING("stack_size", loader.error_info.expected, success);
+  }
+  yaml_loader_delete(&loader);
+  free(deep);
+
+  return success ? 0 : 1;
+}
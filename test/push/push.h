@@ -0,0 +1,32 @@
+#ifndef _PUSH_H
+#define _PUSH_H
+
+#include <stdlib.h>
+
+struct point {
+  int x, y;
+};
+
+//!list
+struct point_list {
+  struct point *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct node {
+  int value;
+  //!optional
+  struct node *child;
+};
+
+struct root {
+  //!string
+  char *name;
+  double scale;
+  struct point_list points;
+  //!optional
+  struct node *tree;
+};
+
+#endif
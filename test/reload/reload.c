@@ -0,0 +1,141 @@
+#include "reload.h"
+#include <reload_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <yaml_reload.h>
+#include <../common/test_common.h>
+
+static const char *before =
+    "name: app\n"
+    "settings: {retries: 3, hosts: [{name: a}, {name: b}]}\n"
+    "services:\n"
+    "- name: web\n"
+    "  note: hello\n"
+    "  limits: {cpu: 2, memory: 4}\n"
+    "  ports: [80, 443]\n"
+    "- name: db\n"
+    "  note: data\n"
+    "  limits: {cpu: 4, memory: 16}\n"
+    "  ports: [5432]\n"
+    "shape: !circle 2\n";
+
+static const char *after =
+    "name: app\n"
+    "settings:\n"
+    "  retries: 3\n"
+    "  hosts:\n"
+    "  - name: a\n"
+    "  - name: b\n"
+    "services:\n"
+    "- name: web\n"
+    "  note: hello\n"
+    "  limits: {cpu: 2, memory: 4}\n"
+    "  ports: [80, 443, 8080]\n"
+    "- name: db\n"
+    "  note: data\n"
+    "  limits: {cpu: 8, memory: 16}\n"
+    "  ports: [5432]\n"
+    "shape: !square 2\n";
+
+/*
+ * Copy the given input, so that it can be freed after reloading to check
+ * that the reloaded value does not refer to it.
+ */
+static char *copy(const char *const input) {
+  char *const ret = malloc(strlen(input) + 1);
+  strcpy(ret, input);
+  return ret;
+}
+
+static bool reload(struct root *const data, const char *const input,
+                   yaml_reload_changes_t *const changes) {
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  bool const ret = yaml_reload_struct_root(data, &loader, changes);
+  yaml_loader_delete(&loader);
+  if (!ret) fprintf(stderr, "error while reloading:\n%s", input);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  bool success = true;
+  char *old_input = copy(before);
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)old_input,
+                          strlen(old_input));
+  struct root data;
+  bool const ret = yaml_load_struct_root(&data, &loader);
+  yaml_loader_delete(&loader);
+  if (!ret) {
+    fprintf(stderr, "error while loading YAML doc.\n");
+    return 1;
+  }
+
+  char const *const name = data.name;
+  struct host const *const hosts = data.settings.hosts.data;
+  char const *const web_name = data.services.data[0].name;
+  struct limits const *const web_limits = data.services.data[0].limits;
+  struct limits const *const db_limits = data.services.data[1].limits;
+  int const *const db_ports = data.services.data[1].ports.data;
+
+  char *new_input = copy(after);
+  yaml_reload_changes_t changes;
+  yaml_reload_changes_init(&changes);
+  if (!reload(&data, new_input, &changes)) return 1;
+  free(old_input);
+
+  ASSERT_EQUALS_SIZE((size_t)3, changes.count, success);
+  if (changes.count == 3) {
+    ASSERT_EQUALS_STRING("services[0].ports", changes.paths[0], success);
+    ASSERT_EQUALS_STRING("services[1].limits.cpu", changes.paths[1], success);
+    ASSERT_EQUALS_STRING("shape", changes.paths[2], success);
+  }
+  ASSERT_EQUALS_BOOL(false, changes.incomplete, success);
+  yaml_reload_changes_delete(&changes);
+
+  // unchanged subtrees are the old ones.
+  ASSERT_EQUALS_BOOL(true, data.name == name, success);
+  ASSERT_EQUALS_BOOL(true, data.settings.hosts.data == hosts, success);
+  ASSERT_EQUALS_BOOL(true, data.services.data[0].name == web_name, success);
+  ASSERT_EQUALS_BOOL(true, data.services.data[0].limits == web_limits,
+                     success);
+  ASSERT_EQUALS_BOOL(true, data.services.data[1].ports.data == db_ports,
+                     success);
+  // changed ones carry the new values.
+  ASSERT_EQUALS_BOOL(false, data.services.data[1].limits == db_limits,
+                     success);
+  ASSERT_EQUALS_INT(8, data.services.data[1].limits->cpu, success);
+  ASSERT_EQUALS_SIZE((size_t)3, data.services.data[0].ports.count, success);
+  ASSERT_EQUALS_INT(8080, data.services.data[0].ports.data[2], success);
+  ASSERT_EQUALS_INT(square, data.shape->kind, success);
+  // views refer to the new input, since the old one is gone.
+  ASSERT_EQUALS_SIZE((size_t)5, data.services.data[0].note.len, success);
+  ASSERT_EQUALS_BOOL(true, strncmp("hello", data.services.data[0].note.ptr,
+                                   5) == 0, success);
+
+  // reloading an equal document changes nothing.
+  old_input = new_input;
+  new_input = copy(after);
+  struct limits const *const limits = data.services.data[1].limits;
+  yaml_reload_changes_init(&changes);
+  if (!reload(&data, new_input, &changes)) return 1;
+  free(old_input);
+  ASSERT_EQUALS_SIZE((size_t)0, changes.count, success);
+  ASSERT_EQUALS_BOOL(true, data.services.data[1].limits == limits, success);
+  ASSERT_EQUALS_BOOL(true, data.settings.hosts.data == hosts, success);
+  ASSERT_EQUALS_BOOL(true, strncmp("data", data.services.data[1].note.ptr,
+                                   4) == 0, success);
+  yaml_reload_changes_delete(&changes);
+
+  // changes need not be collected.
+  if (!reload(&data, before, NULL)) return 1;
+  ASSERT_EQUALS_INT(4, data.services.data[1].limits->cpu, success);
+  ASSERT_EQUALS_INT(circle, data.shape->kind, success);
+  free(new_input);
+
+  yaml_free_struct_root(&data);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#ifndef _RELOAD_H
+#define _RELOAD_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+//!view
+struct text {
+  const char *ptr;
+  size_t len;
+};
+
+struct host {
+  //!string
+  char *name;
+};
+
+//!list
+struct host_list {
+  struct host *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct settings {
+  int retries;
+  struct host_list hosts;
+};
+
+struct limits {
+  int cpu;
+  int memory;
+};
+
+//!list
+struct port_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct service {
+  //!string
+  char *name;
+  struct text note;
+  struct limits *limits;
+  struct port_list ports;
+};
+
+//!list
+struct service_list {
+  struct service *data;
+  size_t count;
+  size_t capacity;
+};
+
+enum shape_kind {
+  circle, square
+};
+
+//!tagged
+struct shape {
+  enum shape_kind kind;
+  union {
+    int radius;
+    int side;
+  };
+};
+
+struct root {
+  //!string
+  char *name;
+  struct settings settings;
+  struct service_list services;
+  //!optional
+  struct shape *shape;
+};
+
+#endif
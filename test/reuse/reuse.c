@@ -0,0 +1,109 @@
+#include "reuse.h"
+#include <reuse_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+
+static const char *const inputs[] = {
+    "name: first\nlabel: \"escaped\\t\"\nvalues: [1, 2, 3]\n",
+    // stops in the middle of a flow sequence, leaving tokens in the parser.
+    "name: second\nlabel: plain\nvalues: [1, two, 3, 4, 5]\n",
+    // stops while the parser holds tag directives.
+    "%TAG !e! tag:example.com,2000:\n---\nname: third\nlabel: x\n"
+    "values: [1, 2, 3]\nunknown: 1\n",
+    // a parser error in the middle of the input.
+    "name: fourth\nlabel: x\nvalues: [1, 2\n",
+    "name: fifth\nlabel: plain\nvalues: []\n"
+};
+
+static const bool valid[] = {true, false, false, false, true};
+
+static bool load(yaml_loader_t *const loader, size_t const index,
+                 bool *const success) {
+  struct root data;
+  bool const ret = yaml_load_struct_root(&data, loader);
+  ASSERT_EQUALS_BOOL(valid[index], ret, *success);
+  if (ret) {
+    if (index == 0) {
+      ASSERT_EQUALS_STRING("first", data.name, *success);
+      ASSERT_EQUALS_SIZE((size_t)8, data.label.len, *success);
+      ASSERT_EQUALS_SIZE((size_t)3, data.values.count, *success);
+    } else {
+      ASSERT_EQUALS_STRING("fifth", data.name, *success);
+      ASSERT_EQUALS_SIZE((size_t)0, data.values.count, *success);
+    }
+    yaml_free_struct_root(&data);
+  }
+  return ret;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  size_t const count = sizeof(inputs) / sizeof(char*);
+
+  // one loader for all inputs, twice, with an untouched parser in between.
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)inputs[0],
+                          strlen(inputs[0]));
+  unsigned char *const buffer = loader.parser->buffer.start;
+  for (size_t round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < count; ++i) {
+      if (round > 0 || i > 0) {
+        ASSERT_EQUALS_BOOL(true, yaml_loader_reset_string(
+            &loader, (const unsigned char*)inputs[i], strlen(inputs[i])),
+            success);
+      }
+      load(&loader, i, &success);
+    }
+  }
+  ASSERT_EQUALS_BOOL(true, yaml_loader_reset_string(
+      &loader, (const unsigned char*)inputs[3], strlen(inputs[3])), success);
+  load(&loader, 3, &success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)3, loader.parser->problem_mark.line, success);
+  // the parser has kept its buffers.
+  ASSERT_EQUALS_BOOL(true, loader.parser->buffer.start == buffer, success);
+
+  // resetting to a file.
+  FILE *const file = tmpfile();
+  fputs(inputs[0], file);
+  rewind(file);
+  ASSERT_EQUALS_BOOL(true, yaml_loader_reset_file(&loader, file), success);
+  load(&loader, 0, &success);
+  fclose(file);
+  yaml_loader_delete(&loader);
+
+  // loaders with an external parser cannot be reset.
+  yaml_parser_t parser;
+  yaml_parser_initialize(&parser);
+  yaml_loader_init_parser(&loader, &parser);
+  ASSERT_EQUALS_BOOL(false, yaml_loader_reset_string(
+      &loader, (const unsigned char*)inputs[0], strlen(inputs[0])), success);
+  yaml_loader_delete(&loader);
+  yaml_parser_delete(&parser);
+
+  // a released loader is handed out again.
+  yaml_loader_t *const first = yaml_loader_acquire_string(
+      (const unsigned char*)inputs[0], strlen(inputs[0]));
+  load(first, 0, &success);
+  yaml_loader_release(first);
+  yaml_loader_t *const second = yaml_loader_acquire_string(
+      (const unsigned char*)inputs[4], strlen(inputs[4]));
+  ASSERT_EQUALS_BOOL(true, first == second, success);
+  load(second, 4, &success);
+
+  // more loaders than the pool keeps.
+  yaml_loader_t *loaders[16];
+  for (size_t i = 0; i < 16; ++i) {
+    loaders[i] = yaml_loader_acquire_string(
+        (const unsigned char*)inputs[i % count], strlen(inputs[i % count]));
+    load(loaders[i], i % count, &success);
+  }
+  for (size_t i = 0; i < 16; ++i) yaml_loader_release(loaders[i]);
+  yaml_loader_release(second);
+  yaml_loader_pool_clear();
+
+  return success ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef _REUSE_H
+#define _REUSE_H
+
+#include <stdlib.h>
+
+//!view
+struct label {
+  const char *ptr;
+  size_t len;
+};
+
+//!list
+struct int_list {
+  int *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char *name;
+  struct label label;
+  struct int_list values;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "shared.h"
+#include <shared_loading.h>
+#include <stdbool.h>
+
+#include <yaml_constructor.h>
+#include <yaml_loader.h>
+#include <yaml_dumper.h>
+#include <../common/test_common.h>
+
+static const char *input =
+    "defaults: &small {cpu: 1, memory: 512}\n"
+    "services:\n"
+    "- name: a\n"
+    "  limits: *small\n"
+    "  replicas: &one 1\n"
+    "- name: b\n"
+    "  limits: *small\n"
+    "  replicas: *one\n"
+    "- name: c\n"
+    "  limits: &big {cpu: 8, memory: 4096}\n"
+    "  replicas: 3\n"
+    "- name: d\n"
+    "  limits: *big\n"
+    "  replicas: *one\n";
+
+static bool check_sharing(struct root const *const data) {
+  bool success = true;
+  ASSERT_EQUALS_SIZE((size_t)4, data->services.count, success);
+  if (data->services.count != 4) return false;
+  struct service const *const services = data->services.data;
+  ASSERT_EQUALS_INT(512, data->defaults->memory, success);
+  ASSERT_EQUALS_BOOL(true, services[0].limits == data->defaults, success);
+  ASSERT_EQUALS_BOOL(true, services[1].limits == data->defaults, success);
+  ASSERT_EQUALS_SIZE((size_t)3, yaml_constructor_shared_refs(data->defaults),
+                     success);
+  ASSERT_EQUALS_INT(8, services[2].limits->cpu, success);
+  ASSERT_EQUALS_BOOL(true, services[3].limits == services[2].limits, success);
+  ASSERT_EQUALS_SIZE((size_t)2,
+                     yaml_constructor_shared_refs(services[2].limits),
+                     success);
+  ASSERT_EQUALS_INT(1, *services[0].replicas, success);
+  ASSERT_EQUALS_BOOL(true, services[1].replicas == services[0].replicas,
+                     success);
+  ASSERT_EQUALS_BOOL(true, services[3].replicas == services[0].replicas,
+                     success);
+  ASSERT_EQUALS_SIZE((size_t)1,
+                     yaml_constructor_shared_refs(services[2].replicas),
+                     success);
+  return success;
+}
+
+/*
+ * Load the given document, which must fail with an alias error expecting the
+ * given type.
+ */
+static bool check_alias_error(const char *const document,
+                              const char *const expected) {
+  bool success = true;
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)document,
+                          strlen(document));
+  struct root data;
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_ALIAS, loader.error_info.type, success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_ALIAS) {
+    ASSERT_EQUALS_STRING(expected, loader.error_info.expected, success);
+    ASSERT_EQUALS_INT(YAML_ALIAS_EVENT, loader.error_info.event.type,
+                      success);
+  }
+  yaml_loader_delete(&loader);
+  return success;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc; (void)argv;
+  bool success = true;
+  yaml_loader_t loader;
+  struct root data;
+  yaml_loader_init_string(&loader, (const unsigned char*)input,
+                          strlen(input));
+  if (!yaml_load_struct_root(&data, &loader)) {
+    fprintf(stderr, "error while loading YAML.\n");
+    yaml_loader_delete(&loader);
+    return 1;
+  }
+  yaml_loader_delete(&loader);
+  success = check_sharing(&data) && success;
+
+  // values with several references are dumped once and then aliased.
+  yaml_dumper_t dumper;
+  yaml_dumper_init(&dumper);
+  ASSERT_EQUALS_BOOL(true, yaml_dump_struct_root(&data, &dumper), success);
+  static const char dumped[] =
+      "defaults: &a1\n"
+      "  cpu: 1\n"
+      "  memory: 512\n"
+      "services:\n"
+      "  - name: a\n"
+      "    limits: *a1\n"
+      "    replicas: &a2 1\n"
+      "  - name: b\n"
+      "    limits: *a1\n"
+      "    replicas: *a2\n"
+      "  - name: c\n"
+      "    limits: &a3\n"
+      "      cpu: 8\n"
+      "      memory: 4096\n"
+      "    replicas: 3\n"
+      "  - name: d\n"
+      "    limits: *a3\n"
+      "    replicas: *a2\n";
+  ASSERT_EQUALS_SIZE(sizeof(dumped) - 1, dumper.size, success);
+  if (dumper.size != sizeof(dumped) - 1 ||
+      memcmp(dumped, dumper.buffer, dumper.size) != 0) {
+    fprintf(stderr, "  dumped YAML differs:\n%.*s", (int)dumper.size,
+            (const char*)dumper.buffer);
+    success = false;
+  }
+
+  // the dump loads with the same sharing, from the parser and from a tape.
+  struct root reloaded;
+  yaml_loader_init_string(&loader, dumper.buffer, dumper.size);
+  if (yaml_load_struct_root(&reloaded, &loader)) {
+    success = check_sharing(&reloaded) && success;
+    yaml_free_struct_root(&reloaded);
+  } else {
+    fprintf(stderr, "error while loading dumped YAML.\n");
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+  yaml_loader_init_string(&loader, dumper.buffer, dumper.size);
+  if (yaml_loader_use_tape(&loader, &tape) &&
+      yaml_load_struct_root(&reloaded, &loader)) {
+    success = check_sharing(&reloaded) && success;
+    yaml_free_struct_root(&reloaded);
+  } else {
+    fprintf(stderr, "error while loading dumped YAML from a tape.\n");
+    success = false;
+  }
+  ASSERT_EQUALS_SIZE((size_t)5, tape.aliases, success);
+  yaml_loader_delete(&loader);
+  yaml_tape_delete(&tape);
+  yaml_dumper_delete(&dumper);
+
+  // CBOR has no aliases; shared values are repeated.
+  yaml_dumper_init(&dumper);
+  yaml_dumper_use_cbor(&dumper);
+  ASSERT_EQUALS_BOOL(true, yaml_dump_struct_root(&data, &dumper), success);
+  yaml_loader_init_cbor(&loader, dumper.buffer, dumper.size);
+  if (yaml_load_struct_root(&reloaded, &loader)) {
+    ASSERT_EQUALS_BOOL(false,
+        reloaded.services.data[0].limits == reloaded.defaults, success);
+    ASSERT_EQUALS_INT(512, reloaded.services.data[1].limits->memory, success);
+    yaml_free_struct_root(&reloaded);
+  } else {
+    fprintf(stderr, "error while loading CBOR.\n");
+    success = false;
+  }
+  yaml_loader_delete(&loader);
+  yaml_dumper_delete(&dumper);
+  yaml_free_struct_root(&data);
+
+  success = check_alias_error(
+      "defaults: {cpu: 1, memory: 1}\n"
+      "services: [{name: a, limits: *none, replicas: 1}]\n",
+      "struct limits") && success;
+  // the anchor belongs to a value of a different type.
+  success = check_alias_error(
+      "defaults: &small {cpu: 1, memory: 1}\n"
+      "services: [{name: a, limits: *small, replicas: *small}]\n",
+      "int") && success;
+  // only values of !shared fields are recorded as anchor targets.
+  success = check_alias_error(
+      "defaults: {cpu: &one 1, memory: 1}\n"
+      "services: [{name: a, limits: *small, replicas: *one}]\n",
+      "struct limits") && success;
+  success = check_alias_error(
+      "defaults: {cpu: &one 1, memory: 1}\n"
+      "services: [{name: a, limits: {cpu: 1, memory: 1}, replicas: *one}]\n",
+      "int") && success;
+
+  // anchors do not reach into the next document.
+  static const char documents[] =
+      "defaults: &small {cpu: 1, memory: 1}\n"
+      "services: []\n"
+      "---\n"
+      "defaults: *small\n"
+      "services: []\n";
+  yaml_loader_init_string(&loader, (const unsigned char*)documents,
+                          sizeof(documents) - 1);
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT,
+                    yaml_load_next_struct_root(&data, &loader), success);
+  yaml_free_struct_root(&data);
+  ASSERT_EQUALS_INT(YAML_LOADER_FAILED,
+                    yaml_load_next_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_ALIAS, loader.error_info.type, success);
+  yaml_loader_delete(&loader);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#ifndef _SHARED_H
+#define _SHARED_H
+
+#include <stdlib.h>
+
+struct limits {
+  int cpu;
+  int memory;
+};
+
+struct service {
+  //!string
+  char *name;
+  //!shared
+  struct limits *limits;
+  //!shared
+  int *replicas;
+};
+
+//!list
+struct service_list {
+  struct service *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!shared
+  struct limits *defaults;
+  struct service_list services;
+};
+
+#endif
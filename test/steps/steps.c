@@ -0,0 +1,120 @@
+#include "steps.h"
+#include <steps_loading.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+#define TILE_COUNT 500
+// deep enough to exhaust the stack a document is loaded in steps on.
+#define EXCESSIVE_DEPTH 10000
+
+static char *render_input(void) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "level: castle\ntiles:\n");
+  for (int i = 0; i < TILE_COUNT; ++i) {
+    test_text_append(&input, "- {x: %d, y: %d, kind: %s}\n", i % 20, i / 20,
+                     i % 3 == 0 ? "wall" : "floor");
+  }
+  return input.data;
+}
+
+static char *render_deep_input(int const depth) {
+  test_text_t input;
+  test_text_init(&input);
+  test_text_append(&input, "level: deep\ntiles: []\ntree: ");
+  for (int i = 0; i < depth; ++i) {
+    test_text_append(&input, i == depth - 1 ? "{value: %d" :
+                                              "{value: %d, child: ", i);
+  }
+  for (int i = 0; i < depth; ++i) test_text_append(&input, "}");
+  test_text_append(&input, "\n");
+  return input.data;
+}
+
+static void check_value(struct root const *const value, bool *const success) {
+  ASSERT_EQUALS_STRING("castle", value->level, *success);
+  ASSERT_EQUALS_SIZE((size_t)TILE_COUNT, value->tiles.count, *success);
+  if (value->tiles.count == TILE_COUNT) {
+    ASSERT_EQUALS_INT(21 % 20, value->tiles.data[21].x, *success);
+    ASSERT_EQUALS_INT(21 / 20, value->tiles.data[21].y, *success);
+    ASSERT_EQUALS_STRING("wall", value->tiles.data[21].kind, *success);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  char *const input = render_input();
+  size_t const length = strlen(input);
+
+  // each tile is eight events, so every step constructs a bit more than one.
+  yaml_loader_t loader;
+  struct root value;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, length);
+  ASSERT_EQUALS_BOOL(true, yaml_start_struct_root(&value, &loader), success);
+  ASSERT_EQUALS_BOOL(false, yaml_start_struct_root(&value, &loader), success);
+  size_t steps = 0;
+  yaml_loader_status_t status;
+  while ((status = yaml_loader_step(&loader, 10, 0)) ==
+         YAML_LOADER_SUSPENDED) {
+    ++steps;
+  }
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, status, success);
+  // 8 events per tile, so there have been at least this many suspensions.
+  ASSERT_EQUALS_BOOL(true, steps >= TILE_COUNT * 8 / 10, success);
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, yaml_loader_step(&loader, 10, 0),
+                    success);
+  check_value(&value, &success);
+  yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+
+  // a deadline that has passed still lets every step make progress.
+  yaml_loader_init_string(&loader, (const unsigned char*)input, length);
+  yaml_start_struct_root(&value, &loader);
+  steps = 0;
+  while ((status = yaml_loader_step(&loader, 0, 1)) == YAML_LOADER_SUSPENDED) {
+    ++steps;
+  }
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, status, success);
+  ASSERT_EQUALS_BOOL(true, steps > 0, success);
+  check_value(&value, &success);
+  yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+
+  // without limits, a single step loads the whole document.
+  yaml_loader_init_string(&loader, (const unsigned char*)input, length);
+  yaml_start_struct_root(&value, &loader);
+  ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT, yaml_loader_step(
+      &loader, 0, yaml_loader_clock() + 60000000000u), success);
+  check_value(&value, &success);
+  yaml_free_struct_root(&value);
+  yaml_loader_delete(&loader);
+
+  // deleting the loader in the middle of the document frees what has been
+  // constructed so far.
+  yaml_loader_init_string(&loader, (const unsigned char*)input, length);
+  yaml_start_struct_root(&value, &loader);
+  ASSERT_EQUALS_INT(YAML_LOADER_SUSPENDED, yaml_loader_step(&loader, 1000, 0),
+                    success);
+  yaml_loader_delete(&loader);
+
+  // input too deep for the loader's stack fails instead of overflowing it.
+  char *const deep = render_deep_input(EXCESSIVE_DEPTH);
+  yaml_loader_init_string(&loader, (const unsigned char*)deep, strlen(deep));
+  yaml_start_struct_root(&value, &loader);
+  while ((status = yaml_loader_step(&loader, 1000, 0)) ==
+         YAML_LOADER_SUSPENDED) {}
+  ASSERT_EQUALS_INT(YAML_LOADER_FAILED, status, success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_LIMIT, loader.error_info.type, success);
+  if (loader.error_info.type == YAML_LOADER_ERROR_LIMIT) {
+    ASSERT_EQUALS_STRING("stack_size", loader.error_info.expected, success);
+  }
+  yaml_loader_delete(&loader);
+  free(deep);
+
+  free(input);
+  return success ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#ifndef _STEPS_H
+#define _STEPS_H
+
+#include <stdlib.h>
+
+struct tile {
+  int x, y;
+  //!string
+  char *kind;
+};
+
+//!list
+struct tile_list {
+  struct tile *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct node {
+  int value;
+  //!optional
+  struct node *child;
+};
+
+struct root {
+  //!string
+  char *level;
+  struct tile_list tiles;
+  //!optional
+  struct node *tree;
+};
+
+#endif
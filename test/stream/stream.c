@@ -0,0 +1,63 @@
+#include "stream.h"
+#include <stream_loading.h>
+
+#include <../common/test_common.h>
+#include <yaml.h>
+#include <yaml_loader.h>
+
+static const char* input =
+    "title: inventory\n"
+    "records:\n"
+    "- {id: 1, name: hammer}\n"
+    "- {id: 2, name: anvil}\n"
+    "- {id: 3, name: tongs}\n";
+
+struct totals {
+  int id_sum;
+  size_t name_lengths;
+  int reject_id;
+};
+
+bool yaml_handle_struct_record_stream(struct record *const item,
+                                      yaml_loader_t *const loader) {
+  struct totals *const totals = (struct totals*)loader->data;
+  if (item->id == totals->reject_id) return false;
+  totals->id_sum += item->id;
+  totals->name_lengths += strlen(item->name);
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  struct totals totals = {0, 0, -1};
+  loader.data = &totals;
+  struct root data;
+  bool ret = yaml_load_struct_root(&data, &loader);
+  yaml_loader_delete(&loader);
+
+  if (!ret) {
+    fprintf(stderr, "error while loading YAML doc.");
+    return 1;
+  }
+  ASSERT_EQUALS_STRING("inventory", data.title, success);
+  ASSERT_EQUALS_SIZE((size_t)3, data.records.count, success);
+  ASSERT_NULL(data.records.data, success);
+  ASSERT_EQUALS_INT(6, totals.id_sum, success);
+  ASSERT_EQUALS_SIZE((size_t)16, totals.name_lengths, success);
+  yaml_free_struct_root(&data);
+
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  totals.reject_id = 2;
+  loader.data = &totals;
+  ret = yaml_load_struct_root(&data, &loader);
+  ASSERT_EQUALS_BOOL(false, ret, success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_CUSTOM_CONSTRUCTOR,
+                    loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)3, loader.error_info.event.start_mark.line,
+                     success);
+  yaml_loader_delete(&loader);
+
+  return success ? 0 : 1;
+}
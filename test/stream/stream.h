@@ -0,0 +1,29 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <yaml_loader.h>
+
+struct record {
+  int id;
+  //!string
+  char *name;
+};
+
+//!stream
+struct record_stream {
+  struct record *data;
+  size_t count, capacity;
+};
+
+bool yaml_handle_struct_record_stream(struct record *const item,
+                                      yaml_loader_t *const loader);
+
+struct root {
+  //!string
+  char *title;
+  struct record_stream records;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "tape.h"
+#include <tape_loading.h>
+#include <stdbool.h>
+
+#include <yaml_constructor.h>
+#include <yaml_loader.h>
+#include <yaml_tape.h>
+#include <../common/test_common.h>
+
+static const char* first_input =
+    "title: first\n"
+    "items:\n"
+    "- {name: a, amount: 1}\n"
+    "- {name: b, amount: 2}\n"
+    "- name: c\n"
+    "  amount: 3\n"
+    "archive:\n"
+    "- {name: old, amount: 0}\n"
+    "---\n"
+    "title: second\n"
+    "items: []\n"
+    "archive: []\n";
+
+static const char* broken_input =
+    "title: broken\n"
+    "items:\n"
+    "- {name: a, amount: 1}\n"
+    "- {name: b, amount: 2\n";
+
+struct counter {
+  size_t documents;
+  bool success;
+};
+
+static bool check_document(struct root *value, void *context) {
+  struct counter *const counter = (struct counter*)context;
+  bool success = true;
+  if (counter->documents++ == 0) {
+    ASSERT_EQUALS_STRING("first", value->title, success);
+    ASSERT_EQUALS_SIZE((size_t)3, value->items.count, success);
+    // the tape knows the sequence length in advance
+    ASSERT_EQUALS_SIZE((size_t)3, value->items.capacity, success);
+    if (value->items.count == 3) {
+      ASSERT_EQUALS_STRING("c", value->items.data[2].name, success);
+      ASSERT_EQUALS_INT(3, value->items.data[2].amount, success);
+    }
+    ASSERT_EQUALS_BOOL(true, yaml_constructor_is_lazy(value->archive),
+                       success);
+    yaml_loader_t loader;
+    if (yaml_force_struct_item_list(&value->archive, &loader)) {
+      ASSERT_EQUALS_SIZE((size_t)1, value->archive->count, success);
+    } else {
+      fprintf(stderr, "error while forcing archive.\n");
+      success = false;
+    }
+    yaml_loader_delete(&loader);
+  } else {
+    ASSERT_EQUALS_STRING("second", value->title, success);
+    ASSERT_EQUALS_SIZE((size_t)0, value->items.count, success);
+  }
+  yaml_free_struct_root(value);
+  if (!success) counter->success = false;
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  bool success = true;
+  yaml_tape_t tape;
+  yaml_tape_init(&tape);
+
+  // the tape is reused for the second load.
+  for (int i = 0; i < 2; ++i) {
+    yaml_loader_t loader;
+    yaml_loader_init_string(&loader, (const unsigned char*)first_input,
+                            strlen(first_input));
+    ASSERT_EQUALS_BOOL(true, yaml_loader_use_tape(&loader, &tape), success);
+    struct counter counter = {0, true};
+    ASSERT_EQUALS_BOOL(true, yaml_load_all_struct_root(
+        &loader, &check_document, &counter), success);
+    ASSERT_EQUALS_SIZE((size_t)2, counter.documents, success);
+    ASSERT_EQUALS_BOOL(true, counter.success, success);
+    yaml_loader_delete(&loader);
+  }
+
+  // parser errors are reported when loading reaches them.
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)broken_input,
+                          strlen(broken_input));
+  ASSERT_EQUALS_BOOL(true, yaml_loader_use_tape(&loader, &tape), success);
+  struct root data;
+  ASSERT_EQUALS_BOOL(false, yaml_load_struct_root(&data, &loader), success);
+  ASSERT_EQUALS_INT(YAML_LOADER_ERROR_PARSER, loader.error_info.type, success);
+  ASSERT_EQUALS_SIZE((size_t)4, loader.parser->problem_mark.line, success);
+  yaml_loader_delete(&loader);
+
+  yaml_tape_delete(&tape);
+  return success ? 0 : 1;
+}
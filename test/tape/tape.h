@@ -0,0 +1,27 @@
+#ifndef _TAPE_H
+#define _TAPE_H
+
+#include <stdlib.h>
+
+struct item {
+  //!string
+  char *name;
+  int amount;
+};
+
+//!list
+struct item_list {
+  struct item *data;
+  size_t count;
+  size_t capacity;
+};
+
+struct root {
+  //!string
+  char *title;
+  struct item_list items;
+  //!lazy
+  struct item_list *archive;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "views.h"
+#include <views_loading.h>
+#include <stdbool.h>
+
+#include <yaml_loader.h>
+#include <../common/test_common.h>
+#include <../common/test_text.h>
+
+static const char* input =
+    "unicode: \xc3\xa4rger\n"
+    "plain: lorem ipsum\n"
+    "quoted: \"dolor sit\"\n"
+    "escaped: \"amet\\tconsectetur\"\n"
+    "folded: adipiscing\n"
+    "  elit\n";
+
+#define ASSERT_VIEW_EQUALS(expected, actual, res) {\
+  if ((actual).len != sizeof(expected) - 1 ||\
+      memcmp((actual).ptr, (expected), (actual).len) != 0) {\
+    fprintf(stderr, "wrong value for \"%s\": expected %s, got %.*s\n",\
+            #actual, expected, (int)(actual).len, (actual).ptr);\
+    (res) = false;\
+  }\
+}
+
+/*
+ * documents whose escaped and folded views are copied.
+ */
+static char *render_documents(size_t const count) {
+  test_text_t text;
+  test_text_init(&text);
+  for (size_t i = 0; i < count; ++i) {
+    test_text_append(&text,
+        "---\nplain: a\nquoted: \"b\"\nescaped: \"c\\t%zu\"\n"
+        "folded: d\n  %zu\nunicode: e\n", i, i);
+  }
+  return text.data;
+}
+
+struct copies {
+  yaml_loader_t *loader;
+  size_t loaded, most;
+  bool views_correct;
+};
+
+static bool check_copies(struct root *value, void *context) {
+  struct copies *const copies = (struct copies*)context;
+  char expected[32];
+  snprintf(expected, sizeof(expected), "c\t%zu", copies->loaded);
+  if (value->escaped.len != strlen(expected) ||
+      memcmp(value->escaped.ptr, expected, value->escaped.len) != 0) {
+    fprintf(stderr, "wrong escaped view in document %zu\n", copies->loaded);
+    copies->views_correct = false;
+  }
+  if (copies->loader->internal.view_copies.count > copies->most) {
+    copies->most = copies->loader->internal.view_copies.count;
+  }
+  yaml_free_struct_root(value);
+  copies->loaded++;
+  return true;
+}
+
+static bool in_input(struct string_view const view) {
+  return view.ptr >= input && view.ptr + view.len <= input + strlen(input);
+}
+
+int main(int argc, char* argv[]) {
+  yaml_loader_t loader;
+  yaml_loader_init_string(&loader, (const unsigned char*)input, strlen(input));
+  struct root data;
+  bool ret = yaml_load_struct_root(&data, &loader);
+
+  if (!ret) {
+    fprintf(stderr, "error while loading YAML.");
+    yaml_loader_delete(&loader);
+    return 1;
+  } else {
+    bool success = true;
+    ASSERT_VIEW_EQUALS("lorem ipsum", data.plain, success);
+    ASSERT_EQUALS_BOOL(true, in_input(data.plain), success);
+    ASSERT_VIEW_EQUALS("dolor sit", data.quoted, success);
+    ASSERT_EQUALS_BOOL(true, in_input(data.quoted), success);
+    ASSERT_VIEW_EQUALS("amet\tconsectetur", data.escaped, success);
+    ASSERT_EQUALS_BOOL(false, in_input(data.escaped), success);
+    ASSERT_VIEW_EQUALS("adipiscing elit", data.folded, success);
+    ASSERT_EQUALS_BOOL(false, in_input(data.folded), success);
+    ASSERT_VIEW_EQUALS("\xc3\xa4rger", data.unicode, success);
+    ASSERT_EQUALS_BOOL(true, in_input(data.unicode), success);
+
+    yaml_free_struct_root(&data);
+    yaml_loader_delete(&loader);
+
+    // with yaml_load_next, copies stay valid while later documents load.
+    char *const documents = render_documents(1000);
+    struct root first, second;
+    yaml_loader_init_string(&loader, (const unsigned char*)documents,
+                            strlen(documents));
+    ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT,
+                      yaml_load_next_struct_root(&first, &loader), success);
+    ASSERT_EQUALS_INT(YAML_LOADER_DOCUMENT,
+                      yaml_load_next_struct_root(&second, &loader), success);
+    ASSERT_VIEW_EQUALS("c\t0", first.escaped, success);
+    ASSERT_VIEW_EQUALS("c\t1", second.escaped, success);
+    yaml_free_struct_root(&first);
+    yaml_free_struct_root(&second);
+    yaml_loader_delete(&loader);
+
+    // yaml_load_all frees them after each callback, so loading many
+    // documents does not accumulate them.
+    yaml_loader_init_string(&loader, (const unsigned char*)documents,
+                            strlen(documents));
+    struct copies copies = {&loader, 0, 0, true};
+    ASSERT_EQUALS_BOOL(true, yaml_load_all_struct_root(
+        &loader, &check_copies, &copies), success);
+    if (!copies.views_correct) success = false;
+    ASSERT_EQUALS_SIZE((size_t)1000, copies.loaded, success);
+    ASSERT_EQUALS_SIZE((size_t)2, copies.most, success);
+    ASSERT_EQUALS_BOOL(true, loader.internal.view_copies.capacity <= 16,
+                       success);
+    yaml_loader_delete(&loader);
+    free(documents);
+    return success ? 0 : 1;
+  }
+}
@@ -0,0 +1,20 @@
+#ifndef _VIEWS_H
+#define _VIEWS_H
+
+#include <stddef.h>
+
+//!view
+struct string_view {
+  const char *ptr;
+  size_t len;
+};
+
+struct root {
+  struct string_view plain;
+  struct string_view quoted;
+  struct string_view escaped;
+  struct string_view folded;
+  struct string_view unicode;
+};
+
+#endif